@@ -13,7 +13,10 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <thread>
 
 #include "tensorflow/core/common_runtime/bfc_allocator.h"
 
@@ -23,12 +26,56 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
+namespace {
+
+uint64 NowNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Index of the calling thread's cache, assigned round robin on first use.
+int ThreadCacheIndex() {
+  static std::atomic<int> next_index{0};
+  static thread_local int index =
+      next_index.fetch_add(1, std::memory_order_relaxed);
+  return index;
+}
+
+}  // namespace
+
+BFCAllocator::CountingLock::CountingLock(BFCAllocator* a)
+    : a_(a), counted_(a->contention_stats_) {
+  if (!counted_) {
+    a_->lock_.lock();
+    return;
+  }
+  const bool contended = !a_->lock_.try_lock();
+  if (contended) {
+    a_->lock_.lock();
+  }
+  ++a_->lock_acquisitions_;
+  if (contended) {
+    ++a_->contended_lock_acquisitions_;
+  }
+  start_nanos_ = NowNanos();
+}
+
+BFCAllocator::CountingLock::~CountingLock() {
+  if (counted_) {
+    a_->lock_hold_nanos_ += NowNanos() - start_nanos_;
+  }
+  a_->lock_.unlock();
+}
+
 BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                            bool allow_growth, const string& name)
     : suballocator_(sub_allocator),
@@ -65,6 +112,26 @@ BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
       CHECK_NE(BinForSize(bin_size * 2), BinFromIndex(b));
     }
   }
+
+  bool use_thread_cache = false;
+  Status status = ReadBoolFromEnvVar("TF_BFC_ALLOCATOR_THREAD_CACHE", false,
+                                     &use_thread_cache);
+  if (!status.ok()) {
+    LOG(ERROR) << "BFCAllocator: " << status.error_message();
+  }
+  if (use_thread_cache) {
+    EnableThreadCache();
+  }
+
+  bool use_contention_stats = false;
+  status = ReadBoolFromEnvVar("TF_BFC_ALLOCATOR_CONTENTION_STATS", false,
+                              &use_contention_stats);
+  if (!status.ok()) {
+    LOG(ERROR) << "BFCAllocator: " << status.error_message();
+  }
+  if (use_contention_stats) {
+    EnableContentionStats();
+  }
 }
 
 BFCAllocator::~BFCAllocator() {
@@ -106,6 +173,15 @@ bool BFCAllocator::Extend(size_t rounded_bytes) {
     increased_allocation = true;
   }
 
+  // Regions can never grow past what the sub-allocator can hand out at once.
+  if (max_region_bytes_ > 0) {
+    if (rounded_bytes > max_region_bytes_) {
+      return false;
+    }
+    curr_region_allocation_bytes_ =
+        std::min(curr_region_allocation_bytes_, max_region_bytes_);
+  }
+
   // Try allocating.
   size_t bytes = std::min(curr_region_allocation_bytes_, available_bytes);
   void* mem_addr = suballocator_->Alloc(32, bytes);
@@ -142,6 +218,9 @@ bool BFCAllocator::Extend(size_t rounded_bytes) {
   VLOG(1) << "Allocated memory at " << mem_addr << " to "
           << static_cast<void*>(static_cast<char*>(mem_addr) + bytes);
   region_manager_.AddAllocationRegion(mem_addr, bytes);
+  if (thread_caches_ != nullptr) {
+    AddCacheRegion(mem_addr, bytes);
+  }
 
   // Create one large chunk for the whole memory space that will
   // be chunked later.
@@ -251,18 +330,26 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
   // so all memory addresses are nicely byte aligned.
   size_t rounded_bytes = RoundedBytes(num_bytes);
 
-  // The BFC allocator tries to find the best fit first.
-  BinNum bin_num = BinNumForSize(rounded_bytes);
+  if (thread_caches_ != nullptr && rounded_bytes <= kMaxCachedBytes) {
+    void* ptr = AllocateFromThreadCache(rounded_bytes);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+  }
 
-  mutex_lock l(lock_);
-  void* ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
-  if (ptr != nullptr) {
-    return ptr;
+  {
+    CountingLock l(this);
+    void* ptr = FindOrExtendChunkPtr(rounded_bytes, num_bytes);
+    if (ptr != nullptr) {
+      return ptr;
+    }
   }
 
-  // Try to extend
-  if (Extend(rounded_bytes)) {
-    ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
+  // The chunks held by the thread caches may be enough to satisfy the
+  // request once they are back in the bins.
+  if (thread_caches_ != nullptr && FlushAllThreadCaches()) {
+    CountingLock l(this);
+    void* ptr = FindOrExtendChunkPtr(rounded_bytes, num_bytes);
     if (ptr != nullptr) {
       return ptr;
     }
@@ -272,6 +359,7 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
   // couldn't find one.  This means we must have run out of memory,
   // Dump the memory log for analysis.
   if (dump_log_on_failure) {
+    mutex_lock l(lock_);
     LOG(WARNING) << "Allocator (" << Name() << ") ran out of memory trying "
                  << "to allocate " << strings::HumanReadableNumBytes(num_bytes)
                  << ".  Current allocation summary follows.";
@@ -281,6 +369,22 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
   return nullptr;
 }
 
+void* BFCAllocator::FindOrExtendChunkPtr(size_t rounded_bytes,
+                                         size_t num_bytes) {
+  // The BFC allocator tries to find the best fit first.
+  BinNum bin_num = BinNumForSize(rounded_bytes);
+  void* ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
+  if (ptr != nullptr) {
+    return ptr;
+  }
+
+  // Try to extend
+  if (Extend(rounded_bytes)) {
+    return FindChunkPtr(bin_num, rounded_bytes, num_bytes);
+  }
+  return nullptr;
+}
+
 void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
                                  size_t num_bytes) {
   // First identify the first bin that could satisfy rounded_bytes.
@@ -372,6 +476,12 @@ void BFCAllocator::SplitChunk(BFCAllocator::ChunkHandle h, size_t num_bytes) {
 }
 
 void BFCAllocator::DeallocateRaw(void* ptr) {
+  // A chunk freed into a thread cache stays in use, so there is nothing to
+  // notify.
+  if (thread_caches_ != nullptr && ptr != nullptr &&
+      DeallocateToThreadCache(ptr)) {
+    return;
+  }
   DeallocateRawInternal(ptr);
   retry_helper_.NotifyDealloc();
 }
@@ -381,12 +491,21 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
     LOG(ERROR) << "tried to deallocate nullptr";
     return;
   }
-  mutex_lock l(lock_);
+  CountingLock l(this);
 
   // Find the chunk from the ptr.
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle);
 
+  // A chunk handed out by a thread cache can still come back here when
+  // the cache of the freeing thread is busy.
+  if (thread_caches_ != nullptr) {
+    std::atomic<uint8>* mark = CacheMark(ptr);
+    if (mark != nullptr) {
+      mark->store(0, std::memory_order_relaxed);
+    }
+  }
+
   // Consider coalescing it.
   FreeAndMaybeCoalesce(h);
 
@@ -692,6 +811,302 @@ void BFCAllocator::ClearStats() {
   stats_.max_alloc_size = 0;
 }
 
+void BFCAllocator::SetMaxRegionBytes(size_t max_region_bytes) {
+  mutex_lock l(lock_);
+  max_region_bytes_ =
+      (max_region_bytes / kMinAllocationSize) * kMinAllocationSize;
+  if (max_region_bytes_ > 0) {
+    curr_region_allocation_bytes_ =
+        std::min(curr_region_allocation_bytes_, max_region_bytes_);
+  }
+}
+
+void BFCAllocator::GetFragmentationStats(FragmentationStats* stats) {
+  mutex_lock l(lock_);
+  *stats = FragmentationStats();
+  for (const auto& region : region_manager_.regions()) {
+    stats->num_regions++;
+    stats->region_bytes += region.memory_size();
+    ChunkHandle h = region_manager_.get_handle(region.ptr());
+    while (h != kInvalidChunkHandle) {
+      const Chunk* c = ChunkFromHandle(h);
+      if (!c->in_use()) {
+        stats->num_free_chunks++;
+        stats->free_bytes += c->size;
+        stats->largest_free_chunk = std::max(stats->largest_free_chunk, c->size);
+      }
+      h = c->next;
+    }
+  }
+}
+
+string BFCAllocator::FragmentationStats::DebugString() const {
+  return strings::Printf(
+      "Regions:           %20lld\n"
+      "RegionBytes:       %20lld\n"
+      "FreeBytes:         %20lld\n"
+      "FreeChunks:        %20lld\n"
+      "LargestFreeChunk:  %20lld\n"
+      "Fragmentation:     %20.4f\n",
+      static_cast<long long>(num_regions),
+      static_cast<long long>(region_bytes),
+      static_cast<long long>(free_bytes),
+      static_cast<long long>(num_free_chunks),
+      static_cast<long long>(largest_free_chunk), fragmentation());
+}
+
+void BFCAllocator::EnableContentionStats() {
+  mutex_lock l(lock_);
+  contention_stats_ = true;
+}
+
+void BFCAllocator::EnableThreadCache() {
+  mutex_lock l(lock_);
+  contention_stats_ = true;
+  if (thread_caches_ != nullptr) {
+    return;
+  }
+  thread_caches_.reset(new ThreadCache[kNumThreadCaches]);
+  for (const auto& region : region_manager_.regions()) {
+    AddCacheRegion(region.ptr(), region.memory_size());
+  }
+}
+
+void BFCAllocator::AddCacheRegion(void* ptr, size_t memory_size) {
+  std::unique_ptr<CacheRegion> region(new CacheRegion);
+  region->base = static_cast<const char*>(ptr);
+  region->memory_size = memory_size;
+  const size_t num_marks = memory_size >> kMinAllocationBits;
+  region->marks.reset(new std::atomic<uint8>[num_marks]);
+  for (size_t i = 0; i < num_marks; ++i) {
+    region->marks[i].store(0, std::memory_order_relaxed);
+  }
+
+  std::unique_ptr<CacheRegionTable> table(new CacheRegionTable);
+  const CacheRegionTable* current =
+      cache_regions_.load(std::memory_order_relaxed);
+  if (current != nullptr) {
+    *table = *current;
+  }
+  table->insert(std::upper_bound(table->begin(), table->end(), region.get(),
+                                 [](const CacheRegion* a, const CacheRegion* b) {
+                                   return a->base < b->base;
+                                 }),
+                region.get());
+  cache_regions_.store(table.get(), std::memory_order_release);
+  cache_region_storage_.push_back(std::move(region));
+  cache_region_tables_.push_back(std::move(table));
+}
+
+std::atomic<uint8>* BFCAllocator::CacheMark(const void* ptr) {
+  const CacheRegionTable* table =
+      cache_regions_.load(std::memory_order_acquire);
+  if (table == nullptr) {
+    return nullptr;
+  }
+  const char* p = static_cast<const char*>(ptr);
+  auto entry = std::upper_bound(
+      table->begin(), table->end(), p,
+      [](const char* addr, const CacheRegion* region) {
+        return addr < region->base + region->memory_size;
+      });
+  if (entry == table->end() || p < (*entry)->base) {
+    return nullptr;
+  }
+  return &(*entry)->marks[(p - (*entry)->base) >> kMinAllocationBits];
+}
+
+BFCAllocator::ThreadCache* BFCAllocator::AcquireThreadCache() {
+  ThreadCache* cache = &thread_caches_[ThreadCacheIndex() % kNumThreadCaches];
+  // Rather than wait for a thread sharing the cache, or for a flush, the
+  // caller takes the locked path.
+  if (cache->busy.exchange(true, std::memory_order_acquire)) {
+    return nullptr;
+  }
+  return cache;
+}
+
+// static
+void BFCAllocator::ReleaseThreadCache(ThreadCache* cache) {
+  cache->busy.store(false, std::memory_order_release);
+}
+
+void* BFCAllocator::AllocateFromThreadCache(size_t rounded_bytes) {
+  ThreadCache* cache = AcquireThreadCache();
+  if (cache == nullptr) {
+    return nullptr;
+  }
+  std::vector<void*>* free_list =
+      &cache->free_lists[CacheClassForSize(rounded_bytes)];
+  if (free_list->empty()) {
+    ++cache->misses;
+    RefillThreadCache(cache, rounded_bytes);
+  } else {
+    ++cache->hits;
+  }
+  void* ptr = nullptr;
+  if (!free_list->empty()) {
+    ptr = free_list->back();
+    free_list->pop_back();
+    cache->cached_bytes -= rounded_bytes;
+  }
+  ReleaseThreadCache(cache);
+  return ptr;
+}
+
+bool BFCAllocator::DeallocateToThreadCache(void* ptr) {
+  std::atomic<uint8>* mark = CacheMark(ptr);
+  const int mark_value =
+      mark == nullptr ? 0 : mark->load(std::memory_order_relaxed);
+  if (mark_value == 0) {
+    return false;
+  }
+  ThreadCache* cache = AcquireThreadCache();
+  if (cache == nullptr) {
+    return false;
+  }
+  const int cache_class = mark_value - 1;
+  const size_t class_bytes = CacheClassBytes(cache_class);
+  std::vector<void*>* free_list = &cache->free_lists[cache_class];
+  if (free_list->size() >= kThreadCacheDepth) {
+    FlushThreadCacheList(cache, cache_class, free_list->size() / 2);
+  } else if (cache->cached_bytes + class_bytes > kMaxThreadCacheBytes) {
+    FlushThreadCache(cache);
+  }
+  free_list->push_back(ptr);
+  cache->cached_bytes += class_bytes;
+  ReleaseThreadCache(cache);
+  return true;
+}
+
+void BFCAllocator::RefillThreadCache(ThreadCache* cache,
+                                     size_t rounded_bytes) {
+  const int cache_class = CacheClassForSize(rounded_bytes);
+  std::vector<void*>* free_list = &cache->free_lists[cache_class];
+  const size_t batch = std::max<size_t>(
+      1, std::min<size_t>(kThreadCacheDepth / 2,
+                          kThreadCacheRefillBytes / rounded_bytes));
+  CountingLock l(this);
+  for (size_t i = 0; i < batch; ++i) {
+    // Only the chunk the caller asked for may extend the allocator.  The
+    // chunks are requested at their rounded size, so that any allocation
+    // of the size class can reuse them.
+    void* ptr = i == 0 ? FindOrExtendChunkPtr(rounded_bytes, rounded_bytes)
+                       : FindChunkPtr(BinNumForSize(rounded_bytes),
+                                      rounded_bytes, rounded_bytes);
+    if (ptr == nullptr) {
+      break;
+    }
+    std::atomic<uint8>* mark = CacheMark(ptr);
+    DCHECK(mark != nullptr);
+    mark->store(cache_class + 1, std::memory_order_relaxed);
+    free_list->push_back(ptr);
+    cache->cached_bytes += rounded_bytes;
+  }
+}
+
+void BFCAllocator::FlushThreadCacheList(ThreadCache* cache, int cache_class,
+                                        size_t count) {
+  std::vector<void*>* free_list = &cache->free_lists[cache_class];
+  std::vector<void*> ptrs(free_list->begin(), free_list->begin() + count);
+  free_list->erase(free_list->begin(), free_list->begin() + count);
+  cache->cached_bytes -= count * CacheClassBytes(cache_class);
+  ++cache->flushes;
+  ReturnCachedChunks(ptrs);
+}
+
+void BFCAllocator::FlushThreadCache(ThreadCache* cache) {
+  std::vector<void*> ptrs;
+  TakeCachedChunks(cache, &ptrs);
+  ++cache->flushes;
+  ReturnCachedChunks(ptrs);
+}
+
+bool BFCAllocator::FlushAllThreadCaches() {
+  std::vector<void*> ptrs;
+  for (int i = 0; i < kNumThreadCaches; ++i) {
+    ThreadCache* cache = &thread_caches_[i];
+    while (cache->busy.exchange(true, std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+    if (cache->cached_bytes > 0) {
+      TakeCachedChunks(cache, &ptrs);
+      ++cache->flushes;
+    }
+    ReleaseThreadCache(cache);
+  }
+  if (ptrs.empty()) {
+    return false;
+  }
+  ReturnCachedChunks(ptrs);
+  return true;
+}
+
+// static
+void BFCAllocator::TakeCachedChunks(ThreadCache* cache,
+                                    std::vector<void*>* ptrs) {
+  for (auto& free_list : cache->free_lists) {
+    ptrs->insert(ptrs->end(), free_list.begin(), free_list.end());
+    free_list.clear();
+  }
+  cache->cached_bytes = 0;
+}
+
+void BFCAllocator::ReturnCachedChunks(const std::vector<void*>& ptrs) {
+  {
+    CountingLock l(this);
+    for (void* ptr : ptrs) {
+      CacheMark(ptr)->store(0, std::memory_order_relaxed);
+      BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
+      CHECK(h != kInvalidChunkHandle);
+      FreeAndMaybeCoalesce(h);
+    }
+  }
+  retry_helper_.NotifyDealloc();
+}
+
+void BFCAllocator::GetContentionStats(ContentionStats* stats) {
+  *stats = ContentionStats();
+  {
+    mutex_lock l(lock_);
+    stats->lock_acquisitions = lock_acquisitions_;
+    stats->contended_acquisitions = contended_lock_acquisitions_;
+    stats->lock_hold_nanos = lock_hold_nanos_;
+  }
+  if (thread_caches_ == nullptr) {
+    return;
+  }
+  for (int i = 0; i < kNumThreadCaches; ++i) {
+    ThreadCache* cache = &thread_caches_[i];
+    while (cache->busy.exchange(true, std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+    stats->cache_hits += cache->hits;
+    stats->cache_misses += cache->misses;
+    stats->cache_flushes += cache->flushes;
+    stats->cached_bytes += cache->cached_bytes;
+    ReleaseThreadCache(cache);
+  }
+}
+
+string BFCAllocator::ContentionStats::DebugString() const {
+  return strings::Printf(
+      "LockAcquisitions:  %20lld\n"
+      "ContendedLocks:    %20lld\n"
+      "LockHoldNanos:     %20lld\n"
+      "CacheHits:         %20lld\n"
+      "CacheMisses:       %20lld\n"
+      "CacheFlushes:      %20lld\n"
+      "CachedBytes:       %20lld\n",
+      static_cast<long long>(lock_acquisitions),
+      static_cast<long long>(contended_acquisitions),
+      static_cast<long long>(lock_hold_nanos),
+      static_cast<long long>(cache_hits),
+      static_cast<long long>(cache_misses),
+      static_cast<long long>(cache_flushes),
+      static_cast<long long>(cached_bytes));
+}
+
 std::array<BFCAllocator::BinDebugInfo, BFCAllocator::kNumBins>
 BFCAllocator::get_bin_debug_info() {
   std::array<BinDebugInfo, kNumBins> bin_infos;
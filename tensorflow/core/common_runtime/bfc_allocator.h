@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_COMMON_RUNTIME_BFC_ALLOCATOR_H_
 
 #include <array>
+#include <atomic>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -72,6 +73,72 @@ class BFCAllocator : public VisitableAllocator {
 
   void ClearStats() override;
 
+  // Snapshot of how the reserved regions are carved up.  fragmentation()
+  // is 0 when all free memory is one contiguous chunk and approaches 1 as
+  // the free memory is scattered over many small chunks.
+  struct FragmentationStats {
+    size_t region_bytes = 0;
+    size_t num_regions = 0;
+    size_t free_bytes = 0;
+    size_t num_free_chunks = 0;
+    size_t largest_free_chunk = 0;
+
+    double fragmentation() const {
+      if (free_bytes == 0) return 0.0;
+      return 1.0 - static_cast<double>(largest_free_chunk) / free_bytes;
+    }
+    string DebugString() const;
+  };
+  void GetFragmentationStats(FragmentationStats* stats);
+
+  // Puts a per-thread cache in front of the bins for allocations of up to
+  // 32KiB.  A thread allocates from and frees into its own free lists of
+  // 256-byte size classes without taking the allocator lock; a miss pulls
+  // a batch of chunks from the bins and an overflowing list returns a
+  // batch, each under a single lock acquisition.  Chunks held in the caches
+  // count as in use in GetStats, and all caches are flushed back to the
+  // bins before an allocation fails.  The RequestedSize of a cached
+  // allocation is its rounded size, and its AllocationId is kept while the
+  // chunk is reused from a cache.
+  //
+  // Also enabled by setting TF_BFC_ALLOCATOR_THREAD_CACHE=true.  Enables
+  // the contention stats as well.  Must be called before the first
+  // allocation.
+  void EnableThreadCache();
+
+  // Starts counting and timing the acquisitions of the allocator lock for
+  // GetContentionStats.  Off by default, as it adds a try_lock and two clock
+  // reads to every acquisition.  Also enabled by setting
+  // TF_BFC_ALLOCATOR_CONTENTION_STATS=true.  Must be called before the first
+  // allocation.
+  void EnableContentionStats();
+
+  // Counters of the allocation and deallocation paths.  The lock counters
+  // cover every acquisition of the allocator lock on those paths and stay 0
+  // unless the contention stats are enabled, the cache counters stay 0
+  // unless the thread cache is enabled.
+  struct ContentionStats {
+    int64 lock_acquisitions = 0;
+    // Acquisitions that found the lock held by another thread.
+    int64 contended_acquisitions = 0;
+    int64 lock_hold_nanos = 0;
+    int64 cache_hits = 0;
+    int64 cache_misses = 0;
+    // Batches of chunks returned from the thread caches to the bins.
+    int64 cache_flushes = 0;
+    int64 cached_bytes = 0;
+
+    string DebugString() const;
+  };
+  void GetContentionStats(ContentionStats* stats);
+
+ protected:
+  // Caps the size of each region requested from the sub-allocator, for
+  // devices that cannot hand out a single buffer as large as the whole
+  // memory limit.  Allocations larger than 'max_region_bytes' fail.
+  // Must be called before the first allocation.
+  void SetMaxRegionBytes(size_t max_region_bytes);
+
  private:
   struct Bin;
 
@@ -79,6 +146,23 @@ class BFCAllocator : public VisitableAllocator {
                             bool dump_log_on_failure);
   void DeallocateRawInternal(void* ptr);
 
+  // Scoped lock of lock_ on the allocation and deallocation paths, which
+  // feeds the lock counters of ContentionStats when they are enabled, and
+  // is a plain lock otherwise.
+  class SCOPED_LOCKABLE CountingLock {
+   public:
+    explicit CountingLock(BFCAllocator* a) EXCLUSIVE_LOCK_FUNCTION(a->lock_)
+        NO_THREAD_SAFETY_ANALYSIS;
+    ~CountingLock() UNLOCK_FUNCTION() NO_THREAD_SAFETY_ANALYSIS;
+
+   private:
+    BFCAllocator* const a_;
+    const bool counted_;
+    uint64 start_nanos_ = 0;
+
+    TF_DISALLOW_COPY_AND_ASSIGN(CountingLock);
+  };
+
   // A ChunkHandle is an index into the chunks_ vector in BFCAllocator
   // kInvalidChunkHandle means an invalid chunk
   typedef size_t ChunkHandle;
@@ -177,6 +261,97 @@ class BFCAllocator : public VisitableAllocator {
   static const size_t kMinAllocationBits = 8;
   static const size_t kMinAllocationSize = 1 << kMinAllocationBits;
 
+  // Allocations of up to kMaxCachedBytes go through the thread caches.
+  // Size class c holds chunks for rounded sizes of (c + 1) *
+  // kMinAllocationSize bytes.
+  static const size_t kMaxCachedBytes = 32 << 10;
+  static const int kNumCacheClasses = kMaxCachedBytes >> kMinAllocationBits;
+  // Threads are assigned caches round robin, so up to kNumThreadCaches
+  // threads never share one.
+  static const int kNumThreadCaches = 128;
+  // Longest free list of a size class, half of it is flushed when full.
+  static const size_t kThreadCacheDepth = 64;
+  // Bytes a cache may hold before it is flushed entirely.
+  static const size_t kMaxThreadCacheBytes = 2 << 20;
+  // One refill of a free list pulls up to kThreadCacheDepth / 2 chunks and
+  // kThreadCacheRefillBytes bytes from the bins.
+  static const size_t kThreadCacheRefillBytes = 16 << 10;
+
+  // The free lists of one or more threads.  Only the thread that set busy
+  // touches the other fields.
+  struct ThreadCache {
+    std::atomic<bool> busy{false};
+    size_t cached_bytes = 0;
+    int64 hits = 0;
+    int64 misses = 0;
+    int64 flushes = 0;
+    std::vector<void*> free_lists[kNumCacheClasses];
+  };
+
+  // Size class marks of a region, read without lock_.  marks[i] is c + 1
+  // while the chunk starting at base + i * kMinAllocationSize belongs to
+  // the thread caches with size class c, and 0 otherwise.  The marks only
+  // change under lock_.
+  struct CacheRegion {
+    const char* base = nullptr;
+    size_t memory_size = 0;
+    std::unique_ptr<std::atomic<uint8>[]> marks;
+  };
+  // The cache regions sorted by base.  A table is never modified once
+  // published, adding a region publishes a new one.
+  typedef std::vector<const CacheRegion*> CacheRegionTable;
+
+  static int CacheClassForSize(size_t rounded_bytes) {
+    return static_cast<int>(rounded_bytes >> kMinAllocationBits) - 1;
+  }
+  static size_t CacheClassBytes(int cache_class) {
+    return static_cast<size_t>(cache_class + 1) << kMinAllocationBits;
+  }
+
+  // Returns the mark of the chunk starting at 'ptr', or nullptr when 'ptr'
+  // is outside all cache regions.  Does not need lock_.
+  std::atomic<uint8>* CacheMark(const void* ptr);
+
+  // Publishes the marks of a new region.
+  void AddCacheRegion(void* ptr, size_t memory_size)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Returns the cache of the calling thread, or nullptr when another
+  // thread is using it.  Release with ReleaseThreadCache.
+  ThreadCache* AcquireThreadCache();
+  static void ReleaseThreadCache(ThreadCache* cache);
+
+  // Pops a chunk of 'rounded_bytes' from the calling thread's cache,
+  // refilling it from the bins when empty.  Returns nullptr when the cache
+  // is busy or the bins are exhausted.
+  void* AllocateFromThreadCache(size_t rounded_bytes);
+
+  // Pushes 'ptr' to the calling thread's cache.  Returns false, and leaves
+  // 'ptr' alone, when it was not handed out by a cache or the cache is
+  // busy.
+  bool DeallocateToThreadCache(void* ptr);
+
+  // Moves a batch of chunks of 'rounded_bytes' from the bins to 'cache'.
+  void RefillThreadCache(ThreadCache* cache, size_t rounded_bytes);
+
+  // Returns the 'count' oldest chunks of a free list of 'cache' to the
+  // bins.
+  void FlushThreadCacheList(ThreadCache* cache, int cache_class,
+                            size_t count);
+
+  // Returns all chunks of 'cache' to the bins.
+  void FlushThreadCache(ThreadCache* cache);
+
+  // Returns the chunks of all thread caches to the bins.  Returns false if
+  // the caches were empty.
+  bool FlushAllThreadCaches();
+
+  // Moves the chunks of 'cache' to 'ptrs'.
+  static void TakeCachedChunks(ThreadCache* cache, std::vector<void*>* ptrs);
+
+  // Frees cached chunks into the bins under one acquisition of lock_.
+  void ReturnCachedChunks(const std::vector<void*>& ptrs);
+
   // AllocationRegion maps pointers to ChunkHandles for a single
   // contiguous memory region.
   //
@@ -312,6 +487,10 @@ class BFCAllocator : public VisitableAllocator {
   void* FindChunkPtr(BinNum bin_num, size_t rounded_bytes, size_t num_bytes)
       EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // FindChunkPtr, extending the allocator once if no chunk fits.
+  void* FindOrExtendChunkPtr(size_t rounded_bytes, size_t num_bytes)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // Splits the chunk specified by 'h' into two chunks, one at least
   // of size 'num_bytes'.
   void SplitChunk(ChunkHandle h, size_t num_bytes)
@@ -413,6 +592,9 @@ class BFCAllocator : public VisitableAllocator {
   // of the available memory.
   bool started_backpedal_ = false;
 
+  // Upper bound on the size of a single region, 0 if unbounded.
+  size_t max_region_bytes_ = 0;
+
   std::unique_ptr<SubAllocator> suballocator_;
   string name_;
 
@@ -434,6 +616,24 @@ class BFCAllocator : public VisitableAllocator {
 
   // Stats.
   AllocatorStats stats_ GUARDED_BY(lock_);
+  int64 lock_acquisitions_ GUARDED_BY(lock_) = 0;
+  int64 contended_lock_acquisitions_ GUARDED_BY(lock_) = 0;
+  int64 lock_hold_nanos_ GUARDED_BY(lock_) = 0;
+  // Whether CountingLock feeds the counters above.  Set before the first
+  // allocation and read without lock_.
+  bool contention_stats_ = false;
+
+  // kNumThreadCaches caches, or nullptr when the thread cache is disabled.
+  // Set before the first allocation and read without lock_.
+  std::unique_ptr<ThreadCache[]> thread_caches_;
+
+  // The current table of cache regions.  The tables and regions stay alive
+  // until destruction, as other threads may still be reading them.
+  std::atomic<const CacheRegionTable*> cache_regions_{nullptr};
+  std::vector<std::unique_ptr<CacheRegion>> cache_region_storage_
+      GUARDED_BY(lock_);
+  std::vector<std::unique_ptr<CacheRegionTable>> cache_region_tables_
+      GUARDED_BY(lock_);
 
   friend class GPUBFCAllocatorPrivateMethodsTest;
   TF_DISALLOW_COPY_AND_ASSIGN(BFCAllocator);
@@ -0,0 +1,280 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/bfc_allocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace {
+
+class HostSubAllocator : public SubAllocator {
+ public:
+  void* Alloc(size_t alignment, size_t num_bytes) override {
+    return port::AlignedMalloc(num_bytes, alignment);
+  }
+  void Free(void* ptr, size_t num_bytes) override { port::AlignedFree(ptr); }
+};
+
+// Exposes SetMaxRegionBytes, which device allocators call on themselves.
+class CappedBFCAllocator : public BFCAllocator {
+ public:
+  CappedBFCAllocator(size_t total_memory, size_t max_region_bytes)
+      : BFCAllocator(new HostSubAllocator, total_memory, false, "bfc") {
+    SetMaxRegionBytes(max_region_bytes);
+  }
+};
+
+TEST(BFCAllocatorTest, FragmentationStats) {
+  BFCAllocator a(new HostSubAllocator, 1 << 20, false, "bfc");
+  BFCAllocator::FragmentationStats stats;
+  a.GetFragmentationStats(&stats);
+  EXPECT_EQ(0, stats.num_regions);
+  EXPECT_EQ(0.0, stats.fragmentation());
+
+  void* p0 = a.AllocateRaw(1, 1024);
+  void* p1 = a.AllocateRaw(1, 1024);
+  void* p2 = a.AllocateRaw(1, 1024);
+  a.GetFragmentationStats(&stats);
+  EXPECT_EQ(1, stats.num_regions);
+  EXPECT_EQ(1 << 20, stats.region_bytes);
+  EXPECT_EQ(1, stats.num_free_chunks);
+  EXPECT_EQ((1 << 20) - 3072, stats.free_bytes);
+  EXPECT_EQ(0.0, stats.fragmentation());
+
+  // Freeing the middle chunk leaves a hole that cannot coalesce.
+  a.DeallocateRaw(p1);
+  a.GetFragmentationStats(&stats);
+  EXPECT_EQ(2, stats.num_free_chunks);
+  EXPECT_EQ((1 << 20) - 2048, stats.free_bytes);
+  EXPECT_EQ((1 << 20) - 3072, stats.largest_free_chunk);
+  EXPECT_GT(stats.fragmentation(), 0.0);
+
+  a.DeallocateRaw(p0);
+  a.DeallocateRaw(p2);
+  a.GetFragmentationStats(&stats);
+  EXPECT_EQ(1, stats.num_free_chunks);
+  EXPECT_EQ(1 << 20, stats.free_bytes);
+  EXPECT_EQ(0.0, stats.fragmentation());
+}
+
+TEST(BFCAllocatorTest, MaxRegionBytes) {
+  CappedBFCAllocator a(4 << 20, 1 << 20);
+
+  AllocationAttributes no_retry;
+  no_retry.no_retry_on_failure = true;
+  // Larger than any region can be.
+  EXPECT_EQ(nullptr, a.AllocateRaw(1, 2 << 20, no_retry));
+
+  void* p0 = a.AllocateRaw(1, 768 << 10, no_retry);
+  void* p1 = a.AllocateRaw(1, 768 << 10, no_retry);
+  ASSERT_NE(p0, nullptr);
+  ASSERT_NE(p1, nullptr);
+
+  BFCAllocator::FragmentationStats stats;
+  a.GetFragmentationStats(&stats);
+  EXPECT_EQ(2, stats.num_regions);
+  EXPECT_EQ(2 << 20, stats.region_bytes);
+  a.DeallocateRaw(p0);
+  a.DeallocateRaw(p1);
+}
+
+TEST(BFCAllocatorTest, ContentionStatsCountLocks) {
+  BFCAllocator a(new HostSubAllocator, 1 << 20, false, "bfc");
+  a.EnableContentionStats();
+  for (int i = 0; i < 10; ++i) {
+    a.DeallocateRaw(a.AllocateRaw(1, 1024));
+  }
+  BFCAllocator::ContentionStats stats;
+  a.GetContentionStats(&stats);
+  EXPECT_EQ(20, stats.lock_acquisitions);
+  EXPECT_EQ(0, stats.contended_acquisitions);
+  EXPECT_GT(stats.lock_hold_nanos, 0);
+  EXPECT_EQ(0, stats.cache_hits);
+  EXPECT_EQ(0, stats.cache_misses);
+}
+
+TEST(BFCAllocatorTest, ContentionStatsDisabledByDefault) {
+  BFCAllocator a(new HostSubAllocator, 1 << 20, false, "bfc");
+  for (int i = 0; i < 10; ++i) {
+    a.DeallocateRaw(a.AllocateRaw(1, 1024));
+  }
+  BFCAllocator::ContentionStats stats;
+  a.GetContentionStats(&stats);
+  EXPECT_EQ(0, stats.lock_acquisitions);
+  EXPECT_EQ(0, stats.lock_hold_nanos);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheReusesChunks) {
+  BFCAllocator a(new HostSubAllocator, 1 << 20, false, "bfc");
+  a.EnableThreadCache();
+
+  void* p0 = a.AllocateRaw(1, 1000);
+  ASSERT_NE(nullptr, p0);
+  // Cached allocations report their rounded size.
+  EXPECT_EQ(1024, a.RequestedSize(p0));
+  const int64 id = a.AllocationId(p0);
+  a.DeallocateRaw(p0);
+
+  // The last chunk freed is the first one reused, with the same id.
+  void* p1 = a.AllocateRaw(1, 900);
+  EXPECT_EQ(p0, p1);
+  EXPECT_EQ(id, a.AllocationId(p1));
+  a.DeallocateRaw(p1);
+
+  // Larger allocations bypass the cache.
+  void* p2 = a.AllocateRaw(1, 64 << 10);
+  EXPECT_EQ(64 << 10, a.RequestedSize(p2));
+  a.DeallocateRaw(p2);
+
+  BFCAllocator::ContentionStats stats;
+  a.GetContentionStats(&stats);
+  EXPECT_EQ(1, stats.cache_misses);
+  EXPECT_EQ(1, stats.cache_hits);
+  EXPECT_GT(stats.cached_bytes, 0);
+  // One refill, plus the allocation and the deallocation of p2.
+  EXPECT_EQ(3, stats.lock_acquisitions);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheFlushedBeforeFailure) {
+  BFCAllocator a(new HostSubAllocator, 1 << 20, false, "bfc");
+  a.EnableThreadCache();
+
+  // Leave most of the memory in the cache.
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 96; ++i) {
+    ptrs.push_back(a.AllocateRaw(1, 8 << 10));
+    ASSERT_NE(nullptr, ptrs.back());
+  }
+  for (void* ptr : ptrs) {
+    a.DeallocateRaw(ptr);
+  }
+  BFCAllocator::ContentionStats stats;
+  a.GetContentionStats(&stats);
+  EXPECT_GE(stats.cached_bytes, 512 << 10);
+
+  AllocationAttributes no_retry;
+  no_retry.no_retry_on_failure = true;
+  void* large = a.AllocateRaw(1, 768 << 10, no_retry);
+  ASSERT_NE(nullptr, large);
+  a.GetContentionStats(&stats);
+  EXPECT_EQ(0, stats.cached_bytes);
+  a.DeallocateRaw(large);
+
+  BFCAllocator::FragmentationStats fragmentation;
+  a.GetFragmentationStats(&fragmentation);
+  EXPECT_EQ(1, fragmentation.num_free_chunks);
+  EXPECT_EQ(1 << 20, fragmentation.free_bytes);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheCrossThreadFrees) {
+  BFCAllocator a(new HostSubAllocator, 64 << 20, true, "bfc");
+  a.EnableThreadCache();
+  const int kNumThreads = 16;
+  const int kNumSlots = 256;
+  std::vector<std::atomic<void*>> slots(kNumSlots);
+  for (auto& slot : slots) slot = nullptr;
+  {
+    thread::ThreadPool pool(Env::Default(), "test", kNumThreads);
+    for (int t = 0; t < kNumThreads; ++t) {
+      pool.Schedule([&a, &slots, t]() {
+        random::PhiloxRandom philox(t, 17);
+        random::SimplePhilox rand(&philox);
+        for (int i = 0; i < 2000; ++i) {
+          const size_t bytes = 1 + rand.Uniform(48 << 10);
+          void* ptr = a.AllocateRaw(1, bytes);
+          ASSERT_NE(nullptr, ptr);
+          EXPECT_GE(a.RequestedSize(ptr), bytes);
+          // Hand the chunk to whichever thread takes the slot next.
+          void* old = slots[rand.Uniform(kNumSlots)].exchange(ptr);
+          if (old != nullptr) a.DeallocateRaw(old);
+        }
+      });
+    }
+  }
+  for (auto& slot : slots) {
+    void* ptr = slot.exchange(nullptr);
+    if (ptr != nullptr) a.DeallocateRaw(ptr);
+  }
+
+  // Failing an allocation returns all cached chunks to the bins.
+  AllocationAttributes no_retry;
+  no_retry.no_retry_on_failure = true;
+  EXPECT_EQ(nullptr, a.AllocateRaw(1, 128 << 20, no_retry));
+  AllocatorStats stats;
+  a.GetStats(&stats);
+  EXPECT_EQ(0, stats.bytes_in_use);
+}
+
+// Alloc/free loop over small sizes on 'num_threads' threads, with the
+// thread cache enabled when 'use_cache' is 1.
+static void BM_ThreadedSmallAllocations(int iters, int num_threads,
+                                        int use_cache) {
+  testing::StopTiming();
+  BFCAllocator a(new HostSubAllocator, 1uLL << 30, true, "bfc");
+  if (use_cache) {
+    a.EnableThreadCache();
+  }
+  const int iters_per_thread = std::max(1, iters / num_threads);
+  testing::ItemsProcessed(static_cast<int64>(iters_per_thread) * num_threads);
+  testing::StartTiming();
+  {
+    thread::ThreadPool pool(Env::Default(), "bench", num_threads);
+    for (int t = 0; t < num_threads; ++t) {
+      pool.Schedule([&a, iters_per_thread]() {
+        const int sizes[] = {256, 1024, 4096, 512, 16384, 768, 2048, 8192};
+        void* live[8] = {};
+        for (int i = 0; i < iters_per_thread; ++i) {
+          const int slot = i % 8;
+          if (live[slot] != nullptr) a.DeallocateRaw(live[slot]);
+          live[slot] = a.AllocateRaw(1, sizes[slot]);
+        }
+        for (void* ptr : live) {
+          if (ptr != nullptr) a.DeallocateRaw(ptr);
+        }
+      });
+    }
+  }
+  testing::StopTiming();
+  BFCAllocator::ContentionStats stats;
+  a.GetContentionStats(&stats);
+  VLOG(1) << "Threads " << num_threads << " cache " << use_cache << "\n"
+          << stats.DebugString();
+}
+BENCHMARK(BM_ThreadedSmallAllocations)
+    ->ArgPair(1, 0)
+    ->ArgPair(1, 1)
+    ->ArgPair(4, 0)
+    ->ArgPair(4, 1)
+    ->ArgPair(16, 0)
+    ->ArgPair(16, 1)
+    ->ArgPair(32, 0)
+    ->ArgPair(32, 1)
+    ->ArgPair(64, 0)
+    ->ArgPair(64, 1);
+
+}  // namespace
+}  // namespace tensorflow
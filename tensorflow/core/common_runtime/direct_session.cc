@@ -282,6 +282,19 @@ DirectSession::DirectSession(const SessionOptions& options,
   if (!status.ok()) {
     LOG(ERROR) << status.error_message();
   }
+  const Status planning_status = ReadBoolFromEnvVar(
+      "TF_DIRECT_SESSION_MEMORY_PLANNING", false, &plan_step_memory_);
+  if (!planning_status.ok()) {
+    LOG(ERROR) << planning_status.error_message();
+  }
+  const Status work_stealing_status =
+      ReadBoolFromEnvVar("TF_EXECUTOR_WORK_STEALING", false, &work_stealing_);
+  if (!work_stealing_status.ok()) {
+    LOG(ERROR) << work_stealing_status.error_message();
+  }
+  if (OpOverheadSampler::Global()->sample_every_n_steps() > 0) {
+    op_overhead_sampler_ = OpOverheadSampler::Global();
+  }
   // NOTE(mrry): We do not need to use a unique string for the session
   // handle, because DirectSession owns its devices. This may change
   // in future versions.
@@ -590,7 +603,9 @@ Status DirectSession::Run(const RunOptions& run_options,
                                            pool](Executor::Args::Closure c) {
     SchedClosure(pool, std::move(c));
   };
-  for (const auto& item : executors_and_keys->items) {
+  std::vector<StepMemoryPlanner::Step*> memory_plan_steps(num_executors);
+  for (size_t i = 0; i < num_executors; ++i) {
+    const auto& item = executors_and_keys->items[i];
     // TODO(zhengxq): support partial run.
     // TODO(zhengxq): if the device picks its own threadpool, we need to assign
     //     less threads to the main compute pool by default.
@@ -603,6 +618,15 @@ Status DirectSession::Run(const RunOptions& run_options,
         SchedClosure(device_thread_pool, std::move(c));
       };
     }
+    if (work_stealing_) {
+      args.work_stealing_workers = device_thread_pool
+                                       ? device_thread_pool->NumThreads()
+                                       : pool->NumThreads();
+    }
+    if (item.memory_planner) {
+      memory_plan_steps[i] = item.memory_planner->BeginStep();
+    }
+    args.memory_plan_step = memory_plan_steps[i];
     item.executor->RunAsync(args, barrier->Get());
   }
 
@@ -610,6 +634,12 @@ Status DirectSession::Run(const RunOptions& run_options,
                       run_options.timeout_in_ms() > 0
                           ? run_options.timeout_in_ms()
                           : operation_timeout_in_ms_);
+  for (size_t i = 0; i < num_executors; ++i) {
+    if (memory_plan_steps[i] != nullptr) {
+      executors_and_keys->items[i].memory_planner->EndStep(
+          memory_plan_steps[i]);
+    }
+  }
 
   if (!cancellation_manager_->DeregisterCallback(cancellation_token)) {
     // The step has been cancelled: make sure we don't attempt to receive the
@@ -1231,6 +1261,7 @@ Status DirectSession::GetOrCreateExecutors(
       }
     };
     params.node_outputs_cb = node_outputs_callback_;
+    params.op_overhead_sampler = op_overhead_sampler_;
 
     optimizer.Optimize(lib, options_.env, device, &iter->second,
                        /*shape_map=*/nullptr);
@@ -1252,6 +1283,10 @@ Status DirectSession::GetOrCreateExecutors(
     TF_RETURN_IF_ERROR(
         NewLocalExecutor(params, partition_graph.release(), &executor));
     item->executor.reset(executor);
+    if (plan_step_memory_ && !run_state_args->is_partial_run) {
+      item->memory_planner.reset(
+          new StepMemoryPlanner(device->GetAllocator(AllocatorAttributes())));
+    }
   }
 
   // Cache the mapping from input/output names to graph elements to
@@ -29,9 +29,11 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_set.h"
 #include "tensorflow/core/common_runtime/executor.h"
 #include "tensorflow/core/common_runtime/graph_execution_state.h"
+#include "tensorflow/core/common_runtime/op_overhead_sampler.h"
 #include "tensorflow/core/common_runtime/process_function_library_runtime.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/common_runtime/session_factory.h"
+#include "tensorflow/core/common_runtime/step_memory_planner.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/session_state.h"
@@ -115,6 +117,8 @@ class DirectSession : public Session {
     Device* device = nullptr;                // not owned.
     FunctionLibraryRuntime* flib = nullptr;  // not owned.
     std::unique_ptr<Executor> executor;
+    // Set if the memory of the steps is planned.
+    std::unique_ptr<StepMemoryPlanner> memory_planner;
   };
 
   // An ExecutorsAndKeys is created for a given set of feeds/fetches.
@@ -288,6 +292,15 @@ class DirectSession : public Session {
 
   // If true, blocks until device has finished all queued operations in a step.
   bool sync_on_finish_ = true;
+  // If true, the steps of Run() allocate from a per-partition arena planned
+  // from the allocations of their first step.
+  bool plan_step_memory_ = false;
+  // If true, the steps of Run() are scheduled with work stealing over as many
+  // workers as the thread pool has threads.
+  bool work_stealing_ = false;
+  // If set, the executors sample the costs of their nodes into it. Not
+  // owned.
+  OpOverheadSampler* op_overhead_sampler_ = nullptr;
   // Schedules 'c' for execution on pool.
   void SchedClosure(thread::ThreadPool* pool, std::function<void()> c);
 
@@ -139,6 +139,30 @@ TEST_F(DirectSessionMinusAXTest, TestFeed) {
   EXPECT_FLOAT_EQ(39.0, mat(1, 0));
 }
 
+TEST_F(DirectSessionMinusAXTest, TestFeedWithMemoryPlanning) {
+  setenv("TF_DIRECT_SESSION_MEMORY_PLANNING", "true", 1);
+  Initialize({1, 2, 3, 4});
+  auto session = CreateSession();
+  unsetenv("TF_DIRECT_SESSION_MEMORY_PLANNING");
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  // The first run plans the memory of the others, in which y is allocated
+  // from the arena.
+  for (int i = 0; i < 5; ++i) {
+    Tensor t(DT_FLOAT, TensorShape({2, 1}));
+    t.matrix<float>()(0, 0) = i;
+    t.matrix<float>()(1, 0) = 1;
+    std::vector<std::pair<string, Tensor>> inputs = {{x_, t}};
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run(inputs, {y_neg_ + ":0"}, {}, &outputs));
+    ASSERT_EQ(1, outputs.size());
+    auto mat = outputs[0].matrix<float>();
+    EXPECT_FLOAT_EQ(-(1 * i + 2), mat(0, 0));
+    EXPECT_FLOAT_EQ(-(3 * i + 4), mat(1, 0));
+  }
+}
+
 TEST_F(DirectSessionMinusAXTest, TestConcurrency) {
   Initialize({1, 2, 3, 4});
   auto session = CreateSession();
@@ -1321,5 +1345,140 @@ void BM_FeedFetch(int iters, int num_feeds) {
 
 BENCHMARK(BM_FeedFetch)->Arg(1)->Arg(2)->Arg(5)->Arg(10);
 
+// Returns a graph of 'width' chains of 'depth' Neg nodes on a scalar one,
+// whose ends are summed by a tree of Add nodes into the fetched node.
+GraphDef WideAndDeepGraph(int width, int depth, string* fetch) {
+  Graph g(OpRegistry::Global());
+  Node* one = test::graph::Constant(&g, test::AsScalar<float>(1));
+  std::vector<Node*> ends;
+  for (int w = 0; w < width; ++w) {
+    Node* node = one;
+    for (int d = 0; d < depth; ++d) {
+      node = test::graph::Unary(&g, "Neg", node);
+    }
+    ends.push_back(node);
+  }
+  while (ends.size() > 1) {
+    std::vector<Node*> sums;
+    for (int i = 0; i + 1 < ends.size(); i += 2) {
+      sums.push_back(test::graph::Binary(&g, "Add", ends[i], ends[i + 1]));
+    }
+    if (ends.size() % 2 == 1) sums.push_back(ends.back());
+    ends.swap(sums);
+  }
+  *fetch = ends[0]->name() + ":0";
+  GraphDef def;
+  test::graph::ToGraphDef(&g, &def);
+  return def;
+}
+
+std::unique_ptr<Session> CreateWorkStealingSession() {
+  setenv("TF_EXECUTOR_WORK_STEALING", "true", 1);
+  SessionOptions options;
+  options.config.set_inter_op_parallelism_threads(4);
+  std::unique_ptr<Session> session(NewSession(options));
+  unsetenv("TF_EXECUTOR_WORK_STEALING");
+  return session;
+}
+
+TEST(DirectSessionTest, WorkStealingRunsWideAndDeepGraphs) {
+  for (const auto& shape : std::vector<std::pair<int, int>>{
+           {1, 64}, {64, 1}, {16, 16}, {100, 3}}) {
+    string fetch;
+    const GraphDef def = WideAndDeepGraph(shape.first, shape.second, &fetch);
+    auto session = CreateWorkStealingSession();
+    TF_ASSERT_OK(session->Create(def));
+    for (int i = 0; i < 3; ++i) {
+      std::vector<Tensor> outputs;
+      TF_ASSERT_OK(session->Run({}, {fetch}, {}, &outputs));
+      ASSERT_EQ(1, outputs.size());
+      EXPECT_FLOAT_EQ(shape.second % 2 == 0 ? shape.first : -shape.first,
+                      outputs[0].scalar<float>()());
+    }
+  }
+}
+
+void WideAndDeepGraphBenchmarkHelper(int iters, int width, int depth,
+                                     bool work_stealing) {
+  testing::StopTiming();
+  string fetch;
+  const GraphDef def = WideAndDeepGraph(width, depth, &fetch);
+  std::unique_ptr<Session> session;
+  if (work_stealing) {
+    session = CreateWorkStealingSession();
+  } else {
+    SessionOptions options;
+    options.config.set_inter_op_parallelism_threads(4);
+    session.reset(NewSession(options));
+  }
+  TF_CHECK_OK(session->Create(def));
+  std::vector<Tensor> outputs;
+  // Ignore the first run, which creates the executors.
+  TF_CHECK_OK(session->Run({}, {fetch}, {}, &outputs));
+  testing::ItemsProcessed(static_cast<int64>(iters) * width * depth);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(session->Run({}, {fetch}, {}, &outputs));
+  }
+  testing::StopTiming();
+}
+
+void BM_WideAndDeepGraph(int iters, int width, int depth) {
+  WideAndDeepGraphBenchmarkHelper(iters, width, depth, false);
+}
+
+void BM_WideAndDeepGraphWorkStealing(int iters, int width, int depth) {
+  WideAndDeepGraphBenchmarkHelper(iters, width, depth, true);
+}
+
+BENCHMARK(BM_WideAndDeepGraph)
+    ->ArgPair(1, 256)
+    ->ArgPair(16, 16)
+    ->ArgPair(256, 1)
+    ->ArgPair(64, 64);
+BENCHMARK(BM_WideAndDeepGraphWorkStealing)
+    ->ArgPair(1, 256)
+    ->ArgPair(16, 16)
+    ->ArgPair(256, 1)
+    ->ArgPair(64, 64);
+
+// Runs a graph of 'width' chains of NoOp nodes, 'num_nodes' in total, tied
+// by control edges and joined by one target NoOp. Nearly all of the time
+// of a step is the per-node scheduling overhead of the executor.
+void BM_NoOpGraph(int iters, int num_nodes, int width) {
+  testing::StopTiming();
+  Graph g(OpRegistry::Global());
+  Node* source = test::graph::NoOp(&g, {});
+  std::vector<Node*> ends;
+  const int depth = num_nodes / width;
+  for (int w = 0; w < width; ++w) {
+    Node* node = source;
+    for (int d = 0; d < depth; ++d) {
+      node = test::graph::NoOp(&g, {node});
+    }
+    ends.push_back(node);
+  }
+  const string target = test::graph::NoOp(&g, ends)->name();
+  GraphDef def;
+  test::graph::ToGraphDef(&g, &def);
+  SessionOptions options;
+  options.config.set_inter_op_parallelism_threads(4);
+  std::unique_ptr<Session> session(NewSession(options));
+  TF_CHECK_OK(session->Create(def));
+  // Ignore the first run, which creates the executors.
+  TF_CHECK_OK(session->Run({}, {}, {target}, nullptr));
+  testing::ItemsProcessed(static_cast<int64>(iters) * depth * width);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(session->Run({}, {}, {target}, nullptr));
+  }
+  testing::StopTiming();
+}
+
+BENCHMARK(BM_NoOpGraph)
+    ->ArgPair(100000, 1)
+    ->ArgPair(100000, 100)
+    ->ArgPair(100000, 100000);
+
 }  // namespace
 }  // namespace tensorflow
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/executor.h"
 
 #include <atomic>
+#include <chrono>
 #include <deque>
 #include <memory>
 #include <string>
@@ -43,6 +44,7 @@ limitations under the License.
 #include "tensorflow/core/graph/edgeset.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/gtl/flatmap.h"
 #include "tensorflow/core/lib/gtl/flatset.h"
@@ -125,6 +127,13 @@ bool SetTimelineLabel(const Node* node, NodeExecStatsWrapper* stats) {
 // Helper routines for collecting step stats.
 namespace nodestats {
 inline int64 NowInUsec() { return Env::Default()->NowMicros(); }
+// For the sampled op costs. The cycle counter is not enabled on all
+// platforms, and reading it costs a syscall on Android.
+inline int64 NowInNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
 
 void SetScheduled(NodeExecStatsWrapper* stats, int64 t) {
   if (!stats) return;
@@ -222,6 +231,9 @@ struct NodeItem {
   bool is_sink : 1;              // True iff IsSink(node)
   // True iff IsEnter(node) || IsExit(node) || IsNextIteration(node)
   bool is_enter_exit_or_next_iter : 1;
+  // True iff any of the nodes the node feeds is a Merge or ControlTrigger
+  // node, whose activation does not go through adjust_for_activation().
+  bool is_any_consumer_merge_or_control_trigger : 1;
 
   // Cached values of node->num_inputs() and node->num_outputs(), to
   // avoid levels of indirection.
@@ -237,6 +249,10 @@ struct NodeItem {
 
   PendingCounts::Handle pending_id;
 
+  // The histograms of the op type of the node in
+  // LocalExecutorParams::op_overhead_sampler, if set.
+  OpOverheadSampler::OpStats* op_stats = nullptr;
+
   const EdgeInfo* output_edge_list() const { return output_edge_base(); }
 
   // ith output edge.
@@ -655,6 +671,17 @@ Status ExecutorImpl::Initialize() {
     item->is_sink = IsSink(n);
     item->is_enter_exit_or_next_iter =
         (IsEnter(n) || IsExit(n) || IsNextIteration(n));
+    item->is_any_consumer_merge_or_control_trigger = false;
+    for (const Node* consumer : n->out_nodes()) {
+      if (IsMerge(consumer) || IsControlTrigger(consumer)) {
+        item->is_any_consumer_merge_or_control_trigger = true;
+        break;
+      }
+    }
+    if (params_.op_overhead_sampler != nullptr) {
+      item->op_stats =
+          params_.op_overhead_sampler->GetOpStats(n->type_string());
+    }
 
     // Compute the maximum values we'll store for this node in the
     // pending counts data structure, and allocate a handle in
@@ -896,8 +923,9 @@ class ExecutorState {
     // edge. The latter node is never run concurrently with the former node.
     Entry* input_tensors;
 
-    // The number of outstanding ops for each iteration.
-    size_t outstanding_ops;
+    // The number of outstanding ops for each iteration. Atomic because
+    // ActivateNodesLockFree() adjusts it under a shared lock of the frame.
+    std::atomic<size_t> outstanding_ops;
 
     // The number of outstanding frames for each iteration.
     int outstanding_frame_count;
@@ -925,6 +953,12 @@ class ExecutorState {
       counts_.adjust_for_activation(h, increment_dead, pending_result,
                                     dead_result);
     }
+    void adjust_for_activation_atomic(PendingCounts::Handle h,
+                                      bool increment_dead, int* pending_result,
+                                      int* dead_result) {
+      counts_.adjust_for_activation_atomic(h, increment_dead, pending_result,
+                                           dead_result);
+    }
 
     ~IterationState() { delete[] input_tensors; }
 
@@ -1037,7 +1071,7 @@ class ExecutorState {
     }
 
     inline IterationState* GetIteration(int64 iter)
-        EXCLUSIVE_LOCKS_REQUIRED(mu) {
+        SHARED_LOCKS_REQUIRED(mu) {
       size_t index = iter % iterations.size();
       return iterations[index];
     }
@@ -1063,8 +1097,7 @@ class ExecutorState {
                                               int64 iter, TaggedNodeSeq* ready)
         EXCLUSIVE_LOCKS_REQUIRED(mu) {
       IterationState* istate = GetIteration(iter);
-      istate->outstanding_ops--;
-      if (istate->outstanding_ops != 0) {
+      if (--istate->outstanding_ops != 0) {
         return false;
       } else {
         return CleanupIterations(gview, iter, ready);
@@ -1101,6 +1134,17 @@ class ExecutorState {
                        EntryVector* outputs, TaggedNodeSeq* ready)
         EXCLUSIVE_LOCKS_REQUIRED(mu);
 
+    // Same as ActivateNodes() followed by DecrementOutstandingOpsLocked(),
+    // but only holding 'mu' shared: the pending counts of the successors
+    // are adjusted atomically and so is the outstanding op count of the
+    // iteration. The iteration can only be done once its last outstanding
+    // op is decremented, and that decrement is left to the caller, under
+    // the exclusive lock. Returns true iff the caller must decrement it.
+    // REQUIRES: no successor of the node is a Merge or ControlTrigger node.
+    bool ActivateNodesLockFree(const NodeItem* item, const bool is_dead,
+                               int64 iter, EntryVector* outputs,
+                               TaggedNodeSeq* ready) SHARED_LOCKS_REQUIRED(mu);
+
     // Cleanup iterations of this frame starting from iteration iter.
     bool CleanupIterations(const GraphView* gview, int64 iter,
                            TaggedNodeSeq* ready) EXCLUSIVE_LOCKS_REQUIRED(mu);
@@ -1165,6 +1209,7 @@ class ExecutorState {
   };
 
   struct AsyncState;
+  class WorkQueues;
 
   const bool vlog_;  // true if VLOG_IS_ON(1). Used to check vlog cheaply.
 
@@ -1187,8 +1232,13 @@ class ExecutorState {
   CancellationManager* cancellation_manager_;
   Executor::Args::Runner runner_;
   bool sync_on_finish_;
+  StepMemoryPlanner::Step* memory_plan_step_;
+  // True if the costs of the nodes of this step go to the histograms of
+  // the OpOverheadSampler of the executor.
+  const bool sample_;
 
-  // Owned.
+  // Owned. Set if the step is scheduled with work stealing.
+  WorkQueues* work_queues_ = nullptr;
 
   // A flag that is set on error after the frame state has been
   // dumped for diagnostic purposes.
@@ -1245,6 +1295,9 @@ class ExecutorState {
   Status ProcessOutputs(const NodeItem& item, OpKernelContext* ctx,
                         EntryVector* outputs, NodeExecStatsWrapper* stats);
 
+  // Adds the bytes of 'outputs' to the histograms of the op of 'item'.
+  void SampleOutputBytes(const NodeItem& item, const EntryVector& outputs);
+
   // After processing the outputs, propagates the outputs to their dsts.
   // Contents of *outputs are left in an indeterminate state after
   // returning from this method.
@@ -1291,6 +1344,190 @@ class ExecutorState {
   }
 };
 
+// The ready nodes of a step scheduled with work stealing. Each worker is a
+// closure of the step's runner that owns a deque of ready nodes. The
+// expensive successors of a node that do not run inline are pushed to the
+// front of the deque of the worker that ran it, which pops them next while
+// their inputs are still in its cache; idle workers steal from the back of
+// the other deques. Nodes made ready outside of a worker go to a shared
+// deque. Workers are added while nodes are queued, up to one per thread of
+// the runner, and retire when they find no node to run.
+//
+// Refcounted, since workers may still look for nodes after the last one
+// finished and deleted the ExecutorState.
+class ExecutorState::WorkQueues : public core::RefCounted {
+ public:
+  WorkQueues(ExecutorState* state, int max_workers,
+             Executor::Args::Runner runner)
+      : state_(state),
+        max_workers_(max_workers),
+        runner_(std::move(runner)),
+        deques_(new Deque[max_workers + 1]) {}
+
+  // Queues the expensive nodes in 'ready', and puts the inexpensive ones
+  // into 'inline_ready' if it is not null and the caller is a worker.
+  void Schedule(const TaggedNodeSeq& ready, TaggedNodeReadyQueue* inline_ready,
+                int64 scheduled_usec);
+
+ private:
+  struct ReadyNode {
+    TaggedNode tagged_node;
+    int64 scheduled_usec;
+  };
+  struct Deque {
+    mutex mu;
+    std::deque<ReadyNode> nodes GUARDED_BY(mu);
+    // True while a worker owns the deque.
+    std::atomic<bool> owned{false};
+  };
+  // The deque of the worker running on the current thread, if any.
+  struct CurrentWorker {
+    const WorkQueues* queues;
+    int index;
+  };
+  static thread_local CurrentWorker current_worker_;
+
+  // Runs ready nodes until there are none left to run or steal.
+  void WorkerLoop();
+  // Adds a worker if there are less than 'max_workers_'.
+  bool TryAddWorker();
+  void MaybeAddWorkers(int num_nodes);
+  int OwnDeque();
+  bool Steal(int index, ReadyNode* node);
+
+  ExecutorState* const state_;  // Valid while nodes are outstanding.
+  const int max_workers_;
+  const Executor::Args::Runner runner_;
+  // The deques of the workers, then the shared deque.
+  const std::unique_ptr<Deque[]> deques_;
+  std::atomic<int> num_workers_{0};
+  std::atomic<int64> num_queued_{0};
+};
+
+thread_local ExecutorState::WorkQueues::CurrentWorker
+    ExecutorState::WorkQueues::current_worker_ = {nullptr, -1};
+
+void ExecutorState::WorkQueues::Schedule(const TaggedNodeSeq& ready,
+                                         TaggedNodeReadyQueue* inline_ready,
+                                         int64 scheduled_usec) {
+  const int index =
+      current_worker_.queues == this ? current_worker_.index : max_workers_;
+  Deque& deque = deques_[index];
+  int num_queued = 0;
+  if (inline_ready == nullptr || index == max_workers_) {
+    mutex_lock l(deque.mu);
+    for (auto& tagged_node : ready) {
+      deque.nodes.push_back({tagged_node, scheduled_usec});
+    }
+    num_queued = ready.size();
+  } else {
+    const GraphView& gview = state_->impl_->gview_;
+    const TaggedNode* curr_expensive_node = nullptr;
+    mutex_lock l(deque.mu);
+    for (auto& tagged_node : ready) {
+      const NodeItem& item = *gview.node(tagged_node.node->id());
+      if (tagged_node.is_dead || !item.kernel_is_expensive) {
+        inline_ready->push_back(tagged_node);
+      } else {
+        if (curr_expensive_node) {
+          deque.nodes.push_front({*curr_expensive_node, scheduled_usec});
+          ++num_queued;
+        }
+        curr_expensive_node = &tagged_node;
+      }
+    }
+    if (curr_expensive_node) {
+      if (inline_ready->empty()) {
+        inline_ready->push_back(*curr_expensive_node);
+      } else {
+        deque.nodes.push_front({*curr_expensive_node, scheduled_usec});
+        ++num_queued;
+      }
+    }
+  }
+  if (num_queued > 0) {
+    num_queued_ += num_queued;
+    MaybeAddWorkers(num_queued);
+  }
+}
+
+bool ExecutorState::WorkQueues::TryAddWorker() {
+  int num_workers = num_workers_.load();
+  while (num_workers < max_workers_) {
+    if (num_workers_.compare_exchange_weak(num_workers, num_workers + 1)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ExecutorState::WorkQueues::MaybeAddWorkers(int num_nodes) {
+  for (int i = 0; i < num_nodes && TryAddWorker(); ++i) {
+    Ref();
+    runner_([this]() {
+      WorkerLoop();
+      Unref();
+    });
+  }
+}
+
+int ExecutorState::WorkQueues::OwnDeque() {
+  // There is a free deque for every worker.
+  for (int i = 0;; i = (i + 1) % max_workers_) {
+    if (!deques_[i].owned.load(std::memory_order_relaxed) &&
+        !deques_[i].owned.exchange(true)) {
+      return i;
+    }
+  }
+}
+
+bool ExecutorState::WorkQueues::Steal(int index, ReadyNode* node) {
+  for (int i = 1; i <= max_workers_; ++i) {
+    Deque& victim = deques_[(index + i) % (max_workers_ + 1)];
+    mutex_lock l(victim.mu);
+    if (!victim.nodes.empty()) {
+      *node = victim.nodes.back();
+      victim.nodes.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
+
+void ExecutorState::WorkQueues::WorkerLoop() {
+  // Runners may run closures inline, in the loop of another worker.
+  const CurrentWorker outer = current_worker_;
+  int index = OwnDeque();
+  current_worker_ = {this, index};
+  ReadyNode node{TaggedNode(nullptr, nullptr, -1, false), 0};
+  while (true) {
+    bool found = false;
+    {
+      Deque& deque = deques_[index];
+      mutex_lock l(deque.mu);
+      if (!deque.nodes.empty()) {
+        node = deque.nodes.front();
+        deque.nodes.pop_front();
+        found = true;
+      }
+    }
+    if (found || Steal(index, &node)) {
+      --num_queued_;
+      // The step is not done while 'node' is outstanding.
+      state_->Process(node.tagged_node, node.scheduled_usec);
+      continue;
+    }
+    // Retire. Schedule() counts its nodes before it adds workers, so either
+    // it sees this worker gone or this worker sees its nodes.
+    deques_[index].owned = false;
+    --num_workers_;
+    if (num_queued_.load() <= 0 || !TryAddWorker()) break;
+    index = OwnDeque();
+    current_worker_ = {this, index};
+  }
+  current_worker_ = outer;
+}
+
 ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
     : vlog_(VLOG_IS_ON(1)),
       log_memory_(LogMemory::IsEnabled()),
@@ -1306,7 +1543,14 @@ ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
       cancellation_manager_(args.cancellation_manager),
       runner_(args.runner),
       sync_on_finish_(args.sync_on_finish),
+      memory_plan_step_(args.memory_plan_step),
+      sample_(impl->params_.op_overhead_sampler != nullptr &&
+              impl->params_.op_overhead_sampler->ShouldSampleStep()),
       num_outstanding_ops_(0) {
+  if (args.work_stealing_workers > 0) {
+    work_queues_ =
+        new WorkQueues(this, args.work_stealing_workers, args.runner);
+  }
   // We start the entire execution in iteration 0 of the root frame
   // so let us create the root frame and the state for iteration 0.
   // We assume root_frame_->frame_name.empty().
@@ -1330,6 +1574,7 @@ ExecutorState::~ExecutorState() {
     it->Unref();
   }
   delete slice_reader_cache_;
+  if (work_queues_ != nullptr) work_queues_->Unref();
 }
 
 Status ExecutorImpl::BuildControlFlowInfo(const Graph* g,
@@ -1478,6 +1723,8 @@ struct ExecutorState::AsyncState {
   Entry* first_input;
   OpKernelContext ctx;
   NodeExecStatsWrapper* stats;
+  // The time at which the kernel started, if the step is sampled.
+  int64 compute_start_nanos = 0;
 
  private:
   OpKernelContext::Params* ParamsButClearingEigenGPUDevice(
@@ -1547,6 +1794,7 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
     }
 
     params.track_allocations = false;
+    params.planned_allocator = nullptr;
     stats = nullptr;
     if (stats_collector_ && !tagged_node.is_dead) {
       // track allocations if and only if we are collecting statistics
@@ -1556,6 +1804,10 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
       nodestats::SetScheduled(stats, scheduled_usec);
       nodestats::SetAllStart(stats);
     }
+    if (sample_) {
+      OpOverheadSampler::Record(item.op_stats, OpOverheadSampler::kQueueMicros,
+                                nodestats::NowInUsec() - scheduled_usec);
+    }
 
     if (vlog_) {
       VLOG(1) << "Process node: " << id << " step " << params.step_id << " "
@@ -1577,8 +1829,14 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
     } else {
       // Prepares inputs.
       bool is_input_dead = false;
+      const int64 prepare_start_nanos = sample_ ? nodestats::NowInNanos() : 0;
       s = PrepareInputs(item, first_input, &inputs, &input_device_contexts,
                         &input_alloc_attrs, &is_input_dead);
+      if (sample_) {
+        OpOverheadSampler::Record(
+            item.op_stats, OpOverheadSampler::kInputPrepNanos,
+            nodestats::NowInNanos() - prepare_start_nanos);
+      }
       if (!s.ok()) {
         // Clear inputs.
         int num_inputs = item.num_inputs;
@@ -1597,6 +1855,12 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
       params.frame_iter = FrameAndIter(input_frame->frame_id, input_iter);
       params.is_input_dead = is_input_dead;
       params.output_attr_array = item.output_attrs();
+      StepMemoryPlanner::NodeAllocator* planned_allocator = nullptr;
+      if (memory_plan_step_ != nullptr) {
+        planned_allocator =
+            StepMemoryPlanner::NewNodeAllocator(memory_plan_step_, id);
+        params.planned_allocator = planned_allocator;
+      }
 
       if (item.kernel_is_async) {
         // Asynchronous computes.
@@ -1606,15 +1870,22 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
         AsyncState* state =
             new AsyncState(params, tagged_node, &item, first_input, stats);
 
-        auto done = [this, state]() {
+        auto done = [this, state, planned_allocator]() {
           Device* device = impl_->params_.device;
           NodeExecStatsWrapper* stats = state->stats;  // Shorthand
           Entry* first_input = state->first_input;     // Shorthand
 
           nodestats::SetOpEnd(stats);
+          if (sample_) {
+            OpOverheadSampler::Record(
+                state->item->op_stats, OpOverheadSampler::kComputeNanos,
+                nodestats::NowInNanos() - state->compute_start_nanos);
+          }
           EntryVector outputs;
           Status s = ProcessOutputs(*state->item, &state->ctx, &outputs, stats);
+          if (sample_ && s.ok()) SampleOutputBytes(*state->item, outputs);
           nodestats::SetMemory(stats, &state->ctx);
+          if (planned_allocator != nullptr) planned_allocator->Finish();
           if (vlog_) {
             VLOG(2) << "Async kernel done: " << state->item->node->id()
                     << " step " << step_id_ << " "
@@ -1651,20 +1922,29 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
           if (completed) Finish();
         };
         nodestats::SetOpStart(stats);
+        if (sample_) state->compute_start_nanos = nodestats::NowInNanos();
         device->ComputeAsync(async, &state->ctx, done);
       } else {
         // Synchronous computes.
         OpKernelContext ctx(&params, item.num_outputs);
         nodestats::SetOpStart(stats);
+        const int64 compute_start_nanos = sample_ ? nodestats::NowInNanos() : 0;
         device->Compute(CHECK_NOTNULL(op_kernel), &ctx);
         nodestats::SetOpEnd(stats);
+        if (sample_) {
+          OpOverheadSampler::Record(
+              item.op_stats, OpOverheadSampler::kComputeNanos,
+              nodestats::NowInNanos() - compute_start_nanos);
+        }
         s = ProcessOutputs(item, &ctx, &outputs, stats);
+        if (sample_ && s.ok()) SampleOutputBytes(item, outputs);
         if (s.ok() && impl_->device_record_tensor_accesses_) {
           // Get the list of all tensors accessed during the execution
           ctx.retrieve_accessed_tensors(&accessed_tensors);
           device_context = ctx.op_device_context();
         }
         nodestats::SetMemory(stats, &ctx);
+        if (planned_allocator != nullptr) planned_allocator->Finish();
       }
     }
 
@@ -1691,7 +1971,7 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
         // device_context is set above in synchronous computes
         device->ConsumeListOfAccessedTensors(device_context, accessed_tensors);
       }
-      if (stats) {
+      if (stats || sample_) {
         scheduled_usec = nodestats::NowInUsec();
       }
       // Postprocess.
@@ -1929,6 +2209,19 @@ Status ExecutorState::ProcessOutputs(const NodeItem& item, OpKernelContext* ctx,
   return s;
 }
 
+void ExecutorState::SampleOutputBytes(const NodeItem& item,
+                                      const EntryVector& outputs) {
+  int64 bytes = 0;
+  for (const Entry& output : outputs) {
+    // Reference outputs are not allocated by the kernel, and may be
+    // reassigned concurrently.
+    if (!output.has_value || output.ref != nullptr) continue;
+    bytes += output.val->TotalBytes();
+  }
+  OpOverheadSampler::Record(item.op_stats, OpOverheadSampler::kOutputBytes,
+                            bytes);
+}
+
 void ExecutorState::PropagateOutputs(const TaggedNode& tagged_node,
                                      const NodeItem* item, EntryVector* outputs,
                                      TaggedNodeSeq* ready) {
@@ -1947,11 +2240,28 @@ void ExecutorState::PropagateOutputs(const TaggedNode& tagged_node,
   if (!item->is_enter_exit_or_next_iter) {
     // Fast path for nodes types that don't need special handling
     DCHECK_EQ(input_frame, output_frame);
-    // Normal path for most nodes
-    mutex_lock l(input_frame->mu);
-    output_frame->ActivateNodes(item, is_dead, output_iter, outputs, ready);
-    is_frame_done = input_frame->DecrementOutstandingOpsLocked(
-        &impl_->gview_, input_iter, ready);
+    if (input_frame == root_frame_ &&
+        !item->is_any_consumer_merge_or_control_trigger) {
+      // Outside of loops, the frame lock is only needed exclusively to
+      // clean up and delete the frame.
+      bool decrement_locked;
+      {
+        tf_shared_lock l(input_frame->mu);
+        decrement_locked = output_frame->ActivateNodesLockFree(
+            item, is_dead, output_iter, outputs, ready);
+      }
+      if (decrement_locked) {
+        mutex_lock l(input_frame->mu);
+        is_frame_done = input_frame->DecrementOutstandingOpsLocked(
+            &impl_->gview_, input_iter, ready);
+      }
+    } else {
+      // Normal path for most nodes
+      mutex_lock l(input_frame->mu);
+      output_frame->ActivateNodes(item, is_dead, output_iter, outputs, ready);
+      is_frame_done = input_frame->DecrementOutstandingOpsLocked(
+          &impl_->gview_, input_iter, ready);
+    }
   } else if (item->is_enter) {
     bool is_constant;
     const Status s = GetNodeAttr(node->attrs(), "is_constant", &is_constant);
@@ -2086,9 +2396,13 @@ void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
   if (ready.empty()) return;
 
   int64 scheduled_usec = 0;
-  if (stats_collector_) {
+  if (stats_collector_ || sample_) {
     scheduled_usec = nodestats::NowInUsec();
   }
+  if (work_queues_ != nullptr) {
+    work_queues_->Schedule(ready, inline_ready, scheduled_usec);
+    return;
+  }
   if (inline_ready == nullptr) {
     // Schedule to run all the ready ops in thread pool.
     for (auto& tagged_node : ready) {
@@ -2503,6 +2817,68 @@ void ExecutorState::FrameState::ActivateNodes(const NodeItem* item,
   }
 }
 
+bool ExecutorState::FrameState::ActivateNodesLockFree(const NodeItem* item,
+                                                      const bool is_dead,
+                                                      int64 iter,
+                                                      EntryVector* outputs,
+                                                      TaggedNodeSeq* ready) {
+  const GraphView& gview = executor->gview_;
+  IterationState* iter_state = GetIteration(iter);
+  const size_t num_output_edges = item->num_output_edges;
+  const EdgeInfo* edges = item->output_edge_list();
+  Entry* input_tensors = iter_state->input_tensors;
+  for (size_t out_index = 0; out_index < num_output_edges; out_index++) {
+    const EdgeInfo& e = edges[out_index];
+    const int dst_id = e.dst_id;
+    const NodeItem* dst_item = gview.node(dst_id);
+    const int src_slot = e.output_slot;
+    if (dst_item->is_sink) continue;
+    DCHECK(!dst_item->is_merge && !dst_item->is_control_trigger);
+
+    const bool is_control_edge = (src_slot == Graph::kControlSlot);
+    const bool increment_dead =
+        (is_dead || (!is_control_edge && !(*outputs)[src_slot].has_value));
+    // The input is written before the pending count is decremented: the
+    // thread that brings the count to zero schedules dst and acquires
+    // every input written by the other producers.
+    if (!is_control_edge) {
+      const int dst_loc = dst_item->input_start + e.input_slot;
+      if (e.is_last) {
+        input_tensors[dst_loc] = std::move((*outputs)[src_slot]);
+      } else {
+        input_tensors[dst_loc] = (*outputs)[src_slot];
+      }
+    }
+
+    int pending, dead;
+    iter_state->adjust_for_activation_atomic(dst_item->pending_id,
+                                             increment_dead, &pending, &dead);
+    if (pending == 0) {
+      ready->push_back(TaggedNode(dst_item->node, this, iter, dead > 0));
+    }
+  }
+
+  // Account for the ready successors and the completion of the node at
+  // once. This never brings the count to zero while other ops of the
+  // iteration may still run: the node holds one of its ops.
+  const size_t num_ready = ready->size();
+  if (num_ready > 0) {
+    iter_state->outstanding_ops.fetch_add(num_ready - 1,
+                                          std::memory_order_relaxed);
+    return false;
+  }
+  size_t outstanding = iter_state->outstanding_ops.load(
+      std::memory_order_relaxed);
+  while (outstanding > 1) {
+    if (iter_state->outstanding_ops.compare_exchange_weak(
+            outstanding, outstanding - 1, std::memory_order_relaxed)) {
+      return false;
+    }
+  }
+  // This may be the last op of the iteration.
+  return true;
+}
+
 void ExecutorState::FrameState::ActivateNexts(const GraphView* gview,
                                               int64 iter,
                                               TaggedNodeSeq* ready) {
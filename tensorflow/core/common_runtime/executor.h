@@ -17,6 +17,8 @@ limitations under the License.
 #define TENSORFLOW_COMMON_RUNTIME_EXECUTOR_H_
 
 #include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/op_overhead_sampler.h"
+#include "tensorflow/core/common_runtime/step_memory_planner.h"
 #include "tensorflow/core/framework/rendezvous.h"
 #include "tensorflow/core/framework/session_state.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -93,10 +95,19 @@ class Executor {
     // If true, calls Sync() on the device.
     bool sync_on_finish = false;
 
+    // If set, the kernels allocate from the memory planned for this step
+    // instead of the default allocator of the device.
+    StepMemoryPlanner::Step* memory_plan_step = nullptr;
+
     typedef std::function<void()> Closure;
     typedef std::function<void(Closure)> Runner;
     Runner runner = nullptr;
 
+    // If > 0, the ready nodes of the step are queued per worker, and at
+    // most this many closures of 'runner' run them, stealing nodes from
+    // each other, instead of one closure per expensive node.
+    int work_stealing_workers = 0;
+
     // A callback that is invoked each time a node has finished executing.
     typedef std::function<Status(const string& node_name, const int output_slot,
                                  const Tensor* tensor, const bool is_ref,
@@ -141,6 +152,10 @@ struct LocalExecutorParams {
   std::function<void(OpKernel*)> delete_kernel;
 
   Executor::Args::NodeOutputsCallback node_outputs_cb;
+
+  // If set, the executor adds the costs of the nodes of the steps it
+  // samples to its histograms. Not owned; must outlive the executor.
+  OpOverheadSampler* op_overhead_sampler = nullptr;
 };
 ::tensorflow::Status NewLocalExecutor(const LocalExecutorParams& params,
                                       const Graph* graph, Executor** executor);
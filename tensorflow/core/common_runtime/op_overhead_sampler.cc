@@ -0,0 +1,166 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/op_overhead_sampler.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/lib/core/bits.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+
+OpOverheadSampler::Histogram::Histogram() { Clear(); }
+
+void OpOverheadSampler::Histogram::Add(int64 value) {
+  if (value < 0) value = 0;
+  const int bucket = value == 0 ? 0 : Log2Floor64(value) + 1;
+  buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+  int64 max = max_.load(std::memory_order_relaxed);
+  while (value > max &&
+         !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+  }
+}
+
+void OpOverheadSampler::Histogram::Clear() {
+  for (int i = 0; i < kNumBuckets; ++i) {
+    buckets_[i].store(0, std::memory_order_relaxed);
+  }
+  sum_.store(0, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
+
+int64 OpOverheadSampler::Histogram::count() const {
+  int64 count = 0;
+  for (int i = 0; i < kNumBuckets; ++i) {
+    count += buckets_[i].load(std::memory_order_relaxed);
+  }
+  return count;
+}
+
+int64 OpOverheadSampler::Histogram::Percentile(double fraction) const {
+  int64 counts[kNumBuckets];
+  int64 total = 0;
+  for (int i = 0; i < kNumBuckets; ++i) {
+    counts[i] = buckets_[i].load(std::memory_order_relaxed);
+    total += counts[i];
+  }
+  if (total == 0) return 0;
+  const double threshold = fraction * total;
+  int64 cumulative = 0;
+  for (int i = 0; i < kNumBuckets; ++i) {
+    cumulative += counts[i];
+    if (cumulative >= threshold && counts[i] > 0) {
+      if (i == 0) return 0;
+      // The max is a tighter bound for the last bucket.
+      return std::min(max(),
+                      static_cast<int64>((static_cast<uint64>(1) << i) - 1));
+    }
+  }
+  return max();
+}
+
+OpOverheadSampler::OpOverheadSampler(int64 sample_every_n_steps)
+    : sample_every_n_steps_(sample_every_n_steps) {}
+
+OpOverheadSampler::~OpOverheadSampler() {}
+
+/* static */ OpOverheadSampler* OpOverheadSampler::Global() {
+  static OpOverheadSampler* sampler = []() {
+    int64 sample_every_n_steps = 0;
+    const Status status = ReadInt64FromEnvVar(
+        "TF_EXECUTOR_SAMPLE_EVERY_N_STEPS", 0, &sample_every_n_steps);
+    if (!status.ok()) {
+      LOG(ERROR) << status.error_message();
+    }
+    return new OpOverheadSampler(sample_every_n_steps);
+  }();
+  return sampler;
+}
+
+OpOverheadSampler::OpStats* OpOverheadSampler::GetOpStats(
+    const string& op_type) {
+  mutex_lock l(mu_);
+  std::unique_ptr<OpStats>& stats = op_stats_[op_type];
+  if (stats == nullptr) {
+    stats.reset(new OpStats(op_type));
+  }
+  return stats.get();
+}
+
+string OpOverheadSampler::DebugString() {
+  std::vector<const OpStats*> sorted;
+  {
+    mutex_lock l(mu_);
+    for (const auto& it : op_stats_) {
+      for (int m = 0; m < kNumMetrics; ++m) {
+        if (it.second->histograms[m].count() > 0) {
+          sorted.push_back(it.second.get());
+          break;
+        }
+      }
+    }
+  }
+  std::sort(sorted.begin(), sorted.end(),
+            [](const OpStats* a, const OpStats* b) {
+              return a->histograms[kComputeNanos].sum() >
+                     b->histograms[kComputeNanos].sum();
+            });
+
+  // Times are shown in microseconds.
+  const char* metric_names[kNumMetrics] = {"queue_us", "input_prep_us",
+                                           "compute_us", "output_bytes"};
+  const double scales[kNumMetrics] = {1.0, 1e-3, 1e-3, 1.0};
+
+  const int64 num_steps = num_steps_.load(std::memory_order_relaxed);
+  const int64 num_sampled =
+      sample_every_n_steps_ > 0
+          ? (num_steps + sample_every_n_steps_ - 1) / sample_every_n_steps_
+          : 0;
+  string out = strings::Printf(
+      "Sampled %lld of %lld steps\n%-24s %-18s %12s %12s %12s %12s %12s\n",
+      static_cast<long long>(num_sampled), static_cast<long long>(num_steps),
+      "Op type", "Metric", "Count", "Mean", "P50", "P99", "Max");
+  for (const OpStats* stats : sorted) {
+    for (int m = 0; m < kNumMetrics; ++m) {
+      const Histogram& h = stats->histograms[m];
+      const int64 count = h.count();
+      if (count == 0) continue;
+      const double scale = scales[m];
+      strings::Appendf(
+          &out, "%-24s %-18s %12lld %12.1f %12.1f %12.1f %12.1f\n",
+          stats->op_type.c_str(), metric_names[m],
+          static_cast<long long>(count), scale * h.sum() / count,
+          scale * h.Percentile(0.5), scale * h.Percentile(0.99),
+          scale * h.max());
+    }
+  }
+  return out;
+}
+
+void OpOverheadSampler::Clear() {
+  mutex_lock l(mu_);
+  for (const auto& it : op_stats_) {
+    for (int m = 0; m < kNumMetrics; ++m) {
+      it.second->histograms[m].Clear();
+    }
+  }
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,142 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_OP_OVERHEAD_SAMPLER_H_
+#define TENSORFLOW_COMMON_RUNTIME_OP_OVERHEAD_SAMPLER_H_
+
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Keeps histograms of the per-node costs of the executor, by op type, for
+// one in N steps.
+//
+// Unlike a StepStatsCollector, which builds a NodeExecStats proto for every
+// node of a traced step, the sampler only adds the costs of each node of a
+// sampled step to fixed histograms with relaxed atomics. Unsampled steps
+// only pay for a branch per node, so the sampler can stay on in production.
+//
+// The executor samples the steps of one executor independently of other
+// executors; a step of a DirectSession with several partitions may be
+// sampled in some partitions only.
+class OpOverheadSampler {
+ public:
+  // Samples one in 'sample_every_n_steps' steps, or none if it is not
+  // positive.
+  explicit OpOverheadSampler(int64 sample_every_n_steps);
+  ~OpOverheadSampler();
+
+  // Returns the sampler of the process, which samples one in
+  // $TF_EXECUTOR_SAMPLE_EVERY_N_STEPS steps, and none by default.
+  static OpOverheadSampler* Global();
+
+  int64 sample_every_n_steps() const { return sample_every_n_steps_; }
+
+  // Returns true if the step about to start should be sampled.
+  bool ShouldSampleStep() {
+    if (sample_every_n_steps_ <= 0) return false;
+    const int64 step = num_steps_.fetch_add(1, std::memory_order_relaxed);
+    return step % sample_every_n_steps_ == 0;
+  }
+
+  enum Metric {
+    // From the node being ready to the start of its processing on a
+    // thread, in microseconds.
+    kQueueMicros = 0,
+    // Gathering the inputs of the node, in nanoseconds.
+    kInputPrepNanos,
+    // The kernel, until the done callback of asynchronous kernels, in
+    // nanoseconds.
+    kComputeNanos,
+    // The bytes of the outputs produced by the kernel, other than
+    // references. The executor does not track the allocations of kernels
+    // outside of traced steps, so the temporary memory of a kernel is not
+    // included.
+    kOutputBytes,
+    kNumMetrics
+  };
+
+  // Lock-free histogram of non-negative values with power of two buckets.
+  class Histogram {
+   public:
+    // Bucket 0 counts 0, and bucket i > 0 counts [2^(i-1), 2^i).
+    static const int kNumBuckets = 64;
+
+    Histogram();
+
+    void Add(int64 value);
+    void Clear();
+
+    int64 count() const;
+    int64 sum() const { return sum_.load(std::memory_order_relaxed); }
+    int64 max() const { return max_.load(std::memory_order_relaxed); }
+    // Returns the upper bound of the bucket of the value at 'fraction' of
+    // the histogram, or 0 if it is empty.
+    int64 Percentile(double fraction) const;
+
+   private:
+    std::atomic<int64> buckets_[kNumBuckets];
+    std::atomic<int64> sum_;
+    std::atomic<int64> max_;
+
+    TF_DISALLOW_COPY_AND_ASSIGN(Histogram);
+  };
+
+  struct OpStats {
+    explicit OpStats(const string& op_type) : op_type(op_type) {}
+
+    const string op_type;
+    Histogram histograms[kNumMetrics];
+  };
+
+  // Returns the histograms of 'op_type', which live as long as the sampler.
+  // Takes a lock: executors look up their op types once, when they are
+  // created.
+  OpStats* GetOpStats(const string& op_type) LOCKS_EXCLUDED(mu_);
+
+  // Adds 'value' to the 'metric' histogram of 'stats'.
+  static void Record(OpStats* stats, Metric metric, int64 value) {
+    stats->histograms[metric].Add(value);
+  }
+
+  // Returns the histograms of all op types, those with the most compute
+  // time first, with times converted to microseconds. May be called at any
+  // time, while steps are sampled.
+  string DebugString() LOCKS_EXCLUDED(mu_);
+
+  // Clears all histograms.
+  void Clear() LOCKS_EXCLUDED(mu_);
+
+ private:
+  const int64 sample_every_n_steps_;
+  std::atomic<int64> num_steps_{0};
+
+  mutex mu_;
+  std::unordered_map<string, std::unique_ptr<OpStats>> op_stats_
+      GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(OpOverheadSampler);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_OP_OVERHEAD_SAMPLER_H_
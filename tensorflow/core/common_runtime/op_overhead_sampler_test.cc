@@ -0,0 +1,102 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/op_overhead_sampler.h"
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(OpOverheadSamplerTest, SamplesOneInNSteps) {
+  OpOverheadSampler sampler(4);
+  int num_sampled = 0;
+  for (int i = 0; i < 12; ++i) {
+    if (sampler.ShouldSampleStep()) ++num_sampled;
+  }
+  EXPECT_EQ(3, num_sampled);
+
+  OpOverheadSampler disabled(0);
+  for (int i = 0; i < 12; ++i) {
+    EXPECT_FALSE(disabled.ShouldSampleStep());
+  }
+}
+
+TEST(OpOverheadSamplerTest, HistogramPercentiles) {
+  OpOverheadSampler::Histogram h;
+  EXPECT_EQ(0, h.Percentile(0.5));
+  for (int i = 0; i < 98; ++i) h.Add(10);
+  h.Add(0);
+  h.Add(1000);
+  EXPECT_EQ(100, h.count());
+  EXPECT_EQ(98 * 10 + 1000, h.sum());
+  EXPECT_EQ(1000, h.max());
+  // 10 is in the bucket [8, 16).
+  EXPECT_EQ(15, h.Percentile(0.5));
+  EXPECT_EQ(15, h.Percentile(0.99));
+  EXPECT_EQ(1000, h.Percentile(1.0));
+  EXPECT_EQ(0, h.Percentile(0.0));
+  h.Clear();
+  EXPECT_EQ(0, h.count());
+  EXPECT_EQ(0, h.max());
+}
+
+TEST(OpOverheadSamplerTest, OpStatsAreSharedByOpType) {
+  OpOverheadSampler sampler(1);
+  OpOverheadSampler::OpStats* matmul = sampler.GetOpStats("MatMul");
+  EXPECT_EQ(matmul, sampler.GetOpStats("MatMul"));
+  EXPECT_NE(matmul, sampler.GetOpStats("Add"));
+  EXPECT_EQ("MatMul", matmul->op_type);
+
+  OpOverheadSampler::Record(matmul, OpOverheadSampler::kOutputBytes, 4096);
+  OpOverheadSampler::Record(matmul, OpOverheadSampler::kComputeNanos, 100);
+  const string dump = sampler.DebugString();
+  EXPECT_NE(string::npos, dump.find("MatMul"));
+  EXPECT_NE(string::npos, dump.find("output_bytes"));
+  // Op types without samples are left out.
+  EXPECT_EQ(string::npos, dump.find("Add"));
+
+  sampler.Clear();
+  EXPECT_EQ(0, matmul->histograms[OpOverheadSampler::kOutputBytes].count());
+}
+
+TEST(OpOverheadSamplerTest, ConcurrentRecords) {
+  OpOverheadSampler sampler(1);
+  OpOverheadSampler::OpStats* stats = sampler.GetOpStats("Neg");
+  const int kNumThreads = 8;
+  const int kRecordsPerThread = 10000;
+  {
+    thread::ThreadPool pool(Env::Default(), "test", kNumThreads);
+    for (int t = 0; t < kNumThreads; ++t) {
+      pool.Schedule([stats, t]() {
+        for (int i = 0; i < kRecordsPerThread; ++i) {
+          OpOverheadSampler::Record(stats, OpOverheadSampler::kQueueMicros,
+                                    t);
+        }
+      });
+    }
+  }
+  const OpOverheadSampler::Histogram& h =
+      stats->histograms[OpOverheadSampler::kQueueMicros];
+  EXPECT_EQ(kNumThreads * kRecordsPerThread, h.count());
+  EXPECT_EQ(kRecordsPerThread * (kNumThreads * (kNumThreads - 1) / 2),
+            h.sum());
+  EXPECT_EQ(kNumThreads - 1, h.max());
+}
+
+}  // namespace
+}  // namespace tensorflow
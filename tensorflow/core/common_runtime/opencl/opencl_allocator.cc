@@ -0,0 +1,84 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/opencl/opencl_allocator.h"
+
+namespace tensorflow {
+
+OpenCLAllocator::OpenCLAllocator(clMatMulRuntime* runtime)
+    : runtime_(runtime) {
+  stats_.bytes_limit = runtime->maxMemAllocSize();
+}
+
+OpenCLAllocator::~OpenCLAllocator() {}
+
+string OpenCLAllocator::Name() { return "device:OPENCL"; }
+
+void* OpenCLAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
+  // cl_mem objects are aligned to CL_DEVICE_MEM_BASE_ADDR_ALIGN by the
+  // driver, alignment doesn't apply to the handle returned here.
+  cl_mem buffer = runtime_->bufferPool()->get(CL_MEM_READ_WRITE, num_bytes);
+  if (buffer == NULL) {
+    return nullptr;
+  }
+  void* ptr = static_cast<void*>(buffer);
+
+  mutex_lock lock(mu_);
+  requested_sizes_[ptr] = num_bytes;
+  ++stats_.num_allocs;
+  stats_.bytes_in_use += num_bytes;
+  stats_.max_bytes_in_use =
+      std::max<int64>(stats_.max_bytes_in_use, stats_.bytes_in_use);
+  stats_.max_alloc_size =
+      std::max<int64>(stats_.max_alloc_size, num_bytes);
+  return ptr;
+}
+
+void OpenCLAllocator::DeallocateRaw(void* ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+  {
+    mutex_lock lock(mu_);
+    auto it = requested_sizes_.find(ptr);
+    if (it != requested_sizes_.end()) {
+      stats_.bytes_in_use -= it->second;
+      requested_sizes_.erase(it);
+    }
+  }
+  // Commands reading or writing the buffer are already enqueued on the
+  // in-order queue, so it can be reused right away
+  runtime_->bufferPool()->put(static_cast<cl_mem>(ptr));
+}
+
+size_t OpenCLAllocator::RequestedSize(void* ptr) {
+  mutex_lock lock(mu_);
+  auto it = requested_sizes_.find(ptr);
+  return it == requested_sizes_.end() ? 0 : it->second;
+}
+
+void OpenCLAllocator::GetStats(AllocatorStats* stats) {
+  mutex_lock lock(mu_);
+  *stats = stats_;
+}
+
+void OpenCLAllocator::ClearStats() {
+  mutex_lock lock(mu_);
+  stats_.num_allocs = 0;
+  stats_.max_bytes_in_use = stats_.bytes_in_use;
+  stats_.max_alloc_size = 0;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,63 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_OPENCL_OPENCL_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_OPENCL_OPENCL_ALLOCATOR_H_
+
+#include <unordered_map>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/kernels/matmul_cl_runtime.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Allocator handing out OpenCL buffers of the clMatMulRuntime context.
+//
+// OpenCL memory objects have no host address, so the void* returned by
+// AllocateRaw() is the cl_mem handle itself (see GetCLBuffer() in
+// opencl_util.h). Tensors allocated here must not be dereferenced on the
+// host, nor sliced with a non-zero offset. Buffers are recycled through the
+// runtime's clBufferPool.
+class OpenCLAllocator : public Allocator {
+ public:
+  explicit OpenCLAllocator(clMatMulRuntime* runtime);
+  ~OpenCLAllocator() override;
+  string Name() override;
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void DeallocateRaw(void* ptr) override;
+
+  // A cl_mem is needed even for empty tensors, kernels take it as argument.
+  bool ShouldAllocateEmptyTensors() override { return true; }
+
+  bool TracksAllocationSizes() override { return true; }
+  size_t RequestedSize(void* ptr) override;
+  void GetStats(AllocatorStats* stats) override;
+  void ClearStats() override;
+
+ private:
+  clMatMulRuntime* runtime_;  // not owned
+
+  mutable mutex mu_;
+  std::unordered_map<void*, size_t> requested_sizes_ GUARDED_BY(mu_);
+  AllocatorStats stats_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(OpenCLAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_OPENCL_OPENCL_ALLOCATOR_H_
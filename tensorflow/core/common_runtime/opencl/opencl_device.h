@@ -0,0 +1,68 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_OPENCL_OPENCL_DEVICE_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_OPENCL_OPENCL_DEVICE_H_
+
+#include "tensorflow/core/common_runtime/local_device.h"
+#include "tensorflow/core/common_runtime/opencl/opencl_allocator.h"
+#include "tensorflow/core/common_runtime/opencl/opencl_device_context.h"
+#include "tensorflow/core/kernels/matmul_cl_runtime.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+
+// Device backed by the OpenCL context and in-order command queue of
+// clMatMulRuntime. Tensors produced by DEVICE_OPENCL kernels stay in cl_mem
+// buffers between ops; they are only copied through OpenCLDeviceContext
+// when an edge crosses to another device.
+class OpenCLDevice : public LocalDevice {
+ public:
+  OpenCLDevice(const SessionOptions& options, const string& name,
+               Bytes memory_limit, const DeviceLocality& locality,
+               const string& physical_device_desc, clMatMulRuntime* runtime,
+               OpenCLAllocator* opencl_allocator, Allocator* cpu_allocator,
+               OpenCLDeviceContext* ctx)
+      : LocalDevice(options, Device::BuildDeviceAttributes(
+                                 name, DEVICE_OPENCL, memory_limit, locality,
+                                 physical_device_desc)),
+        runtime_(runtime),
+        cpu_allocator_(cpu_allocator),
+        opencl_allocator_(opencl_allocator),
+        device_context_(ctx) {}
+
+  ~OpenCLDevice() override;
+
+  void Compute(OpKernel* op_kernel, OpKernelContext* context) override;
+  Allocator* GetAllocator(AllocatorAttributes attr) override;
+  Status MakeTensorFromProto(const TensorProto& tensor_proto,
+                             const AllocatorAttributes alloc_attrs,
+                             Tensor* tensor) override;
+
+  Status FillContextMap(const Graph* graph,
+                        DeviceContextMap* device_context_map) override;
+
+  Status Sync() override;
+
+ private:
+  clMatMulRuntime* runtime_;             // not owned
+  Allocator* cpu_allocator_;             // not owned
+  OpenCLAllocator* opencl_allocator_;    // not owned
+  OpenCLDeviceContext* device_context_;  // not owned
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_OPENCL_OPENCL_DEVICE_H_
@@ -0,0 +1,66 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/opencl/opencl_device_context.h"
+
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/common_runtime/opencl/opencl_util.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+void OpenCLDeviceContext::CopyCPUTensorToDevice(const Tensor* cpu_tensor,
+                                                Device* device,
+                                                Tensor* device_tensor,
+                                                StatusCallback done) const {
+  const int64 total_bytes = cpu_tensor->TotalBytes();
+  if (total_bytes > 0) {
+    const void* src_ptr = DMAHelper::base(cpu_tensor);
+    cl_mem dst_buffer = GetCLBuffer(*device_tensor);
+    const cl_int err =
+        clEnqueueWriteBuffer(runtime_->queue(), dst_buffer, CL_TRUE, 0,
+                             total_bytes, src_ptr, 0, NULL, NULL);
+    if (err != CL_SUCCESS) {
+      done(errors::Internal("OpenCL host to device copy of ", total_bytes,
+                            " bytes failed with code ", err));
+      return;
+    }
+  }
+  done(Status::OK());
+}
+
+void OpenCLDeviceContext::CopyDeviceTensorToCPU(const Tensor* device_tensor,
+                                                StringPiece edge_name,
+                                                Device* device,
+                                                Tensor* cpu_tensor,
+                                                StatusCallback done) {
+  const int64 total_bytes = device_tensor->TotalBytes();
+  if (total_bytes > 0) {
+    cl_mem src_buffer = GetCLBuffer(*device_tensor);
+    void* dst_ptr = DMAHelper::base(cpu_tensor);
+    const cl_int err =
+        clEnqueueReadBuffer(runtime_->queue(), src_buffer, CL_TRUE, 0,
+                            total_bytes, dst_ptr, 0, NULL, NULL);
+    if (err != CL_SUCCESS) {
+      done(errors::Internal("OpenCL device to host copy of ", total_bytes,
+                            " bytes for ", edge_name,
+                            " failed with code ", err));
+      return;
+    }
+  }
+  done(Status::OK());
+}
+
+}  // namespace tensorflow
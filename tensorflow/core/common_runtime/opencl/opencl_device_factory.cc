@@ -0,0 +1,64 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/opencl/opencl_device.h"
+
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+
+class OpenCLDeviceFactory : public DeviceFactory {
+ public:
+  Status CreateDevices(const SessionOptions& options, const string& name_prefix,
+                       std::vector<Device*>* devices) override {
+    size_t n = 1;
+    auto iter = options.config.device_count().find("OPENCL");
+    if (iter != options.config.device_count().end()) {
+      n = iter->second;
+    }
+    if (n == 0) {
+      return Status::OK();
+    }
+
+    clMatMulRuntime* runtime = clMatMulRuntime::Global();
+    if (!runtime->ok()) {
+      LOG(INFO) << "No OpenCL device, not creating an OPENCL device";
+      return Status::OK();
+    }
+
+    // The allocator and context are shared by every session and never
+    // deleted: the Allocator lifetime must exceed any Tensor created by it,
+    // and Tensors may be released at program exit.
+    static OpenCLAllocator* opencl_allocator = new OpenCLAllocator(runtime);
+    static OpenCLDeviceContext* device_context =
+        new OpenCLDeviceContext(runtime);
+
+    // clMatMulRuntime drives a single OpenCL device
+    string name = strings::StrCat(name_prefix, "/device:OPENCL:0");
+    string desc = strings::StrCat("id: 0, name: ", runtime->deviceName(),
+                                  ", driver: ", runtime->driverVersion());
+    devices->push_back(new OpenCLDevice(
+        options, name, Bytes(runtime->maxMemAllocSize()), DeviceLocality(),
+        desc, runtime, opencl_allocator, cpu_allocator(), device_context));
+    return Status::OK();
+  }
+};
+
+// Registered below CPU (priority 60), so ops are only placed on the OpenCL
+// device when the graph asks for it, e.g. with tf.device("/device:OPENCL:0").
+REGISTER_LOCAL_DEVICE_FACTORY("OPENCL", OpenCLDeviceFactory, 50);
+
+}  // namespace tensorflow
@@ -0,0 +1,34 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_OPENCL_OPENCL_UTIL_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_OPENCL_OPENCL_UTIL_H_
+
+// For DMA helper
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/matmul_cl_runtime.h"
+
+namespace tensorflow {
+
+// Returns the OpenCL buffer of a tensor allocated by OpenCLAllocator, which
+// stores the cl_mem handle in place of the tensor's base address.
+inline cl_mem GetCLBuffer(const Tensor& tensor) {
+  return static_cast<cl_mem>(const_cast<void*>(DMAHelper::base(&tensor)));
+}
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_OPENCL_OPENCL_UTIL_H_
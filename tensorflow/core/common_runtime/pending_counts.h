@@ -16,6 +16,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <atomic>
+
 #include "tensorflow/core/lib/gtl/flatmap.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/logging.h"
@@ -45,6 +47,11 @@ namespace tensorflow {
 //    PendingCounts counts(layout);
 //    ...
 //    counts.decrement_pending(h[id], 1);
+//
+// The counts are held in atomics. Every method but
+// adjust_for_activation_atomic() loads and stores them without ordering
+// and must not run concurrently with another method on the same handle.
+// adjust_for_activation_atomic() may run concurrently with itself.
 class PendingCounts {
  public:
   // The state machine for a node's execution.
@@ -79,13 +86,15 @@ class PendingCounts {
   // Create a new PendingCounts object that can hold the state of
   // all the Handles allocated from "final_allocator".
   explicit PendingCounts(Layout layout)
-      : num_bytes_(layout.next_offset_), bytes_(new char[num_bytes_]) {}
+      : num_bytes_(layout.next_offset_), bytes_(new char[num_bytes_]) {
+    CHECK_EQ(uintptr_t(bytes_) % alignof(std::atomic<LargeCounts>), 0);
+  }
 
   // Create a new PendingCounts object with the same layout and counts
   // as "other".
   explicit PendingCounts(const PendingCounts& other)
       : num_bytes_(other.num_bytes_), bytes_(new char[num_bytes_]) {
-    CHECK_EQ(uintptr_t(bytes_) % alignof(LargeCounts), 0);
+    CHECK_EQ(uintptr_t(bytes_) % alignof(std::atomic<LargeCounts>), 0);
     memcpy(bytes_, other.bytes_, other.num_bytes_);
   }
 
@@ -93,63 +102,75 @@ class PendingCounts {
 
   void set_initial_count(Handle h, size_t pending_count) {
     if (h.is_large_) {
-      LargeCounts* c = Large(h);
-      c->pending = pending_count;
-      c->dead_count = 0;
-      c->has_started = 0;
+      std::atomic<LargeCounts>* c_ptr = Large(h);
+      LargeCounts c = c_ptr->load(std::memory_order_relaxed);
+      c.pending = pending_count;
+      c.dead_count = 0;
+      c.has_started = 0;
+      c_ptr->store(c, std::memory_order_relaxed);
     } else {
-      PackedCounts* c = Packed(h);
+      std::atomic<PackedCounts>* c_ptr = Packed(h);
+      PackedCounts c = c_ptr->load(std::memory_order_relaxed);
       DCHECK_LE(pending_count, kMaxCountForPackedCounts);
-      c->pending = pending_count;
-      c->dead_count = 0;
-      c->has_started = 0;
+      c.pending = pending_count;
+      c.dead_count = 0;
+      c.has_started = 0;
+      c_ptr->store(c, std::memory_order_relaxed);
     }
   }
 
   NodeState node_state(Handle h) {
     if (h.is_large_) {
-      return NodeStateForStruct(Large(h));
+      return NodeStateForStruct(Large(h)->load(std::memory_order_relaxed));
     } else {
-      return NodeStateForStruct(Packed(h));
+      return NodeStateForStruct(Packed(h)->load(std::memory_order_relaxed));
     }
   }
   void mark_started(Handle h) {
     DCHECK_EQ(pending(h), 0);
     if (h.is_large_) {
-      LargeCounts* c = Large(h);
-      DCHECK_EQ(c->has_started, 0);
-      c->has_started = 1;
+      std::atomic<LargeCounts>* c_ptr = Large(h);
+      LargeCounts c = c_ptr->load(std::memory_order_relaxed);
+      DCHECK_EQ(c.has_started, 0);
+      c.has_started = 1;
+      c_ptr->store(c, std::memory_order_relaxed);
     } else {
-      PackedCounts* c = Packed(h);
-      DCHECK_EQ(c->has_started, 0);
-      c->has_started = 1;
+      std::atomic<PackedCounts>* c_ptr = Packed(h);
+      PackedCounts c = c_ptr->load(std::memory_order_relaxed);
+      DCHECK_EQ(c.has_started, 0);
+      c.has_started = 1;
+      c_ptr->store(c, std::memory_order_relaxed);
     }
   }
   void mark_completed(Handle h) {
     if (h.is_large_) {
-      LargeCounts* c = Large(h);
-      DCHECK_EQ(c->has_started, 1);
-      c->pending = 1;
+      std::atomic<LargeCounts>* c_ptr = Large(h);
+      LargeCounts c = c_ptr->load(std::memory_order_relaxed);
+      DCHECK_EQ(c.has_started, 1);
+      c.pending = 1;
+      c_ptr->store(c, std::memory_order_relaxed);
     } else {
-      PackedCounts* c = Packed(h);
-      DCHECK_EQ(c->has_started, 1);
-      c->pending = 1;
+      std::atomic<PackedCounts>* c_ptr = Packed(h);
+      PackedCounts c = c_ptr->load(std::memory_order_relaxed);
+      DCHECK_EQ(c.has_started, 1);
+      c.pending = 1;
+      c_ptr->store(c, std::memory_order_relaxed);
     }
   }
   int pending(Handle h) {
     if (h.is_large_) {
-      LargeCounts* c = Large(h);
+      LargeCounts c = Large(h)->load(std::memory_order_relaxed);
       if (PENDING_NOTREADY == NodeStateForStruct(c)) {
-        return c->pending;
+        return c.pending;
       } else {
         // The pending count encodes the state once the node has
         // started, so just return 0.
         return 0;
       }
     } else {
-      PackedCounts* c = Packed(h);
+      PackedCounts c = Packed(h)->load(std::memory_order_relaxed);
       if (PENDING_NOTREADY == NodeStateForStruct(c)) {
-        return c->pending;
+        return c.pending;
       } else {
         // The pending count encodes the state once the node has
         // started, so just return 0.
@@ -160,50 +181,63 @@ class PendingCounts {
   int decrement_pending(Handle h, int v) {
     DCHECK_GE(pending(h), v);
     if (h.is_large_) {
-      LargeCounts* c = Large(h);
-      c->pending -= v;
-      return c->pending;
+      std::atomic<LargeCounts>* c_ptr = Large(h);
+      LargeCounts c = c_ptr->load(std::memory_order_relaxed);
+      c.pending -= v;
+      c_ptr->store(c, std::memory_order_relaxed);
+      return c.pending;
     } else {
-      PackedCounts* c = Packed(h);
-      c->pending -= v;
-      return c->pending;
+      std::atomic<PackedCounts>* c_ptr = Packed(h);
+      PackedCounts c = c_ptr->load(std::memory_order_relaxed);
+      c.pending -= v;
+      c_ptr->store(c, std::memory_order_relaxed);
+      return c.pending;
     }
   }
   // Mark a merge node as live
   // REQUIRES: Node corresponding to "h" is a merge node
   void mark_live(Handle h) {
     if (h.is_large_) {
-      LargeCounts* c = Large(h);
+      std::atomic<LargeCounts>* c_ptr = Large(h);
+      LargeCounts c = c_ptr->load(std::memory_order_relaxed);
       // Only do anything if the node hasn't already started executing.
       if (PENDING_NOTREADY == NodeStateForStruct(c)) {
-        c->pending &= ~static_cast<int>(0x1);
+        c.pending &= ~static_cast<int>(0x1);
+        c_ptr->store(c, std::memory_order_relaxed);
       }
     } else {
-      PackedCounts* c = Packed(h);
+      std::atomic<PackedCounts>* c_ptr = Packed(h);
+      PackedCounts c = c_ptr->load(std::memory_order_relaxed);
       // Only do anything if the node hasn't already started executing.
       if (PENDING_NOTREADY == NodeStateForStruct(c)) {
         static_assert(7 == kMaxCountForPackedCounts,
                       "Live flag incorrect for max packed count");
-        c->pending &= 0x6;
+        c.pending &= 0x6;
+        c_ptr->store(c, std::memory_order_relaxed);
       }
     }
   }
 
   int dead_count(Handle h) {
-    int r = h.is_large_ ? Large(h)->dead_count : Packed(h)->dead_count;
+    int r = h.is_large_ ? Large(h)->load(std::memory_order_relaxed).dead_count
+                        : Packed(h)->load(std::memory_order_relaxed).dead_count;
     return r;
   }
   void increment_dead_count(Handle h) {
     if (h.is_large_) {
-      LargeCounts* c = Large(h);
+      std::atomic<LargeCounts>* c_ptr = Large(h);
+      LargeCounts c = c_ptr->load(std::memory_order_relaxed);
       if (PENDING_NOTREADY == NodeStateForStruct(c)) {
-        c->dead_count++;
+        c.dead_count++;
+        c_ptr->store(c, std::memory_order_relaxed);
       }
     } else {
-      PackedCounts* c = Packed(h);
+      std::atomic<PackedCounts>* c_ptr = Packed(h);
+      PackedCounts c = c_ptr->load(std::memory_order_relaxed);
       if (PENDING_NOTREADY == NodeStateForStruct(c)) {
-        DCHECK_LT(c->dead_count, kMaxCountForPackedCounts);
-        c->dead_count++;
+        DCHECK_LT(c.dead_count, kMaxCountForPackedCounts);
+        c.dead_count++;
+        c_ptr->store(c, std::memory_order_relaxed);
       }
     }
   }
@@ -226,6 +260,22 @@ class PendingCounts {
     }
   }
 
+  // Same as adjust_for_activation(), but with a single atomic
+  // read-modify-write of the counts of "h", so that several threads may
+  // activate the same node at once without a lock. The only other methods
+  // allowed to run concurrently on "h" are adjust_for_activation_atomic()
+  // calls.
+  void adjust_for_activation_atomic(Handle h, bool increment_dead,
+                                    int* pending_result, int* dead_result) {
+    if (h.is_large_) {
+      adjust_for_activation_shared_atomic(Large(h), increment_dead,
+                                          pending_result, dead_result);
+    } else {
+      adjust_for_activation_shared_atomic(Packed(h), increment_dead,
+                                          pending_result, dead_result);
+    }
+  }
+
   class Handle {
    public:
     Handle() : byte_offset_(0), is_large_(0) {}
@@ -238,17 +288,48 @@ class PendingCounts {
 
  private:
   template <typename T>
-  inline void adjust_for_activation_shared(T* c, bool increment_dead,
+  inline void adjust_for_activation_shared(std::atomic<T>* c_ptr,
+                                           bool increment_dead,
                                            int* pending_result,
                                            int* dead_result) {
+    T c = c_ptr->load(std::memory_order_relaxed);
     if (increment_dead) {
       if (PENDING_NOTREADY == NodeStateForStruct(c)) {
-        c->dead_count++;
+        c.dead_count++;
+      }
+    }
+    c.pending -= 1;
+    c_ptr->store(c, std::memory_order_relaxed);
+    *dead_result = c.dead_count;
+    *pending_result = c.pending;
+  }
+
+  // The thread that brings the pending count to zero is the one that
+  // schedules the node, so it must see the inputs written by the other
+  // producers: every update is acq_rel.
+  template <typename T>
+  inline void adjust_for_activation_shared_atomic(std::atomic<T>* c_ptr,
+                                                  bool increment_dead,
+                                                  int* pending_result,
+                                                  int* dead_result) {
+    T old_c = c_ptr->load(std::memory_order_relaxed);
+    while (true) {
+      T c = old_c;
+      DCHECK_GE(c.pending, 1);
+      if (increment_dead) {
+        if (PENDING_NOTREADY == NodeStateForStruct(c)) {
+          c.dead_count++;
+        }
+      }
+      c.pending -= 1;
+      if (TF_PREDICT_TRUE(c_ptr->compare_exchange_weak(
+              old_c, c, std::memory_order_acq_rel,
+              std::memory_order_relaxed))) {
+        *dead_result = c.dead_count;
+        *pending_result = c.pending;
+        return;
       }
     }
-    c->pending -= 1;
-    *dead_result = c->dead_count;
-    *pending_result = c->pending;
   }
 
   // We keep track of the pending count and dead input count for each
@@ -273,30 +354,39 @@ class PendingCounts {
     uint8 has_started : 1;
   };
 
+  // All fields are uint32 so that the struct packs into 8 bytes, which
+  // keeps std::atomic<LargeCounts> lock-free on 64-bit platforms.
   struct LargeCounts {
     uint32 pending;
     uint32 dead_count : 31;
-    uint8 has_started : 1;
+    uint32 has_started : 1;
   };
 
+  static_assert(sizeof(std::atomic<PackedCounts>) == sizeof(PackedCounts),
+                "std::atomic<PackedCounts> must have the size of PackedCounts");
+  static_assert(sizeof(std::atomic<LargeCounts>) == sizeof(LargeCounts),
+                "std::atomic<LargeCounts> must have the size of LargeCounts");
+
   template <typename T>
-  NodeState NodeStateForStruct(T* c) const {
-    if (c->has_started) {
-      return (c->pending == 0) ? STARTED : COMPLETED;
+  NodeState NodeStateForStruct(const T& c) const {
+    if (c.has_started) {
+      return (c.pending == 0) ? STARTED : COMPLETED;
     } else {
-      return (c->pending == 0) ? PENDING_READY : PENDING_NOTREADY;
+      return (c.pending == 0) ? PENDING_READY : PENDING_NOTREADY;
     }
   }
-  inline LargeCounts* Large(Handle h) {
+  inline std::atomic<LargeCounts>* Large(Handle h) {
     DCHECK(h.is_large_);
     DCHECK_LE(h.byte_offset_ + sizeof(LargeCounts), num_bytes_);
-    DCHECK_EQ(h.byte_offset_ % alignof(LargeCounts), 0);
-    return reinterpret_cast<LargeCounts*>(bytes_ + h.byte_offset_);
+    DCHECK_EQ(h.byte_offset_ % alignof(std::atomic<LargeCounts>), 0);
+    return reinterpret_cast<std::atomic<LargeCounts>*>(bytes_ +
+                                                        h.byte_offset_);
   }
-  inline PackedCounts* Packed(Handle h) {
+  inline std::atomic<PackedCounts>* Packed(Handle h) {
     DCHECK(!h.is_large_);
     DCHECK_LE(h.byte_offset_ + sizeof(PackedCounts), num_bytes_);
-    return reinterpret_cast<PackedCounts*>(bytes_ + h.byte_offset_);
+    return reinterpret_cast<std::atomic<PackedCounts>*>(bytes_ +
+                                                         h.byte_offset_);
   }
 
   const int num_bytes_;  // Just for bounds checking in debug mode
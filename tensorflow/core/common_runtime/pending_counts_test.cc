@@ -13,10 +13,13 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <atomic>
 #include <memory>
 #include <unordered_map>
 
 #include "tensorflow/core/common_runtime/pending_counts.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -166,4 +169,39 @@ TEST(PendingCounts, AdjustForActivation) {
   }
 }
 
+TEST(PendingCounts, AdjustForActivationAtomic) {
+  PendingCounts::Layout layout;
+  PendingCounts::Handle handles[2];
+  handles[0] = layout.CreateHandle(7, 7);
+  handles[1] = layout.CreateHandle(8000, 8000);
+  for (int id = 0; id < 2; id++) {
+    PendingCounts::Handle h = handles[id];
+    // Test for both packed and large.
+    const int num_threads = (id == 0) ? 7 : 8;
+    const int activations_per_thread = (id == 0) ? 1 : 1000;
+    const int count = num_threads * activations_per_thread;
+
+    PendingCounts c(layout);
+    c.set_initial_count(h, count);
+    std::atomic<int> num_ready(0);
+    {
+      thread::ThreadPool pool(Env::Default(), "test", num_threads);
+      for (int t = 0; t < num_threads; ++t) {
+        pool.Schedule([&c, &num_ready, h, t, activations_per_thread]() {
+          for (int i = 0; i < activations_per_thread; ++i) {
+            int pending, dead;
+            // The inputs of odd threads are dead.
+            c.adjust_for_activation_atomic(h, t % 2 == 1, &pending, &dead);
+            if (pending == 0) ++num_ready;
+          }
+        });
+      }
+    }
+    // Exactly one activation makes the node ready.
+    EXPECT_EQ(1, num_ready);
+    EXPECT_EQ(c.node_state(h), PendingCounts::PENDING_READY);
+    EXPECT_EQ(c.dead_count(h), (num_threads / 2) * activations_per_thread);
+  }
+}
+
 }  // namespace tensorflow
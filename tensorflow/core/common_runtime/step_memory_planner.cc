@@ -0,0 +1,412 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_memory_planner.h"
+
+#include <algorithm>
+#include <limits>
+#include <set>
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+// The allocations of the recording step, in the order of the step.
+struct StepMemoryPlanner::Recording {
+  struct Record {
+    int node_id;
+    int index;  // The index of the allocation in the node invocation.
+    size_t num_bytes;
+    // Logical times of the allocation and of the free, -1 if the buffer
+    // outlived the step.
+    int64 alloc_time;
+    int64 free_time;
+  };
+
+  mutex mu;
+  bool done GUARDED_BY(mu) = false;  // Set when the step ended.
+  int64 clock GUARDED_BY(mu) = 0;
+  std::vector<Record> records GUARDED_BY(mu);
+};
+
+// The arena and the slots of the planned allocations. Immutable but for
+// the in-use flags of the slots. Shared by the planner and the steps and
+// node allocators that use it, so the arena outlives all its tensors.
+struct StepMemoryPlanner::Plan {
+  struct Slot {
+    size_t offset;
+    size_t num_bytes;
+    // The slots overlapping this one, which must not be in use while this
+    // one is.
+    std::vector<int> conflicts;
+  };
+
+  explicit Plan(Allocator* a) : allocator(a) {}
+  ~Plan() {
+    if (base != nullptr) allocator->DeallocateRaw(base);
+  }
+
+  Allocator* const allocator;  // Not owned.
+  char* base = nullptr;
+  size_t size = 0;
+  std::vector<Slot> slots;
+  // The slot of the k-th allocation of each node, or -1.
+  std::vector<std::vector<int>> node_slots;
+  std::unique_ptr<std::atomic<bool>[]> in_use;
+};
+
+class StepMemoryPlanner::Step {
+ public:
+  Allocator* allocator = nullptr;  // Not owned.
+  std::shared_ptr<Recording> recording;
+  std::shared_ptr<const Plan> plan;
+  std::atomic<int64> hits{0};
+  std::atomic<int64> misses{0};
+};
+
+StepMemoryPlanner::StepMemoryPlanner(Allocator* allocator)
+    : allocator_(allocator) {}
+
+StepMemoryPlanner::~StepMemoryPlanner() {
+  mutex_lock l(mu_);
+  if (plan_ != nullptr) {
+    VLOG(1) << "Planned memory of " << allocator_->Name() << "\n"
+            << stats_.DebugString();
+  }
+}
+
+StepMemoryPlanner::Step* StepMemoryPlanner::BeginStep() {
+  mutex_lock l(mu_);
+  if (plan_ != nullptr) {
+    Step* step = new Step;
+    step->allocator = allocator_;
+    step->plan = plan_;
+    return step;
+  }
+  if (planned_ || recording_) {
+    return nullptr;
+  }
+  recording_ = true;
+  Step* step = new Step;
+  step->allocator = allocator_;
+  step->recording = std::make_shared<Recording>();
+  return step;
+}
+
+void StepMemoryPlanner::EndStep(Step* step) {
+  if (step == nullptr) return;
+  std::unique_ptr<Step> owned(step);
+  if (step->recording != nullptr) {
+    mutex_lock l(mu_);
+    {
+      mutex_lock rl(step->recording->mu);
+      step->recording->done = true;
+    }
+    recording_ = false;
+    planned_ = true;
+    BuildPlan(step->recording.get());
+  } else {
+    mutex_lock l(mu_);
+    ++stats_.planned_steps;
+    stats_.arena_hits += step->hits;
+    stats_.arena_misses += step->misses;
+  }
+}
+
+void StepMemoryPlanner::BuildPlan(Recording* recording) {
+  std::vector<Recording::Record> records;
+  {
+    mutex_lock l(recording->mu);
+    records = recording->records;
+  }
+  stats_.recorded_allocations = records.size();
+
+  // Nodes whose allocations cannot be told apart by their index.
+  std::set<std::pair<int, int>> seen;
+  std::unordered_set<int> repeated_nodes;
+  for (const auto& r : records) {
+    if (!seen.insert(std::make_pair(r.node_id, r.index)).second) {
+      repeated_nodes.insert(r.node_id);
+    }
+  }
+  std::vector<int> candidates;
+  for (int i = 0; i < records.size(); ++i) {
+    if (records[i].free_time >= 0 &&
+        repeated_nodes.count(records[i].node_id) == 0) {
+      candidates.push_back(i);
+    }
+  }
+  if (candidates.empty()) {
+    VLOG(1) << "No allocation to plan out of " << records.size();
+    return;
+  }
+
+  // Peak of the live bytes over the step.
+  std::vector<std::pair<int64, int64>> events;
+  for (int i : candidates) {
+    events.emplace_back(records[i].alloc_time, records[i].num_bytes);
+    events.emplace_back(records[i].free_time,
+                        -static_cast<int64>(records[i].num_bytes));
+  }
+  std::sort(events.begin(), events.end());
+  int64 live_bytes = 0;
+  for (const auto& event : events) {
+    live_bytes += event.second;
+    stats_.planned_peak_bytes =
+        std::max(stats_.planned_peak_bytes, live_bytes);
+  }
+
+  // Largest first, then in the order of the step.
+  std::sort(candidates.begin(), candidates.end(), [&records](int a, int b) {
+    if (records[a].num_bytes != records[b].num_bytes) {
+      return records[a].num_bytes > records[b].num_bytes;
+    }
+    return records[a].alloc_time < records[b].alloc_time;
+  });
+
+  auto plan = std::make_shared<Plan>(allocator_);
+  // Records of the slots, and the slots ordered by offset.
+  std::vector<int> slot_records;
+  std::vector<int> by_offset;
+  for (int i : candidates) {
+    const Recording::Record& r = records[i];
+    const size_t num_bytes =
+        (r.num_bytes + Allocator::kAllocatorAlignment - 1) /
+        Allocator::kAllocatorAlignment * Allocator::kAllocatorAlignment;
+    // Best fitting gap between the slots whose lifetime intersects.
+    size_t best_offset = 0;
+    size_t best_gap = std::numeric_limits<size_t>::max();
+    size_t offset = 0;
+    for (int s : by_offset) {
+      const Recording::Record& other = records[slot_records[s]];
+      if (other.free_time <= r.alloc_time || r.free_time <= other.alloc_time) {
+        continue;
+      }
+      const Plan::Slot& slot = plan->slots[s];
+      if (slot.offset >= offset + num_bytes &&
+          slot.offset - offset < best_gap) {
+        best_gap = slot.offset - offset;
+        best_offset = offset;
+      }
+      offset = std::max(offset, slot.offset + slot.num_bytes);
+    }
+    if (best_gap == std::numeric_limits<size_t>::max()) {
+      best_offset = offset;
+    }
+
+    const int s = plan->slots.size();
+    plan->slots.push_back({best_offset, num_bytes, {}});
+    slot_records.push_back(i);
+    auto pos = std::upper_bound(
+        by_offset.begin(), by_offset.end(), best_offset,
+        [&plan](size_t o, int t) { return o < plan->slots[t].offset; });
+    by_offset.insert(pos, s);
+    plan->size = std::max(plan->size, best_offset + num_bytes);
+    if (r.node_id >= plan->node_slots.size()) {
+      plan->node_slots.resize(r.node_id + 1);
+    }
+    std::vector<int>& node_slots = plan->node_slots[r.node_id];
+    if (r.index >= node_slots.size()) {
+      node_slots.resize(r.index + 1, -1);
+    }
+    node_slots[r.index] = s;
+  }
+
+  // Slots sharing memory, whose lifetimes were disjoint in the recording.
+  for (int i = 0; i < by_offset.size(); ++i) {
+    Plan::Slot& a = plan->slots[by_offset[i]];
+    for (int j = i + 1; j < by_offset.size(); ++j) {
+      Plan::Slot& b = plan->slots[by_offset[j]];
+      if (b.offset >= a.offset + a.num_bytes) break;
+      a.conflicts.push_back(by_offset[j]);
+      b.conflicts.push_back(by_offset[i]);
+    }
+  }
+
+  plan->base = static_cast<char*>(
+      allocator_->AllocateRaw(Allocator::kAllocatorAlignment, plan->size));
+  if (plan->base == nullptr) {
+    LOG(WARNING) << "Could not allocate a planned arena of " << plan->size
+                 << " bytes from " << allocator_->Name();
+    return;
+  }
+  plan->in_use.reset(new std::atomic<bool>[plan->slots.size()]);
+  for (int s = 0; s < plan->slots.size(); ++s) {
+    plan->in_use[s] = false;
+  }
+  stats_.planned_allocations = plan->slots.size();
+  stats_.arena_bytes = plan->size;
+  VLOG(1) << "Planned " << plan->slots.size() << " of " << records.size()
+          << " allocations on " << allocator_->Name() << " into an arena of "
+          << plan->size << " bytes, their peak was "
+          << stats_.planned_peak_bytes << " bytes";
+  plan_ = std::move(plan);
+}
+
+StepMemoryPlanner::NodeAllocator* StepMemoryPlanner::NewNodeAllocator(
+    Step* step, int node_id) {
+  return new NodeAllocator(step, node_id);
+}
+
+void StepMemoryPlanner::GetStats(Stats* stats) {
+  mutex_lock l(mu_);
+  *stats = stats_;
+}
+
+string StepMemoryPlanner::Stats::DebugString() const {
+  return strings::Printf(
+      "PlannedSteps:        %20lld\n"
+      "RecordedAllocations: %20lld\n"
+      "PlannedAllocations:  %20lld\n"
+      "PlannedPeakBytes:    %20lld\n"
+      "ArenaBytes:          %20lld\n"
+      "ArenaHits:           %20lld\n"
+      "ArenaMisses:         %20lld\n",
+      static_cast<long long>(planned_steps),
+      static_cast<long long>(recorded_allocations),
+      static_cast<long long>(planned_allocations),
+      static_cast<long long>(planned_peak_bytes),
+      static_cast<long long>(arena_bytes),
+      static_cast<long long>(arena_hits), static_cast<long long>(arena_misses));
+}
+
+StepMemoryPlanner::NodeAllocator::NodeAllocator(Step* step, int node_id)
+    : step_(step),
+      node_id_(node_id),
+      allocator_(step->allocator),
+      recording_(step->recording),
+      plan_(step->plan) {}
+
+int StepMemoryPlanner::NodeAllocator::ClaimSlot(int index, size_t alignment,
+                                                size_t num_bytes) {
+  if (node_id_ >= plan_->node_slots.size() ||
+      index >= plan_->node_slots[node_id_].size()) {
+    return -1;
+  }
+  const int s = plan_->node_slots[node_id_][index];
+  if (s < 0 || num_bytes > plan_->slots[s].num_bytes ||
+      alignment > Allocator::kAllocatorAlignment) {
+    return -1;
+  }
+  // Both flags are sequentially consistent: of two overlapping slots
+  // claimed at once, at least one sees the other in use and backs off.
+  if (plan_->in_use[s].exchange(true)) {
+    return -1;
+  }
+  for (int c : plan_->slots[s].conflicts) {
+    if (plan_->in_use[c].load()) {
+      plan_->in_use[s] = false;
+      return -1;
+    }
+  }
+  return s;
+}
+
+void* StepMemoryPlanner::NodeAllocator::AllocateRaw(
+    size_t alignment, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
+  int index;
+  {
+    mutex_lock l(mu_);
+    index = next_index_++;
+  }
+  if (plan_ != nullptr) {
+    const int s = ClaimSlot(index, alignment, num_bytes);
+    if (s >= 0) {
+      void* ptr = plan_->base + plan_->slots[s].offset;
+      mutex_lock l(mu_);
+      ++hits_;
+      ++ref_;
+      live_.emplace_back(ptr, s);
+      return ptr;
+    }
+  }
+
+  void* ptr = allocator_->AllocateRaw(alignment, num_bytes, allocation_attr);
+  if (ptr == nullptr) {
+    return nullptr;
+  }
+  int record = -1;
+  if (recording_ != nullptr && num_bytes > 0) {
+    mutex_lock l(recording_->mu);
+    if (!recording_->done) {
+      record = recording_->records.size();
+      recording_->records.push_back(
+          {node_id_, index, num_bytes, recording_->clock++, -1});
+    }
+  }
+  mutex_lock l(mu_);
+  if (plan_ != nullptr) {
+    ++misses_;
+  }
+  ++ref_;
+  live_.emplace_back(ptr, record);
+  return ptr;
+}
+
+void StepMemoryPlanner::NodeAllocator::DeallocateRaw(void* ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+  int tag = -1;
+  {
+    mutex_lock l(mu_);
+    auto it = std::find_if(
+        live_.begin(), live_.end(),
+        [ptr](const std::pair<void*, int>& p) { return p.first == ptr; });
+    CHECK(it != live_.end()) << "Freeing an unknown pointer " << ptr;
+    tag = it->second;
+    *it = live_.back();
+    live_.pop_back();
+  }
+  if (plan_ != nullptr && tag >= 0) {
+    plan_->in_use[tag] = false;
+  } else {
+    if (recording_ != nullptr && tag >= 0) {
+      mutex_lock l(recording_->mu);
+      if (!recording_->done) {
+        recording_->records[tag].free_time = recording_->clock++;
+      }
+    }
+    allocator_->DeallocateRaw(ptr);
+  }
+  Unref();
+}
+
+void StepMemoryPlanner::NodeAllocator::Finish() {
+  {
+    mutex_lock l(mu_);
+    step_->hits += hits_;
+    step_->misses += misses_;
+    step_ = nullptr;
+  }
+  Unref();
+}
+
+void StepMemoryPlanner::NodeAllocator::Unref() {
+  bool should_delete;
+  {
+    mutex_lock l(mu_);
+    should_delete = --ref_ == 0;
+  }
+  if (should_delete) {
+    delete this;
+  }
+}
+
+}  // namespace tensorflow
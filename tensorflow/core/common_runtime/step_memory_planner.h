@@ -0,0 +1,170 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_STEP_MEMORY_PLANNER_H_
+#define TENSORFLOW_COMMON_RUNTIME_STEP_MEMORY_PLANNER_H_
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Plans the memory of the steps of one executor ahead of time, the way
+// TF Lite's ArenaPlanner plans the tensors of an interpreter.
+//
+// The first step run with a StepMemoryPlanner records every allocation its
+// kernels make from the device allocator: its size and when, in the order
+// of the step, it was allocated and freed. The allocations freed before the
+// end of the step are then packed into one arena, largest first, each at
+// the best fitting offset that does not overlap an allocation whose
+// lifetime intersects its own. Later steps serve the k-th allocation of
+// each node from its slot in the arena instead of the device allocator.
+//
+// Later steps need not follow the recorded schedule: the executor may run
+// the nodes in another order, several steps may run at once and shapes may
+// change. A slot is only handed out while no slot overlapping it is in use
+// and big enough for the request; otherwise the allocation falls back to
+// the device allocator. The plan only changes where tensors live, never
+// the result of a step.
+//
+// Nodes that run several times in a step (loops) are not planned.
+class StepMemoryPlanner {
+ public:
+  // 'allocator' is the default allocator of the device the executor runs
+  // on. It must outlive the planner and every tensor allocated through it.
+  explicit StepMemoryPlanner(Allocator* allocator);
+  ~StepMemoryPlanner();
+
+  class Step;
+  class NodeAllocator;
+
+  // Starts a step. Returns nullptr if the step does not need a
+  // NodeAllocator for its kernels, e.g. while another step is recording.
+  Step* BeginStep();
+
+  // Ends 'step', once all its kernels are done. Builds the plan if 'step'
+  // recorded the allocations. Deletes 'step'.
+  void EndStep(Step* step);
+
+  // Returns the allocator of one invocation of node 'node_id' in 'step',
+  // which replaces the device allocator for that invocation. The caller
+  // must call Finish() on it once the kernel is done.
+  static NodeAllocator* NewNodeAllocator(Step* step, int node_id);
+
+  struct Stats {
+    // Steps served from the arena.
+    int64 planned_steps = 0;
+    // Allocations of the recorded step.
+    int64 recorded_allocations = 0;
+    // Allocations placed in the arena, the peak bytes they took in the
+    // recorded step and the size of the arena.
+    int64 planned_allocations = 0;
+    int64 planned_peak_bytes = 0;
+    int64 arena_bytes = 0;
+    // Allocations of later steps served from the arena, and those that
+    // fell back to the device allocator.
+    int64 arena_hits = 0;
+    int64 arena_misses = 0;
+
+    string DebugString() const;
+  };
+  void GetStats(Stats* stats);
+
+ private:
+  struct Plan;
+  struct Recording;
+
+  void BuildPlan(Recording* recording) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Allocator* const allocator_;  // Not owned.
+
+  mutex mu_;
+  bool recording_ GUARDED_BY(mu_) = false;
+  bool planned_ GUARDED_BY(mu_) = false;
+  std::shared_ptr<const Plan> plan_ GUARDED_BY(mu_);
+  Stats stats_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StepMemoryPlanner);
+};
+
+// Allocator of one kernel invocation in a step. Serves the allocations of
+// the invocation from the arena of the plan, from the device allocator
+// while recording, or from the device allocator when its slot is not
+// available.
+//
+// Like TrackingAllocator it deletes itself once Finish() was called and
+// all of its allocations are freed.
+class StepMemoryPlanner::NodeAllocator : public Allocator {
+ public:
+  NodeAllocator(Step* step, int node_id);
+
+  string Name() override { return allocator_->Name(); }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return AllocateRaw(alignment, num_bytes, AllocationAttributes());
+  }
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr) override;
+  void DeallocateRaw(void* ptr) override;
+  bool ShouldAllocateEmptyTensors() override {
+    return allocator_->ShouldAllocateEmptyTensors();
+  }
+  void GetStats(AllocatorStats* stats) override {
+    allocator_->GetStats(stats);
+  }
+
+  // Called once the kernel is done allocating.
+  void Finish();
+
+ private:
+  ~NodeAllocator() override {}
+
+  // Returns the slot of the 'index'-th allocation of the node if it can
+  // hold 'num_bytes' and is claimed for it, otherwise -1.
+  int ClaimSlot(int index, size_t alignment, size_t num_bytes);
+
+  // Drops a reference, deleting the allocator with the last one.
+  void Unref() LOCKS_EXCLUDED(mu_);
+
+  Step* step_;  // Only valid until Finish().
+  const int node_id_;
+  Allocator* const allocator_;  // Not owned.
+  // One of them is set.
+  const std::shared_ptr<Recording> recording_;
+  const std::shared_ptr<const Plan> plan_;
+
+  mutex mu_;
+  // One for the invocation and one per live allocation.
+  int ref_ GUARDED_BY(mu_) = 1;
+  int next_index_ GUARDED_BY(mu_) = 0;
+  int64 hits_ GUARDED_BY(mu_) = 0;
+  int64 misses_ GUARDED_BY(mu_) = 0;
+  // The live allocations with their slot in the plan, or their record
+  // while recording, or -1.
+  gtl::InlinedVector<std::pair<void*, int>, 4> live_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(NodeAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_STEP_MEMORY_PLANNER_H_
@@ -0,0 +1,217 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_memory_planner.h"
+
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace {
+
+class CountingAllocator : public Allocator {
+ public:
+  string Name() override { return "counting"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    ++num_allocs;
+    return port::AlignedMalloc(num_bytes, alignment);
+  }
+  void DeallocateRaw(void* ptr) override { port::AlignedFree(ptr); }
+
+  std::atomic<int> num_allocs{0};
+};
+
+typedef StepMemoryPlanner::NodeAllocator NodeAllocator;
+
+struct StepBuffers {
+  void* a = nullptr;
+  void* b = nullptr;
+  void* c = nullptr;
+  void* d = nullptr;
+};
+
+// Runs a step in which node 0 allocates a, node 1 allocates b once a is
+// computed, and node 2 allocates c and the output d of the step. The
+// lifetime of b intersects those of a and c, which are disjoint. d outlives
+// the step.
+StepBuffers RunStep(StepMemoryPlanner* planner, size_t b_bytes = 4000) {
+  StepBuffers buffers;
+  StepMemoryPlanner::Step* step = planner->BeginStep();
+  NodeAllocator* n0 = StepMemoryPlanner::NewNodeAllocator(step, 0);
+  buffers.a = n0->AllocateRaw(Allocator::kAllocatorAlignment, 1000);
+  n0->Finish();
+  NodeAllocator* n1 = StepMemoryPlanner::NewNodeAllocator(step, 1);
+  buffers.b = n1->AllocateRaw(Allocator::kAllocatorAlignment, b_bytes);
+  n1->Finish();
+  n0->DeallocateRaw(buffers.a);
+  NodeAllocator* n2 = StepMemoryPlanner::NewNodeAllocator(step, 2);
+  buffers.c = n2->AllocateRaw(Allocator::kAllocatorAlignment, 500);
+  buffers.d = n2->AllocateRaw(Allocator::kAllocatorAlignment, 300);
+  n2->Finish();
+  n1->DeallocateRaw(buffers.b);
+  n2->DeallocateRaw(buffers.c);
+  planner->EndStep(step);
+  n2->DeallocateRaw(buffers.d);
+  return buffers;
+}
+
+TEST(StepMemoryPlannerTest, PlansAllocationsFreedInStep) {
+  CountingAllocator allocator;
+  StepMemoryPlanner planner(&allocator);
+  RunStep(&planner);
+  // The four allocations of the step and the arena.
+  EXPECT_EQ(5, allocator.num_allocs);
+
+  StepMemoryPlanner::Stats stats;
+  planner.GetStats(&stats);
+  EXPECT_EQ(4, stats.recorded_allocations);
+  EXPECT_EQ(3, stats.planned_allocations);
+  EXPECT_EQ(5000, stats.planned_peak_bytes);
+  // b, then a next to it, then c in place of a.
+  EXPECT_EQ(4032 + 1024, stats.arena_bytes);
+
+  for (int i = 0; i < 2; ++i) {
+    const StepBuffers buffers = RunStep(&planner);
+    EXPECT_EQ(buffers.a, buffers.c);
+    EXPECT_EQ(static_cast<char*>(buffers.b) + 4032, buffers.a);
+  }
+  // Only d is allocated by the device allocator.
+  EXPECT_EQ(7, allocator.num_allocs);
+  planner.GetStats(&stats);
+  EXPECT_EQ(2, stats.planned_steps);
+  EXPECT_EQ(6, stats.arena_hits);
+  EXPECT_EQ(2, stats.arena_misses);
+}
+
+TEST(StepMemoryPlannerTest, LargerAllocationsFallBack) {
+  CountingAllocator allocator;
+  StepMemoryPlanner planner(&allocator);
+  RunStep(&planner);
+  const StepBuffers buffers = RunStep(&planner, 8000);
+  EXPECT_EQ(buffers.a, buffers.c);
+  EXPECT_NE(static_cast<char*>(buffers.b) + 4032, buffers.a);
+  StepMemoryPlanner::Stats stats;
+  planner.GetStats(&stats);
+  EXPECT_EQ(2, stats.arena_hits);
+  EXPECT_EQ(2, stats.arena_misses);
+}
+
+TEST(StepMemoryPlannerTest, OverlappingSlotsAreNotShared) {
+  CountingAllocator allocator;
+  StepMemoryPlanner planner(&allocator);
+  RunStep(&planner);
+
+  // Node 2 runs before a is freed, so c cannot take its place.
+  StepMemoryPlanner::Step* step = planner.BeginStep();
+  NodeAllocator* n0 = StepMemoryPlanner::NewNodeAllocator(step, 0);
+  void* a = n0->AllocateRaw(Allocator::kAllocatorAlignment, 1000);
+  n0->Finish();
+  NodeAllocator* n2 = StepMemoryPlanner::NewNodeAllocator(step, 2);
+  void* c = n2->AllocateRaw(Allocator::kAllocatorAlignment, 500);
+  n2->Finish();
+  EXPECT_NE(a, c);
+  n0->DeallocateRaw(a);
+  n2->DeallocateRaw(c);
+  planner.EndStep(step);
+
+  StepMemoryPlanner::Stats stats;
+  planner.GetStats(&stats);
+  EXPECT_EQ(1, stats.arena_hits);
+  EXPECT_EQ(1, stats.arena_misses);
+}
+
+TEST(StepMemoryPlannerTest, OnlyOneStepRecords) {
+  CountingAllocator allocator;
+  StepMemoryPlanner planner(&allocator);
+  StepMemoryPlanner::Step* recording = planner.BeginStep();
+  EXPECT_NE(nullptr, recording);
+  EXPECT_EQ(nullptr, planner.BeginStep());
+  planner.EndStep(recording);
+  // Nothing was allocated, so there is no plan.
+  EXPECT_EQ(nullptr, planner.BeginStep());
+}
+
+TEST(StepMemoryPlannerTest, RepeatedNodesAreNotPlanned) {
+  CountingAllocator allocator;
+  StepMemoryPlanner planner(&allocator);
+  StepMemoryPlanner::Step* step = planner.BeginStep();
+  for (int i = 0; i < 2; ++i) {
+    NodeAllocator* n0 = StepMemoryPlanner::NewNodeAllocator(step, 0);
+    n0->DeallocateRaw(n0->AllocateRaw(Allocator::kAllocatorAlignment, 64));
+    n0->Finish();
+  }
+  NodeAllocator* n1 = StepMemoryPlanner::NewNodeAllocator(step, 1);
+  n1->DeallocateRaw(n1->AllocateRaw(Allocator::kAllocatorAlignment, 64));
+  n1->Finish();
+  planner.EndStep(step);
+
+  StepMemoryPlanner::Stats stats;
+  planner.GetStats(&stats);
+  EXPECT_EQ(3, stats.recorded_allocations);
+  EXPECT_EQ(1, stats.planned_allocations);
+}
+
+TEST(StepMemoryPlannerTest, ConcurrentStepsDoNotShareBuffers) {
+  CountingAllocator allocator;
+  StepMemoryPlanner planner(&allocator);
+  RunStep(&planner);
+
+  const int kNumThreads = 8;
+  std::atomic<int> corrupted{0};
+  {
+    thread::ThreadPool pool(Env::Default(), "test", kNumThreads);
+    for (int t = 0; t < kNumThreads; ++t) {
+      pool.Schedule([&planner, &corrupted, t]() {
+        for (int i = 0; i < 200; ++i) {
+          StepMemoryPlanner::Step* step = planner.BeginStep();
+          NodeAllocator* n0 = StepMemoryPlanner::NewNodeAllocator(step, 0);
+          char* a = static_cast<char*>(
+              n0->AllocateRaw(Allocator::kAllocatorAlignment, 1000));
+          n0->Finish();
+          std::memset(a, t, 1000);
+          NodeAllocator* n1 = StepMemoryPlanner::NewNodeAllocator(step, 1);
+          char* b = static_cast<char*>(
+              n1->AllocateRaw(Allocator::kAllocatorAlignment, 4000));
+          n1->Finish();
+          std::memset(b, t, 4000);
+          for (int j = 0; j < 1000; ++j) {
+            if (a[j] != t) ++corrupted;
+          }
+          n0->DeallocateRaw(a);
+          for (int j = 0; j < 4000; ++j) {
+            if (b[j] != t) ++corrupted;
+          }
+          n1->DeallocateRaw(b);
+          planner.EndStep(step);
+        }
+      });
+    }
+  }
+  EXPECT_EQ(0, corrupted);
+  StepMemoryPlanner::Stats stats;
+  planner.GetStats(&stats);
+  EXPECT_EQ(kNumThreads * 200, stats.planned_steps);
+  EXPECT_EQ(kNumThreads * 200 * 2, stats.arena_hits + stats.arena_misses);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -19,72 +19,53 @@ limitations under the License.
 
 namespace tensorflow {
 
-SYCLAllocator::SYCLAllocator(Eigen::QueueInterface* queue)
+SYCLMemAllocator::SYCLMemAllocator(Eigen::QueueInterface* queue)
     : sycl_device_(new Eigen::SyclDevice(queue)) {
   cl::sycl::queue& sycl_queue = sycl_device_->sycl_queue();
   const cl::sycl::device& device = sycl_queue.get_device();
-  stats_.bytes_limit =
+  max_alloc_size_ =
       device.get_info<cl::sycl::info::device::max_mem_alloc_size>();
 }
 
-SYCLAllocator::~SYCLAllocator() {
+SYCLMemAllocator::~SYCLMemAllocator() {
   if (sycl_device_) {
     delete sycl_device_;
   }
 }
 
-string SYCLAllocator::Name() { return "device:SYCL"; }
-
-void* SYCLAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
+void* SYCLMemAllocator::Alloc(size_t alignment, size_t num_bytes) {
   mutex_lock lock(mu_);
-  assert(sycl_device_);
-  if (num_bytes == 0) {
-    // Cannot allocate no bytes in SYCL, so instead allocate a single byte
-    num_bytes = 1;
+  if (!sycl_device_ || num_bytes > max_alloc_size_) {
+    return nullptr;
   }
-  auto p = sycl_device_->allocate(num_bytes);
-  const auto& allocated_buffer = sycl_device_->get_sycl_buffer(p);
-  const std::size_t bytes_allocated = allocated_buffer.get_range().size();
-
-  ++stats_.num_allocs;
-  stats_.bytes_in_use += bytes_allocated;
-  stats_.max_bytes_in_use =
-      std::max<int64>(stats_.max_bytes_in_use, stats_.bytes_in_use);
-  stats_.max_alloc_size =
-      std::max<int64>(stats_.max_alloc_size, bytes_allocated);
-
-  return p;
+  return sycl_device_->allocate(num_bytes);
 }
 
-void SYCLAllocator::DeallocateRaw(void* ptr) {
+void SYCLMemAllocator::Free(void* ptr, size_t num_bytes) {
   mutex_lock lock(mu_);
-  if (sycl_device_) {
-    const auto& buffer_to_delete = sycl_device_->get_sycl_buffer(ptr);
-    const std::size_t dealloc_size = buffer_to_delete.get_range().size();
-    stats_.bytes_in_use -= dealloc_size;
+  if (sycl_device_ && ptr != nullptr) {
     sycl_device_->deallocate(ptr);
   }
 }
 
-void SYCLAllocator::GetStats(AllocatorStats* stats) {
-  mutex_lock lock(mu_);
-  *stats = stats_;
-}
+SYCLAllocator::SYCLAllocator(Eigen::QueueInterface* queue,
+                             size_t total_memory, bool allow_growth)
+    : SYCLAllocator(new SYCLMemAllocator(queue), total_memory, allow_growth) {}
 
-void SYCLAllocator::ClearStats() override {
-  mutex_lock l(mu_);
-  stats_.num_allocs = 0;
-  stats_.max_bytes_in_use = stats_.bytes_in_use;
-  stats_.max_alloc_size = 0;
+SYCLAllocator::SYCLAllocator(SYCLMemAllocator* sub_allocator,
+                             size_t total_memory, bool allow_growth)
+    : BFCAllocator(sub_allocator, total_memory, allow_growth, "device:SYCL"),
+      sub_allocator_(sub_allocator) {
+  SetMaxRegionBytes(sub_allocator_->max_alloc_size());
 }
 
-size_t SYCLAllocator::RequestedSize(void* ptr) {
-  mutex_lock lock(mu_);
-  if (!sycl_device_) {
-    return 0;
+void SYCLAllocator::ClearSYCLDevice() {
+  if (VLOG_IS_ON(1)) {
+    FragmentationStats frag_stats;
+    GetFragmentationStats(&frag_stats);
+    VLOG(1) << Name() << " fragmentation:\n" << frag_stats.DebugString();
   }
-  const auto& buffer = sycl_device_->get_sycl_buffer(ptr);
-  return buffer.get_size();
+  sub_allocator_->ClearSYCLDevice();
 }
 
 }  // namespace tensorflow
@@ -20,40 +20,41 @@ limitations under the License.
 #ifndef TENSORFLOW_COMMON_RUNTIME_SYCL_SYCL_ALLOCATOR_H_
 #define TENSORFLOW_COMMON_RUNTIME_SYCL_SYCL_ALLOCATOR_H_
 
+#include <algorithm>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/common_runtime/bfc_allocator.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
 
-class SYCLAllocator : public Allocator {
+// Reserves whole SYCL buffers through Eigen::SyclDevice.  Each call is a
+// device allocation, so it is only used to back the regions of a
+// BFCAllocator.
+class SYCLMemAllocator : public SubAllocator {
  public:
-  SYCLAllocator(Eigen::QueueInterface* queue);
-  virtual ~SYCLAllocator() override;
-  string Name() override;
-  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
-  void DeallocateRaw(void* ptr) override;
+  explicit SYCLMemAllocator(Eigen::QueueInterface* queue);
+  ~SYCLMemAllocator() override;
+
+  void* Alloc(size_t alignment, size_t num_bytes) override;
+  void Free(void* ptr, size_t num_bytes) override;
+
+  // Largest single buffer the device can allocate.
+  size_t max_alloc_size() const { return max_alloc_size_; }
 
-  virtual bool ShouldAllocateEmptyTensors() override final { return true; }
   void Synchronize() {
     mutex_lock lock(mu_);
     if (sycl_device_) {
       sycl_device_->synchronize();
     }
   }
-  bool Ok() { return sycl_device_ && sycl_device_->ok(); }
-  void GetStats(AllocatorStats* stats) override;
-  void ClearStats() override;
-
-  // The SYCL buffers keep track of their size, so we already have tracking.
-  bool TracksAllocationSizes() override { return true; }
-  // Get the size of the corresponding SYCL buffer.
-  // Implementing this also provides an implementation of
-  // AllocatedSize(void* ptr) by default.
-  size_t RequestedSize(void* ptr) override;
-  Eigen::SyclDevice* getSyclDevice() { return sycl_device_; }
-  // Clear the SYCL device used by the Allocator
+  bool Ok() {
+    mutex_lock lock(mu_);
+    return sycl_device_ && sycl_device_->ok();
+  }
+  Eigen::SyclDevice* sycl_device() { return sycl_device_; }
   void ClearSYCLDevice() {
     mutex_lock lock(mu_);
     if (sycl_device_) {
@@ -65,7 +66,48 @@ class SYCLAllocator : public Allocator {
  private:
   mutable mutex mu_;
   Eigen::SyclDevice* sycl_device_ GUARDED_BY(mu_);  // owned
-  AllocatorStats stats_ GUARDED_BY(mu_);
+  size_t max_alloc_size_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SYCLMemAllocator);
+};
+
+// Best-fit with coalescing allocator for a SYCL device.  Tensors are carved
+// out of a few large SYCL buffers reserved up front (or on demand with
+// allow_growth), instead of creating one SYCL buffer per tensor.  A region
+// is never larger than the device max_mem_alloc_size.
+//
+// The pointers handed out are Eigen::SyclDevice virtual pointers, so a
+// tensor may start at a non-zero offset inside its SYCL buffer: kernels
+// that access the buffer directly must go through GetSYCLTensorAccessor in
+// sycl_util.h.
+class SYCLAllocator : public BFCAllocator {
+ public:
+  SYCLAllocator(Eigen::QueueInterface* queue, size_t total_memory,
+                bool allow_growth);
+  ~SYCLAllocator() override {}
+
+  // Cannot allocate no bytes in SYCL, so empty tensors get a single byte.
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return BFCAllocator::AllocateRaw(alignment, std::max<size_t>(num_bytes, 1));
+  }
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr) override {
+    return BFCAllocator::AllocateRaw(
+        alignment, std::max<size_t>(num_bytes, 1), allocation_attr);
+  }
+
+  virtual bool ShouldAllocateEmptyTensors() override final { return true; }
+  void Synchronize() { sub_allocator_->Synchronize(); }
+  bool Ok() { return sub_allocator_->Ok(); }
+  Eigen::SyclDevice* getSyclDevice() { return sub_allocator_->sycl_device(); }
+  // Clear the SYCL device used by the Allocator
+  void ClearSYCLDevice();
+
+ private:
+  SYCLAllocator(SYCLMemAllocator* sub_allocator, size_t total_memory,
+                bool allow_growth);
+
+  SYCLMemAllocator* sub_allocator_;  // owned by BFCAllocator
 
   TF_DISALLOW_COPY_AND_ASSIGN(SYCLAllocator);
 };
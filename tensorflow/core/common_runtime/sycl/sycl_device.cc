@@ -19,6 +19,7 @@ limitations under the License.
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 
 #include "tensorflow/core/framework/tensor.pb_text.h"
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/platform/tracing.h"
 
 namespace tensorflow {
@@ -68,8 +69,14 @@ Status SYCLDevice::MakeTensorFromProto(const TensorProto& tensor_proto,
           " and type ", DataTypeString(parsed.dtype()));
     }
 
-    device_context_->CopyCPUTensorToDevice(
-        &parsed, this, &copy, [&status](const Status& s) { status = s; });
+    // The copy completes asynchronously, and "parsed" lives on this stack.
+    Notification n;
+    device_context_->CopyCPUTensorToDevice(&parsed, this, &copy,
+                                           [&n, &status](const Status& s) {
+                                             status = s;
+                                             n.Notify();
+                                           });
+    n.WaitForNotification();
     *tensor = copy;
   }
   return status;
@@ -23,15 +23,26 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/local_device.h"
 #include "tensorflow/core/common_runtime/sycl/sycl_allocator.h"
 #include "tensorflow/core/common_runtime/sycl/sycl_device_context.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/public/session_options.h"
 
 namespace tensorflow {
 
 class GSYCLInterface {
+  // Share of the device global memory given to the allocator when the
+  // session does not set per_process_gpu_memory_fraction.
+  static constexpr double kDefaultMemoryFraction = 0.9;
+
   std::vector<Eigen::QueueInterface*> m_queue_interface_;  // owned
   std::vector<Allocator*> m_cpu_allocator_;                // not owned
-  std::vector<SYCLAllocator*> m_sycl_allocator_;           // owned
+  std::vector<SYCLEventMgr*> m_event_mgr_;                 // owned
   std::vector<SYCLDeviceContext*> m_sycl_context_;         // ref counted
+  // Created by the first GetSYCLAllocator call, which knows the session
+  // memory options.
+  mutable mutex m_allocator_mu_;
+  mutable std::vector<SYCLAllocator*> m_sycl_allocator_
+      GUARDED_BY(m_allocator_mu_);  // owned
   GSYCLInterface() {
     bool found_device = false;
     auto device_list = Eigen::get_sycl_supported_devices();
@@ -61,14 +72,15 @@ class GSYCLInterface {
     if (!found_device) {
       LOG(WARNING) << "No OpenCL CPU found that is supported by "
                    << "ComputeCpp/triSYCL, checking for host sycl device";
-    }
-
-    for (const auto& device : device_list) {
-      // triSYCL only supports the host device for now
-      if (device.is_host()) {
-        LOG(WARNING) << "Found SYCL host device";
-        AddDevice(device);
-        found_device = true;
+      // The host device is only a fallback, it would otherwise take a
+      // device id next to the OpenCL devices.
+      for (const auto& device : device_list) {
+        // triSYCL only supports the host device for now
+        if (device.is_host()) {
+          LOG(WARNING) << "Found SYCL host device";
+          AddDevice(device);
+          found_device = true;
+        }
       }
     }
 
@@ -78,7 +90,7 @@ class GSYCLInterface {
                  << " supported by ComputeCPP/triSYCL was found";
     } else {
       LOG(INFO) << "Found following OpenCL devices:";
-      for (int i = 0; i < device_list.size(); i++) {
+      for (int i = 0; i < m_queue_interface_.size(); i++) {
         LOG(INFO) << GetShortDeviceDescription(i);
       }
     }
@@ -87,7 +99,9 @@ class GSYCLInterface {
   ~GSYCLInterface() {
     m_cpu_allocator_.clear();
 
+    mutex_lock lock(m_allocator_mu_);
     for (auto p : m_sycl_allocator_) {
+      if (p == nullptr) continue;
       p->Synchronize();
       p->ClearSYCLDevice();
       // Cannot delete the Allocator instances, as the Allocator lifetime
@@ -105,6 +119,12 @@ class GSYCLInterface {
     }
     m_sycl_context_.clear();
 
+    // Waits for the outstanding copies before the queues go away.
+    for (auto p : m_event_mgr_) {
+      delete p;
+    }
+    m_event_mgr_.clear();
+
     for (auto p : m_queue_interface_) {
       p->deallocate_all();
       delete p;
@@ -115,8 +135,9 @@ class GSYCLInterface {
   void AddDevice(const cl::sycl::device& d) {
     m_queue_interface_.push_back(new Eigen::QueueInterface(d));
     m_cpu_allocator_.push_back(cpu_allocator());
-    m_sycl_allocator_.push_back(new SYCLAllocator(m_queue_interface_.back()));
-    m_sycl_context_.push_back(new SYCLDeviceContext());
+    m_sycl_allocator_.push_back(nullptr);
+    m_event_mgr_.push_back(new SYCLEventMgr());
+    m_sycl_context_.push_back(new SYCLDeviceContext(m_event_mgr_.back()));
   }
 
  public:
@@ -126,6 +147,11 @@ class GSYCLInterface {
     return &instance;
   }
 
+  // Every device has its own queue, allocator, event manager and device
+  // context, so the SYCL devices of a process run independently of each
+  // other.
+  size_t NumDevices() const { return m_queue_interface_.size(); }
+
   Eigen::QueueInterface* GetQueueInterface(size_t i = 0) const {
     if (!m_queue_interface_.empty()) {
       return m_queue_interface_[i];
@@ -135,13 +161,34 @@ class GSYCLInterface {
     }
   }
 
-  SYCLAllocator* GetSYCLAllocator(size_t i = 0) const {
-    if (!m_sycl_allocator_.empty()) {
-      return m_sycl_allocator_[i];
-    } else {
+  // The allocator of device i reserves per_process_gpu_memory_fraction of
+  // the device global memory (kDefaultMemoryFraction if unset), all at once
+  // or on demand with allow_growth.  The options of the first call win,
+  // later calls return the same allocator.
+  SYCLAllocator* GetSYCLAllocator(size_t i,
+                                  const GPUOptions& gpu_options) const {
+    mutex_lock lock(m_allocator_mu_);
+    if (m_sycl_allocator_.empty()) {
       std::cerr << "No cl::sycl::device has been added" << std::endl;
       return nullptr;
     }
+    if (m_sycl_allocator_[i] == nullptr) {
+      auto device = m_queue_interface_[i]->sycl_queue().get_device();
+      const uint64 global_mem_size =
+          device.get_info<cl::sycl::info::device::global_mem_size>();
+      double fraction = gpu_options.per_process_gpu_memory_fraction();
+      if (fraction <= 0.0) {
+        fraction = kDefaultMemoryFraction;
+      }
+      const size_t total_memory =
+          static_cast<size_t>(global_mem_size * fraction);
+      VLOG(1) << "SYCL device " << i << " memory limit: "
+              << strings::HumanReadableNumBytes(total_memory)
+              << (gpu_options.allow_growth() ? " (allow_growth)" : "");
+      m_sycl_allocator_[i] = new SYCLAllocator(
+          m_queue_interface_[i], total_memory, gpu_options.allow_growth());
+    }
+    return m_sycl_allocator_[i];
   }
 
   Allocator* GetCPUAllocator(size_t i = 0) const {
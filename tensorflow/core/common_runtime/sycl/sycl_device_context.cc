@@ -17,86 +17,116 @@ limitations under the License.
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 
+#include "tensorflow/core/common_runtime/copy_tensor.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/sycl/sycl_device_context.h"
+#include "tensorflow/core/lib/core/errors.h"
 
 namespace tensorflow {
 
+namespace {
+
+// The tensor may start at an offset inside its SYCL buffer, so the copies
+// use ranged accessors over the tensor bytes only.
+cl::sycl::event CopyHostToDevice(const Eigen::SyclDevice &device,
+                                 const void *src_ptr, void *dst_ptr,
+                                 size_t total_bytes) {
+  auto buffer = device.get_sycl_buffer(dst_ptr);
+  const size_t offset = device.get_offset(dst_ptr);
+  return device.sycl_queue().submit([&](cl::sycl::handler &cgh) {
+    auto dst_acc =
+        buffer.template get_access<cl::sycl::access::mode::discard_write>(
+            cgh, cl::sycl::range<1>(total_bytes), cl::sycl::id<1>(offset));
+    cgh.copy(static_cast<const uint8_t *>(src_ptr), dst_acc);
+  });
+}
+
+cl::sycl::event CopyDeviceToHost(const Eigen::SyclDevice &device,
+                                 const void *src_ptr, void *dst_ptr,
+                                 size_t total_bytes) {
+  auto buffer = device.get_sycl_buffer(src_ptr);
+  const size_t offset = device.get_offset(src_ptr);
+  return device.sycl_queue().submit([&](cl::sycl::handler &cgh) {
+    auto src_acc = buffer.template get_access<cl::sycl::access::mode::read>(
+        cgh, cl::sycl::range<1>(total_bytes), cl::sycl::id<1>(offset));
+    cgh.copy(src_acc, static_cast<uint8_t *>(dst_ptr));
+  });
+}
+
+// Each device maps its pointers to its own SYCL buffers.  The copy is
+// enqueued on the destination queue, and the SYCL runtime orders it after
+// the pending work of the source queue on the source buffer.
+cl::sycl::event CopyPeerToPeer(const Eigen::SyclDevice &src_device,
+                               const void *src_ptr,
+                               const Eigen::SyclDevice &dst_device,
+                               void *dst_ptr, size_t total_bytes) {
+  auto src_buffer = src_device.get_sycl_buffer(src_ptr);
+  const size_t src_offset = src_device.get_offset(src_ptr);
+  auto dst_buffer = dst_device.get_sycl_buffer(dst_ptr);
+  const size_t dst_offset = dst_device.get_offset(dst_ptr);
+  return dst_device.sycl_queue().submit([&](cl::sycl::handler &cgh) {
+    auto src_acc =
+        src_buffer.template get_access<cl::sycl::access::mode::read>(
+            cgh, cl::sycl::range<1>(total_bytes), cl::sycl::id<1>(src_offset));
+    auto dst_acc =
+        dst_buffer.template get_access<cl::sycl::access::mode::discard_write>(
+            cgh, cl::sycl::range<1>(total_bytes), cl::sycl::id<1>(dst_offset));
+    cgh.copy(src_acc, dst_acc);
+  });
+}
+
+void SYCLDeviceToDeviceCopy(DeviceContext *send_dev_context,
+                            DeviceContext *recv_dev_context, Device *src,
+                            Device *dst, AllocatorAttributes src_alloc_attr,
+                            AllocatorAttributes dst_alloc_attr,
+                            const Tensor *input, Tensor *output,
+                            StatusCallback done) {
+  const int64 total_bytes = input->TotalBytes();
+  if (total_bytes == 0) {
+    done(Status::OK());
+    return;
+  }
+  const void *src_ptr = DMAHelper::base(input);
+  void *dst_ptr = DMAHelper::base(output);
+  cl::sycl::event event;
+  try {
+    event = CopyPeerToPeer(*src->eigen_sycl_device(), src_ptr,
+                           *dst->eigen_sycl_device(), dst_ptr, total_bytes);
+  } catch (const cl::sycl::exception &e) {
+    done(errors::Internal("SYCL device to device copy from ", src->name(),
+                          " to ", dst->name(), " failed: ", e.what()));
+    return;
+  }
+  static_cast<SYCLDeviceContext *>(recv_dev_context)
+      ->event_mgr()
+      ->ThenExecute(event, [done]() { done(Status::OK()); });
+}
+
+}  // namespace
+
+static CopyTensor::Registration register_sycl_sycl_copy(
+    DEVICE_SYCL, DEVICE_SYCL, SYCLDeviceToDeviceCopy);
+
 void SYCLDeviceContext::CopyCPUTensorToDevice(const Tensor *cpu_tensor,
                                               Device *device,
                                               Tensor *device_tensor,
                                               StatusCallback done) const {
   const int64 total_bytes = cpu_tensor->TotalBytes();
-  if (total_bytes > 0) {
-    const void *src_ptr = DMAHelper::base(cpu_tensor);
-    void *dst_ptr = DMAHelper::base(device_tensor);
-    switch (cpu_tensor->dtype()) {
-      case DT_FLOAT:
-        device->eigen_sycl_device()->memcpyHostToDevice(
-            static_cast<float *>(dst_ptr), static_cast<const float *>(src_ptr),
-            total_bytes);
-        break;
-      case DT_DOUBLE:
-        device->eigen_sycl_device()->memcpyHostToDevice(
-            static_cast<double *>(dst_ptr),
-            static_cast<const double *>(src_ptr), total_bytes);
-        break;
-      case DT_INT32:
-        device->eigen_sycl_device()->memcpyHostToDevice(
-            static_cast<int32 *>(dst_ptr), static_cast<const int32 *>(src_ptr),
-            total_bytes);
-        break;
-      case DT_INT64:
-        device->eigen_sycl_device()->memcpyHostToDevice(
-            static_cast<int64 *>(dst_ptr), static_cast<const int64 *>(src_ptr),
-            total_bytes);
-        break;
-      case DT_HALF:
-        device->eigen_sycl_device()->memcpyHostToDevice(
-            static_cast<Eigen::half *>(dst_ptr),
-            static_cast<const Eigen::half *>(src_ptr), total_bytes);
-        break;
-      case DT_COMPLEX64:
-        device->eigen_sycl_device()->memcpyHostToDevice(
-            static_cast<std::complex<float> *>(dst_ptr),
-            static_cast<const std::complex<float> *>(src_ptr), total_bytes);
-        break;
-      case DT_COMPLEX128:
-        device->eigen_sycl_device()->memcpyHostToDevice(
-            static_cast<std::complex<double> *>(dst_ptr),
-            static_cast<const std::complex<double> *>(src_ptr), total_bytes);
-        break;
-      case DT_INT8:
-        device->eigen_sycl_device()->memcpyHostToDevice(
-            static_cast<int8 *>(dst_ptr), static_cast<const int8 *>(src_ptr),
-            total_bytes);
-        break;
-      case DT_INT16:
-        device->eigen_sycl_device()->memcpyHostToDevice(
-            static_cast<int16 *>(dst_ptr), static_cast<const int16 *>(src_ptr),
-            total_bytes);
-        break;
-      case DT_UINT8:
-        device->eigen_sycl_device()->memcpyHostToDevice(
-            static_cast<uint8 *>(dst_ptr), static_cast<const uint8 *>(src_ptr),
-            total_bytes);
-        break;
-      case DT_UINT16:
-        device->eigen_sycl_device()->memcpyHostToDevice(
-            static_cast<uint16 *>(dst_ptr),
-            static_cast<const uint16 *>(src_ptr), total_bytes);
-        break;
-      case DT_BOOL:
-        device->eigen_sycl_device()->memcpyHostToDevice(
-            static_cast<bool *>(dst_ptr), static_cast<const bool *>(src_ptr),
-            total_bytes);
-        break;
-      default:
-        assert(false && "unsupported type");
-    }
+  if (total_bytes == 0) {
+    done(Status::OK());
+    return;
+  }
+  const void *src_ptr = DMAHelper::base(cpu_tensor);
+  void *dst_ptr = DMAHelper::base(device_tensor);
+  cl::sycl::event event;
+  try {
+    event = CopyHostToDevice(*device->eigen_sycl_device(), src_ptr, dst_ptr,
+                             total_bytes);
+  } catch (const cl::sycl::exception &e) {
+    done(errors::Internal("SYCL host to device copy failed: ", e.what()));
+    return;
   }
-  device->eigen_sycl_device()->synchronize();
-  done(Status::OK());
+  event_mgr_->ThenExecute(event, [done]() { done(Status::OK()); });
 }
 
 void SYCLDeviceContext::CopyDeviceTensorToCPU(const Tensor *device_tensor,
@@ -105,76 +135,21 @@ void SYCLDeviceContext::CopyDeviceTensorToCPU(const Tensor *device_tensor,
                                               Tensor *cpu_tensor,
                                               StatusCallback done) {
   const int64 total_bytes = device_tensor->TotalBytes();
-  if (total_bytes > 0) {
-    const void *src_ptr = DMAHelper::base(device_tensor);
-    void *dst_ptr = DMAHelper::base(cpu_tensor);
-    switch (device_tensor->dtype()) {
-      case DT_FLOAT:
-        device->eigen_sycl_device()->memcpyDeviceToHost(
-            static_cast<float *>(dst_ptr), static_cast<const float *>(src_ptr),
-            total_bytes);
-        break;
-      case DT_DOUBLE:
-        device->eigen_sycl_device()->memcpyDeviceToHost(
-            static_cast<double *>(dst_ptr),
-            static_cast<const double *>(src_ptr), total_bytes);
-        break;
-      case DT_INT32:
-        device->eigen_sycl_device()->memcpyDeviceToHost(
-            static_cast<int32 *>(dst_ptr), static_cast<const int32 *>(src_ptr),
-            total_bytes);
-        break;
-      case DT_INT64:
-        device->eigen_sycl_device()->memcpyDeviceToHost(
-            static_cast<int64 *>(dst_ptr), static_cast<const int64 *>(src_ptr),
-            total_bytes);
-        break;
-      case DT_HALF:
-        device->eigen_sycl_device()->memcpyDeviceToHost(
-            static_cast<Eigen::half *>(dst_ptr),
-            static_cast<const Eigen::half *>(src_ptr), total_bytes);
-        break;
-      case DT_COMPLEX64:
-        device->eigen_sycl_device()->memcpyDeviceToHost(
-            static_cast<std::complex<float> *>(dst_ptr),
-            static_cast<const std::complex<float> *>(src_ptr), total_bytes);
-        break;
-      case DT_COMPLEX128:
-        device->eigen_sycl_device()->memcpyDeviceToHost(
-            static_cast<std::complex<double> *>(dst_ptr),
-            static_cast<const std::complex<double> *>(src_ptr), total_bytes);
-        break;
-      case DT_INT8:
-        device->eigen_sycl_device()->memcpyDeviceToHost(
-            static_cast<int8 *>(dst_ptr), static_cast<const int8 *>(src_ptr),
-            total_bytes);
-        break;
-      case DT_INT16:
-        device->eigen_sycl_device()->memcpyDeviceToHost(
-            static_cast<int16 *>(dst_ptr), static_cast<const int16 *>(src_ptr),
-            total_bytes);
-        break;
-      case DT_UINT8:
-        device->eigen_sycl_device()->memcpyDeviceToHost(
-            static_cast<uint8 *>(dst_ptr), static_cast<const uint8 *>(src_ptr),
-            total_bytes);
-        break;
-      case DT_UINT16:
-        device->eigen_sycl_device()->memcpyDeviceToHost(
-            static_cast<uint16 *>(dst_ptr),
-            static_cast<const uint16 *>(src_ptr), total_bytes);
-        break;
-      case DT_BOOL:
-        device->eigen_sycl_device()->memcpyDeviceToHost(
-            static_cast<bool *>(dst_ptr), static_cast<const bool *>(src_ptr),
-            total_bytes);
-        break;
-      default:
-        assert(false && "unsupported type");
-    }
+  if (total_bytes == 0) {
+    done(Status::OK());
+    return;
+  }
+  const void *src_ptr = DMAHelper::base(device_tensor);
+  void *dst_ptr = DMAHelper::base(cpu_tensor);
+  cl::sycl::event event;
+  try {
+    event = CopyDeviceToHost(*device->eigen_sycl_device(), src_ptr, dst_ptr,
+                             total_bytes);
+  } catch (const cl::sycl::exception &e) {
+    done(errors::Internal("SYCL device to host copy failed: ", e.what()));
+    return;
   }
-  device->eigen_sycl_device()->synchronize();
-  done(Status::OK());
+  event_mgr_->ThenExecute(event, [done]() { done(Status::OK()); });
 }
 
 }  // namespace tensorflow
@@ -21,13 +21,20 @@ limitations under the License.
 #define TENSORFLOW_COMMON_RUNTIME_SYCL_SYCL_DEVICE_CONTEXT_H_
 
 #include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/sycl/sycl_event_mgr.h"
 #include "tensorflow/core/framework/device_base.h"
 
 namespace tensorflow {
 
+// Host <-> device copies are submitted as their own command groups, and
+// "done" is called by the event manager once that copy has completed,
+// without draining the rest of the SYCL queue.  Copies between two SYCL
+// devices are registered with CopyTensor in sycl_device_context.cc and do
+// not go through the host.
 class SYCLDeviceContext : public DeviceContext {
  public:
-  SYCLDeviceContext() {}
+  explicit SYCLDeviceContext(SYCLEventMgr *event_mgr)
+      : event_mgr_(event_mgr) {}
 
   ~SYCLDeviceContext() override {}
 
@@ -38,6 +45,11 @@ class SYCLDeviceContext : public DeviceContext {
   void CopyDeviceTensorToCPU(const Tensor *device_tensor, StringPiece edge_name,
                              Device *device, Tensor *cpu_tensor,
                              StatusCallback done) override;
+
+  SYCLEventMgr *event_mgr() const { return event_mgr_; }
+
+ private:
+  SYCLEventMgr *event_mgr_;  // not owned
 };
 
 }  // namespace tensorflow
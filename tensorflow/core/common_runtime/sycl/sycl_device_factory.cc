@@ -15,6 +15,8 @@ limitations under the License.
 
 #if TENSORFLOW_USE_SYCL
 
+#include <algorithm>
+
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/sycl/sycl_device.h"
 
@@ -28,19 +30,28 @@ class SYCLDeviceFactory : public DeviceFactory {
                        std::vector<Device *> *devices) override {
     auto syclInterface = GSYCLInterface::instance();
 
-    size_t n = 1;
+    // One TensorFlow device per SYCL queue, unless the session asks for
+    // fewer, so that graphs can be replicated over all of them.
+    size_t n = syclInterface->NumDevices();
     auto iter = options.config.device_count().find("SYCL");
     if (iter != options.config.device_count().end()) {
-      n = iter->second;
+      if (iter->second > n) {
+        LOG(WARNING) << "Requested " << iter->second << " SYCL devices, but "
+                     << "only " << n << " are available";
+      }
+      n = std::min<size_t>(n, iter->second);
     }
 
     for (int i = 0; i < n; i++) {
       string name = strings::StrCat(name_prefix, "/device:SYCL:", i);
+      SYCLAllocator *sycl_allocator =
+          syclInterface->GetSYCLAllocator(i, options.config.gpu_options());
+      AllocatorStats stats;
+      sycl_allocator->GetStats(&stats);
       devices->push_back(new SYCLDevice(
-          options, name, Bytes(256 << 20), DeviceLocality(),
-          syclInterface->GetShortDeviceDescription(i),
-          syclInterface->GetSYCLAllocator(i), syclInterface->GetCPUAllocator(i),
-          syclInterface->GetSYCLContext(i)));
+          options, name, Bytes(stats.bytes_limit), DeviceLocality(),
+          syclInterface->GetShortDeviceDescription(i), sycl_allocator,
+          syclInterface->GetCPUAllocator(i), syclInterface->GetSYCLContext(i)));
     }
 
     return Status::OK();
@@ -0,0 +1,163 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifdef TENSORFLOW_USE_SYCL
+
+#include "tensorflow/core/common_runtime/sycl/sycl_device.h"
+
+#include <memory>
+#include <set>
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/common_runtime/copy_tensor.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow/core/public/session_options.h"
+
+// The multi-device tests need two SYCL devices, e.g. two POCL CPU devices
+// with POCL_DEVICES="pthread pthread", and pass trivially otherwise.
+
+namespace tensorflow {
+namespace {
+
+const char kTaskName[] = "/job:localhost/replica:0/task:0";
+
+SessionOptions SYCLSessionOptions(int num_devices) {
+  SessionOptions options;
+  (*options.config.mutable_device_count())["SYCL"] = num_devices;
+  return options;
+}
+
+std::vector<std::unique_ptr<Device>> NewSYCLDevices(int num_devices) {
+  std::vector<Device*> devices;
+  TF_CHECK_OK(DeviceFactory::GetFactory("SYCL")->CreateDevices(
+      SYCLSessionOptions(num_devices), kTaskName, &devices));
+  std::vector<std::unique_ptr<Device>> owned;
+  for (Device* d : devices) owned.emplace_back(d);
+  return owned;
+}
+
+bool HasTwoSYCLDevices() {
+  if (GSYCLInterface::instance()->NumDevices() < 2) {
+    LOG(INFO) << "Skipping test, it needs two SYCL devices";
+    return false;
+  }
+  return true;
+}
+
+DeviceContext* GetSYCLContext(size_t i) {
+  return GSYCLInterface::instance()->GetSYCLContext(i);
+}
+
+Status WaitFor(const std::function<void(StatusCallback)>& copy) {
+  Status status;
+  Notification n;
+  copy([&n, &status](const Status& s) {
+    status = s;
+    n.Notify();
+  });
+  n.WaitForNotification();
+  return status;
+}
+
+TEST(SYCLDevice, OneDevicePerQueue) {
+  const size_t num_devices = GSYCLInterface::instance()->NumDevices();
+  auto devices = NewSYCLDevices(num_devices);
+  ASSERT_EQ(num_devices, devices.size());
+
+  std::set<string> names;
+  std::set<Allocator*> allocators;
+  for (int i = 0; i < devices.size(); ++i) {
+    EXPECT_EQ(strings::StrCat(kTaskName, "/device:SYCL:", i),
+              devices[i]->name());
+    names.insert(devices[i]->name());
+    allocators.insert(devices[i]->GetAllocator(AllocatorAttributes()));
+  }
+  EXPECT_EQ(num_devices, names.size());
+  EXPECT_EQ(num_devices, allocators.size());
+
+  // Asking for more devices than there are queues is not an error.
+  EXPECT_EQ(num_devices, NewSYCLDevices(num_devices + 1).size());
+}
+
+TEST(SYCLDevice, PeerCopy) {
+  if (!HasTwoSYCLDevices()) return;
+  auto devices = NewSYCLDevices(2);
+  Device* src = devices[0].get();
+  Device* dst = devices[1].get();
+  Allocator* src_allocator = src->GetAllocator(AllocatorAttributes());
+  Allocator* dst_allocator = dst->GetAllocator(AllocatorAttributes());
+
+  Tensor cpu(DT_FLOAT, TensorShape({7, 300}));
+  cpu.flat<float>().setRandom();
+  // Offset the tensors inside their SYCL buffers, differently on each side.
+  Tensor src_unused(src_allocator, DT_FLOAT, TensorShape({5}));
+  Tensor on_src(src_allocator, DT_FLOAT, cpu.shape());
+  Tensor dst_unused(dst_allocator, DT_FLOAT, TensorShape({33}));
+  Tensor on_dst(dst_allocator, DT_FLOAT, cpu.shape());
+
+  TF_ASSERT_OK(WaitFor([&](StatusCallback done) {
+    GetSYCLContext(0)->CopyCPUTensorToDevice(&cpu, src, &on_src, done);
+  }));
+  TF_ASSERT_OK(WaitFor([&](StatusCallback done) {
+    CopyTensor::ViaDMA("peer", GetSYCLContext(0), GetSYCLContext(1), src, dst,
+                       AllocatorAttributes(), AllocatorAttributes(), &on_src,
+                       &on_dst, done);
+  }));
+  Tensor back(DT_FLOAT, cpu.shape());
+  TF_ASSERT_OK(WaitFor([&](StatusCallback done) {
+    GetSYCLContext(1)->CopyDeviceTensorToCPU(&on_dst, "", dst, &back, done);
+  }));
+  test::ExpectTensorEqual<float>(cpu, back);
+}
+
+// Splits a batch over two SYCL devices, runs the same MatMul on both halves
+// and concatenates the results on the CPU.
+TEST(SYCLDevice, DataParallelReplicas) {
+  if (!HasTwoSYCLDevices()) return;
+  Scope root = Scope::NewRootScope().WithDevice("/cpu:0");
+  Tensor x_data(DT_FLOAT, TensorShape({8, 16}));
+  x_data.flat<float>().setRandom();
+  Tensor w_data(DT_FLOAT, TensorShape({16, 4}));
+  w_data.flat<float>().setRandom();
+  auto x = ops::Const(root, Input::Initializer(x_data));
+  auto w = ops::Const(root, Input::Initializer(w_data));
+  auto halves = ops::Split(root, 0, x, 2);
+
+  std::vector<Output> replicas;
+  for (int i = 0; i < 2; ++i) {
+    Scope device = root.WithDevice(strings::StrCat("/device:SYCL:", i));
+    replicas.push_back(ops::MatMul(device, halves.output[i], w));
+  }
+  auto replicated = ops::Concat(root, replicas, 0);
+  auto expected = ops::MatMul(root, x, w);
+  GraphDef graph;
+  TF_ASSERT_OK(root.ToGraphDef(&graph));
+
+  std::unique_ptr<Session> session(NewSession(SYCLSessionOptions(2)));
+  TF_ASSERT_OK(session->Create(graph));
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->Run(
+      {}, {replicated.node()->name(), expected.node()->name()}, {}, &outputs));
+  test::ExpectClose(outputs[1], outputs[0], 1e-4, 1e-4);
+}
+
+}  // namespace
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_USE_SYCL
@@ -0,0 +1,125 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifdef TENSORFLOW_USE_SYCL
+
+#include "tensorflow/core/common_runtime/sycl/sycl_event_mgr.h"
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+bool EventCompleted(const cl::sycl::event& event) {
+  return event.get_info<cl::sycl::info::event::command_execution_status>() ==
+         cl::sycl::info::event_command_status::complete;
+}
+
+}  // namespace
+
+SYCLEventMgr::SYCLEventMgr()
+    : polling_active_delay_usecs_(10),
+      polling_inactive_delay_msecs_(1),
+      // threadpool_ has 1 thread for the polling loop, and one to execute
+      // event callback functions.
+      threadpool_(Env::Default(), "SYCL_Event_Manager", 2) {
+  StartPollingLoop();
+}
+
+SYCLEventMgr::~SYCLEventMgr() {
+  StopPollingLoop();
+
+  // The callbacks still own references to host tensors, so wait for the
+  // outstanding transfers instead of dropping them.
+  while (!used_events_.empty()) {
+    InUse* iu = &used_events_[0];
+    iu->event.wait();
+    threadpool_.Schedule(iu->func);
+    used_events_.pop_front();
+  }
+}
+
+void SYCLEventMgr::StartPollingLoop() {
+  CHECK(polling_stopped_ == nullptr);
+  stop_polling_.reset(new Notification);
+  polling_stopped_.reset(new Notification);
+  threadpool_.Schedule([this]() { PollLoop(); });
+}
+
+void SYCLEventMgr::StopPollingLoop() {
+  if (stop_polling_) {
+    stop_polling_->Notify();
+    polling_stopped_->WaitForNotification();
+    stop_polling_.reset(nullptr);
+    polling_stopped_.reset(nullptr);
+  }
+}
+
+void SYCLEventMgr::ThenExecute(cl::sycl::event event,
+                               std::function<void()> func) {
+  ToRunVector to_run;
+  {
+    mutex_lock l(mu_);
+    bool was_empty = used_events_.empty();
+    used_events_.push_back({std::move(event), std::move(func)});
+    PollEvents(false, &to_run);
+    // Maybe wake up the polling thread
+    if (was_empty) events_pending_.notify_all();
+  }
+  RunCallbacks(to_run);
+}
+
+// Same strategy as EventMgr::PollLoop: poll frequently while events are
+// pending, and infrequently otherwise.
+void SYCLEventMgr::PollLoop() {
+  bool queue_empty = false;
+  while (!stop_polling_->HasBeenNotified()) {
+    if (queue_empty) {
+      mutex_lock l(mu_);
+      WaitForMilliseconds(&l, &events_pending_, polling_inactive_delay_msecs_);
+    } else {
+      Env::Default()->SleepForMicroseconds(polling_active_delay_usecs_);
+    }
+    ToRunVector to_run;
+    {
+      mutex_lock l(mu_);
+      PollEvents(true, &to_run);
+      queue_empty = used_events_.empty();
+    }
+    RunCallbacks(to_run);
+  }
+  polling_stopped_->Notify();
+}
+
+void SYCLEventMgr::PollEvents(bool is_dedicated_poller, ToRunVector* to_run) {
+  VLOG(2) << "PollEvents used_events_ " << used_events_.size();
+  auto it = used_events_.begin();
+  while (it != used_events_.end()) {
+    if (EventCompleted(it->event)) {
+      to_run->push_back(std::move(*it));
+      it = used_events_.erase(it);
+    } else if (is_dedicated_poller) {
+      ++it;
+    } else {
+      break;
+    }
+  }
+}
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_USE_SYCL
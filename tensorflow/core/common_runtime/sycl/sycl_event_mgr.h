@@ -0,0 +1,99 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if !TENSORFLOW_USE_SYCL
+#error This file must only be included when building TensorFlow with SYCL support
+#endif
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_SYCL_SYCL_EVENT_MGR_H_
+#define TENSORFLOW_COMMON_RUNTIME_SYCL_SYCL_EVENT_MGR_H_
+
+#include <deque>
+#include <functional>
+#include <memory>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Runs callbacks once specific SYCL events have completed, without waiting
+// for the rest of the queue.  This is the SYCL counterpart of EventMgr in
+// gpu/gpu_event_mgr.h: a dedicated thread polls the pending events, and
+// callbacks run on a separate thread so they never block the poller.
+class SYCLEventMgr {
+ public:
+  SYCLEventMgr();
+  ~SYCLEventMgr();
+
+  // Calls "func" on another thread once "event" has completed.
+  void ThenExecute(cl::sycl::event event, std::function<void()> func);
+
+ private:
+  friend class TEST_SYCLEventMgrHelper;
+
+  struct InUse {
+    cl::sycl::event event;
+    std::function<void()> func;
+  };
+
+  typedef gtl::InlinedVector<InUse, 4> ToRunVector;
+
+  void RunCallbacks(const ToRunVector& to_run) {
+    for (const auto& iu : to_run) {
+      // The function must be called in another thread.
+      threadpool_.Schedule(iu.func);
+    }
+  }
+
+  // Moves the completed events to "*to_run".  Calls made when queueing a
+  // new event stop at the first pending one, the dedicated poller sweeps
+  // the whole queue since copies and kernels may complete out of order.
+  void PollEvents(bool is_dedicated_poller, ToRunVector* to_run)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // An internal polling loop that runs at a low frequency to clear
+  // straggler events.
+  void PollLoop();
+
+  // Setup/Teardown functions for the polling loop.
+  void StartPollingLoop();
+  void StopPollingLoop();
+
+  const int32 polling_active_delay_usecs_;
+  const int32 polling_inactive_delay_msecs_;
+  mutex mu_;
+  condition_variable events_pending_ GUARDED_BY(mu_);
+
+  // A FIFO queue of pending events and their callbacks.
+  std::deque<InUse> used_events_ GUARDED_BY(mu_);
+
+  std::unique_ptr<Notification> stop_polling_;
+  std::unique_ptr<Notification> polling_stopped_;
+
+  // The polling loop runs in this threadpool, next to the callbacks.
+  thread::ThreadPool threadpool_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SYCLEventMgr);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_SYCL_SYCL_EVENT_MGR_H_
@@ -0,0 +1,182 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifdef TENSORFLOW_USE_SYCL
+
+#include "tensorflow/core/common_runtime/sycl/sycl_event_mgr.h"
+
+#include <memory>
+
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/sycl/sycl_device.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+
+class TEST_SYCLEventMgrHelper {
+ public:
+  explicit TEST_SYCLEventMgrHelper(SYCLEventMgr* em) : em_(em) {}
+
+  size_t queue_size() {
+    mutex_lock l(em_->mu_);
+    return em_->used_events_.size();
+  }
+
+ private:
+  SYCLEventMgr* em_;
+};
+
+namespace {
+
+std::unique_ptr<Device> NewSYCLDevice() {
+  return std::unique_ptr<Device>(DeviceFactory::NewDevice(
+      "SYCL", SessionOptions(), "/job:localhost/replica:0/task:0"));
+}
+
+SYCLDeviceContext* GetSYCLContext() {
+  return GSYCLInterface::instance()->GetSYCLContext(0);
+}
+
+Status CopyToDeviceAndWait(Device* device, const Tensor& cpu,
+                           Tensor* on_device) {
+  Status status;
+  Notification n;
+  GetSYCLContext()->CopyCPUTensorToDevice(&cpu, device, on_device,
+                                          [&n, &status](const Status& s) {
+                                            status = s;
+                                            n.Notify();
+                                          });
+  n.WaitForNotification();
+  return status;
+}
+
+Status CopyToHostAndWait(Device* device, const Tensor& on_device,
+                         Tensor* cpu) {
+  Status status;
+  Notification n;
+  GetSYCLContext()->CopyDeviceTensorToCPU(&on_device, "", device, cpu,
+                                          [&n, &status](const Status& s) {
+                                            status = s;
+                                            n.Notify();
+                                          });
+  n.WaitForNotification();
+  return status;
+}
+
+TEST(SYCLEventMgr, Empty) {
+  SYCLEventMgr em;
+  TEST_SYCLEventMgrHelper th(&em);
+  EXPECT_EQ(0, th.queue_size());
+}
+
+TEST(SYCLEventMgr, RoundTrip) {
+  auto device = NewSYCLDevice();
+  Allocator* sycl_allocator = device->GetAllocator(AllocatorAttributes());
+
+  Tensor cpu(DT_FLOAT, TensorShape({3, 1000}));
+  cpu.flat<float>().setRandom();
+  // Several device tensors share a SYCL buffer, copy into a later one so
+  // the buffer offset is exercised.
+  Tensor unused(sycl_allocator, DT_FLOAT, TensorShape({17}));
+  Tensor on_device(sycl_allocator, DT_FLOAT, cpu.shape());
+  TF_ASSERT_OK(CopyToDeviceAndWait(device.get(), cpu, &on_device));
+
+  Tensor back(DT_FLOAT, cpu.shape());
+  TF_ASSERT_OK(CopyToHostAndWait(device.get(), on_device, &back));
+  test::ExpectTensorEqual<float>(cpu, back);
+}
+
+TEST(SYCLEventMgr, ManyCopiesInFlight) {
+  auto device = NewSYCLDevice();
+  Allocator* sycl_allocator = device->GetAllocator(AllocatorAttributes());
+
+  const int kNumCopies = 64;
+  std::vector<Tensor> cpu;
+  std::vector<Tensor> on_device;
+  for (int i = 0; i < kNumCopies; ++i) {
+    cpu.emplace_back(DT_INT32, TensorShape({256}));
+    cpu.back().flat<int32>().setConstant(i);
+    on_device.emplace_back(sycl_allocator, DT_INT32, TensorShape({256}));
+  }
+  BlockingCounter counter(kNumCopies);
+  for (int i = 0; i < kNumCopies; ++i) {
+    GetSYCLContext()->CopyCPUTensorToDevice(&cpu[i], device.get(),
+                                            &on_device[i],
+                                            [&counter](const Status& s) {
+                                              TF_EXPECT_OK(s);
+                                              counter.DecrementCount();
+                                            });
+  }
+  counter.Wait();
+
+  for (int i = 0; i < kNumCopies; ++i) {
+    Tensor back(DT_INT32, TensorShape({256}));
+    TF_ASSERT_OK(CopyToHostAndWait(device.get(), on_device[i], &back));
+    test::ExpectTensorEqual<int32>(cpu[i], back);
+  }
+}
+
+// Host to device copies issued while the device is busy with unrelated
+// work.  BM_CopyWhileComputing only waits for the copy itself,
+// BM_CopyThenSync also drains the queue after each copy, which is what
+// every transfer used to cost.
+void CopyComputeOverlap(int iters, int num_floats, bool sync_after_copy) {
+  testing::StopTiming();
+  auto device = NewSYCLDevice();
+  Allocator* sycl_allocator = device->GetAllocator(AllocatorAttributes());
+  const Eigen::SyclDevice& d = *device->eigen_sycl_device();
+
+  Tensor compute_in(sycl_allocator, DT_FLOAT, TensorShape({1 << 22}));
+  Tensor compute_out(sycl_allocator, DT_FLOAT, TensorShape({1 << 22}));
+  compute_in.flat<float>().device(d) = compute_in.flat<float>().constant(1.f);
+  Tensor cpu(DT_FLOAT, TensorShape({num_floats}));
+  cpu.flat<float>().setRandom();
+  Tensor on_device(sycl_allocator, DT_FLOAT, cpu.shape());
+  TF_CHECK_OK(device->Sync());
+
+  testing::BytesProcessed(static_cast<int64>(iters) * num_floats *
+                          sizeof(float));
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    compute_out.flat<float>().device(d) =
+        (compute_in.flat<float>() * compute_in.flat<float>()).sqrt().exp();
+    TF_CHECK_OK(CopyToDeviceAndWait(device.get(), cpu, &on_device));
+    if (sync_after_copy) {
+      TF_CHECK_OK(device->Sync());
+    }
+  }
+  TF_CHECK_OK(device->Sync());
+  testing::StopTiming();
+}
+
+static void BM_CopyWhileComputing(int iters, int num_floats) {
+  CopyComputeOverlap(iters, num_floats, false);
+}
+BENCHMARK(BM_CopyWhileComputing)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20);
+
+static void BM_CopyThenSync(int iters, int num_floats) {
+  CopyComputeOverlap(iters, num_floats, true);
+}
+BENCHMARK(BM_CopyThenSync)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20);
+
+}  // namespace
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_USE_SYCL
@@ -30,6 +30,41 @@ namespace tensorflow {
 inline void const* GetBase(const Tensor* src) { return DMAHelper::base(src); }
 inline void* GetBase(Tensor* dst) { return DMAHelper::base(dst); }
 
+// SYCLAllocator sub-allocates tensors out of large SYCL buffers, so the data
+// of a tensor starts at some byte offset in the buffer returned by
+// get_sycl_buffer.  Kernels that access SYCL buffers directly use this
+// accessor, which carries the offset, instead of a plain buffer accessor.
+template <cl::sycl::access::mode Mode>
+class SYCLTensorAccessor {
+ public:
+  using accessor_type =
+      cl::sycl::accessor<uint8_t, 1, Mode,
+                         cl::sycl::access::target::global_buffer>;
+
+  SYCLTensorAccessor(const accessor_type& accessor, size_t offset)
+      : accessor_(accessor), offset_(offset) {}
+
+  // Pointer to the first element of the tensor, valid inside a kernel.
+  template <typename T>
+  T* get() const {
+    return reinterpret_cast<T*>(ConvertToActualTypeSycl(uint8_t, accessor_) +
+                                offset_);
+  }
+
+ private:
+  accessor_type accessor_;
+  size_t offset_;
+};
+
+template <cl::sycl::access::mode Mode>
+inline SYCLTensorAccessor<Mode> GetSYCLTensorAccessor(
+    const Eigen::SyclDevice& device, const void* ptr,
+    cl::sycl::handler& cgh) {
+  auto buffer = device.get_sycl_buffer(ptr);
+  return SYCLTensorAccessor<Mode>(buffer.template get_access<Mode>(cgh),
+                                  device.get_offset(ptr));
+}
+
 inline void SYCLmemcpy(Eigen::SyclDevice const& device,
                        Tensor const& src_tensor, Tensor* dst_tensor) {
   const size_t size = src_tensor.TotalBytes();
@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/graph/graph_constructor.h"
+#include "tensorflow/core/graph/testlib.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
@@ -56,8 +57,9 @@ class ExecutorTest : public ::testing::Test {
     delete device_;
   }
 
-  // Resets executor_ with a new executor based on a graph 'gdef'.
-  void Create(const Graph* graph) {
+  // Resets executor_ with a new executor based on a graph 'gdef'.  The
+  // executor records the costs of its sampled steps in 'sampler', if set.
+  void Create(const Graph* graph, OpOverheadSampler* sampler = nullptr) {
     const int version = graph->versions().producer();
     LocalExecutorParams params;
     params.device = device_;
@@ -68,6 +70,7 @@ class ExecutorTest : public ::testing::Test {
     params.delete_kernel = [](OpKernel* kernel) {
       DeleteNonCachedKernel(kernel);
     };
+    params.op_overhead_sampler = sampler;
     delete exec_;
     TF_CHECK_OK(NewLocalExecutor(params, graph, &exec_));
     runner_ = [this](std::function<void()> fn) { thread_pool_->Schedule(fn); };
@@ -163,6 +166,41 @@ TEST_F(ExecutorTest, SimpleAdd) {
   EXPECT_EQ(2.0, V(out));  // out = 1.0 + 1.0 = 2.0
 }
 
+TEST_F(ExecutorTest, SampledStepRecordsOpCosts) {
+  OpOverheadSampler sampler(1);
+  // c = ((a + a) + ...) on a 256x256 float tensor
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* node = test::graph::Recv(g, "a", "float", ALICE, 1, BOB);
+  const int kNumAdds = 8;
+  for (int i = 0; i < kNumAdds; ++i) {
+    node = test::graph::Add(g, node, node);
+  }
+  test::graph::Send(g, node, "c", BOB, 1, ALICE);
+  Create(g, &sampler);
+  Rendezvous::Args args;
+  Tensor a(DT_FLOAT, TensorShape({256, 256}));
+  a.flat<float>().setConstant(1.0);
+  TF_ASSERT_OK(rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, a,
+                             false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out;
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "c"), args, &out, &is_dead));
+  EXPECT_EQ(256.0, out.flat<float>()(0));
+
+  OpOverheadSampler::OpStats* add = sampler.GetOpStats("Add");
+  const OpOverheadSampler::Histogram& compute =
+      add->histograms[OpOverheadSampler::kComputeNanos];
+  EXPECT_EQ(kNumAdds, compute.count());
+  EXPECT_GT(compute.sum(), 0);
+  EXPECT_GT(compute.Percentile(0.5), 0);
+  EXPECT_EQ(kNumAdds,
+            add->histograms[OpOverheadSampler::kInputPrepNanos].count());
+  EXPECT_EQ(kNumAdds * static_cast<int64>(a.TotalBytes()),
+            add->histograms[OpOverheadSampler::kOutputBytes].sum());
+}
+
 TEST_F(ExecutorTest, SelfAdd) {
   // v0 <- a
   // v1 = v0 + v0
@@ -410,4 +448,75 @@ TEST_F(ExecutorTest, RecvInvalidRefDtype) {
   rendez->Unref();
 }
 
+// Runs 'width' chains of NoOp nodes, 'num_nodes' in total, on a local
+// executor.  The executor samples one in 'sample_every_n_steps' steps, or
+// has no sampler at all when it is 0, to compare the cost of
+// ExecutorState::Process with and without op overhead sampling.
+static void BM_ExecutorProcess(int iters, int num_nodes,
+                               int sample_every_n_steps) {
+  testing::StopTiming();
+  Graph* g = new Graph(OpRegistry::Global());
+  const int width = 16;
+  const int depth = num_nodes / width;
+  Node* source = test::graph::NoOp(g, {});
+  std::vector<Node*> ends;
+  for (int w = 0; w < width; ++w) {
+    Node* node = source;
+    for (int d = 0; d < depth; ++d) {
+      node = test::graph::NoOp(g, {node});
+    }
+    ends.push_back(node);
+  }
+  test::graph::NoOp(g, ends);
+
+  std::unique_ptr<Device> device(DeviceFactory::NewDevice(
+      "CPU", {}, "/job:localhost/replica:0/task:0"));
+  std::unique_ptr<OpOverheadSampler> sampler;
+  if (sample_every_n_steps > 0) {
+    sampler.reset(new OpOverheadSampler(sample_every_n_steps));
+  }
+  const int version = g->versions().producer();
+  LocalExecutorParams params;
+  params.device = device.get();
+  params.create_kernel = [&device, version](const NodeDef& ndef,
+                                            OpKernel** kernel) {
+    return CreateNonCachedKernel(device.get(), nullptr, ndef, version,
+                                 kernel);
+  };
+  params.delete_kernel = [](OpKernel* kernel) {
+    DeleteNonCachedKernel(kernel);
+  };
+  params.op_overhead_sampler = sampler.get();
+  Executor* exec = nullptr;
+  TF_CHECK_OK(NewLocalExecutor(params, g, &exec));
+
+  SessionOptions options;
+  thread::ThreadPool* pool = ComputePool(options);
+  Rendezvous* rendez = NewLocalRendezvous();
+  Executor::Args args;
+  args.rendezvous = rendez;
+  args.runner = [pool](std::function<void()> fn) { pool->Schedule(fn); };
+  // Warm up
+  TF_CHECK_OK(exec->Run(args));
+
+  testing::ItemsProcessed(static_cast<int64>(iters) * depth * width);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(exec->Run(args));
+  }
+  testing::StopTiming();
+  if (sampler != nullptr) {
+    VLOG(1) << sampler->DebugString();
+  }
+  delete exec;
+  rendez->Unref();
+}
+BENCHMARK(BM_ExecutorProcess)
+    ->ArgPair(1024, 0)
+    ->ArgPair(1024, 1)
+    ->ArgPair(1024, 100)
+    ->ArgPair(16384, 0)
+    ->ArgPair(16384, 1)
+    ->ArgPair(16384, 100);
+
 }  // namespace tensorflow
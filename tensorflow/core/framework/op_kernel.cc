@@ -278,6 +278,10 @@ OpKernelContext::~OpKernelContext() {
 Allocator* OpKernelContext::get_allocator(AllocatorAttributes attr) {
   Allocator* allocator =
       params_->device->GetStepAllocator(attr, resource_manager());
+  if (params_->planned_allocator != nullptr &&
+      allocator == params_->device->GetAllocator(AllocatorAttributes())) {
+    allocator = params_->planned_allocator;
+  }
   if (track_allocations()) {
     mutex_lock lock(mu_);
     for (const auto& wrapped : wrapped_allocators_) {
@@ -510,6 +510,11 @@ class OpKernelContext {
     bool log_memory = false;
     bool record_tensor_accesses = false;
 
+    // If set, replaces the default allocator of the device for this op
+    // kernel invocation, e.g. to serve its allocations from memory the
+    // session planned ahead of the step.
+    Allocator* planned_allocator = nullptr;
+
     // Array indexed by output number for this node
     const AllocatorAttributes* output_attr_array = nullptr;
 
@@ -0,0 +1,331 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifdef TENSORFLOW_USE_SYCL
+
+#include "tensorflow/core/graph/sycl_fusion_pass.h"
+
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/optimization_registry.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/device_name_utils.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace {
+
+// Limits of the _SYCLFusedElementwise kernel.
+const int kMaxFusedInputs = 4;
+const int kMaxFusedOps = 8;
+
+typedef std::pair<Node*, int> Endpoint;
+
+// Number of inputs of the elementwise ops _SYCLFusedElementwise evaluates,
+// 0 for other ops.
+int ElementwiseArity(const string& op) {
+  static const auto* arity = new std::unordered_map<string, int>({
+      {"Abs", 1},
+      {"Exp", 1},
+      {"Log", 1},
+      {"Neg", 1},
+      {"Reciprocal", 1},
+      {"Relu", 1},
+      {"Rsqrt", 1},
+      {"Sigmoid", 1},
+      {"Sqrt", 1},
+      {"Square", 1},
+      {"Tanh", 1},
+      {"Add", 2},
+      {"BiasAdd", 2},
+      {"Maximum", 2},
+      {"Minimum", 2},
+      {"Mul", 2},
+      {"RealDiv", 2},
+      {"ReluGrad", 2},
+      {"SigmoidGrad", 2},
+      {"SquaredDifference", 2},
+      {"Sub", 2},
+      {"TanhGrad", 2},
+  });
+  auto it = arity->find(op);
+  return it == arity->end() ? 0 : it->second;
+}
+
+bool IsOnSYCL(const Node* n) {
+  DeviceNameUtils::ParsedName parsed;
+  return DeviceNameUtils::ParseFullName(n->assigned_device_name(), &parsed) &&
+         parsed.type == DEVICE_SYCL;
+}
+
+// Float elementwise ops placed on a SYCL device that do not read reference
+// tensors.
+bool IsFusible(const Node* n) {
+  if (!n->IsOp() || n->num_outputs() != 1 ||
+      ElementwiseArity(n->type_string()) != n->num_inputs() || !IsOnSYCL(n)) {
+    return false;
+  }
+  DataType dtype;
+  if (!GetNodeAttr(n->attrs(), "T", &dtype).ok() || dtype != DT_FLOAT) {
+    return false;
+  }
+  string data_format;
+  if (n->type_string() == "BiasAdd" &&
+      GetNodeAttr(n->attrs(), "data_format", &data_format).ok() &&
+      data_format != "NHWC") {
+    return false;
+  }
+  for (const Edge* e : n->in_edges()) {
+    if (!e->IsControlEdge() &&
+        IsRefType(e->src()->output_type(e->src_output()))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Only the last node of a group has consumers outside of it, which keeps
+// the fused graph acyclic.
+bool AllConsumersIn(const Node* n,
+                    const std::unordered_set<const Node*>& members) {
+  for (const Edge* e : n->out_edges()) {
+    if (e->IsControlEdge() || members.count(e->dst()) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Distinct tensors produced outside of the group and read inside of it, in
+// the order they are first read.
+std::vector<Endpoint> ExternalInputs(
+    const std::vector<Node*>& group,
+    const std::unordered_set<const Node*>& members) {
+  std::vector<Endpoint> inputs;
+  for (Node* n : group) {
+    std::vector<const Edge*> args;
+    if (!n->input_edges(&args).ok()) continue;
+    for (const Edge* e : args) {
+      if (members.count(e->src()) > 0) continue;
+      const Endpoint input(e->src(), e->src_output());
+      if (std::find(inputs.begin(), inputs.end(), input) == inputs.end()) {
+        inputs.push_back(input);
+      }
+    }
+  }
+  return inputs;
+}
+
+// Grows a group from 'root' towards its producers, within the limits of the
+// fused kernel.  Nodes already in the 'fused' groups are left alone.
+std::vector<Node*> FindGroup(Node* root,
+                             const std::unordered_set<const Node*>& fused) {
+  std::vector<Node*> group = {root};
+  std::unordered_set<const Node*> members = {root};
+  bool grown = true;
+  while (grown) {
+    grown = false;
+    for (int i = 0; i < group.size(); ++i) {
+      for (const Edge* e : group[i]->in_edges()) {
+        Node* producer = e->src();
+        if (group.size() == kMaxFusedOps || e->IsControlEdge() ||
+            members.count(producer) > 0 || fused.count(producer) > 0 ||
+            !IsFusible(producer) ||
+            producer->assigned_device_name() != root->assigned_device_name() ||
+            !AllConsumersIn(producer, members)) {
+          continue;
+        }
+        members.insert(producer);
+        group.push_back(producer);
+        if (ExternalInputs(group, members).size() > kMaxFusedInputs) {
+          members.erase(producer);
+          group.pop_back();
+          continue;
+        }
+        grown = true;
+      }
+    }
+  }
+  return group;
+}
+
+// Replaces 'group', in topological order, by one _SYCLFusedElementwise node.
+Status FuseGroup(Graph* g, const std::vector<Node*>& group) {
+  Node* root = group.back();
+  const std::unordered_set<const Node*> members(group.begin(), group.end());
+  const std::vector<Endpoint> inputs = ExternalInputs(group, members);
+  const int num_inputs = inputs.size();
+
+  std::vector<NodeBuilder::NodeOut> input_list;
+  std::map<Endpoint, int> input_index;
+  for (int i = 0; i < num_inputs; ++i) {
+    input_list.emplace_back(inputs[i].first, inputs[i].second);
+    input_index[inputs[i]] = i;
+  }
+
+  std::vector<string> ops;
+  std::vector<int> operands;
+  std::vector<Node*> control_inputs;
+  std::unordered_map<const Node*, int> step;
+  for (Node* n : group) {
+    std::vector<const Edge*> args;
+    TF_RETURN_IF_ERROR(n->input_edges(&args));
+    for (int k = 0; k < 2; ++k) {
+      if (k >= args.size()) {
+        operands.push_back(-1);
+        continue;
+      }
+      auto producer = step.find(args[k]->src());
+      operands.push_back(
+          producer != step.end()
+              ? num_inputs + producer->second
+              : input_index[Endpoint(args[k]->src(), args[k]->src_output())]);
+    }
+    step[n] = ops.size();
+    ops.push_back(n->type_string());
+    for (const Edge* e : n->in_edges()) {
+      if (e->IsControlEdge()) control_inputs.push_back(e->src());
+    }
+  }
+  std::sort(control_inputs.begin(), control_inputs.end());
+  control_inputs.erase(
+      std::unique(control_inputs.begin(), control_inputs.end()),
+      control_inputs.end());
+
+  Node* fused = nullptr;
+  TF_RETURN_IF_ERROR(
+      NodeBuilder(g->NewName(strings::StrCat(root->name(), "/SYCLFused")),
+                  "_SYCLFusedElementwise")
+          .Input(input_list)
+          .Attr("T", DT_FLOAT)
+          .Attr("ops", ops)
+          .Attr("operands", operands)
+          .ControlInputs(control_inputs)
+          .Device(root->requested_device())
+          .Finalize(g, &fused));
+  fused->set_assigned_device_name(root->assigned_device_name());
+
+  std::vector<NodeBuilder::NodeOut> out_nodes;
+  for (const Edge* e : root->out_edges()) {
+    out_nodes.emplace_back(e->dst(), e->dst_input());
+  }
+  for (Node* n : group) {
+    g->RemoveNode(n);
+  }
+  for (const auto& out_node : out_nodes) {
+    if (out_node.index == Graph::kControlSlot) {
+      g->AddControlEdge(fused, out_node.node);
+    } else {
+      g->AddEdge(fused, 0, out_node.node, out_node.index);
+    }
+  }
+  VLOG(1) << "SYCLFusionPass: fused " << group.size() << " ops into "
+          << fused->name();
+  return Status::OK();
+}
+
+// Each elementwise op on a SYCL device is its own kernel, which reads its
+// inputs from and writes its output to global memory.  This pass replaces
+// connected elementwise ops, whose intermediate results are not used
+// anywhere else, with a _SYCLFusedElementwise op that evaluates them in a
+// single kernel without intermediate buffers.
+//
+// It runs on the partition graphs, where feeds and fetches already are
+// _Recv and _Send nodes, so a fetched intermediate result is never fused
+// away.  Setting TF_SYCL_ELEMENTWISE_FUSION=0 disables it.
+class SYCLFusionPass : public GraphOptimizationPass {
+ public:
+  Status Run(const GraphOptimizationPassOptions& options) override;
+
+  // Returns true if and only if 'g' is mutated.
+  bool RunPass(std::unique_ptr<Graph>* g);
+};
+
+REGISTER_OPTIMIZATION(OptimizationPassRegistry::POST_PARTITIONING, 0,
+                      SYCLFusionPass);
+
+bool SYCLFusionPass::RunPass(std::unique_ptr<Graph>* g) {
+  std::vector<Node*> order;
+  GetReversePostOrder(**g, &order);
+  std::unordered_map<const Node*, int> position;
+  for (int i = 0; i < order.size(); ++i) {
+    position[order[i]] = i;
+  }
+
+  // Visit consumers before producers, so that a group grows from the end of
+  // its chain.
+  std::unordered_set<const Node*> fused;
+  std::vector<std::vector<Node*>> groups;
+  for (auto it = order.rbegin(); it != order.rend(); ++it) {
+    Node* root = *it;
+    if (fused.count(root) > 0 || !IsFusible(root)) continue;
+    std::vector<Node*> group = FindGroup(root, fused);
+    if (group.size() < 2) continue;
+    std::sort(group.begin(), group.end(),
+              [&position](const Node* a, const Node* b) {
+                return position[a] < position[b];
+              });
+    fused.insert(group.begin(), group.end());
+    groups.push_back(std::move(group));
+  }
+
+  bool result = false;
+  for (const auto& group : groups) {
+    Status s = FuseGroup(g->get(), group);
+    if (s.ok()) {
+      result = true;
+    } else {
+      LOG(WARNING) << "SYCLFusionPass: could not fuse the ops ending with "
+                   << group.back()->name() << ": " << s;
+    }
+  }
+  return result;
+}
+
+Status SYCLFusionPass::Run(const GraphOptimizationPassOptions& options) {
+  if (options.partition_graphs == nullptr) {
+    return Status::OK();
+  }
+  bool enabled = true;
+  TF_RETURN_IF_ERROR(
+      ReadBoolFromEnvVar("TF_SYCL_ELEMENTWISE_FUSION", true, &enabled));
+  if (!enabled) {
+    return Status::OK();
+  }
+  for (auto& pg : *options.partition_graphs) {
+    RunPass(&pg.second);
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+bool RunSYCLFusionPass(std::unique_ptr<Graph>* g) {
+  return SYCLFusionPass().RunPass(g);
+}
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_USE_SYCL
@@ -0,0 +1,388 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifdef TENSORFLOW_USE_SYCL
+
+#include "tensorflow/core/graph/sycl_fusion_pass.h"
+
+#include <stdlib.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "tensorflow/cc/ops/math_ops_internal.h"
+#include "tensorflow/cc/ops/nn_ops_internal.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/graph_constructor.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/session.h"
+
+namespace tensorflow {
+namespace {
+
+const char kCPUDevice[] = "/job:a/replica:0/task:0/device:CPU:0";
+const char kSYCLDevice[] = "/job:a/replica:0/task:0/device:SYCL:0";
+
+class SYCLFusionPassTest : public ::testing::Test {
+ public:
+  SYCLFusionPassTest() : graph_(OpRegistry::Global()) {}
+
+  void InitGraph(const string& s, const string& device = kSYCLDevice) {
+    GraphDef graph_def;
+    CHECK(protobuf::TextFormat::ParseFromString(s, &graph_def)) << s;
+    GraphConstructorOptions opts;
+    TF_CHECK_OK(ConvertGraphDefToGraph(opts, graph_def, &graph_));
+    for (Node* node : graph_.nodes()) {
+      node->set_assigned_device_name(device);
+    }
+  }
+
+  static string EdgeId(const Node* n, int index) {
+    if (index == 0) {
+      return n->name();
+    } else if (index == Graph::kControlSlot) {
+      return strings::StrCat(n->name(), ":control");
+    } else {
+      return strings::StrCat(n->name(), ":", index);
+    }
+  }
+
+  string CanonicalGraphString() {
+    std::vector<string> nodes;
+    std::vector<string> edges;
+    for (const Node* n : graph_.op_nodes()) {
+      nodes.push_back(strings::StrCat(n->name(), "(", n->type_string(), ")"));
+    }
+    for (const Edge* e : graph_.edges()) {
+      if (e->src()->IsOp() && e->dst()->IsOp()) {
+        edges.push_back(strings::StrCat(EdgeId(e->src(), e->src_output()), "->",
+                                        EdgeId(e->dst(), e->dst_input())));
+      }
+    }
+    std::sort(nodes.begin(), nodes.end());
+    std::sort(edges.begin(), edges.end());
+    return strings::StrCat(str_util::Join(nodes, ";"), "|",
+                           str_util::Join(edges, ";"));
+  }
+
+  string DoSYCLFusionPass() {
+    std::unique_ptr<Graph> ug(&graph_);
+    RunSYCLFusionPass(&ug);
+    ug.release();
+    return CanonicalGraphString();
+  }
+
+  Node* FindNode(const string& name) {
+    for (Node* n : graph_.op_nodes()) {
+      if (n->name() == name) return n;
+    }
+    return nullptr;
+  }
+
+  Graph graph_;
+};
+
+REGISTER_OP("Input").Output("o: float").SetIsStateful();
+REGISTER_OP("Int32Input").Output("o: int32").SetIsStateful();
+
+// relu(a * b + c) feeding a non-elementwise op.
+const char kMulAddRelu[] =
+    "node { name: 'A' op: 'Input'}"
+    "node { name: 'B' op: 'Input'}"
+    "node { name: 'C' op: 'Input'}"
+    "node { name: 'M' op: 'Mul'"
+    " attr { key: 'T' value { type: DT_FLOAT } }"
+    " input: ['A', 'B']}"
+    "node { name: 'D' op: 'Add'"
+    " attr { key: 'T' value { type: DT_FLOAT } }"
+    " input: ['M', 'C']}"
+    "node { name: 'R' op: 'Relu'"
+    " attr { key: 'T' value { type: DT_FLOAT } }"
+    " input: ['D']}"
+    "node { name: 'Z' op: 'Zeta'"
+    " attr { key: 'T' value { type: DT_FLOAT } }"
+    " input: ['R', 'A']}";
+
+TEST_F(SYCLFusionPassTest, MulAddRelu) {
+  InitGraph(kMulAddRelu);
+  EXPECT_EQ(DoSYCLFusionPass(),
+            "A(Input);B(Input);C(Input);R/SYCLFused/_0(_SYCLFusedElementwise);"
+            "Z(Zeta)|A->R/SYCLFused/_0;A->Z:1;B->R/SYCLFused/_0:1;"
+            "C->R/SYCLFused/_0:2;R/SYCLFused/_0->Z");
+
+  Node* fused = FindNode("R/SYCLFused/_0");
+  ASSERT_NE(fused, nullptr);
+  EXPECT_EQ(kSYCLDevice, fused->assigned_device_name());
+  std::vector<string> ops;
+  TF_ASSERT_OK(GetNodeAttr(fused->attrs(), "ops", &ops));
+  EXPECT_EQ(std::vector<string>({"Mul", "Add", "Relu"}), ops);
+  std::vector<int32> operands;
+  TF_ASSERT_OK(GetNodeAttr(fused->attrs(), "operands", &operands));
+  // Inputs A, B, C are operands 0 to 2, the steps 3 to 5.
+  EXPECT_EQ(std::vector<int32>({0, 1, 3, 2, 4, -1}), operands);
+}
+
+TEST_F(SYCLFusionPassTest, NotOnSYCL) {
+  InitGraph(kMulAddRelu, kCPUDevice);
+  const string before = CanonicalGraphString();
+  EXPECT_EQ(before, DoSYCLFusionPass());
+}
+
+// M is also read by Z, so it has to be computed on its own.
+TEST_F(SYCLFusionPassTest, SharedIntermediateIsNotFused) {
+  InitGraph(
+      "node { name: 'A' op: 'Input'}"
+      "node { name: 'B' op: 'Input'}"
+      "node { name: 'M' op: 'Mul'"
+      " attr { key: 'T' value { type: DT_FLOAT } }"
+      " input: ['A', 'B']}"
+      "node { name: 'N' op: 'Neg'"
+      " attr { key: 'T' value { type: DT_FLOAT } }"
+      " input: ['M']}"
+      "node { name: 'E' op: 'Exp'"
+      " attr { key: 'T' value { type: DT_FLOAT } }"
+      " input: ['N']}"
+      "node { name: 'Z' op: 'Zeta'"
+      " attr { key: 'T' value { type: DT_FLOAT } }"
+      " input: ['E', 'M']}");
+  EXPECT_EQ(DoSYCLFusionPass(),
+            "A(Input);B(Input);E/SYCLFused/_0(_SYCLFusedElementwise);M(Mul);"
+            "Z(Zeta)|A->M;B->M:1;E/SYCLFused/_0->Z;M->E/SYCLFused/_0;M->Z:1");
+}
+
+// Each Add reads a new input, and a fused op reads at most four.
+TEST_F(SYCLFusionPassTest, InputLimit) {
+  InitGraph(
+      "node { name: 'A' op: 'Input'}"
+      "node { name: 'B' op: 'Input'}"
+      "node { name: 'C' op: 'Input'}"
+      "node { name: 'D' op: 'Input'}"
+      "node { name: 'E' op: 'Input'}"
+      "node { name: 'S1' op: 'Add'"
+      " attr { key: 'T' value { type: DT_FLOAT } }"
+      " input: ['A', 'B']}"
+      "node { name: 'S2' op: 'Add'"
+      " attr { key: 'T' value { type: DT_FLOAT } }"
+      " input: ['S1', 'C']}"
+      "node { name: 'S3' op: 'Add'"
+      " attr { key: 'T' value { type: DT_FLOAT } }"
+      " input: ['S2', 'D']}"
+      "node { name: 'S4' op: 'Add'"
+      " attr { key: 'T' value { type: DT_FLOAT } }"
+      " input: ['S3', 'E']}"
+      "node { name: 'Z' op: 'Zeta'"
+      " attr { key: 'T' value { type: DT_FLOAT } }"
+      " input: ['S4', 'A']}");
+  EXPECT_EQ(DoSYCLFusionPass(),
+            "A(Input);B(Input);C(Input);D(Input);E(Input);S1(Add);"
+            "S4/SYCLFused/_0(_SYCLFusedElementwise);Z(Zeta)|A->S1;A->Z:1;"
+            "B->S1:1;C->S4/SYCLFused/_0:1;D->S4/SYCLFused/_0:2;"
+            "E->S4/SYCLFused/_0:3;S1->S4/SYCLFused/_0;S4/SYCLFused/_0->Z");
+}
+
+TEST_F(SYCLFusionPassTest, ControlEdgesMoveToFusedOp) {
+  InitGraph(
+      "node { name: 'A' op: 'Input'}"
+      "node { name: 'B' op: 'Input'}"
+      "node { name: 'C' op: 'Input'}"
+      "node { name: 'S' op: 'Sub'"
+      " attr { key: 'T' value { type: DT_FLOAT } }"
+      " input: ['A', 'B', '^C']}"
+      "node { name: 'Q' op: 'Square'"
+      " attr { key: 'T' value { type: DT_FLOAT } }"
+      " input: ['S']}"
+      "node { name: 'Z' op: 'Zeta'"
+      " attr { key: 'T' value { type: DT_FLOAT } }"
+      " input: ['A', 'B', '^Q']}");
+  EXPECT_EQ(DoSYCLFusionPass(),
+            "A(Input);B(Input);C(Input);Q/SYCLFused/_0(_SYCLFusedElementwise);"
+            "Z(Zeta)|A->Q/SYCLFused/_0;A->Z;B->Q/SYCLFused/_0:1;B->Z:1;"
+            "C:control->Q/SYCLFused/_0:control;"
+            "Q/SYCLFused/_0:control->Z:control");
+}
+
+TEST_F(SYCLFusionPassTest, Int32IsNotFused) {
+  InitGraph(
+      "node { name: 'A' op: 'Int32Input'}"
+      "node { name: 'B' op: 'Int32Input'}"
+      "node { name: 'S' op: 'Add'"
+      " attr { key: 'T' value { type: DT_INT32 } }"
+      " input: ['A', 'B']}"
+      "node { name: 'N' op: 'Neg'"
+      " attr { key: 'T' value { type: DT_INT32 } }"
+      " input: ['S']}");
+  const string before = CanonicalGraphString();
+  EXPECT_EQ(before, DoSYCLFusionPass());
+}
+
+// Constant folding would otherwise evaluate the elementwise ops of the
+// unfused graphs on the CPU.
+SessionOptions UnoptimizedSessionOptions() {
+  SessionOptions options;
+  options.config.mutable_graph_options()
+      ->mutable_optimizer_options()
+      ->set_opt_level(OptimizerOptions::L0);
+  return options;
+}
+
+// Runs the graph built by 'make_graph' on the SYCL device, with or without
+// the fusion pass, and returns its outputs.
+std::vector<Tensor> RunOnSYCL(
+    const std::function<std::vector<Output>(const Scope&)>& make_graph,
+    bool fuse, int* num_fused_ops) {
+  setenv("TF_SYCL_ELEMENTWISE_FUSION", fuse ? "1" : "0", 1);
+  Scope root = Scope::NewRootScope().WithDevice("/device:SYCL:0");
+  std::vector<Output> outputs = make_graph(root);
+  GraphDef graph;
+  TF_CHECK_OK(root.ToGraphDef(&graph));
+  std::vector<string> fetches;
+  for (const Output& output : outputs) {
+    fetches.push_back(output.node()->name());
+  }
+
+  std::unique_ptr<Session> session(NewSession(UnoptimizedSessionOptions()));
+  TF_CHECK_OK(session->Create(graph));
+  RunOptions run_options;
+  run_options.set_output_partition_graphs(true);
+  RunMetadata metadata;
+  std::vector<Tensor> results;
+  TF_CHECK_OK(
+      session->Run(run_options, {}, fetches, {}, &results, &metadata));
+  *num_fused_ops = 0;
+  for (const GraphDef& partition : metadata.partition_graphs()) {
+    for (const NodeDef& node : partition.node()) {
+      if (node.op() == "_SYCLFusedElementwise") ++*num_fused_ops;
+    }
+  }
+  unsetenv("TF_SYCL_ELEMENTWISE_FUSION");
+  return results;
+}
+
+Output RandomConst(const Scope& s, const TensorShape& shape) {
+  Tensor data(DT_FLOAT, shape);
+  data.flat<float>().setRandom();
+  data.flat<float>() -= data.flat<float>().constant(0.5f);
+  return ops::Const(s, Input::Initializer(data));
+}
+
+TEST(SYCLFusionPass, FusedResultsMatch) {
+  auto make_graph = [](const Scope& s) {
+    Output x = RandomConst(s, TensorShape({16, 32}));
+    Output w = RandomConst(s, TensorShape({16, 32}));
+    Output b = RandomConst(s, TensorShape({32}));
+    Output c = RandomConst(s, TensorShape({16, 1}));
+    // x * w + b -> relu -> mul, with a row and a column broadcast.
+    Output relu = ops::Relu(s, ops::BiasAdd(s, ops::Mul(s, x, w), b));
+    Output scaled = ops::Mul(s, relu, c);
+    Output grad =
+        ops::internal::TanhGrad(s, ops::Tanh(s, x), ops::Sub(s, scaled, w));
+    return std::vector<Output>({scaled, grad});
+  };
+  int num_fused_ops = 0;
+  std::vector<Tensor> unfused = RunOnSYCL(make_graph, false, &num_fused_ops);
+  EXPECT_EQ(0, num_fused_ops);
+  std::vector<Tensor> fused = RunOnSYCL(make_graph, true, &num_fused_ops);
+  EXPECT_GT(num_fused_ops, 0);
+  for (int i = 0; i < unfused.size(); ++i) {
+    test::ExpectClose(unfused[i], fused[i], 1e-5, 1e-5);
+  }
+}
+
+// One training step of the train_mnist MLP (784-50-50-10, with relu) on the
+// SYCL device.  The label is the number of ops the SYCL device runs per
+// step.
+void MLPTrainStep(int iters, int batch, bool fuse) {
+  testing::StopTiming();
+  setenv("TF_SYCL_ELEMENTWISE_FUSION", fuse ? "1" : "0", 1);
+  Scope s = Scope::NewRootScope().WithDevice("/device:SYCL:0");
+  const std::vector<int> sizes = {784, 50, 50, 10};
+  Output x = RandomConst(s, TensorShape({batch, sizes[0]}));
+  Output y = RandomConst(s, TensorShape({batch, sizes.back()}));
+  Output lr = ops::Const(s, 0.01f);
+  std::vector<Output> weights, biases, activations = {x};
+  for (int l = 0; l + 1 < sizes.size(); ++l) {
+    weights.push_back(RandomConst(s, TensorShape({sizes[l], sizes[l + 1]})));
+    biases.push_back(RandomConst(s, TensorShape({sizes[l + 1]})));
+    Output z = ops::BiasAdd(s, ops::MatMul(s, activations.back(), weights[l]),
+                            biases[l]);
+    activations.push_back(l + 2 < sizes.size() ? Output(ops::Relu(s, z)) : z);
+  }
+  std::vector<Output> updates;
+  Output delta = ops::Sub(s, activations.back(), y);
+  for (int l = weights.size() - 1; l >= 0; --l) {
+    Output grad_w = ops::MatMul(s, activations[l], delta,
+                                ops::MatMul::TransposeA(true));
+    Output grad_b = ops::Sum(s, delta, 0);
+    updates.push_back(ops::Sub(s, weights[l], ops::Mul(s, lr, grad_w)));
+    updates.push_back(ops::Sub(s, biases[l], ops::Mul(s, lr, grad_b)));
+    if (l > 0) {
+      delta = ops::internal::ReluGrad(
+          s,
+          ops::MatMul(s, delta, weights[l], ops::MatMul::TransposeB(true)),
+          activations[l]);
+    }
+  }
+  std::vector<Operation> outputs;
+  for (const Output& update : updates) {
+    outputs.push_back(ops::Identity(s, update).output.op());
+  }
+  auto step = ops::NoOp(s.WithOpName("step").WithControlDependencies(outputs));
+  GraphDef graph;
+  TF_CHECK_OK(s.ToGraphDef(&graph));
+
+  std::unique_ptr<Session> session(NewSession(UnoptimizedSessionOptions()));
+  TF_CHECK_OK(session->Create(graph));
+  RunOptions run_options;
+  run_options.set_trace_level(RunOptions::FULL_TRACE);
+  RunMetadata metadata;
+  TF_CHECK_OK(session->Run(run_options, {}, {}, {"step"}, nullptr, &metadata));
+  int num_sycl_ops = 0;
+  for (const auto& dev_stats : metadata.step_stats().dev_stats()) {
+    if (StringPiece(dev_stats.device()).contains("SYCL")) {
+      num_sycl_ops += dev_stats.node_stats_size();
+    }
+  }
+  testing::SetLabel(strings::StrCat(num_sycl_ops, " SYCL ops"));
+
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(session->Run({}, {}, {"step"}, nullptr));
+  }
+  testing::StopTiming();
+  unsetenv("TF_SYCL_ELEMENTWISE_FUSION");
+}
+
+static void BM_MLPTrainStepFused(int iters, int batch) {
+  MLPTrainStep(iters, batch, true);
+}
+BENCHMARK(BM_MLPTrainStepFused)->Arg(100)->Arg(1000);
+
+static void BM_MLPTrainStepUnfused(int iters, int batch) {
+  MLPTrainStep(iters, batch, false);
+}
+BENCHMARK(BM_MLPTrainStepUnfused)->Arg(100)->Arg(1000);
+
+}  // namespace
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_USE_SYCL
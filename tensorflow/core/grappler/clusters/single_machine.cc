@@ -86,6 +86,8 @@ Status SingleMachine::Provision() {
       attr = GetLocalCPUInfo();
     } else if (dev.device_type() == "GPU") {
       attr = GetLocalGPUInfo(gpu_id++);
+    } else if (dev.device_type() == "OPENCL") {
+      attr = GetLocalOpenCLInfo();
     } else {
       attr.set_type(dev.device_type());
     }
@@ -27,6 +27,7 @@ limitations under the License.
 #include "include/libxsmm.h"
 #endif
 
+#include "tensorflow/core/kernels/matmul_cl_device_info.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/cpu_info.h"
@@ -99,6 +100,44 @@ DeviceProperties GetLocalGPUInfo(int gpu_id) {
   return device;
 }
 
+DeviceProperties GetLocalOpenCLInfo() {
+  DeviceProperties device;
+  device.set_type("OPENCL");
+
+  const clDeviceCapabilities* caps = clDeviceInfo::Global();
+  if (caps != nullptr) {
+    device.set_vendor(caps->vendor);
+    device.set_model(caps->name);
+    device.set_frequency(caps->clockMHz);
+    device.set_num_cores(caps->computeUnits);
+    device.set_l2_cache_size(caps->globalMemCacheSize);
+    device.set_shared_memory_size_per_multiprocessor(caps->localMemSize);
+    device.set_memory_size(caps->globalMemSize);
+    // GB/s to KB/s.
+    device.set_bandwidth(caps->deviceGBps * 1e6);
+
+    auto* environment = device.mutable_environment();
+    (*environment)["opencl"] = caps->version;
+    (*environment)["driver"] = caps->driverVersion;
+    (*environment)["max_work_group_size"] =
+        strings::StrCat(caps->maxWorkGroupSize);
+    (*environment)["fp16"] = caps->fp16 ? "1" : "0";
+    if (caps->measured()) {
+      (*environment)["peak_gflops"] = strings::StrCat(caps->peakGflops);
+      for (const auto& g : caps->gflops) {
+        (*environment)[strings::StrCat("gflops_at_intensity_", g.first)] =
+            strings::StrCat(g.second);
+      }
+      (*environment)["host_to_device_gb_per_sec"] =
+          strings::StrCat(caps->hostToDeviceGBps);
+      (*environment)["device_to_host_gb_per_sec"] =
+          strings::StrCat(caps->deviceToHostGBps);
+    }
+  }
+
+  return device;
+}
+
 DeviceProperties GetDeviceInfo(const DeviceNameUtils::ParsedName& device) {
   if (device.type == "CPU") {
     return GetLocalCPUInfo();
@@ -108,6 +147,8 @@ DeviceProperties GetDeviceInfo(const DeviceNameUtils::ParsedName& device) {
     } else {
       return GetLocalGPUInfo(0);
     }
+  } else if (device.type == "OPENCL") {
+    return GetLocalOpenCLInfo();
   }
   DeviceProperties result;
   result.set_type("UNKNOWN");
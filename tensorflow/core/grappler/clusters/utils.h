@@ -29,6 +29,11 @@ DeviceProperties GetLocalCPUInfo();
 // which grappler is running.
 DeviceProperties GetLocalGPUInfo(int gpu_id);
 
+// Returns the DeviceProperties of the OpenCL device of clMatMulRuntime, the
+// device behind /device:OPENCL:0. The measured throughput is stored in the
+// environment map, see clDeviceInfo in core/kernels/matmul_cl_device_info.h.
+DeviceProperties GetLocalOpenCLInfo();
+
 // Returns the DeviceProperties of the specified device
 DeviceProperties GetDeviceInfo(const DeviceNameUtils::ParsedName& device);
 
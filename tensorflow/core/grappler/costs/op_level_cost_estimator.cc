@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/framework/attr_value_util.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/grappler/clusters/utils.h"
+#include "tensorflow/core/lib/strings/numbers.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -349,6 +350,20 @@ OpLevelCostEstimator::DeviceInfo OpLevelCostEstimator::GetDeviceInfo(
     } else {
       gb_per_sec = 100;
     }
+  } else if (device.type() == "OPENCL") {
+    // Throughput measured by the OpenCL device probe, if it ran. Otherwise
+    // assume one multiply-add per compute unit and cycle, the OpenCL spec
+    // does not tell how many lanes a compute unit has.
+    auto peak_gflops = device.environment().find("peak_gflops");
+    if (peak_gflops == device.environment().end() ||
+        !strings::safe_strtod(peak_gflops->second.c_str(), &gflops)) {
+      gflops = device.num_cores() * device.frequency() * 1e-3 * kOpsPerMac;
+    }
+    if (device.bandwidth() > 0) {
+      gb_per_sec = device.bandwidth() / 1e6;
+    } else {
+      gb_per_sec = 10;
+    }
   }
   VLOG(1) << "Device: " << device.type() << " gflops: " << gflops
           << " gb_per_sec: " << gb_per_sec;
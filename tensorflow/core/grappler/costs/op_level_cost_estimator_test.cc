@@ -138,6 +138,15 @@ OpContext DescribeOp(const string& op, int size1, int size2) {
   SetCpuDevice(&op_context.op_info);
   return op_context;
 }
+
+void SetOpenCLDevice(OpInfo* op_features) {
+  auto device = op_features->mutable_device();
+  device->Clear();
+  device->set_type("OPENCL");
+  device->set_num_cores(4);
+  device->set_bandwidth(20000000);  // 20000000 KB/s = 20 GB/s
+  device->set_frequency(500);       // 500 Mhz
+}
 }  // namespace
 
 class OpLevelCostEstimatorTest : public ::testing::Test {
@@ -190,6 +199,24 @@ TEST_F(OpLevelCostEstimatorTest, MulExecutionTime) {
   EXPECT_FALSE(cost.inaccurate);
 }
 
+TEST_F(OpLevelCostEstimatorTest, OpenCLMulExecutionTime) {
+  auto op_context = DescribeOp("Mul", 1000, 1);
+  SetOpenCLDevice(&op_context.op_info);
+  // Without a probe, one multiply-add per compute unit and cycle: 4 GFLOP/s.
+  auto cost = PredictCosts(op_context);
+  EXPECT_EQ(Costs::Duration(1000), cost.memory_time);
+  EXPECT_EQ(Costs::Duration(500), cost.compute_time);
+
+  // The throughput measured by the device probe wins.
+  (*op_context.op_info.mutable_device()->mutable_environment())["peak_gflops"] =
+      "20";
+  cost = PredictCosts(op_context);
+  EXPECT_EQ(Costs::Duration(1000), cost.memory_time);
+  EXPECT_EQ(Costs::Duration(100), cost.compute_time);
+  EXPECT_EQ(Costs::Duration(1100), cost.execution_time);
+  EXPECT_FALSE(cost.inaccurate);
+}
+
 TEST_F(OpLevelCostEstimatorTest, MulBroadcastExecutionTime) {
   auto cost = PredictCosts(DescribeOp("Mul", 1000, 2));
   EXPECT_EQ(Costs::Duration(3600), cost.memory_time);
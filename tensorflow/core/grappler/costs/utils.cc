@@ -206,6 +206,8 @@ DeviceProperties GetDeviceInfo(const string& device_str) {
       return GetLocalGPUInfo(parsed.id);
     } else if (parsed.type == "CPU") {
       return GetLocalCPUInfo();
+    } else if (parsed.type == "OPENCL") {
+      return GetLocalOpenCLInfo();
     }
   }
   DeviceProperties device;
@@ -39,6 +39,9 @@ namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
+#ifdef TENSORFLOW_USE_SYCL
+typedef Eigen::SyclDevice SYCLDevice;
+#endif  // TENSORFLOW_USE_SYCL
 
 template <typename Device, typename T, typename Tout, typename ArgFunctor>
 class ArgOp : public OpKernel {
@@ -224,4 +227,42 @@ TF_CALL_GPU_NUMBER_TYPES(REGISTER_ARGMAX_GPU);
 
 #endif  // GOOGLE_CUDA
 
+#ifdef TENSORFLOW_USE_SYCL
+// The generic functors, since Eigen reduces argmax and argmin on SYCL devices.
+#define REGISTER_ARGMAX_SYCL(type)                                  \
+  REGISTER_KERNEL_BUILDER(Name("ArgMax")                            \
+                              .Device(DEVICE_SYCL)                  \
+                              .TypeConstraint<type>("T")            \
+                              .TypeConstraint<int64>("output_type") \
+                              .TypeConstraint<int32>("Tidx")        \
+                              .HostMemory("dimension"),             \
+                          ArgMaxOp<SYCLDevice, type, int64>);       \
+  REGISTER_KERNEL_BUILDER(Name("ArgMin")                            \
+                              .Device(DEVICE_SYCL)                  \
+                              .TypeConstraint<type>("T")            \
+                              .TypeConstraint<int64>("output_type") \
+                              .TypeConstraint<int32>("Tidx")        \
+                              .HostMemory("dimension"),             \
+                          ArgMinOp<SYCLDevice, type, int64>);       \
+  REGISTER_KERNEL_BUILDER(Name("ArgMax")                            \
+                              .Device(DEVICE_SYCL)                  \
+                              .TypeConstraint<type>("T")            \
+                              .TypeConstraint<int32>("output_type") \
+                              .TypeConstraint<int32>("Tidx")        \
+                              .HostMemory("dimension"),             \
+                          ArgMaxOp<SYCLDevice, type, int32>);       \
+  REGISTER_KERNEL_BUILDER(Name("ArgMin")                            \
+                              .Device(DEVICE_SYCL)                  \
+                              .TypeConstraint<type>("T")            \
+                              .TypeConstraint<int32>("output_type") \
+                              .TypeConstraint<int32>("Tidx")        \
+                              .HostMemory("dimension"),             \
+                          ArgMinOp<SYCLDevice, type, int32>);
+
+TF_CALL_SYCL_NUMBER_TYPES(REGISTER_ARGMAX_SYCL);
+
+#undef REGISTER_ARGMAX_SYCL
+
+#endif  // TENSORFLOW_USE_SYCL
+
 }  // namespace tensorflow
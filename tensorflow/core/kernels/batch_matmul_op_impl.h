@@ -27,6 +27,9 @@ limitations under the License.
 #include "tensorflow/core/framework/type_traits.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/fill_functor.h"
+#include "tensorflow/core/kernels/matmul_cl_batched.h"
+#include "tensorflow/core/kernels/matmul_cl_dispatch.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/work_sharder.h"
@@ -191,6 +194,96 @@ struct SequentialMatMulKernel {
   }
 };
 
+// Computes the batch on OpenCL with clBatchedEngine, returns false if it
+// stayed on the CPU and out is left to Eigen. Only float and half batches
+// go to OpenCL.
+template <typename Scalar>
+struct LaunchBatchMatMulCL {
+  static bool Launch(OpKernelContext* context, const Tensor& in_x,
+                     const Tensor& in_y, bool adj_x, bool adj_y, Tensor* out) {
+    return false;
+  }
+};
+
+// Float batches run on OpenCL when clMatMulDispatcher predicts one upload,
+// launch and read back of the whole batch to beat the Eigen loop over it.
+template <>
+struct LaunchBatchMatMulCL<float> {
+  static bool Launch(OpKernelContext* context, const Tensor& in_x,
+                     const Tensor& in_y, bool adj_x, bool adj_y, Tensor* out) {
+    Calibrate(context->eigen_cpu_device());
+    const int64 batch = in_x.dim_size(0);
+    const int64 m = out->dim_size(1);
+    const int64 k = in_x.dim_size(adj_x ? 1 : 2);
+    const int64 n = out->dim_size(2);
+    if (clMatMulDispatcher::Global()->chooseBatched(batch, m, k, n) !=
+        kClMatMulOpenCL) {
+      return false;
+    }
+    return clBatchedEngine<float>::run(in_x.flat<float>().data(),
+                                       in_y.flat<float>().data(),
+                                       out->flat<float>().data(), batch, m, k,
+                                       n, adj_x, adj_y) == CL_SUCCESS;
+  }
+
+  // Runs the dispatcher calibration on the first call, unless a MatMul
+  // already did.
+  static void Calibrate(const CPUDevice& d) {
+    clMatMulDispatcher::Global()->calibrateOnce(
+        [&d](int64 m, int64 k, int64 n, double* seconds) {
+          return TimeCalibrationGemm(m, k, n, seconds,
+                                     [&d](Tensor* z, const Tensor& x,
+                                          const Tensor& y) {
+                                       z->matrix<float>().device(d) =
+                                           x.matrix<float>().contract(
+                                               y.matrix<float>(),
+                                               ContractionDims(false, false));
+                                       return true;
+                                     });
+        },
+        [](int64 m, int64 k, int64 n, double* seconds) {
+          return TimeCalibrationGemm(
+              m, k, n, seconds,
+              [m, k, n](Tensor* z, const Tensor& x, const Tensor& y) {
+                return clBatchedEngine<float>::run(
+                           x.flat<float>().data(), y.flat<float>().data(),
+                           z->flat<float>().data(), 1, m, k, n, false,
+                           false) == CL_SUCCESS;
+              });
+        });
+  }
+
+ private:
+  // Times gemm on random m x k and k x n inputs.
+  template <typename GemmFn>
+  static bool TimeCalibrationGemm(int64 m, int64 k, int64 n, double* seconds,
+                                  GemmFn gemm) {
+    Tensor x(DT_FLOAT, TensorShape({m, k}));
+    Tensor y(DT_FLOAT, TensorShape({k, n}));
+    Tensor z(DT_FLOAT, TensorShape({m, n}));
+    x.flat<float>().setRandom();
+    y.flat<float>().setRandom();
+    const uint64 start = Env::Default()->NowMicros();
+    const bool ok = gemm(&z, x, y);
+    *seconds = (Env::Default()->NowMicros() - start) * 1e-6;
+    return ok;
+  }
+};
+
+// Eigen has no vectorized half GEMM on the CPU, so half batches always go to
+// OpenCL when there is a device, like half MatMuls (see MatMulCLFunctor).
+template <>
+struct LaunchBatchMatMulCL<Eigen::half> {
+  static bool Launch(OpKernelContext* context, const Tensor& in_x,
+                     const Tensor& in_y, bool adj_x, bool adj_y, Tensor* out) {
+    return clBatchedEngine<Eigen::half>::run(
+               in_x.flat<Eigen::half>().data(), in_y.flat<Eigen::half>().data(),
+               out->flat<Eigen::half>().data(), in_x.dim_size(0),
+               out->dim_size(1), in_x.dim_size(adj_x ? 1 : 2), out->dim_size(2),
+               adj_x, adj_y) == CL_SUCCESS;
+  }
+};
+
 }  // namespace
 
 template <typename Device, typename Scalar>
@@ -202,6 +295,10 @@ struct LaunchBatchMatMul<CPUDevice, Scalar> {
                      const Tensor& in_y, bool adj_x, bool adj_y, Tensor* out) {
     typedef ParallelMatMulKernel<Scalar, Eigen::NumTraits<Scalar>::IsComplex>
         ParallelMatMulKernel;
+    if (LaunchBatchMatMulCL<Scalar>::Launch(context, in_x, in_y, adj_x, adj_y,
+                                            out)) {
+      return;
+    }
     bool conjugate_result = false;
 
     // Number of matrix multiplies i.e. size of the batch.
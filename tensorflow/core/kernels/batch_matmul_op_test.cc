@@ -15,11 +15,91 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/matmul_cl_batched.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 
+// clBatchedEngine is checked against Eigen's contraction of every matrix of
+// the batch. The tests are skipped when the process has no OpenCL device or
+// the kernels fail to build.
+static bool OpenCLMatMulAvailable() {
+  clMatMulRuntime* runtime = clMatMulRuntime::Global();
+  if (!runtime->ok() ||
+      runtime->program(kClMatMulProgram, "-cl-fast-relaxed-math") == NULL) {
+    LOG(WARNING) << "No OpenCL MatMul runtime, skipping test";
+    return false;
+  }
+  return true;
+}
+
+// T is the storage type, float or Eigen::half; the expected product is
+// computed in float from the same T inputs.
+template <typename T>
+static void ExpectBatchedMatchesEigen(int batch, int m, int k, int n,
+                                      bool adj_x, bool adj_y,
+                                      double tolerance_per_k) {
+  const DataType type = DataTypeToEnum<T>::value;
+  Tensor x_float(DT_FLOAT, adj_x ? TensorShape({batch, k, m})
+                                 : TensorShape({batch, m, k}));
+  x_float.flat<float>().setRandom();
+  Tensor y_float(DT_FLOAT, adj_y ? TensorShape({batch, n, k})
+                                 : TensorShape({batch, k, n}));
+  y_float.flat<float>().setRandom();
+  Tensor x(type, x_float.shape());
+  x.flat<T>() = x_float.flat<float>().cast<T>();
+  Tensor y(type, y_float.shape());
+  y.flat<T>() = y_float.flat<float>().cast<T>();
+
+  Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1> dim_pair;
+  dim_pair[0].first = adj_x ? 0 : 1;
+  dim_pair[0].second = adj_y ? 1 : 0;
+  Tensor expected(DT_FLOAT, TensorShape({batch, m, n}));
+  const Tensor& cx = x;
+  const Tensor& cy = y;
+  for (int b = 0; b < batch; ++b) {
+    expected.tensor<float, 3>().chip<0>(b) =
+        cx.tensor<T, 3>().template chip<0>(b).template cast<float>().contract(
+            cy.tensor<T, 3>().template chip<0>(b).template cast<float>(),
+            dim_pair);
+  }
+
+  Tensor actual(type, TensorShape({batch, m, n}));
+  ASSERT_EQ(CL_SUCCESS,
+            clBatchedEngine<T>::run(cx.flat<T>().data(), cy.flat<T>().data(),
+                                    actual.flat<T>().data(), batch, m, k, n,
+                                    adj_x, adj_y))
+      << "batch=" << batch << " m=" << m << " k=" << k << " n=" << n
+      << " adj_x=" << adj_x << " adj_y=" << adj_y;
+  Tensor actual_float(DT_FLOAT, actual.shape());
+  actual_float.flat<float>() = actual.flat<T>().template cast<float>();
+  test::ExpectTensorNear<float>(expected, actual_float, tolerance_per_k * k);
+}
+
+TEST(BatchMatMulCLTest, FloatMatchesEigen) {
+  if (!OpenCLMatMulAvailable()) return;
+  for (bool adj_x : {false, true}) {
+    for (bool adj_y : {false, true}) {
+      ExpectBatchedMatchesEigen<float>(1, 100, 37, 83, adj_x, adj_y, 1e-4);
+      ExpectBatchedMatchesEigen<float>(7, 16, 64, 16, adj_x, adj_y, 1e-4);
+      ExpectBatchedMatchesEigen<float>(300, 3, 5, 1, adj_x, adj_y, 1e-4);
+    }
+  }
+}
+
+TEST(BatchMatMulCLTest, HalfMatchesEigen) {
+  if (!OpenCLMatMulAvailable()) return;
+  for (bool adj_x : {false, true}) {
+    for (bool adj_y : {false, true}) {
+      ExpectBatchedMatchesEigen<Eigen::half>(5, 33, 40, 17, adj_x, adj_y,
+                                             1e-3);
+      ExpectBatchedMatchesEigen<Eigen::half>(64, 8, 64, 8, adj_x, adj_y, 1e-3);
+    }
+  }
+}
+
 template <typename T>
 static Graph* BatchMatmul(int b, int m, int k, int n, bool adjoint_a,
                           bool adjoint_b, DataType type) {
@@ -132,4 +212,25 @@ BM_BatchMatmul(1, 1, 200, 10000, true, true);
 BM_BatchMatmul(8, 1, 200, 10000, true, true);
 BM_BatchMatmul(32, 1, 200, 10000, true, true);
 
+// Many small products, as issued by attention and RNN cells. Float batches
+// go to OpenCL when clMatMulDispatcher predicts it to be faster; run with
+// TF_OPENCL_MATMUL_DISPATCH=cpu and =opencl to measure both sides of the
+// crossover, and without it to check the dispatcher's choice.
+#define BM_BatchMatmulSmall(B, D)                                   \
+  BM_BatchMatmulDev(B, D, D, D, false, false, float, DT_FLOAT, cpu); \
+  BM_BatchMatmulDev(B, D, D, D, false, false, Eigen::half, DT_HALF, cpu);
+
+BM_BatchMatmulSmall(1, 32);
+BM_BatchMatmulSmall(4, 32);
+BM_BatchMatmulSmall(16, 32);
+BM_BatchMatmulSmall(64, 32);
+BM_BatchMatmulSmall(256, 32);
+BM_BatchMatmulSmall(1024, 32);
+BM_BatchMatmulSmall(1, 64);
+BM_BatchMatmulSmall(4, 64);
+BM_BatchMatmulSmall(16, 64);
+BM_BatchMatmulSmall(64, 64);
+BM_BatchMatmulSmall(256, 64);
+BM_BatchMatmulSmall(1024, 64);
+
 }  // end namespace tensorflow
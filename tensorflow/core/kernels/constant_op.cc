@@ -102,6 +102,12 @@ REGISTER_SYCL_KERNEL(SYCL, bool);
 #undef REGISTER_SYCL_KERNEL
 #endif
 
+// OpenCL device, see core/common_runtime/opencl/opencl_device.h. The value
+// is copied to a cl_mem buffer once, by MakeTensorFromProto().
+REGISTER_KERNEL_BUILDER(
+    Name("Const").Device(DEVICE_OPENCL).TypeConstraint<float>("dtype"),
+    ConstantOp);
+
 HostConstantOp::HostConstantOp(OpKernelConstruction* ctx)
     : OpKernel(ctx), tensor_(ctx->output_type(0)) {
   const TensorProto* proto = nullptr;
@@ -140,6 +146,12 @@ REGISTER_KERNEL_BUILDER(Name("Const")
                         HostConstantOp);
 #endif  // TENSORFLOW_USE_SYCL
 
+REGISTER_KERNEL_BUILDER(Name("Const")
+                            .Device(DEVICE_OPENCL)
+                            .HostMemory("output")
+                            .TypeConstraint<int32>("dtype"),
+                        HostConstantOp);
+
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
 #ifdef TENSORFLOW_USE_SYCL
@@ -47,6 +47,9 @@ limitations under the License.
 #include "tensorflow/core/kernels/conv_ops_gpu.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #endif  // GOOGLE_CUDA
+#ifdef TENSORFLOW_USE_SYCL
+#include "tensorflow/core/kernels/conv_ops_sycl.h"
+#endif  // TENSORFLOW_USE_SYCL
 
 namespace {
 
@@ -92,6 +95,9 @@ namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
+#ifdef TENSORFLOW_USE_SYCL
+typedef Eigen::SyclDevice SYCLDevice;
+#endif  // TENSORFLOW_USE_SYCL
 
 // The fast versions using eigen computations directly. They are only enabled
 // for CPU for now since nvcc times out when trying to compile them.
@@ -110,6 +116,20 @@ struct LaunchConv2DBackpropInputOp<CPUDevice, T> {
   }
 };
 
+#ifdef TENSORFLOW_USE_SYCL
+template <typename T>
+struct LaunchConv2DBackpropInputOp<SYCLDevice, T> {
+  void operator()(OpKernelContext* ctx, bool use_cudnn, bool cudnn_use_autotune,
+                  const Tensor& out_backprop, const Tensor& filter,
+                  int row_stride, int col_stride, const Padding& padding,
+                  Tensor* in_backprop, TensorFormat data_format) {
+    LaunchConv2DBackpropInputSYCL<T>::launch(
+        ctx, out_backprop, filter, row_stride, col_stride, padding,
+        in_backprop);
+  }
+};
+#endif  // TENSORFLOW_USE_SYCL
+
 #ifdef TENSORFLOW_USE_LIBXSMM
 template <typename Device, class T>
 struct LaunchXsmmBackwardInputConvolution {
@@ -591,6 +611,18 @@ TF_CALL_half(REGISTER_CPU_KERNELS);
 TF_CALL_float(REGISTER_CPU_KERNELS);
 #undef REGISTER_CPU_KERNELS
 
+#ifdef TENSORFLOW_USE_SYCL
+#define REGISTER_SYCL_KERNELS(T)                          \
+  REGISTER_KERNEL_BUILDER(Name("Conv2DBackpropInput")     \
+                              .Device(DEVICE_SYCL)        \
+                              .TypeConstraint<T>("T")     \
+                              .HostMemory("input_sizes"), \
+                          Conv2DFastBackpropInputOp<SYCLDevice, T>);
+
+TF_CALL_float(REGISTER_SYCL_KERNELS);
+#undef REGISTER_SYCL_KERNELS
+#endif  // TENSORFLOW_USE_SYCL
+
 // GPU definitions.
 #if GOOGLE_CUDA
 // The slow version (but compiles for GPU)
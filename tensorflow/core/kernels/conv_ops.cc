@@ -49,11 +49,17 @@ limitations under the License.
 #include "tensorflow/core/kernels/conv_ops_gpu.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #endif  // GOOGLE_CUDA
+#ifdef TENSORFLOW_USE_SYCL
+#include "tensorflow/core/kernels/conv_ops_sycl.h"
+#endif  // TENSORFLOW_USE_SYCL
 
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
+#ifdef TENSORFLOW_USE_SYCL
+typedef Eigen::SyclDevice SYCLDevice;
+#endif  // TENSORFLOW_USE_SYCL
 
 namespace {
 template <typename Device, typename T>
@@ -456,6 +462,41 @@ TF_CALL_float(REGISTER_CPU);
 // To be used inside depthwise_conv_op.cc.
 template class LaunchConv2DOp<CPUDevice, float>;
 
+#ifdef TENSORFLOW_USE_SYCL
+template <typename T>
+void LaunchConv2DOp<SYCLDevice, T>::operator()(
+    OpKernelContext* ctx, bool use_cudnn, bool cudnn_use_autotune,
+    const Tensor& input, const Tensor& filter, int row_dilation,
+    int col_dilation, int row_stride, int col_stride, const Padding& padding,
+    Tensor* output, TensorFormat data_format) {
+  if (data_format != FORMAT_NHWC) {
+    ctx->SetStatus(
+        errors::Unimplemented("SYCL conv implementation only supports "
+                              "NHWC tensor format for now."));
+    return;
+  }
+  if (row_dilation > 1 || col_dilation > 1) {
+    ctx->SetStatus(
+        errors::Unimplemented("SYCL conv implementation only supports "
+                              "dilated rate of 1 for now."));
+    return;
+  }
+  LaunchConv2DSYCL<T>::launch(ctx, input, filter, row_stride, col_stride,
+                              padding, output);
+}
+
+// To be used inside depthwise_conv_op.cc.
+template class LaunchConv2DOp<SYCLDevice, float>;
+
+#define REGISTER_SYCL(T)                                         \
+  REGISTER_KERNEL_BUILDER(                                       \
+      Name("Conv2D").Device(DEVICE_SYCL).TypeConstraint<T>("T"), \
+      Conv2DOp<SYCLDevice, T>);
+
+TF_CALL_float(REGISTER_SYCL);
+#undef REGISTER_SYCL
+#endif  // TENSORFLOW_USE_SYCL
+
 #if GOOGLE_CUDA
 int64 GetCudnnWorkspaceLimit(const string& envvar_in_mb,
                              int64 default_value_in_bytes) {
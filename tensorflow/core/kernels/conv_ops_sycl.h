@@ -0,0 +1,694 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if !TENSORFLOW_USE_SYCL
+#error This file must only be included when building with SYCL support
+#endif
+
+#ifndef TENSORFLOW_CORE_KERNELS_CONV_OPS_SYCL_H_
+#define TENSORFLOW_CORE_KERNELS_CONV_OPS_SYCL_H_
+
+#include <algorithm>
+
+#include "tensorflow/core/common_runtime/sycl/sycl_util.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/conv_2d.h"
+#include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/util/padding.h"
+
+namespace tensorflow {
+
+typedef Eigen::SyclDevice SYCLDevice;
+
+// SYCL Conv2D, Conv2DBackpropInput and Conv2DBackpropFilter for NHWC inputs
+// and HWIO filters.  Each op has two implementations:
+//
+//  * im2col + GEMM: the input patches are unrolled into a
+//    [images * out_rows * out_cols, filter_rows * filter_cols * in_depth]
+//    matrix and multiplied with the filter by an Eigen contraction.  The
+//    patch matrix is a temporary, so large batches are processed a few
+//    images at a time to keep it under kSYCLConvScratchBytes.
+//  * direct: every work item loops over the window of one output (or
+//    gradient) element.  No scratch memory, and cheaper than the GEMM when
+//    the reduction is short.
+//
+// UseDirectSYCLConv picks between the two.
+
+// Upper bound of the im2col scratch buffer.
+constexpr int64 kSYCLConvScratchBytes = 64 << 20;
+
+// Patch sizes below this are too short for the GEMM to pay for the im2col
+// round trip through global memory.
+constexpr int64 kSYCLConvMinGemmPatchSize = 32;
+
+// Shapes of a 2D convolution.  "in" is the convolution input, "out" the
+// convolution output, for the forward as well as the backprop kernels.
+struct SYCLConv2DParams {
+  int batch_;
+  int in_rows_;
+  int in_cols_;
+  int in_depth_;
+
+  int filter_rows_;
+  int filter_cols_;
+  int out_depth_;
+
+  int out_rows_;
+  int out_cols_;
+
+  int stride_rows_;
+  int stride_cols_;
+
+  int pad_rows_;
+  int pad_cols_;
+
+  // Length of one row of the im2col matrix.
+  int64 patch_size() const {
+    return static_cast<int64>(filter_rows_) * filter_cols_ * in_depth_;
+  }
+  int64 out_pixels() const {
+    return static_cast<int64>(out_rows_) * out_cols_;
+  }
+};
+
+inline Status InitSYCLConv2DParams(const TensorShape& input_shape,
+                                   const TensorShape& filter_shape,
+                                   int row_stride, int col_stride,
+                                   Padding padding, SYCLConv2DParams* params) {
+  params->batch_ = input_shape.dim_size(0);
+  params->in_rows_ = input_shape.dim_size(1);
+  params->in_cols_ = input_shape.dim_size(2);
+  params->in_depth_ = input_shape.dim_size(3);
+  params->filter_rows_ = filter_shape.dim_size(0);
+  params->filter_cols_ = filter_shape.dim_size(1);
+  params->out_depth_ = filter_shape.dim_size(3);
+  params->stride_rows_ = row_stride;
+  params->stride_cols_ = col_stride;
+
+  int64 out_rows = 0, out_cols = 0, pad_rows = 0, pad_cols = 0;
+  TF_RETURN_IF_ERROR(GetWindowedOutputSize(params->in_rows_,
+                                           params->filter_rows_, row_stride,
+                                           padding, &out_rows, &pad_rows));
+  TF_RETURN_IF_ERROR(GetWindowedOutputSize(params->in_cols_,
+                                           params->filter_cols_, col_stride,
+                                           padding, &out_cols, &pad_cols));
+  params->out_rows_ = out_rows;
+  params->out_cols_ = out_cols;
+  params->pad_rows_ = pad_rows;
+  params->pad_cols_ = pad_cols;
+  return Status::OK();
+}
+
+// The direct kernels are used for short patches, and when the patches of a
+// single image do not fit in the scratch budget.
+inline bool UseDirectSYCLConv(const SYCLConv2DParams& p, size_t type_size) {
+  return p.patch_size() < kSYCLConvMinGemmPatchSize ||
+         p.out_pixels() * p.patch_size() * static_cast<int64>(type_size) >
+             kSYCLConvScratchBytes;
+}
+
+// Number of images whose im2col matrix fits in the scratch budget.
+inline int64 SYCLConvImagesPerChunk(const SYCLConv2DParams& p,
+                                    size_t type_size) {
+  const int64 image_bytes =
+      p.out_pixels() * p.patch_size() * static_cast<int64>(type_size);
+  return std::max<int64>(
+      1, std::min<int64>(p.batch_, kSYCLConvScratchBytes / image_bytes));
+}
+
+// Unrolls the input patches of a number of images into the rows of
+// "patches". Expects one thread per element of "patches".
+template <typename T>
+class Im2ColSYCL {
+  using write_accessor = SYCLTensorAccessor<cl::sycl::access::mode::write>;
+  using read_accessor = SYCLTensorAccessor<cl::sycl::access::mode::read>;
+
+ public:
+  Im2ColSYCL(const SYCLConv2DParams& params, const read_accessor input,
+             write_accessor patches)
+      : p_(params), input_accessor_(input), patches_accessor_(patches) {}
+  void operator()(cl::sycl::item<1> item) {
+    const T* input_data = input_accessor_.template get<T>();
+    T* patches_data = patches_accessor_.template get<T>();
+
+    const int index = item.get_linear_id();
+    const int patch_size = p_.filter_rows_ * p_.filter_cols_ * p_.in_depth_;
+    int k = index % patch_size;
+    const int d = k % p_.in_depth_;
+    k /= p_.in_depth_;
+    const int filter_col = k % p_.filter_cols_;
+    const int filter_row = k / p_.filter_cols_;
+
+    int n = index / patch_size;
+    const int out_col = n % p_.out_cols_;
+    n /= p_.out_cols_;
+    const int out_row = n % p_.out_rows_;
+    n /= p_.out_rows_;
+
+    const int in_row = out_row * p_.stride_rows_ - p_.pad_rows_ + filter_row;
+    const int in_col = out_col * p_.stride_cols_ - p_.pad_cols_ + filter_col;
+    T value = T(0);
+    if (in_row >= 0 && in_row < p_.in_rows_ && in_col >= 0 &&
+        in_col < p_.in_cols_) {
+      value = input_data[((n * p_.in_rows_ + in_row) * p_.in_cols_ + in_col) *
+                             p_.in_depth_ +
+                         d];
+    }
+    patches_data[index] = value;
+  }
+
+ private:
+  const SYCLConv2DParams p_;
+  const read_accessor input_accessor_;
+  write_accessor patches_accessor_;
+};
+
+// Inverse of Im2ColSYCL: sums the rows of "patches" back into the image
+// elements they were read from. Expects one thread per element of "output".
+template <typename T>
+class Col2ImSYCL {
+  using write_accessor = SYCLTensorAccessor<cl::sycl::access::mode::write>;
+  using read_accessor = SYCLTensorAccessor<cl::sycl::access::mode::read>;
+
+ public:
+  Col2ImSYCL(const SYCLConv2DParams& params, const read_accessor patches,
+             write_accessor output)
+      : p_(params), patches_accessor_(patches), output_accessor_(output) {}
+  void operator()(cl::sycl::item<1> item) {
+    const T* patches_data = patches_accessor_.template get<T>();
+    T* output_data = output_accessor_.template get<T>();
+
+    const int index = item.get_linear_id();
+    int n = index;
+    const int d = n % p_.in_depth_;
+    n /= p_.in_depth_;
+    const int col = n % p_.in_cols_ + p_.pad_cols_;
+    n /= p_.in_cols_;
+    const int row = n % p_.in_rows_ + p_.pad_rows_;
+    n /= p_.in_rows_;
+
+    const int patch_size = p_.filter_rows_ * p_.filter_cols_ * p_.in_depth_;
+    T value = T(0);
+    for (int filter_row = 0; filter_row < p_.filter_rows_; ++filter_row) {
+      const int row_offset = row - filter_row;
+      if (row_offset < 0) break;
+      if (row_offset % p_.stride_rows_ != 0) continue;
+      const int out_row = row_offset / p_.stride_rows_;
+      if (out_row >= p_.out_rows_) continue;
+      for (int filter_col = 0; filter_col < p_.filter_cols_; ++filter_col) {
+        const int col_offset = col - filter_col;
+        if (col_offset < 0) break;
+        if (col_offset % p_.stride_cols_ != 0) continue;
+        const int out_col = col_offset / p_.stride_cols_;
+        if (out_col >= p_.out_cols_) continue;
+        const int patch = (n * p_.out_rows_ + out_row) * p_.out_cols_ + out_col;
+        const int k = (filter_row * p_.filter_cols_ + filter_col) *
+                          p_.in_depth_ +
+                      d;
+        value += patches_data[patch * patch_size + k];
+      }
+    }
+    output_data[index] = value;
+  }
+
+ private:
+  const SYCLConv2DParams p_;
+  const read_accessor patches_accessor_;
+  write_accessor output_accessor_;
+};
+
+// Direct Conv2D. Each thread computes kTileDepth output channels of one
+// output pixel, so that each input value read is used kTileDepth times and
+// the filter is read contiguously. Expects one thread per output pixel and
+// tile of output channels.
+template <typename T>
+class Conv2DDirectSYCL {
+  using write_accessor = SYCLTensorAccessor<cl::sycl::access::mode::write>;
+  using read_accessor = SYCLTensorAccessor<cl::sycl::access::mode::read>;
+
+ public:
+  static constexpr int kTileDepth = 4;
+
+  static int NumTiles(const SYCLConv2DParams& params) {
+    return (params.out_depth_ + kTileDepth - 1) / kTileDepth;
+  }
+
+  Conv2DDirectSYCL(const SYCLConv2DParams& params, const read_accessor input,
+                   const read_accessor filter, write_accessor output)
+      : p_(params),
+        input_accessor_(input),
+        filter_accessor_(filter),
+        output_accessor_(output) {}
+  void operator()(cl::sycl::item<1> item) {
+    const T* input_data = input_accessor_.template get<T>();
+    const T* filter_data = filter_accessor_.template get<T>();
+    T* output_data = output_accessor_.template get<T>();
+
+    int n = item.get_linear_id();
+    const int tile = n % NumTiles(p_);
+    n /= NumTiles(p_);
+    const int out_col = n % p_.out_cols_;
+    n /= p_.out_cols_;
+    const int out_row = n % p_.out_rows_;
+    n /= p_.out_rows_;
+
+    const int depth_start = tile * kTileDepth;
+    const int remaining_depth = p_.out_depth_ - depth_start;
+    const int tile_depth =
+        remaining_depth < kTileDepth ? remaining_depth : kTileDepth;
+    T accum[kTileDepth];
+    for (int i = 0; i < kTileDepth; ++i) {
+      accum[i] = T(0);
+    }
+
+    const int row_start = out_row * p_.stride_rows_ - p_.pad_rows_;
+    const int col_start = out_col * p_.stride_cols_ - p_.pad_cols_;
+    for (int filter_row = 0; filter_row < p_.filter_rows_; ++filter_row) {
+      const int in_row = row_start + filter_row;
+      if (in_row < 0 || in_row >= p_.in_rows_) continue;
+      for (int filter_col = 0; filter_col < p_.filter_cols_; ++filter_col) {
+        const int in_col = col_start + filter_col;
+        if (in_col < 0 || in_col >= p_.in_cols_) continue;
+        const T* input_pixel =
+            input_data +
+            ((n * p_.in_rows_ + in_row) * p_.in_cols_ + in_col) * p_.in_depth_;
+        const T* filter_pixel =
+            filter_data +
+            (filter_row * p_.filter_cols_ + filter_col) * p_.in_depth_ *
+                p_.out_depth_ +
+            depth_start;
+        for (int d = 0; d < p_.in_depth_; ++d) {
+          const T value = input_pixel[d];
+          const T* filter_values = filter_pixel + d * p_.out_depth_;
+          for (int i = 0; i < tile_depth; ++i) {
+            accum[i] += value * filter_values[i];
+          }
+        }
+      }
+    }
+
+    T* output_pixel =
+        output_data +
+        ((n * p_.out_rows_ + out_row) * p_.out_cols_ + out_col) *
+            p_.out_depth_ +
+        depth_start;
+    for (int i = 0; i < tile_depth; ++i) {
+      output_pixel[i] = accum[i];
+    }
+  }
+
+ private:
+  const SYCLConv2DParams p_;
+  const read_accessor input_accessor_;
+  const read_accessor filter_accessor_;
+  write_accessor output_accessor_;
+};
+
+// Direct Conv2DBackpropInput. Each thread sums the gradients of all the
+// outputs whose window contains its input element. Expects one thread per
+// element of the input backprop tensor.
+template <typename T>
+class Conv2DBackpropInputDirectSYCL {
+  using write_accessor = SYCLTensorAccessor<cl::sycl::access::mode::write>;
+  using read_accessor = SYCLTensorAccessor<cl::sycl::access::mode::read>;
+
+ public:
+  Conv2DBackpropInputDirectSYCL(const SYCLConv2DParams& params,
+                                const read_accessor out_backprop,
+                                const read_accessor filter,
+                                write_accessor in_backprop)
+      : p_(params),
+        out_backprop_accessor_(out_backprop),
+        filter_accessor_(filter),
+        in_backprop_accessor_(in_backprop) {}
+  void operator()(cl::sycl::item<1> item) {
+    const T* out_backprop_data = out_backprop_accessor_.template get<T>();
+    const T* filter_data = filter_accessor_.template get<T>();
+    T* in_backprop_data = in_backprop_accessor_.template get<T>();
+
+    const int index = item.get_linear_id();
+    int n = index;
+    const int d = n % p_.in_depth_;
+    n /= p_.in_depth_;
+    const int col = n % p_.in_cols_ + p_.pad_cols_;
+    n /= p_.in_cols_;
+    const int row = n % p_.in_rows_ + p_.pad_rows_;
+    n /= p_.in_rows_;
+
+    T value = T(0);
+    for (int filter_row = 0; filter_row < p_.filter_rows_; ++filter_row) {
+      const int row_offset = row - filter_row;
+      if (row_offset < 0) break;
+      if (row_offset % p_.stride_rows_ != 0) continue;
+      const int out_row = row_offset / p_.stride_rows_;
+      if (out_row >= p_.out_rows_) continue;
+      for (int filter_col = 0; filter_col < p_.filter_cols_; ++filter_col) {
+        const int col_offset = col - filter_col;
+        if (col_offset < 0) break;
+        if (col_offset % p_.stride_cols_ != 0) continue;
+        const int out_col = col_offset / p_.stride_cols_;
+        if (out_col >= p_.out_cols_) continue;
+        const T* out_backprop_pixel =
+            out_backprop_data +
+            ((n * p_.out_rows_ + out_row) * p_.out_cols_ + out_col) *
+                p_.out_depth_;
+        const T* filter_values =
+            filter_data +
+            ((filter_row * p_.filter_cols_ + filter_col) * p_.in_depth_ + d) *
+                p_.out_depth_;
+        for (int od = 0; od < p_.out_depth_; ++od) {
+          value += out_backprop_pixel[od] * filter_values[od];
+        }
+      }
+    }
+    in_backprop_data[index] = value;
+  }
+
+ private:
+  const SYCLConv2DParams p_;
+  const read_accessor out_backprop_accessor_;
+  const read_accessor filter_accessor_;
+  write_accessor in_backprop_accessor_;
+};
+
+// Direct Conv2DBackpropFilter. Each thread correlates one input channel with
+// one output channel over the whole batch. Expects one thread per element of
+// the filter backprop tensor.
+template <typename T>
+class Conv2DBackpropFilterDirectSYCL {
+  using write_accessor = SYCLTensorAccessor<cl::sycl::access::mode::write>;
+  using read_accessor = SYCLTensorAccessor<cl::sycl::access::mode::read>;
+
+ public:
+  Conv2DBackpropFilterDirectSYCL(const SYCLConv2DParams& params,
+                                 const read_accessor input,
+                                 const read_accessor out_backprop,
+                                 write_accessor filter_backprop)
+      : p_(params),
+        input_accessor_(input),
+        out_backprop_accessor_(out_backprop),
+        filter_backprop_accessor_(filter_backprop) {}
+  void operator()(cl::sycl::item<1> item) {
+    const T* input_data = input_accessor_.template get<T>();
+    const T* out_backprop_data = out_backprop_accessor_.template get<T>();
+    T* filter_backprop_data = filter_backprop_accessor_.template get<T>();
+
+    const int index = item.get_linear_id();
+    int n = index;
+    const int od = n % p_.out_depth_;
+    n /= p_.out_depth_;
+    const int d = n % p_.in_depth_;
+    n /= p_.in_depth_;
+    const int filter_col = n % p_.filter_cols_;
+    const int filter_row = n / p_.filter_cols_;
+
+    T value = T(0);
+    for (int b = 0; b < p_.batch_; ++b) {
+      for (int out_row = 0; out_row < p_.out_rows_; ++out_row) {
+        const int in_row =
+            out_row * p_.stride_rows_ - p_.pad_rows_ + filter_row;
+        if (in_row < 0 || in_row >= p_.in_rows_) continue;
+        for (int out_col = 0; out_col < p_.out_cols_; ++out_col) {
+          const int in_col =
+              out_col * p_.stride_cols_ - p_.pad_cols_ + filter_col;
+          if (in_col < 0 || in_col >= p_.in_cols_) continue;
+          const int in_idx =
+              ((b * p_.in_rows_ + in_row) * p_.in_cols_ + in_col) *
+                  p_.in_depth_ +
+              d;
+          const int out_idx =
+              ((b * p_.out_rows_ + out_row) * p_.out_cols_ + out_col) *
+                  p_.out_depth_ +
+              od;
+          value += input_data[in_idx] * out_backprop_data[out_idx];
+        }
+      }
+    }
+    filter_backprop_data[index] = value;
+  }
+
+ private:
+  const SYCLConv2DParams p_;
+  const read_accessor input_accessor_;
+  const read_accessor out_backprop_accessor_;
+  write_accessor filter_backprop_accessor_;
+};
+
+namespace sycl_conv2d {
+
+template <typename T>
+void Im2Col(const SYCLDevice& device, const SYCLConv2DParams& params,
+            const T* input, int64 num_patches, T* patches) {
+  device.sycl_queue().submit([&](cl::sycl::handler& cgh) {
+    auto input_access =
+        GetSYCLTensorAccessor<cl::sycl::access::mode::read>(device, input, cgh);
+    auto patches_access = GetSYCLTensorAccessor<cl::sycl::access::mode::write>(
+        device, patches, cgh);
+    Im2ColSYCL<T> functor(params, input_access, patches_access);
+    cgh.parallel_for(
+        cl::sycl::range<1>(num_patches * params.patch_size()), functor);
+  });
+}
+
+// C = A * B, contracting dimension "a_dim" of A with "b_dim" of B.
+template <typename T>
+void MatMul(const SYCLDevice& device, const T* a, int64 a_rows, int64 a_cols,
+            const T* b, int64 b_rows, int64 b_cols, int a_dim, int b_dim,
+            T* c, int64 c_rows, int64 c_cols) {
+  Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1> dim_pair;
+  dim_pair[0] = Eigen::IndexPair<Eigen::DenseIndex>(a_dim, b_dim);
+  functor::MatMulConvFunctor<SYCLDevice, T>()(
+      device, typename TTypes<T, 2>::Tensor(c, c_rows, c_cols),
+      typename TTypes<T, 2>::ConstTensor(a, a_rows, a_cols),
+      typename TTypes<T, 2>::ConstTensor(b, b_rows, b_cols), dim_pair);
+}
+
+}  // namespace sycl_conv2d
+
+template <typename T>
+struct LaunchConv2DSYCL {
+  static void launch(OpKernelContext* context, const Tensor& input,
+                     const Tensor& filter, int row_stride, int col_stride,
+                     const Padding& padding, Tensor* output) {
+    const SYCLDevice& device = context->eigen_device<SYCLDevice>();
+    SYCLConv2DParams p;
+    OP_REQUIRES_OK(context,
+                   InitSYCLConv2DParams(input.shape(), filter.shape(),
+                                        row_stride, col_stride, padding, &p));
+    const T* input_data = input.template flat<T>().data();
+    const T* filter_data = filter.template flat<T>().data();
+    T* output_data = output->template flat<T>().data();
+
+    if (p.filter_rows_ == 1 && p.filter_cols_ == 1 && p.stride_rows_ == 1 &&
+        p.stride_cols_ == 1) {
+      // A 1x1 convolution is a matrix multiplication of the input as is.
+      const int64 rows = p.batch_ * p.out_pixels();
+      sycl_conv2d::MatMul<T>(device, input_data, rows, p.in_depth_,
+                             filter_data, p.in_depth_, p.out_depth_, 1, 0,
+                             output_data, rows, p.out_depth_);
+      return;
+    }
+
+    if (UseDirectSYCLConv(p, sizeof(T))) {
+      const int num_threads =
+          p.batch_ * p.out_pixels() * Conv2DDirectSYCL<T>::NumTiles(p);
+      device.sycl_queue().submit([&](cl::sycl::handler& cgh) {
+        auto input_access = GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+            device, input_data, cgh);
+        auto filter_access =
+            GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+                device, filter_data, cgh);
+        auto output_access =
+            GetSYCLTensorAccessor<cl::sycl::access::mode::write>(
+                device, output_data, cgh);
+        Conv2DDirectSYCL<T> functor(p, input_access, filter_access,
+                                    output_access);
+        cgh.parallel_for(cl::sycl::range<1>(num_threads), functor);
+      });
+      return;
+    }
+
+    const int64 images_per_chunk = SYCLConvImagesPerChunk(p, sizeof(T));
+    const int64 patch_size = p.patch_size();
+    Tensor patches;
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                DataTypeToEnum<T>::value,
+                                TensorShape({images_per_chunk * p.out_pixels(),
+                                             patch_size}),
+                                &patches));
+    T* patches_data = patches.template flat<T>().data();
+    const int64 input_image_size =
+        static_cast<int64>(p.in_rows_) * p.in_cols_ * p.in_depth_;
+    const int64 output_image_size = p.out_pixels() * p.out_depth_;
+    for (int64 image = 0; image < p.batch_; image += images_per_chunk) {
+      const int64 num_images = std::min(images_per_chunk, p.batch_ - image);
+      const int64 rows = num_images * p.out_pixels();
+      sycl_conv2d::Im2Col<T>(device, p, input_data + image * input_image_size,
+                             rows, patches_data);
+      sycl_conv2d::MatMul<T>(device, patches_data, rows, patch_size,
+                             filter_data, patch_size, p.out_depth_, 1, 0,
+                             output_data + image * output_image_size, rows,
+                             p.out_depth_);
+    }
+  }
+};
+
+template <typename T>
+struct LaunchConv2DBackpropInputSYCL {
+  static void launch(OpKernelContext* context, const Tensor& out_backprop,
+                     const Tensor& filter, int row_stride, int col_stride,
+                     const Padding& padding, Tensor* in_backprop) {
+    const SYCLDevice& device = context->eigen_device<SYCLDevice>();
+    SYCLConv2DParams p;
+    OP_REQUIRES_OK(context,
+                   InitSYCLConv2DParams(in_backprop->shape(), filter.shape(),
+                                        row_stride, col_stride, padding, &p));
+    const T* out_backprop_data = out_backprop.template flat<T>().data();
+    const T* filter_data = filter.template flat<T>().data();
+    T* in_backprop_data = in_backprop->template flat<T>().data();
+
+    if (UseDirectSYCLConv(p, sizeof(T))) {
+      const int num_threads = in_backprop->NumElements();
+      device.sycl_queue().submit([&](cl::sycl::handler& cgh) {
+        auto out_backprop_access =
+            GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+                device, out_backprop_data, cgh);
+        auto filter_access =
+            GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+                device, filter_data, cgh);
+        auto in_backprop_access =
+            GetSYCLTensorAccessor<cl::sycl::access::mode::write>(
+                device, in_backprop_data, cgh);
+        Conv2DBackpropInputDirectSYCL<T> functor(
+            p, out_backprop_access, filter_access, in_backprop_access);
+        cgh.parallel_for(cl::sycl::range<1>(num_threads), functor);
+      });
+      return;
+    }
+
+    // The gradient of the patches is out_backprop * filter^T, which is then
+    // folded back into the input gradient.
+    const int64 images_per_chunk = SYCLConvImagesPerChunk(p, sizeof(T));
+    const int64 patch_size = p.patch_size();
+    Tensor patches;
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                DataTypeToEnum<T>::value,
+                                TensorShape({images_per_chunk * p.out_pixels(),
+                                             patch_size}),
+                                &patches));
+    T* patches_data = patches.template flat<T>().data();
+    const int64 input_image_size =
+        static_cast<int64>(p.in_rows_) * p.in_cols_ * p.in_depth_;
+    const int64 output_image_size = p.out_pixels() * p.out_depth_;
+    for (int64 image = 0; image < p.batch_; image += images_per_chunk) {
+      const int64 num_images = std::min(images_per_chunk, p.batch_ - image);
+      const int64 rows = num_images * p.out_pixels();
+      sycl_conv2d::MatMul<T>(
+          device, out_backprop_data + image * output_image_size, rows,
+          p.out_depth_, filter_data, patch_size, p.out_depth_, 1, 1,
+          patches_data, rows, patch_size);
+      T* in_backprop_chunk = in_backprop_data + image * input_image_size;
+      device.sycl_queue().submit([&](cl::sycl::handler& cgh) {
+        auto patches_access =
+            GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+                device, patches_data, cgh);
+        auto in_backprop_access =
+            GetSYCLTensorAccessor<cl::sycl::access::mode::write>(
+                device, in_backprop_chunk, cgh);
+        Col2ImSYCL<T> functor(p, patches_access, in_backprop_access);
+        cgh.parallel_for(cl::sycl::range<1>(num_images * input_image_size),
+                         functor);
+      });
+    }
+  }
+};
+
+template <typename T>
+struct LaunchConv2DBackpropFilterSYCL {
+  static void launch(OpKernelContext* context, const Tensor& out_backprop,
+                     const Tensor& input, int row_stride, int col_stride,
+                     const Padding& padding, Tensor* filter_backprop) {
+    const SYCLDevice& device = context->eigen_device<SYCLDevice>();
+    SYCLConv2DParams p;
+    OP_REQUIRES_OK(context, InitSYCLConv2DParams(input.shape(),
+                                                 filter_backprop->shape(),
+                                                 row_stride, col_stride,
+                                                 padding, &p));
+    const T* out_backprop_data = out_backprop.template flat<T>().data();
+    const T* input_data = input.template flat<T>().data();
+    T* filter_backprop_data = filter_backprop->template flat<T>().data();
+
+    // The direct kernel also zeroes the gradient of an empty batch.
+    if (p.batch_ == 0 || UseDirectSYCLConv(p, sizeof(T))) {
+      const int num_threads = filter_backprop->NumElements();
+      device.sycl_queue().submit([&](cl::sycl::handler& cgh) {
+        auto input_access = GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+            device, input_data, cgh);
+        auto out_backprop_access =
+            GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+                device, out_backprop_data, cgh);
+        auto filter_backprop_access =
+            GetSYCLTensorAccessor<cl::sycl::access::mode::write>(
+                device, filter_backprop_data, cgh);
+        Conv2DBackpropFilterDirectSYCL<T> functor(
+            p, input_access, out_backprop_access, filter_backprop_access);
+        cgh.parallel_for(cl::sycl::range<1>(num_threads), functor);
+      });
+      return;
+    }
+
+    // filter_backprop = patches^T * out_backprop. Chunks after the first are
+    // computed into "partial" and accumulated.
+    const int64 images_per_chunk = SYCLConvImagesPerChunk(p, sizeof(T));
+    const int64 patch_size = p.patch_size();
+    Tensor patches;
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                DataTypeToEnum<T>::value,
+                                TensorShape({images_per_chunk * p.out_pixels(),
+                                             patch_size}),
+                                &patches));
+    Tensor partial;
+    if (images_per_chunk < p.batch_) {
+      OP_REQUIRES_OK(context, context->allocate_temp(DataTypeToEnum<T>::value,
+                                                     filter_backprop->shape(),
+                                                     &partial));
+    }
+    T* patches_data = patches.template flat<T>().data();
+    const int64 input_image_size =
+        static_cast<int64>(p.in_rows_) * p.in_cols_ * p.in_depth_;
+    const int64 output_image_size = p.out_pixels() * p.out_depth_;
+    for (int64 image = 0; image < p.batch_; image += images_per_chunk) {
+      const int64 num_images = std::min(images_per_chunk, p.batch_ - image);
+      const int64 rows = num_images * p.out_pixels();
+      sycl_conv2d::Im2Col<T>(device, p, input_data + image * input_image_size,
+                             rows, patches_data);
+      T* chunk_backprop = image == 0 ? filter_backprop_data
+                                     : partial.template flat<T>().data();
+      sycl_conv2d::MatMul<T>(device, patches_data, rows, patch_size,
+                             out_backprop_data + image * output_image_size,
+                             rows, p.out_depth_, 0, 0, chunk_backprop,
+                             patch_size, p.out_depth_);
+      if (image > 0) {
+        filter_backprop->template flat<T>().device(device) +=
+            partial.template flat<T>();
+      }
+    }
+  }
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_CONV_OPS_SYCL_H_
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/cc/ops/const_op.h"
 #include "tensorflow/cc/ops/image_ops.h"
 #include "tensorflow/cc/ops/nn_ops.h"
+#include "tensorflow/cc/ops/nn_ops_internal.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/framework/fake_input.h"
@@ -464,4 +465,228 @@ TEST_F(ConvOpTest, HandwrittenConv) { HandwrittenConv(); }
 
 TEST_F(ConvOpTest, AnisotropicStride) { AnisotropicStrides(); }
 
+#ifdef TENSORFLOW_USE_SYCL
+// Runs each op on the CPU and on the SYCL device and compares the results.
+// The convolution shapes cover the 1x1, direct and im2col + GEMM paths of the
+// SYCL kernels.
+class SYCLConvOpTest : public ::testing::Test {
+ protected:
+  typedef std::function<Output(const Scope&)> OpBuilder;
+
+  static Output RandomInput(const Scope& root, const string& name,
+                            const TensorShape& shape) {
+    Tensor data(DT_FLOAT, shape);
+    data.flat<float>().setRandom();
+    return ops::Const(root.WithOpName(name), Input::Initializer(data));
+  }
+
+  // "make_op" builds the op under test from inputs created on "root".
+  void CompareWithCPU(const Scope& root, const OpBuilder& make_op) {
+    Output cpu = make_op(root.NewSubScope("cpu").WithDevice("/cpu:0"));
+    Output sycl =
+        make_op(root.NewSubScope("sycl").WithDevice("/device:SYCL:0"));
+    GraphDef graph;
+    TF_ASSERT_OK(root.ToGraphDef(&graph));
+
+    std::unique_ptr<Session> session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(session->Create(graph));
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({}, {cpu.node()->name(), sycl.node()->name()},
+                              {}, &outputs));
+    test::ExpectClose(outputs[0], outputs[1], 1e-4, 1e-4);
+  }
+
+  void CompareConv(int batch, int rows, int cols, int in_depth, int out_depth,
+                   int filter_size, int stride, const string& padding) {
+    const std::vector<int> strides = {1, stride, stride, 1};
+    Scope root = Scope::NewRootScope().WithDevice("/cpu:0");
+    Output input =
+        RandomInput(root, "input", TensorShape({batch, rows, cols, in_depth}));
+    Output filter = RandomInput(
+        root, "filter",
+        TensorShape({filter_size, filter_size, in_depth, out_depth}));
+    Output conv = ops::Conv2D(root.WithOpName("conv"), input, filter, strides,
+                              padding);
+    // Only the shape of "conv" matters for the gradients.
+    Output out_backprop = ops::Relu(root.WithOpName("out_backprop"), conv);
+    Output input_sizes = ops::Shape(root.WithOpName("input_sizes"), input);
+    Output filter_sizes = ops::Shape(root.WithOpName("filter_sizes"), filter);
+
+    CompareWithCPU(root, [&](const Scope& s) {
+      return ops::Conv2D(s, input, filter, strides, padding);
+    });
+    CompareWithCPU(root, [&](const Scope& s) {
+      return ops::Conv2DBackpropInput(s, input_sizes, filter, out_backprop,
+                                      strides, padding);
+    });
+    CompareWithCPU(root, [&](const Scope& s) {
+      return ops::Conv2DBackpropFilter(s, input, filter_sizes, out_backprop,
+                                       strides, padding);
+    });
+  }
+
+  void CompareDepthwise(int batch, int rows, int cols, int in_depth,
+                        int depth_multiplier, int filter_size, int stride,
+                        const string& padding) {
+    const std::vector<int> strides = {1, stride, stride, 1};
+    Scope root = Scope::NewRootScope().WithDevice("/cpu:0");
+    Output input =
+        RandomInput(root, "input", TensorShape({batch, rows, cols, in_depth}));
+    Output filter = RandomInput(
+        root, "filter",
+        TensorShape({filter_size, filter_size, in_depth, depth_multiplier}));
+    Output conv = ops::DepthwiseConv2dNative(root.WithOpName("conv"), input,
+                                            filter, strides, padding);
+    Output out_backprop = ops::Relu(root.WithOpName("out_backprop"), conv);
+    Output input_sizes = ops::Shape(root.WithOpName("input_sizes"), input);
+    Output filter_sizes = ops::Shape(root.WithOpName("filter_sizes"), filter);
+
+    CompareWithCPU(root, [&](const Scope& s) {
+      return ops::DepthwiseConv2dNative(s, input, filter, strides, padding);
+    });
+    CompareWithCPU(root, [&](const Scope& s) {
+      return ops::DepthwiseConv2dNativeBackpropInput(
+          s, input_sizes, filter, out_backprop, strides, padding);
+    });
+    CompareWithCPU(root, [&](const Scope& s) {
+      return ops::DepthwiseConv2dNativeBackpropFilter(
+          s, input, filter_sizes, out_backprop, strides, padding);
+    });
+  }
+
+  void ComparePool(int batch, int rows, int cols, int depth, int window,
+                   int stride, const string& padding) {
+    const std::vector<int> ksize = {1, window, window, 1};
+    const std::vector<int> strides = {1, stride, stride, 1};
+    Scope root = Scope::NewRootScope().WithDevice("/cpu:0");
+    Output input =
+        RandomInput(root, "input", TensorShape({batch, rows, cols, depth}));
+    Output max_pool = ops::MaxPool(root.WithOpName("max_pool"), input, ksize,
+                                   strides, padding);
+    Output avg_pool = ops::AvgPool(root.WithOpName("avg_pool"), input, ksize,
+                                   strides, padding);
+    Output out_backprop = ops::Relu(root.WithOpName("out_backprop"), avg_pool);
+    Output input_shape = ops::Shape(root.WithOpName("input_shape"), input);
+
+    CompareWithCPU(root, [&](const Scope& s) {
+      return ops::MaxPool(s, input, ksize, strides, padding);
+    });
+    CompareWithCPU(root, [&](const Scope& s) {
+      return ops::AvgPool(s, input, ksize, strides, padding);
+    });
+    CompareWithCPU(root, [&](const Scope& s) {
+      return ops::internal::MaxPoolGrad(s, input, max_pool, out_backprop,
+                                        ksize, strides, padding);
+    });
+    CompareWithCPU(root, [&](const Scope& s) {
+      return ops::internal::AvgPoolGrad(s, input_shape, out_backprop, ksize,
+                                        strides, padding);
+    });
+  }
+};
+
+TEST_F(SYCLConvOpTest, Pointwise) { CompareConv(2, 5, 5, 16, 8, 1, 1, "SAME"); }
+
+TEST_F(SYCLConvOpTest, PointwiseStrided) {
+  CompareConv(2, 7, 7, 16, 8, 1, 2, "VALID");
+}
+
+TEST_F(SYCLConvOpTest, DirectSame) { CompareConv(2, 9, 9, 3, 5, 3, 1, "SAME"); }
+
+TEST_F(SYCLConvOpTest, DirectStridedValid) {
+  CompareConv(3, 10, 8, 2, 7, 3, 2, "VALID");
+}
+
+TEST_F(SYCLConvOpTest, Im2ColSame) {
+  CompareConv(3, 11, 11, 8, 6, 3, 1, "SAME");
+}
+
+TEST_F(SYCLConvOpTest, Im2ColStridedSame) {
+  CompareConv(2, 12, 9, 4, 10, 5, 2, "SAME");
+}
+
+TEST_F(SYCLConvOpTest, Im2ColStridedValid) {
+  CompareConv(4, 13, 13, 16, 4, 3, 2, "VALID");
+}
+
+TEST_F(SYCLConvOpTest, PoolSame) { ComparePool(2, 9, 9, 3, 3, 2, "SAME"); }
+
+TEST_F(SYCLConvOpTest, PoolValid) { ComparePool(3, 10, 7, 5, 3, 2, "VALID"); }
+
+TEST_F(SYCLConvOpTest, PoolOverlapping) {
+  ComparePool(2, 8, 8, 4, 3, 1, "SAME");
+}
+
+TEST_F(SYCLConvOpTest, Depthwise) {
+  CompareDepthwise(2, 9, 9, 8, 1, 3, 1, "SAME");
+}
+
+TEST_F(SYCLConvOpTest, DepthwiseMultiplierStrided) {
+  CompareDepthwise(3, 10, 7, 3, 2, 3, 2, "VALID");
+}
+
+TEST_F(SYCLConvOpTest, DepthwiseSingleChannel) {
+  CompareDepthwise(2, 8, 8, 1, 4, 3, 2, "SAME");
+}
+
+// The remaining ops of a MobileNet training step. The sessions place nodes
+// strictly, so a missing SYCL kernel fails the comparison.
+TEST_F(SYCLConvOpTest, FusedBatchNorm) {
+  Scope root = Scope::NewRootScope().WithDevice("/cpu:0");
+  Output x = RandomInput(root, "x", TensorShape({4, 5, 5, 6}));
+  Output scale = RandomInput(root, "scale", TensorShape({6}));
+  Output offset = RandomInput(root, "offset", TensorShape({6}));
+  Output y_backprop =
+      RandomInput(root, "y_backprop", TensorShape({4, 5, 5, 6}));
+  Output empty =
+      ops::Const(root.WithOpName("empty"),
+                 Input::Initializer(Tensor(DT_FLOAT, TensorShape({0}))));
+  auto training = ops::FusedBatchNorm::IsTraining(true);
+  auto forward = ops::FusedBatchNorm(root.WithOpName("forward"), x, scale,
+                                     offset, empty, empty, training);
+
+  CompareWithCPU(root, [&](const Scope& s) {
+    return ops::FusedBatchNorm(s, x, scale, offset, empty, empty, training).y;
+  });
+  CompareWithCPU(root, [&](const Scope& s) {
+    return ops::FusedBatchNorm(s, x, scale, offset, empty, empty, training)
+        .batch_variance;
+  });
+  CompareWithCPU(root, [&](const Scope& s) {
+    return ops::FusedBatchNorm(s, x, scale, offset, forward.batch_mean,
+                               forward.batch_variance,
+                               ops::FusedBatchNorm::IsTraining(false))
+        .y;
+  });
+  CompareWithCPU(root, [&](const Scope& s) {
+    return ops::FusedBatchNormGrad(s, y_backprop, x, scale,
+                                   forward.reserve_space_1,
+                                   forward.reserve_space_2)
+        .x_backprop;
+  });
+  CompareWithCPU(root, [&](const Scope& s) {
+    return ops::FusedBatchNormGrad(s, y_backprop, x, scale,
+                                   forward.reserve_space_1,
+                                   forward.reserve_space_2)
+        .scale_backprop;
+  });
+}
+
+TEST_F(SYCLConvOpTest, GatherArgMaxOneHot) {
+  Scope root = Scope::NewRootScope().WithDevice("/cpu:0");
+  Output params = RandomInput(root, "params", TensorShape({10, 6}));
+  Output indices = ops::Const(root.WithOpName("indices"), {3, 0, 9, 3});
+
+  CompareWithCPU(root, [&](const Scope& s) {
+    return ops::Gather(s, params, indices);
+  });
+  CompareWithCPU(root, [&](const Scope& s) {
+    return ops::Cast(s, ops::ArgMax(s, params, 1), DT_FLOAT);
+  });
+  CompareWithCPU(root, [&](const Scope& s) {
+    return ops::OneHot(s, indices, 10, 1.0f, 0.0f);
+  });
+}
+#endif  // TENSORFLOW_USE_SYCL
+
 }  // namespace tensorflow
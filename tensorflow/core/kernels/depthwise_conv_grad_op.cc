@@ -38,6 +38,9 @@ limitations under the License.
 #if GOOGLE_CUDA
 #include "tensorflow/core/platform/stream_executor.h"
 #endif  // GOOGLE_CUDA
+#ifdef TENSORFLOW_USE_SYCL
+#include "tensorflow/core/kernels/depthwise_conv_op_sycl.h"
+#endif  // TENSORFLOW_USE_SYCL
 
 namespace tensorflow {
 
@@ -45,6 +48,9 @@ namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
+#ifdef TENSORFLOW_USE_SYCL
+typedef Eigen::SyclDevice SYCLDevice;
+#endif  // TENSORFLOW_USE_SYCL
 
 // Common code between the two backward pass kernels: verifies that the
 // dimensions all match and extract the padded rows and columns.
@@ -616,6 +622,17 @@ REGISTER_KERNEL_BUILDER(
     DepthwiseConv2dNativeBackpropInputOp<GPUDevice, double>);
 #endif  // GOOGLE_CUDA
 
+#ifdef TENSORFLOW_USE_SYCL
+#define REGISTER_SYCL_KERNEL(T)                                      \
+  REGISTER_KERNEL_BUILDER(Name("DepthwiseConv2dNativeBackpropInput") \
+                              .Device(DEVICE_SYCL)                   \
+                              .TypeConstraint<T>("T")                \
+                              .HostMemory("input_sizes"),            \
+                          DepthwiseConv2dNativeBackpropInputOp<SYCLDevice, T>);
+TF_CALL_SYCL_NUMBER_TYPES(REGISTER_SYCL_KERNEL);
+#undef REGISTER_SYCL_KERNEL
+#endif  // TENSORFLOW_USE_SYCL
+
 // Kernels to compute the gradients of the filters for depthwise convolution.
 
 // Computes filter backprop using 'out_backprop' and 'input_buffer', storing the
@@ -996,4 +1013,16 @@ REGISTER_KERNEL_BUILDER(
     DepthwiseConv2dNativeBackpropFilterOp<GPUDevice, double>);
 #endif  // GOOGLE_CUDA
 
+#ifdef TENSORFLOW_USE_SYCL
+#define REGISTER_SYCL_KERNEL(T)                   \
+  REGISTER_KERNEL_BUILDER(                        \
+      Name("DepthwiseConv2dNativeBackpropFilter") \
+          .Device(DEVICE_SYCL)                    \
+          .TypeConstraint<T>("T")                 \
+          .HostMemory("filter_sizes"),            \
+      DepthwiseConv2dNativeBackpropFilterOp<SYCLDevice, T>);
+TF_CALL_SYCL_NUMBER_TYPES(REGISTER_SYCL_KERNEL);
+#undef REGISTER_SYCL_KERNEL
+#endif  // TENSORFLOW_USE_SYCL
+
 }  // namespace tensorflow
@@ -41,6 +41,9 @@ limitations under the License.
 #if GOOGLE_CUDA
 #include "tensorflow/core/platform/stream_executor.h"
 #endif  // GOOGLE_CUDA
+#ifdef TENSORFLOW_USE_SYCL
+#include "tensorflow/core/kernels/depthwise_conv_op_sycl.h"
+#endif  // TENSORFLOW_USE_SYCL
 
 namespace tensorflow {
 
@@ -53,6 +56,9 @@ namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
+#ifdef TENSORFLOW_USE_SYCL
+typedef Eigen::SyclDevice SYCLDevice;
+#endif  // TENSORFLOW_USE_SYCL
 
 // Computes the vectorized product of 'input_buffer' and 'filter' and stores
 // result in 'output' at location specified by 'out_r' and 'out_c'.
@@ -255,6 +261,11 @@ extern template class LaunchConv2DOp<GPUDevice, float>;
 
 #endif
 
+#ifdef TENSORFLOW_USE_SYCL
+// Extern template instantiated in conv_ops.cc.
+extern template class LaunchConv2DOp<SYCLDevice, float>;
+#endif  // TENSORFLOW_USE_SYCL
+
 template <typename Device, typename T>
 class DepthwiseConv2dNativeOp : public BinaryOp<T> {
  public:
@@ -445,4 +456,12 @@ REGISTER_KERNEL_BUILDER(Name("DepthwiseConv2dNative")
                         DepthwiseConv2dNativeOp<GPUDevice, double>);
 #endif
 
+#ifdef TENSORFLOW_USE_SYCL
+// Only float, since an input depth of 1 is delegated to the SYCL Conv2D.
+REGISTER_KERNEL_BUILDER(Name("DepthwiseConv2dNative")
+                            .Device(DEVICE_SYCL)
+                            .TypeConstraint<float>("T"),
+                        DepthwiseConv2dNativeOp<SYCLDevice, float>);
+#endif  // TENSORFLOW_USE_SYCL
+
 }  // namespace tensorflow
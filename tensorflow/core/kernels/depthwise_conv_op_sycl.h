@@ -0,0 +1,332 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if !TENSORFLOW_USE_SYCL
+#error This file must only be included when building with SYCL support
+#endif
+
+#ifndef TENSORFLOW_CORE_KERNELS_DEPTHWISE_CONV_OP_SYCL_H_
+#define TENSORFLOW_CORE_KERNELS_DEPTHWISE_CONV_OP_SYCL_H_
+
+#include "tensorflow/core/common_runtime/sycl/sycl_util.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/depthwise_conv_op.h"
+
+namespace tensorflow {
+
+typedef Eigen::SyclDevice SYCLDevice;
+
+// SYCL DepthwiseConv2dNative and its gradients for NHWC inputs and
+// [filter_rows, filter_cols, in_depth, depth_multiplier] filters.  Output
+// channel "d" reads input channel d / depth_multiplier, and the filter
+// element of (row, col, d) is at (row * filter_cols + col) * out_depth + d.
+
+// Each thread computes one output element.
+template <typename T>
+class DepthwiseConv2DSYCL {
+  using write_accessor = SYCLTensorAccessor<cl::sycl::access::mode::write>;
+  using read_accessor = SYCLTensorAccessor<cl::sycl::access::mode::read>;
+
+ public:
+  DepthwiseConv2DSYCL(const DepthwiseArgs& args, const read_accessor input,
+                      const read_accessor filter, write_accessor output)
+      : args_(args),
+        input_accessor_(input),
+        filter_accessor_(filter),
+        output_accessor_(output) {}
+  void operator()(cl::sycl::item<1> item) {
+    const T* input_data = input_accessor_.template get<T>();
+    const T* filter_data = filter_accessor_.template get<T>();
+    T* output_data = output_accessor_.template get<T>();
+
+    const int index = item.get_linear_id();
+    int n = index;
+    const int out_d = n % args_.out_depth;
+    n /= args_.out_depth;
+    const int out_col = n % args_.out_cols;
+    n /= args_.out_cols;
+    const int out_row = n % args_.out_rows;
+    n /= args_.out_rows;
+    const int in_d = out_d / args_.depth_multiplier;
+
+    const int row_start = out_row * args_.stride - args_.pad_rows;
+    const int col_start = out_col * args_.stride - args_.pad_cols;
+    T value = T(0);
+    for (int filter_row = 0; filter_row < args_.filter_rows; ++filter_row) {
+      const int in_row = row_start + filter_row;
+      if (in_row < 0 || in_row >= args_.in_rows) continue;
+      for (int filter_col = 0; filter_col < args_.filter_cols; ++filter_col) {
+        const int in_col = col_start + filter_col;
+        if (in_col < 0 || in_col >= args_.in_cols) continue;
+        const int in_idx =
+            ((n * args_.in_rows + in_row) * args_.in_cols + in_col) *
+                args_.in_depth +
+            in_d;
+        const int filter_idx =
+            (filter_row * args_.filter_cols + filter_col) * args_.out_depth +
+            out_d;
+        value += input_data[in_idx] * filter_data[filter_idx];
+      }
+    }
+    output_data[index] = value;
+  }
+
+ private:
+  const DepthwiseArgs args_;
+  const read_accessor input_accessor_;
+  const read_accessor filter_accessor_;
+  write_accessor output_accessor_;
+};
+
+// Each thread sums the gradients of the depth_multiplier output channels of
+// all the outputs whose window contains its input element.
+template <typename T>
+class DepthwiseConv2DBackpropInputSYCL {
+  using write_accessor = SYCLTensorAccessor<cl::sycl::access::mode::write>;
+  using read_accessor = SYCLTensorAccessor<cl::sycl::access::mode::read>;
+
+ public:
+  DepthwiseConv2DBackpropInputSYCL(const DepthwiseArgs& args,
+                                   const read_accessor out_backprop,
+                                   const read_accessor filter,
+                                   write_accessor in_backprop)
+      : args_(args),
+        out_backprop_accessor_(out_backprop),
+        filter_accessor_(filter),
+        in_backprop_accessor_(in_backprop) {}
+  void operator()(cl::sycl::item<1> item) {
+    const T* out_backprop_data = out_backprop_accessor_.template get<T>();
+    const T* filter_data = filter_accessor_.template get<T>();
+    T* in_backprop_data = in_backprop_accessor_.template get<T>();
+
+    const int index = item.get_linear_id();
+    int n = index;
+    const int in_d = n % args_.in_depth;
+    n /= args_.in_depth;
+    const int col = n % args_.in_cols + args_.pad_cols;
+    n /= args_.in_cols;
+    const int row = n % args_.in_rows + args_.pad_rows;
+    n /= args_.in_rows;
+    const int out_d_start = in_d * args_.depth_multiplier;
+
+    T value = T(0);
+    for (int filter_row = 0; filter_row < args_.filter_rows; ++filter_row) {
+      const int row_offset = row - filter_row;
+      if (row_offset < 0) break;
+      if (row_offset % args_.stride != 0) continue;
+      const int out_row = row_offset / args_.stride;
+      if (out_row >= args_.out_rows) continue;
+      for (int filter_col = 0; filter_col < args_.filter_cols; ++filter_col) {
+        const int col_offset = col - filter_col;
+        if (col_offset < 0) break;
+        if (col_offset % args_.stride != 0) continue;
+        const int out_col = col_offset / args_.stride;
+        if (out_col >= args_.out_cols) continue;
+        const T* out_backprop_pixel =
+            out_backprop_data +
+            ((n * args_.out_rows + out_row) * args_.out_cols + out_col) *
+                args_.out_depth +
+            out_d_start;
+        const T* filter_values =
+            filter_data +
+            (filter_row * args_.filter_cols + filter_col) * args_.out_depth +
+            out_d_start;
+        for (int m = 0; m < args_.depth_multiplier; ++m) {
+          value += out_backprop_pixel[m] * filter_values[m];
+        }
+      }
+    }
+    in_backprop_data[index] = value;
+  }
+
+ private:
+  const DepthwiseArgs args_;
+  const read_accessor out_backprop_accessor_;
+  const read_accessor filter_accessor_;
+  write_accessor in_backprop_accessor_;
+};
+
+// Each thread computes the gradient of one filter element over one image.
+// The per-image gradients are written to a [batch, filter elements] buffer
+// and summed afterwards, which keeps batch times more threads busy than
+// reducing over the whole batch in each thread.
+template <typename T>
+class DepthwiseConv2DBackpropFilterSYCL {
+  using write_accessor = SYCLTensorAccessor<cl::sycl::access::mode::write>;
+  using read_accessor = SYCLTensorAccessor<cl::sycl::access::mode::read>;
+
+ public:
+  DepthwiseConv2DBackpropFilterSYCL(const DepthwiseArgs& args,
+                                    const read_accessor out_backprop,
+                                    const read_accessor input,
+                                    write_accessor image_backprop)
+      : args_(args),
+        out_backprop_accessor_(out_backprop),
+        input_accessor_(input),
+        image_backprop_accessor_(image_backprop) {}
+  void operator()(cl::sycl::item<1> item) {
+    const T* out_backprop_data = out_backprop_accessor_.template get<T>();
+    const T* input_data = input_accessor_.template get<T>();
+    T* image_backprop_data = image_backprop_accessor_.template get<T>();
+
+    const int index = item.get_linear_id();
+    int n = index;
+    const int out_d = n % args_.out_depth;
+    n /= args_.out_depth;
+    const int filter_col = n % args_.filter_cols;
+    n /= args_.filter_cols;
+    const int filter_row = n % args_.filter_rows;
+    n /= args_.filter_rows;
+    const int in_d = out_d / args_.depth_multiplier;
+
+    T value = T(0);
+    for (int out_row = 0; out_row < args_.out_rows; ++out_row) {
+      const int in_row = out_row * args_.stride - args_.pad_rows + filter_row;
+      if (in_row < 0 || in_row >= args_.in_rows) continue;
+      for (int out_col = 0; out_col < args_.out_cols; ++out_col) {
+        const int in_col =
+            out_col * args_.stride - args_.pad_cols + filter_col;
+        if (in_col < 0 || in_col >= args_.in_cols) continue;
+        const int in_idx =
+            ((n * args_.in_rows + in_row) * args_.in_cols + in_col) *
+                args_.in_depth +
+            in_d;
+        const int out_idx =
+            ((n * args_.out_rows + out_row) * args_.out_cols + out_col) *
+                args_.out_depth +
+            out_d;
+        value += input_data[in_idx] * out_backprop_data[out_idx];
+      }
+    }
+    image_backprop_data[index] = value;
+  }
+
+ private:
+  const DepthwiseArgs args_;
+  const read_accessor out_backprop_accessor_;
+  const read_accessor input_accessor_;
+  write_accessor image_backprop_accessor_;
+};
+
+template <typename T>
+struct LaunchDepthwiseConvOp<SYCLDevice, T> {
+  void operator()(OpKernelContext* ctx, const DepthwiseArgs& args,
+                  const T* input, const T* filter, T* output,
+                  TensorFormat data_format) {
+    OP_REQUIRES(
+        ctx, data_format == FORMAT_NHWC,
+        errors::Unimplemented(
+            "Depthwise convolution on SYCL is only supported for NHWC format"));
+    const SYCLDevice& device = ctx->eigen_device<SYCLDevice>();
+    const int num_threads =
+        args.batch * args.out_rows * args.out_cols * args.out_depth;
+    device.sycl_queue().submit([&](cl::sycl::handler& cgh) {
+      auto input_access =
+          GetSYCLTensorAccessor<cl::sycl::access::mode::read>(device, input,
+                                                              cgh);
+      auto filter_access =
+          GetSYCLTensorAccessor<cl::sycl::access::mode::read>(device, filter,
+                                                              cgh);
+      auto output_access =
+          GetSYCLTensorAccessor<cl::sycl::access::mode::write>(device, output,
+                                                               cgh);
+      DepthwiseConv2DSYCL<T> functor(args, input_access, filter_access,
+                                     output_access);
+      cgh.parallel_for(cl::sycl::range<1>(num_threads), functor);
+    });
+  }
+};
+
+template <typename T>
+struct LaunchDepthwiseConvBackpropInputOp<SYCLDevice, T> {
+  void operator()(OpKernelContext* ctx, const DepthwiseArgs& args,
+                  const T* out_backprop, const T* filter, T* in_backprop,
+                  TensorFormat data_format) {
+    OP_REQUIRES(
+        ctx, data_format == FORMAT_NHWC,
+        errors::Unimplemented(
+            "Depthwise convolution on SYCL is only supported for NHWC format"));
+    const SYCLDevice& device = ctx->eigen_device<SYCLDevice>();
+    const int num_threads =
+        args.batch * args.in_rows * args.in_cols * args.in_depth;
+    device.sycl_queue().submit([&](cl::sycl::handler& cgh) {
+      auto out_backprop_access =
+          GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+              device, out_backprop, cgh);
+      auto filter_access =
+          GetSYCLTensorAccessor<cl::sycl::access::mode::read>(device, filter,
+                                                              cgh);
+      auto in_backprop_access =
+          GetSYCLTensorAccessor<cl::sycl::access::mode::write>(
+              device, in_backprop, cgh);
+      DepthwiseConv2DBackpropInputSYCL<T> functor(
+          args, out_backprop_access, filter_access, in_backprop_access);
+      cgh.parallel_for(cl::sycl::range<1>(num_threads), functor);
+    });
+  }
+};
+
+template <typename T>
+struct LaunchDepthwiseConvBackpropFilterOp<SYCLDevice, T> {
+  void operator()(OpKernelContext* ctx, const DepthwiseArgs& args,
+                  const T* out_backprop, const T* input, T* filter_backprop,
+                  TensorFormat data_format) {
+    OP_REQUIRES(
+        ctx, data_format == FORMAT_NHWC,
+        errors::Unimplemented(
+            "Depthwise convolution on SYCL is only supported for NHWC format"));
+    const SYCLDevice& device = ctx->eigen_device<SYCLDevice>();
+    const int64 filter_size =
+        static_cast<int64>(args.filter_rows) * args.filter_cols *
+        args.out_depth;
+    typename TTypes<T>::Flat filter_backprop_flat(filter_backprop,
+                                                  filter_size);
+    if (args.batch == 0) {
+      filter_backprop_flat.device(device) =
+          filter_backprop_flat.constant(T(0));
+      return;
+    }
+
+    Tensor image_backprop;
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(
+                            DataTypeToEnum<T>::value,
+                            TensorShape({args.batch, filter_size}),
+                            &image_backprop));
+    T* image_backprop_data = image_backprop.template flat<T>().data();
+    device.sycl_queue().submit([&](cl::sycl::handler& cgh) {
+      auto out_backprop_access =
+          GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+              device, out_backprop, cgh);
+      auto input_access =
+          GetSYCLTensorAccessor<cl::sycl::access::mode::read>(device, input,
+                                                              cgh);
+      auto image_backprop_access =
+          GetSYCLTensorAccessor<cl::sycl::access::mode::write>(
+              device, image_backprop_data, cgh);
+      DepthwiseConv2DBackpropFilterSYCL<T> functor(
+          args, out_backprop_access, input_access, image_backprop_access);
+      cgh.parallel_for(cl::sycl::range<1>(args.batch * filter_size), functor);
+    });
+
+    Eigen::array<int, 1> batch_dim = {{0}};
+    filter_backprop_flat.device(device) =
+        image_backprop.template matrix<T>().sum(batch_dim);
+  }
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DEPTHWISE_CONV_OP_SYCL_H_
@@ -34,6 +34,9 @@ limitations under the License.
 namespace tensorflow {
 using CPUDevice = Eigen::ThreadPoolDevice;
 using GPUDevice = Eigen::GpuDevice;
+#ifdef TENSORFLOW_USE_SYCL
+using SYCLDevice = Eigen::SyclDevice;
+#endif  // TENSORFLOW_USE_SYCL
 
 namespace functor {
 
@@ -45,8 +48,10 @@ struct FusedBatchNorm;
 template <typename Device, typename T, typename U>
 struct FusedBatchNormGrad;
 
-template <typename T, typename U>
-struct FusedBatchNorm<CPUDevice, T, U> {
+// Eigen implementations of the two functors, shared by the CPU and SYCL
+// devices.
+template <typename Device, typename T, typename U>
+struct FusedBatchNormEigen {
   void operator()(OpKernelContext* context, const Tensor& x_input,
                   const Tensor& scale_input, const Tensor& offset_input,
                   const Tensor& estimated_mean_input,
@@ -56,8 +61,9 @@ struct FusedBatchNorm<CPUDevice, T, U> {
                   Tensor* saved_var_output, TensorFormat tensor_format,
                   bool is_training) {
     OP_REQUIRES(context, tensor_format == FORMAT_NHWC,
-                errors::Internal("The CPU implementation of FusedBatchNorm "
-                                 "only supports NHWC tensor format for now."));
+                errors::Internal("The CPU and SYCL implementations of "
+                                 "FusedBatchNorm only support NHWC tensor "
+                                 "format for now."));
     typename TTypes<T, 4>::ConstTensor x(x_input.tensor<T, 4>());
     typename TTypes<U>::ConstVec scale(scale_input.vec<U>());
     typename TTypes<U>::ConstVec offset(offset_input.vec<U>());
@@ -70,7 +76,7 @@ struct FusedBatchNorm<CPUDevice, T, U> {
     typename TTypes<U>::Vec saved_mean(saved_mean_output->vec<U>());
     typename TTypes<U>::Vec saved_var(saved_var_output->vec<U>());
 
-    const CPUDevice& d = context->eigen_device<CPUDevice>();
+    const Device& d = context->eigen_device<Device>();
 
     const int depth = x.dimension(3);
     const int size = x.size();
@@ -96,8 +102,17 @@ struct FusedBatchNorm<CPUDevice, T, U> {
     U rest_size_adjust =
         static_cast<U>(rest_size) / static_cast<U>(rest_size_minus_one);
 
-    Eigen::Tensor<U, 1, Eigen::RowMajor> mean(depth);
-    Eigen::Tensor<U, 1, Eigen::RowMajor> variance(depth);
+    // Temporaries of the device, so that SYCL kernels can read them.
+    Tensor mean_tensor;
+    OP_REQUIRES_OK(context, context->allocate_temp(DataTypeToEnum<U>::value,
+                                                   TensorShape({depth}),
+                                                   &mean_tensor));
+    Tensor variance_tensor;
+    OP_REQUIRES_OK(context, context->allocate_temp(DataTypeToEnum<U>::value,
+                                                   TensorShape({depth}),
+                                                   &variance_tensor));
+    typename TTypes<U>::Vec mean(mean_tensor.vec<U>());
+    typename TTypes<U>::Vec variance(variance_tensor.vec<U>());
     if (is_training) {
       mean.device(d) = (x_rest_by_depth.sum(reduce_dims) * rest_size_inv);
       batch_mean.device(d) = mean;
@@ -129,8 +144,8 @@ struct FusedBatchNorm<CPUDevice, T, U> {
   }
 };
 
-template <typename T, typename U>
-struct FusedBatchNormGrad<CPUDevice, T, U> {
+template <typename Device, typename T, typename U>
+struct FusedBatchNormGradEigen {
   void operator()(OpKernelContext* context, const Tensor& y_backprop_input,
                   const Tensor& x_input, const Tensor& scale_input,
                   const Tensor& mean_input, const Tensor& variance_input,
@@ -138,8 +153,9 @@ struct FusedBatchNormGrad<CPUDevice, T, U> {
                   Tensor* scale_backprop_output, Tensor* offset_backprop_output,
                   TensorFormat tensor_format) {
     OP_REQUIRES(context, tensor_format == FORMAT_NHWC,
-                errors::Internal("The CPU implementation of FusedBatchNormGrad "
-                                 "only supports NHWC tensor format for now."));
+                errors::Internal("The CPU and SYCL implementations of "
+                                 "FusedBatchNormGrad only support NHWC tensor "
+                                 "format for now."));
     typename TTypes<T, 4>::ConstTensor y_backprop(
         y_backprop_input.tensor<T, 4>());
     typename TTypes<T, 4>::ConstTensor x(x_input.tensor<T, 4>());
@@ -159,7 +175,7 @@ struct FusedBatchNormGrad<CPUDevice, T, U> {
     //                  (x - mean(x)) * rsqrt(variance + epsilon))
     // offset_backprop = sum(y_backprop)
 
-    const CPUDevice& d = context->eigen_device<CPUDevice>();
+    const Device& d = context->eigen_device<Device>();
     const int depth = x.dimension(3);
     const int size = x.size();
     const int rest_size = size / depth;
@@ -215,6 +231,26 @@ struct FusedBatchNormGrad<CPUDevice, T, U> {
   }
 };
 
+template <typename T, typename U>
+struct FusedBatchNorm<CPUDevice, T, U>
+    : public FusedBatchNormEigen<CPUDevice, T, U> {};
+
+template <typename T, typename U>
+struct FusedBatchNormGrad<CPUDevice, T, U>
+    : public FusedBatchNormGradEigen<CPUDevice, T, U> {};
+
+#ifdef TENSORFLOW_USE_SYCL
+// Unlike cuDNN, these save the variance rather than its inverse for the
+// gradient, like the CPU kernels do.
+template <typename T, typename U>
+struct FusedBatchNorm<SYCLDevice, T, U>
+    : public FusedBatchNormEigen<SYCLDevice, T, U> {};
+
+template <typename T, typename U>
+struct FusedBatchNormGrad<SYCLDevice, T, U>
+    : public FusedBatchNormGradEigen<SYCLDevice, T, U> {};
+#endif  // TENSORFLOW_USE_SYCL
+
 #if GOOGLE_CUDA
 template <typename T, typename U>
 struct FusedBatchNorm<GPUDevice, T, U> {
@@ -754,4 +790,28 @@ REGISTER_KERNEL_BUILDER(Name("FusedBatchNormGradV2")
 
 #endif
 
+#ifdef TENSORFLOW_USE_SYCL
+
+REGISTER_KERNEL_BUILDER(
+    Name("FusedBatchNorm").Device(DEVICE_SYCL).TypeConstraint<float>("T"),
+    FusedBatchNormOp<SYCLDevice, float, float>);
+
+REGISTER_KERNEL_BUILDER(
+    Name("FusedBatchNormGrad").Device(DEVICE_SYCL).TypeConstraint<float>("T"),
+    FusedBatchNormGradOp<SYCLDevice, float, float>);
+
+REGISTER_KERNEL_BUILDER(Name("FusedBatchNormV2")
+                            .Device(DEVICE_SYCL)
+                            .TypeConstraint<float>("T")
+                            .TypeConstraint<float>("U"),
+                        FusedBatchNormOp<SYCLDevice, float, float>);
+
+REGISTER_KERNEL_BUILDER(Name("FusedBatchNormGradV2")
+                            .Device(DEVICE_SYCL)
+                            .TypeConstraint<float>("T")
+                            .TypeConstraint<float>("U"),
+                        FusedBatchNormGradOp<SYCLDevice, float, float>);
+
+#endif  // TENSORFLOW_USE_SYCL
+
 }  // namespace tensorflow
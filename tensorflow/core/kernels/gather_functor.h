@@ -25,9 +25,15 @@ limitations under the License.
 #include "tensorflow/core/platform/prefetch.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/work_sharder.h"
+#ifdef TENSORFLOW_USE_SYCL
+#include "tensorflow/core/common_runtime/sycl/sycl_util.h"
+#endif  // TENSORFLOW_USE_SYCL
 
 namespace tensorflow {
 typedef Eigen::ThreadPoolDevice CPUDevice;
+#ifdef TENSORFLOW_USE_SYCL
+typedef Eigen::SyclDevice SYCLDevice;
+#endif  // TENSORFLOW_USE_SYCL
 
 namespace functor {
 
@@ -162,6 +168,88 @@ struct GatherFunctor<CPUDevice, T, Index> {
   }
 };
 
+#ifdef TENSORFLOW_USE_SYCL
+// Copies params[batch, indices[i], slice] to out[batch, i, slice]. Expects
+// one thread per element of "out".
+template <typename T, typename Index>
+class GatherOpSYCL {
+  using write_accessor = SYCLTensorAccessor<cl::sycl::access::mode::write>;
+  using read_accessor = SYCLTensorAccessor<cl::sycl::access::mode::read>;
+
+ public:
+  GatherOpSYCL(const read_accessor params, const read_accessor indices,
+               write_accessor out, int64 gather_dim_size, int64 indices_size,
+               int64 slice_size)
+      : params_accessor_(params),
+        indices_accessor_(indices),
+        out_accessor_(out),
+        gather_dim_size_(gather_dim_size),
+        indices_size_(indices_size),
+        slice_size_(slice_size) {}
+  void operator()(cl::sycl::item<1> item) {
+    const T* params_data = params_accessor_.template get<T>();
+    const Index* indices_data = indices_accessor_.template get<Index>();
+    T* out_data = out_accessor_.template get<T>();
+
+    const int64 index = item.get_linear_id();
+    const int64 batch_indices_i = index / slice_size_;
+    const int64 batch_i = batch_indices_i / indices_size_;
+    const int64 indices_i = batch_indices_i - batch_i * indices_size_;
+    const int64 slice_i = index - batch_indices_i * slice_size_;
+
+    const Index gather_i = indices_data[indices_i];
+    if (!FastBoundsCheck(gather_i, gather_dim_size_)) {
+      // Like the GPU kernel, out of range indices gather zeros.
+      out_data[index] = T(0);
+    } else {
+      out_data[index] =
+          params_data[(batch_i * gather_dim_size_ + gather_i) * slice_size_ +
+                      slice_i];
+    }
+  }
+
+ private:
+  const read_accessor params_accessor_;
+  const read_accessor indices_accessor_;
+  write_accessor out_accessor_;
+  const int64 gather_dim_size_;
+  const int64 indices_size_;
+  const int64 slice_size_;
+};
+
+template <typename T, typename Index>
+struct GatherFunctor<SYCLDevice, T, Index> {
+  int64 operator()(OpKernelContext* ctx,
+                   typename TTypes<T, 3>::ConstTensor params,
+                   typename TTypes<Index>::ConstFlat indices,
+                   typename TTypes<T, 3>::Tensor out) {
+    const SYCLDevice& device = ctx->eigen_device<SYCLDevice>();
+    const int64 out_size = out.size();
+    if (out_size == 0) {
+      return -1;
+    }
+    const int64 gather_dim_size = params.dimension(1);
+    const int64 indices_size = indices.size();
+    const int64 slice_size = params.dimension(2);
+    device.sycl_queue().submit([&](cl::sycl::handler& cgh) {
+      auto params_access = GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+          device, params.data(), cgh);
+      auto indices_access =
+          GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+              device, indices.data(), cgh);
+      auto out_access = GetSYCLTensorAccessor<cl::sycl::access::mode::write>(
+          device, out.data(), cgh);
+      GatherOpSYCL<T, Index> functor(params_access, indices_access,
+                                     out_access, gather_dim_size,
+                                     indices_size, slice_size);
+      cgh.parallel_for(cl::sycl::range<1>(out_size), functor);
+    });
+    // The indices live on the device, so as on GPU they are not validated.
+    return -1;
+  }
+};
+#endif  // TENSORFLOW_USE_SYCL
+
 }  // namespace functor
 }  // namespace tensorflow
 
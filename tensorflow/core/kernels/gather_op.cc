@@ -30,6 +30,9 @@ namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
+#ifdef TENSORFLOW_USE_SYCL
+typedef Eigen::SyclDevice SYCLDevice;
+#endif  // TENSORFLOW_USE_SYCL
 
 template <typename Device, typename T, typename Index>
 class GatherOp : public OpKernel {
@@ -159,6 +162,17 @@ TF_CALL_complex128(REGISTER_GATHER_GPU);
 
 #endif  // GOOGLE_CUDA
 
+#ifdef TENSORFLOW_USE_SYCL
+
+// Registration of the SYCL implementations.
+#define REGISTER_GATHER_SYCL(type) REGISTER_GATHER_ALL_INDICES(SYCL, type)
+
+TF_CALL_SYCL_NUMBER_TYPES(REGISTER_GATHER_SYCL);
+
+#undef REGISTER_GATHER_SYCL
+
+#endif  // TENSORFLOW_USE_SYCL
+
 #undef REGISTER_GATHER_ALL_INDICES
 #undef REGISTER_GATHER_FULL
 
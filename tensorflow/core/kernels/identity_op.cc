@@ -85,6 +85,17 @@ REGISTER_SYCL_HOST_KERNEL(bool);
 
 #endif  // TENSORFLOW_USE_SYCL
 
+// OpenCL device, the output shares the input's cl_mem buffer
+REGISTER_KERNEL_BUILDER(
+    Name("Identity").Device(DEVICE_OPENCL).TypeConstraint<float>("T"),
+    IdentityOp);
+REGISTER_KERNEL_BUILDER(Name("Identity")
+                            .Device(DEVICE_OPENCL)
+                            .HostMemory("input")
+                            .HostMemory("output")
+                            .TypeConstraint<int32>("T"),
+                        IdentityOp);
+
 #define REGISTER_GPU_KERNEL(type)                                           \
   REGISTER_KERNEL_BUILDER(                                                  \
       Name("Identity").Device(DEVICE_GPU).TypeConstraint<type>("T"),        \
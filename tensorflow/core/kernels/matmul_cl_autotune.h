@@ -0,0 +1,212 @@
+// clGemmAutotuneCache <---- clMatMulRuntime (device name, driver version)
+//     |
+//     +-- (M, K, N, transpose A, transpose B, dtype) -> clGemmAlgorithm
+//     +-- <cache dir>/gemm_autotune_<device hash>.txt
+//
+// Records the fastest OpenCL GEMM variant per problem shape, the OpenCL
+// counterpart of the cuBLAS algorithm autotuning in matmul_op.cc.
+
+#ifndef MATMUL_CL_AUTOTUNE_H_
+#define MATMUL_CL_AUTOTUNE_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/matmul_cl_runtime.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+
+  // OpenCL GEMM implementations the MatMul path can dispatch to
+  enum clGemmAlgorithm {
+    kClGemmTN1DFloat4 = 0,   // MatMul_TN_1D_Fp32_Float4
+    kClGemmTN1DFloat8 = 1,   // MatMul_TN_1D_Fp32_Float8
+    kClGemmTN1DFloat16 = 2,  // MatMul_TN_1D_Fp32_Float16
+    kClGemmNN2DLocalMem = 3, // MatMul_NN_2D_LocalMem_Fp32
+    kClGemmCLBlast = 4,      // CLBlastSgemm
+    kClGemmTiled2D = 5,      // MatMul_NN_2D_Tiled_Fp32, any shape
+    kClGemmNumAlgorithms = 6,
+  };
+
+  // Used when autotuning is disabled and no tuned result is cached
+  constexpr clGemmAlgorithm kClGemmDefaultAlgorithm = kClGemmTN1DFloat16;
+
+  // Used for shapes the default algorithm doesn't support
+  constexpr clGemmAlgorithm kClGemmFallbackAlgorithm = kClGemmTiled2D;
+
+  inline const char* clGemmAlgorithmName(clGemmAlgorithm algorithm){
+    switch( algorithm ){
+      case kClGemmTN1DFloat4: return "TN_1D_Float4";
+      case kClGemmTN1DFloat8: return "TN_1D_Float8";
+      case kClGemmTN1DFloat16: return "TN_1D_Float16";
+      case kClGemmNN2DLocalMem: return "NN_2D_LocalMem";
+      case kClGemmCLBlast: return "CLBlast";
+      case kClGemmTiled2D: return "NN_2D_Tiled";
+      default: return "Unknown";
+    }
+  }
+
+  // Problem description an autotuned algorithm is keyed by
+  struct clGemmParameters {
+    uint64 m;
+    uint64 k;
+    uint64 n;
+    bool transpose_a;
+    bool transpose_b;
+    DataType dtype;
+
+    bool operator==(const clGemmParameters& other) const {
+      return m == other.m && k == other.k && n == other.n &&
+             transpose_a == other.transpose_a &&
+             transpose_b == other.transpose_b && dtype == other.dtype;
+    }
+
+    string ToString() const {
+      return strings::StrCat(m, " ", k, " ", n, " ",
+                             static_cast<int>(transpose_a), " ",
+                             static_cast<int>(transpose_b), " ",
+                             static_cast<int>(dtype));
+    }
+
+    struct Hasher {
+      size_t operator()(const clGemmParameters& p) const {
+        return static_cast<size_t>(Hash64(p.ToString()));
+      }
+    };
+  };
+
+  // Process-wide map from clGemmParameters to the fastest clGemmAlgorithm on
+  // the runtime's device. Entries are written to a text file in the OpenCL
+  // cache directory, named after a hash of the device name and driver
+  // version, and reloaded on the first lookup of the next process.
+  class clGemmAutotuneCache {
+    public:
+
+      static clGemmAutotuneCache* Global(){
+        static clGemmAutotuneCache* cache = new clGemmAutotuneCache();
+        return cache;
+      }
+
+      // Cache persisted to cachePath rather than to the file of the runtime's
+      // device, for tests
+      clGemmAutotuneCache(const string& deviceKey, const string& cachePath)
+        : deviceKey(deviceKey), cachePath(cachePath) {}
+
+      // Returns true and sets *algorithm if params have been tuned
+      bool find(const clGemmParameters& params, clGemmAlgorithm* algorithm)
+      {
+        mutex_lock l(mu);
+        loadLocked();
+        auto it = results.find(params);
+        if( it == results.end() ){
+          return false;
+        }
+        *algorithm = it->second;
+        return true;
+      }
+
+      // Records the winner for params and persists it
+      void insert(const clGemmParameters& params, clGemmAlgorithm algorithm)
+      {
+        mutex_lock l(mu);
+        loadLocked();
+        results[params] = algorithm;
+        VLOG(1) << "OpenCL GEMM autotune [" << params.ToString() << "] -> "
+                << clGemmAlgorithmName(algorithm);
+
+        // Rewrite the whole file, it only holds a few hundred lines
+        string contents = strings::StrCat("# ", deviceKey, "\n");
+        for( const auto& r : results ){
+          strings::StrAppend(&contents, r.first.ToString(), " ",
+                             static_cast<int>(r.second), "\n");
+        }
+
+        // Write to a temporary file and rename it, so a concurrent process
+        // never reads a partial cache
+        Env* env = Env::Default();
+        const string tmpPath = strings::StrCat(cachePath, ".tmp",
+                                               env->NowMicros());
+        Status s = env->RecursivelyCreateDir(io::Dirname(cachePath).ToString());
+        if( s.ok() ){
+          s = WriteStringToFile(env, tmpPath, contents);
+        }
+        if( s.ok() ){
+          s = env->RenameFile(tmpPath, cachePath);
+        }
+        if( !s.ok() ){
+          LOG(WARNING) << "Fail to write OpenCL GEMM autotune cache "
+                       << cachePath << ": " << s;
+          env->DeleteFile(tmpPath).IgnoreError();
+        }
+      }
+
+    private:
+
+      clGemmAutotuneCache() {}
+
+      // Reads the cache file, once. The file of the runtime's device unless
+      // the cache was given a path.
+      void loadLocked() EXCLUSIVE_LOCKS_REQUIRED(mu)
+      {
+        if( loaded ){
+          return;
+        }
+        loaded = true;
+
+        if( cachePath.empty() ){
+          clMatMulRuntime* runtime = clMatMulRuntime::Global();
+          deviceKey = runtime->deviceName() + "|" + runtime->driverVersion();
+          cachePath = io::JoinPath(runtime->cacheDirectory(),
+                                   strings::StrCat("gemm_autotune_",
+                                                   Hash64(deviceKey), ".txt"));
+        }
+
+        string contents;
+        if( !ReadFileToString(Env::Default(), cachePath, &contents).ok() ){
+          return;
+        }
+        for( const string& line : str_util::Split(contents, '\n') ){
+          if( line.empty() || line[0] == '#' ){
+            continue;
+          }
+          std::vector<string> fields = str_util::Split(line, ' ');
+          int64 v[7];
+          bool valid = fields.size() == 7;
+          for( size_t i = 0 ; valid && i < 7 ; i++ ){
+            valid = strings::safe_strto64(fields[i], &v[i]);
+          }
+          if( !valid || v[6] < 0 || v[6] >= kClGemmNumAlgorithms ){
+            LOG(WARNING) << "Skipping malformed OpenCL GEMM autotune entry: "
+                         << line;
+            continue;
+          }
+          clGemmParameters params = {
+            static_cast<uint64>(v[0]), static_cast<uint64>(v[1]),
+            static_cast<uint64>(v[2]), v[3] != 0, v[4] != 0,
+            static_cast<DataType>(v[5]),
+          };
+          results[params] = static_cast<clGemmAlgorithm>(v[6]);
+        }
+      }
+
+      mutex mu;
+      bool loaded GUARDED_BY(mu) = false;
+      string deviceKey GUARDED_BY(mu);
+      string cachePath GUARDED_BY(mu);
+      std::unordered_map<clGemmParameters, clGemmAlgorithm,
+                         clGemmParameters::Hasher> results GUARDED_BY(mu);
+
+  };  // class clGemmAutotuneCache
+
+}  // end namespace tensorflow
+
+#endif  // MATMUL_CL_AUTOTUNE_H_
@@ -0,0 +1,112 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/matmul_cl_autotune.h"
+
+#include <vector>
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+string CachePath(const string& name) {
+  const string dir = io::JoinPath(testing::TmpDir(), "gemm_autotune", name);
+  int64 undeleted_files, undeleted_dirs;
+  Env::Default()
+      ->DeleteRecursively(dir, &undeleted_files, &undeleted_dirs)
+      .IgnoreError();
+  return io::JoinPath(dir, "gemm_autotune.txt");
+}
+
+const clGemmParameters kSquare = {256, 256, 256, false, false, DT_FLOAT};
+const clGemmParameters kTransposed = {100, 37, 83, true, false, DT_FLOAT};
+const clGemmParameters kHalf = {64, 64, 64, false, true, DT_HALF};
+
+TEST(clGemmAutotuneCacheTest, MissingFile) {
+  clGemmAutotuneCache cache("device", CachePath("missing"));
+  clGemmAlgorithm algorithm;
+  EXPECT_FALSE(cache.find(kSquare, &algorithm));
+}
+
+TEST(clGemmAutotuneCacheTest, RoundTrip) {
+  const string path = CachePath("round_trip");
+  {
+    clGemmAutotuneCache cache("device", path);
+    cache.insert(kSquare, kClGemmTN1DFloat8);
+    cache.insert(kTransposed, kClGemmTiled2D);
+    cache.insert(kHalf, kClGemmNN2DLocalMem);
+    // The last result for a shape wins
+    cache.insert(kSquare, kClGemmCLBlast);
+  }
+
+  clGemmAutotuneCache reloaded("device", path);
+  clGemmAlgorithm algorithm;
+  ASSERT_TRUE(reloaded.find(kSquare, &algorithm));
+  EXPECT_EQ(kClGemmCLBlast, algorithm);
+  ASSERT_TRUE(reloaded.find(kTransposed, &algorithm));
+  EXPECT_EQ(kClGemmTiled2D, algorithm);
+  ASSERT_TRUE(reloaded.find(kHalf, &algorithm));
+  EXPECT_EQ(kClGemmNN2DLocalMem, algorithm);
+  const clGemmParameters other = {256, 256, 256, false, true, DT_FLOAT};
+  EXPECT_FALSE(reloaded.find(other, &algorithm));
+
+  // Only the cache file is left, no temporary file
+  std::vector<string> children;
+  TF_ASSERT_OK(Env::Default()->GetChildren(io::Dirname(path).ToString(),
+                                           &children));
+  ASSERT_EQ(1, children.size());
+  EXPECT_EQ("gemm_autotune.txt", children[0]);
+}
+
+TEST(clGemmAutotuneCacheTest, SkipsMalformedLines) {
+  const string path = CachePath("malformed");
+  Env* env = Env::Default();
+  TF_ASSERT_OK(env->RecursivelyCreateDir(io::Dirname(path).ToString()));
+  TF_ASSERT_OK(WriteStringToFile(
+      env, path,
+      strings::StrCat("# device\n",
+                      "garbage\n",
+                      "256 256 256 0 0\n",
+                      "256 256 256 0 0 1 99\n",
+                      "256 256 256 0 0 1 -1\n",
+                      "256 x 256 0 0 1 2\n",
+                      "\n",
+                      kTransposed.ToString(), " ",
+                      static_cast<int>(kClGemmTiled2D), "\n")));
+
+  clGemmAutotuneCache cache("device", path);
+  clGemmAlgorithm algorithm;
+  EXPECT_FALSE(cache.find(kSquare, &algorithm));
+  ASSERT_TRUE(cache.find(kTransposed, &algorithm));
+  EXPECT_EQ(kClGemmTiled2D, algorithm);
+
+  // The next write drops the malformed lines
+  cache.insert(kSquare, kClGemmTN1DFloat4);
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(env, path, &contents));
+  EXPECT_EQ(string::npos, contents.find("garbage"));
+  EXPECT_EQ(string::npos, contents.find(" 99"));
+  clGemmAutotuneCache reloaded("device", path);
+  ASSERT_TRUE(reloaded.find(kSquare, &algorithm));
+  EXPECT_EQ(kClGemmTN1DFloat4, algorithm);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,186 @@
+// clBatchedEngine<T>, T = float or Eigen::half <---- clMatMulRuntime
+//     |
+//     +-- MatMul_Batched_2D_Tiled_Fp32 / MatMul_Batched_2D_Tiled_Fp16
+//         (opencl-compiler/kernels/GEMM.c)
+//
+// Computes a whole BatchMatMul with one upload of each operand, one kernel
+// launch and one read back, instead of a GEMM call per matrix. Used by
+// LaunchBatchMatMul<CPUDevice> (batch_matmul_op_impl.h) when
+// clMatMulDispatcher::chooseBatched() predicts OpenCL to be faster than the
+// Eigen loop over the batch.
+
+#ifndef MATMUL_CL_BATCHED_H_
+#define MATMUL_CL_BATCHED_H_
+
+#include <algorithm>
+#include <initializer_list>
+
+#include "third_party/eigen3/Eigen/Core"
+#include "tensorflow/core/kernels/matmul_cl_runtime.h"
+#include "tensorflow/core/lib/core/bits.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+  // Batched C[b] = op(A[b]) * op(B[b]) on row-major matrices packed one
+  // after the other. T is float or Eigen::half; half operands are uploaded
+  // as is and accumulated in float. Batches larger than the device
+  // allocation limit are computed in as few launches as fit.
+  template<class T>
+  class clBatchedEngine {
+    static_assert(sizeof(T) == sizeof(float) || sizeof(T) == sizeof(cl_half),
+                  "clBatchedEngine computes float or half products");
+
+    public:
+
+      static constexpr size_t kTileSize = 16;
+
+      // out[b] (m x n) = op(x[b]) * op(y[b]), where op(x[b]) is m x k and
+      // op(y[b]) is k x n. adjX / adjY select the transpose of x and y.
+      // Returns the first failing OpenCL status, out is undefined then.
+      static cl_int run(const T* x, const T* y, T* out, uint64 batch,
+                        uint64 m, uint64 k, uint64 n, bool adjX, bool adjY)
+      {
+        clMatMulRuntime* runtime = clMatMulRuntime::Global();
+        if( !runtime->ok() ){
+          return runtime->status();
+        }
+
+        // Every buffer must fit the device allocation limit once rounded up
+        // to a buffer pool bucket, and be addressable with 32-bit indices
+        const size_t maxAllocBytes = runtime->maxMemAllocSize();
+        if( maxAllocBytes < sizeof(T) ){
+          return CL_INVALID_BUFFER_SIZE;
+        }
+        const uint64 maxElems = std::min<uint64>(
+            ( uint64(1) << Log2Floor64(maxAllocBytes) ) / sizeof(T),
+            0xffffffffu);
+        const uint64 elemsX = m * k;
+        const uint64 elemsY = k * n;
+        const uint64 elemsOut = m * n;
+        const uint64 perBatch = std::max(std::max(elemsX, elemsY), elemsOut);
+        if( perBatch == 0 || perBatch > maxElems ){
+          return CL_INVALID_BUFFER_SIZE;
+        }
+        const uint64 chunk = std::min(batch, maxElems / perBatch);
+
+        cl_program clProgram = runtime->program(kClMatMulProgram,
+                                                "-cl-fast-relaxed-math");
+        if( clProgram == NULL ){
+          return CL_INVALID_PROGRAM;
+        }
+        cl_kernel clKernel = runtime->acquireKernel(clProgram, kernelName());
+        if( clKernel == NULL ){
+          return CL_INVALID_PROGRAM;
+        }
+
+        clBufferPool* pool = runtime->bufferPool();
+        cl_mem clBufferX = pool->get(CL_MEM_READ_ONLY,
+                                     sizeof(T) * chunk * elemsX);
+        cl_mem clBufferY = pool->get(CL_MEM_READ_ONLY,
+                                     sizeof(T) * chunk * elemsY);
+        cl_mem clBufferOut = pool->get(CL_MEM_WRITE_ONLY,
+                                       sizeof(T) * chunk * elemsOut);
+        cl_int err = CL_SUCCESS;
+        if( clBufferX == NULL || clBufferY == NULL || clBufferOut == NULL ){
+          err = CL_MEM_OBJECT_ALLOCATION_FAILURE;
+        }
+
+        // Element (i, j) of op(x[b]) is x[b][i * rowStrideX + j * colStrideX]
+        const cl_uint M = m;
+        const cl_uint K = k;
+        const cl_uint N = n;
+        const cl_uint rowStrideX = adjX ? 1 : k;
+        const cl_uint colStrideX = adjX ? m : 1;
+        const cl_uint rowStrideY = adjY ? 1 : n;
+        const cl_uint colStrideY = adjY ? k : 1;
+        if( err == CL_SUCCESS ){
+          err = setArgs(clKernel, { { sizeof(cl_uint), &M },
+                                    { sizeof(cl_uint), &K },
+                                    { sizeof(cl_uint), &N },
+                                    { sizeof(cl_mem), &clBufferX },
+                                    { sizeof(cl_uint), &rowStrideX },
+                                    { sizeof(cl_uint), &colStrideX },
+                                    { sizeof(cl_mem), &clBufferY },
+                                    { sizeof(cl_uint), &rowStrideY },
+                                    { sizeof(cl_uint), &colStrideY },
+                                    { sizeof(cl_mem), &clBufferOut } });
+        }
+
+        // The in-order queue serializes the chunks, so the buffers are only
+        // overwritten once the previous kernel and read back are done
+        cl_command_queue clQueue = runtime->queue();
+        for( uint64 start = 0 ; start < batch && err == CL_SUCCESS ;
+             start += chunk ){
+          const uint64 count = std::min(chunk, batch - start);
+          err = clEnqueueWriteBuffer(clQueue, clBufferX, CL_FALSE, 0,
+                  sizeof(T) * count * elemsX, x + start * elemsX, 0, NULL,
+                  NULL);
+          if( err != CL_SUCCESS ) break;
+          err = clEnqueueWriteBuffer(clQueue, clBufferY, CL_FALSE, 0,
+                  sizeof(T) * count * elemsY, y + start * elemsY, 0, NULL,
+                  NULL);
+          if( err != CL_SUCCESS ) break;
+          const size_t global[3] = { roundUpToTile(m), roundUpToTile(n),
+                                     static_cast<size_t>(count) };
+          const size_t local[3] = { kTileSize, kTileSize, 1 };
+          err = clEnqueueNDRangeKernel(clQueue, clKernel, 3, NULL, global,
+                                       local, 0, NULL, NULL);
+          if( err != CL_SUCCESS ) break;
+          err = clEnqueueReadBuffer(clQueue, clBufferOut, CL_FALSE, 0,
+                  sizeof(T) * count * elemsOut, out + start * elemsOut, 0,
+                  NULL, NULL);
+        }
+
+        // Wait for the read backs, and for commands enqueued before a
+        // failure which may still use the buffers
+        const cl_int finish = clFinish(clQueue);
+        if( err == CL_SUCCESS ){
+          err = finish;
+        }
+
+        pool->put(clBufferX);
+        pool->put(clBufferY);
+        pool->put(clBufferOut);
+        runtime->releaseKernel(clProgram, kernelName(), clKernel);
+        if( err != CL_SUCCESS ){
+          LOG(WARNING) << "OpenCL batched MatMul [" << batch << " x " << m
+                       << "," << k << "," << n << "] failed with code " << err;
+        }
+        return err;
+      }
+
+    private:
+
+      clBatchedEngine() = delete;
+
+      static const char* kernelName(){
+        return sizeof(T) == sizeof(cl_half) ? "MatMul_Batched_2D_Tiled_Fp16"
+                                            : "MatMul_Batched_2D_Tiled_Fp32";
+      }
+
+      static size_t roundUpToTile(uint64 n){
+        return ( n + kTileSize - 1 ) / kTileSize * kTileSize;
+      }
+
+      struct clKernelArg {
+        size_t size;
+        const void* value;
+      };
+
+      static cl_int setArgs(cl_kernel clKernel,
+                            std::initializer_list<clKernelArg> args){
+        cl_uint index = 0;
+        for( const clKernelArg& arg : args ){
+          cl_int err = clSetKernelArg(clKernel, index++, arg.size, arg.value);
+          if( err != CL_SUCCESS ) return err;
+        }
+        return CL_SUCCESS;
+      }
+
+  };  // class clBatchedEngine
+
+}  // end namespace tensorflow
+
+#endif  // MATMUL_CL_BATCHED_H_
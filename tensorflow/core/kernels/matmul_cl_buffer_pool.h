@@ -0,0 +1,234 @@
+// clBufferPool <---- clMatMulRuntime
+//     |
+//     +-- free list   (keyed by cl_mem_flags + size bucket, LRU eviction)
+//     +-- in-use map  (cl_mem -> size bucket)
+//
+// Recycles OpenCL memory objects across MatMul calls, in the spirit of
+// PoolAllocator (core/common_runtime/gpu/pool_allocator.h) for host memory.
+
+#ifndef MATMUL_CL_BUFFER_POOL_H_
+#define MATMUL_CL_BUFFER_POOL_H_
+
+#include <algorithm>
+#include <iterator>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/lib/core/bits.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+#define CL_USE_DEPRECATED_OPENCL_1_2_APIS // to disable deprecation warnings
+
+#include "CL/cl.h"
+
+namespace tensorflow {
+
+  // Size-bucketed pool of cl_mem objects. Requests are rounded up to the
+  // next power of two (at least kMinBucketBytes) and served from a buffer of
+  // the same bucket and cl_mem_flags if one is idle, so device buffers and
+  // host-mapped (CL_MEM_ALLOC_HOST_PTR) buffers are both recycled.
+  //
+  // Idle buffers are evicted least-recently-used first once the pool holds
+  // more than "pool_bytes_limit" bytes or "pool_size_limit" buffers. A limit
+  // of 0 disables caching, making the pool a thin wrapper around
+  // clCreateBuffer/clReleaseMemObject.
+  class clBufferPool {
+    public:
+
+      static constexpr size_t kMinBucketBytes = 4096;
+
+      clBufferPool(cl_context clCtx, size_t pool_bytes_limit,
+                   size_t pool_size_limit)
+        : clCtx(clCtx),
+          poolBytesLimit(pool_bytes_limit),
+          poolSizeLimit(pool_size_limit) {}
+
+      ~clBufferPool(){ clear(); }
+
+      // Returns a buffer of at least numBytes created with flags, or NULL on
+      // failure. The buffer must be handed back through put().
+      cl_mem get(cl_mem_flags flags, size_t numBytes)
+      {
+        const BucketKey key(flags, roundUp(numBytes));
+        {
+          mutex_lock l(mu);
+          auto it = freeBuffers.find(key);
+          if( it != freeBuffers.end() ){
+            cl_mem buffer = it->second->buffer;
+            lru.erase(it->second);
+            freeBuffers.erase(it);
+            cachedBytes -= key.second;
+            inUse[buffer] = key;
+            recordAlloc(key.second);
+            ++hits;
+            return buffer;
+          }
+          ++misses;
+        }
+
+        // Pool miss, create a new buffer outside of the lock
+        cl_int err = CL_SUCCESS;
+        cl_mem buffer = clCreateBuffer(clCtx, flags, key.second, NULL, &err);
+        if( err != CL_SUCCESS ){
+          LOG(ERROR) << "Fail to create cl buffer of " << key.second
+                     << " bytes with code " << err;
+          return NULL;
+        }
+
+        mutex_lock l(mu);
+        inUse[buffer] = key;
+        recordAlloc(key.second);
+        return buffer;
+      }
+
+      // Returns a buffer obtained from get() to the pool. All commands using
+      // the buffer must have been enqueued before this call; the in-order
+      // command queue guarantees they complete before the buffer is reused.
+      void put(cl_mem buffer)
+      {
+        if( buffer == NULL ){
+          return;
+        }
+
+        std::vector<cl_mem> evicted;
+        {
+          mutex_lock l(mu);
+          auto it = inUse.find(buffer);
+          if( it == inUse.end() ){
+            LOG(ERROR) << "cl buffer was not allocated from this pool";
+            return;
+          }
+          const BucketKey key = it->second;
+          inUse.erase(it);
+          bytesInUse -= key.second;
+
+          lru.push_front(FreeRecord{key, buffer});
+          freeBuffers.emplace(key, lru.begin());
+          cachedBytes += key.second;
+
+          while( !lru.empty() &&
+                 ( static_cast<size_t>(cachedBytes) > poolBytesLimit ||
+                   lru.size() > poolSizeLimit ) ){
+            evicted.push_back(evictOne());
+          }
+        }
+
+        for( cl_mem e : evicted ){
+          clReleaseMemObject(e);
+        }
+      }
+
+      // Releases every idle buffer. Buffers in use are unaffected.
+      void clear()
+      {
+        std::vector<cl_mem> evicted;
+        {
+          mutex_lock l(mu);
+          while( !lru.empty() ){
+            evicted.push_back(evictOne());
+          }
+        }
+        for( cl_mem e : evicted ){
+          clReleaseMemObject(e);
+        }
+      }
+
+      // Allocation statistics, bytes are counted in rounded bucket sizes.
+      // bytes_limit reports the cap on idle cached bytes.
+      void GetStats(AllocatorStats* stats)
+      {
+        mutex_lock l(mu);
+        stats->num_allocs = numAllocs;
+        stats->bytes_in_use = bytesInUse;
+        stats->max_bytes_in_use = maxBytesInUse;
+        stats->max_alloc_size = maxAllocSize;
+        stats->bytes_limit = static_cast<int64>(poolBytesLimit);
+      }
+
+      // The following accessors permit monitoring the effectiveness of the
+      // pool, as in PoolAllocator.
+
+      // Number of get() requests satisfied from the pool.
+      int64 hitCount(){ mutex_lock l(mu); return hits; }
+      // Number of get() requests requiring a fresh clCreateBuffer.
+      int64 missCount(){ mutex_lock l(mu); return misses; }
+      // Number of idle buffers released to stay within the limits.
+      int64 evictedCount(){ mutex_lock l(mu); return evictions; }
+      // Bytes held by idle buffers.
+      int64 cachedByteCount(){ mutex_lock l(mu); return cachedBytes; }
+
+    private:
+
+      typedef std::pair<cl_mem_flags, size_t> BucketKey;
+
+      struct FreeRecord {
+        BucketKey key;
+        cl_mem buffer;
+      };
+
+      static size_t roundUp(size_t numBytes){
+        if( numBytes <= kMinBucketBytes ){
+          return kMinBucketBytes;
+        }
+        return static_cast<size_t>(1uLL << Log2Ceiling64(numBytes));
+      }
+
+      void recordAlloc(size_t bucketBytes) EXCLUSIVE_LOCKS_REQUIRED(mu)
+      {
+        ++numAllocs;
+        bytesInUse += bucketBytes;
+        maxBytesInUse = std::max(maxBytesInUse, bytesInUse);
+        maxAllocSize = std::max(maxAllocSize, static_cast<int64>(bucketBytes));
+      }
+
+      // Removes the least recently used idle buffer and returns it. The
+      // caller releases it outside of the lock.
+      cl_mem evictOne() EXCLUSIVE_LOCKS_REQUIRED(mu)
+      {
+        auto last = std::prev(lru.end());
+        auto range = freeBuffers.equal_range(last->key);
+        for( auto it = range.first; it != range.second; ++it ){
+          if( it->second == last ){
+            freeBuffers.erase(it);
+            break;
+          }
+        }
+        cl_mem buffer = last->buffer;
+        cachedBytes -= last->key.second;
+        lru.erase(last);
+        ++evictions;
+        return buffer;
+      }
+
+      const cl_context clCtx;
+      const size_t poolBytesLimit;
+      const size_t poolSizeLimit;
+
+      mutex mu;
+      // Idle buffers, most recently returned at the front
+      std::list<FreeRecord> lru GUARDED_BY(mu);
+      std::multimap<BucketKey, std::list<FreeRecord>::iterator> freeBuffers
+        GUARDED_BY(mu);
+      std::unordered_map<cl_mem, BucketKey> inUse GUARDED_BY(mu);
+
+      int64 cachedBytes GUARDED_BY(mu) = 0;
+      int64 bytesInUse GUARDED_BY(mu) = 0;
+      int64 maxBytesInUse GUARDED_BY(mu) = 0;
+      int64 maxAllocSize GUARDED_BY(mu) = 0;
+      int64 numAllocs GUARDED_BY(mu) = 0;
+      int64 hits GUARDED_BY(mu) = 0;
+      int64 misses GUARDED_BY(mu) = 0;
+      int64 evictions GUARDED_BY(mu) = 0;
+
+  };  // class clBufferPool
+
+}  // end namespace tensorflow
+
+#endif  // MATMUL_CL_BUFFER_POOL_H_
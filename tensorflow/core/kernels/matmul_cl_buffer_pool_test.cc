@@ -0,0 +1,194 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/matmul_cl_buffer_pool.h"
+
+#include "tensorflow/core/kernels/matmul_cl_runtime.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// The pools create real buffers in the context of the process-wide runtime.
+// The tests are skipped when the process has no OpenCL device.
+cl_context Context() {
+  clMatMulRuntime* runtime = clMatMulRuntime::Global();
+  if (!runtime->ok()) {
+    LOG(WARNING) << "No OpenCL runtime, skipping test";
+    return NULL;
+  }
+  return runtime->context();
+}
+
+TEST(clBufferPoolTest, RoundsToBuckets) {
+  cl_context ctx = Context();
+  if (ctx == NULL) return;
+  clBufferPool pool(ctx, 1 << 20 /*pool_bytes_limit*/,
+                    100 /*pool_size_limit*/);
+
+  cl_mem p0 = pool.get(CL_MEM_READ_WRITE, 1);
+  ASSERT_NE(nullptr, p0);
+  AllocatorStats stats;
+  pool.GetStats(&stats);
+  EXPECT_EQ(4096, stats.bytes_in_use);
+
+  cl_mem p1 = pool.get(CL_MEM_READ_WRITE, 5000);
+  ASSERT_NE(nullptr, p1);
+  pool.GetStats(&stats);
+  EXPECT_EQ(4096 + 8192, stats.bytes_in_use);
+  EXPECT_EQ(8192, stats.max_alloc_size);
+
+  // Sizes of the same bucket share buffers.
+  pool.put(p1);
+  EXPECT_EQ(p1, pool.get(CL_MEM_READ_WRITE, 8192));
+  pool.put(p1);
+  EXPECT_EQ(p1, pool.get(CL_MEM_READ_WRITE, 4097));
+  EXPECT_EQ(2, pool.hitCount());
+
+  // Buffers with other flags don't.
+  pool.put(p1);
+  cl_mem p2 = pool.get(CL_MEM_READ_ONLY, 8192);
+  ASSERT_NE(nullptr, p2);
+  EXPECT_NE(p1, p2);
+  EXPECT_EQ(2, pool.hitCount());
+  EXPECT_EQ(3, pool.missCount());
+
+  pool.put(p0);
+  pool.put(p2);
+  pool.GetStats(&stats);
+  EXPECT_EQ(0, stats.bytes_in_use);
+  EXPECT_EQ(4096 + 8192, stats.max_bytes_in_use);
+  EXPECT_EQ(5, stats.num_allocs);
+  EXPECT_EQ(1 << 20, stats.bytes_limit);
+  EXPECT_EQ(4096 + 8192 + 8192, pool.cachedByteCount());
+  EXPECT_EQ(0, pool.evictedCount());
+}
+
+TEST(clBufferPoolTest, EvictsLeastRecentlyUsedOverBytesLimit) {
+  cl_context ctx = Context();
+  if (ctx == NULL) return;
+  clBufferPool pool(ctx, 16384 /*pool_bytes_limit*/, 100 /*pool_size_limit*/);
+
+  cl_mem p0 = pool.get(CL_MEM_READ_WRITE, 8192);
+  cl_mem p1 = pool.get(CL_MEM_READ_WRITE, 4096);
+  cl_mem p2 = pool.get(CL_MEM_READ_WRITE, 8192);
+  ASSERT_NE(nullptr, p0);
+  ASSERT_NE(nullptr, p1);
+  ASSERT_NE(nullptr, p2);
+  pool.put(p0);
+  pool.put(p1);
+  EXPECT_EQ(0, pool.evictedCount());
+  EXPECT_EQ(12288, pool.cachedByteCount());
+
+  // 20 KB of idle buffers, p0 is the least recently used.
+  pool.put(p2);
+  EXPECT_EQ(1, pool.evictedCount());
+  EXPECT_EQ(12288, pool.cachedByteCount());
+
+  EXPECT_EQ(p2, pool.get(CL_MEM_READ_WRITE, 8192));
+  EXPECT_EQ(1, pool.hitCount());
+  EXPECT_EQ(p1, pool.get(CL_MEM_READ_WRITE, 4096));
+  EXPECT_EQ(2, pool.hitCount());
+  EXPECT_EQ(0, pool.cachedByteCount());
+
+  // A buffer larger than the limit is released as soon as it is returned.
+  cl_mem p3 = pool.get(CL_MEM_READ_WRITE, 32768);
+  ASSERT_NE(nullptr, p3);
+  pool.put(p3);
+  EXPECT_EQ(2, pool.evictedCount());
+  EXPECT_EQ(0, pool.cachedByteCount());
+
+  pool.put(p1);
+  pool.put(p2);
+}
+
+TEST(clBufferPoolTest, EvictsLeastRecentlyUsedOverSizeLimit) {
+  cl_context ctx = Context();
+  if (ctx == NULL) return;
+  clBufferPool pool(ctx, 1 << 20 /*pool_bytes_limit*/, 2 /*pool_size_limit*/);
+
+  cl_mem p0 = pool.get(CL_MEM_READ_WRITE, 4096);
+  cl_mem p1 = pool.get(CL_MEM_READ_WRITE, 4096);
+  cl_mem p2 = pool.get(CL_MEM_READ_WRITE, 4096);
+  ASSERT_NE(nullptr, p0);
+  ASSERT_NE(nullptr, p1);
+  ASSERT_NE(nullptr, p2);
+  pool.put(p0);
+  pool.put(p1);
+  pool.put(p2);
+  EXPECT_EQ(1, pool.evictedCount());
+  EXPECT_EQ(8192, pool.cachedByteCount());
+
+  // p0 was released, p1 and p2 are still pooled.
+  cl_mem q0 = pool.get(CL_MEM_READ_WRITE, 4096);
+  cl_mem q1 = pool.get(CL_MEM_READ_WRITE, 4096);
+  EXPECT_TRUE((q0 == p1 && q1 == p2) || (q0 == p2 && q1 == p1));
+  EXPECT_EQ(2, pool.hitCount());
+  EXPECT_EQ(3, pool.missCount());
+
+  pool.put(q0);
+  pool.put(q1);
+  pool.clear();
+  EXPECT_EQ(0, pool.cachedByteCount());
+  EXPECT_EQ(3, pool.evictedCount());
+}
+
+TEST(clBufferPoolTest, ZeroLimitPassesThrough) {
+  cl_context ctx = Context();
+  if (ctx == NULL) return;
+  clBufferPool pool(ctx, 0 /*pool_bytes_limit*/, 0 /*pool_size_limit*/);
+
+  for (int i = 0; i < 3; ++i) {
+    cl_mem p = pool.get(CL_MEM_READ_WRITE, 4096);
+    ASSERT_NE(nullptr, p);
+    pool.put(p);
+    EXPECT_EQ(0, pool.cachedByteCount());
+  }
+  EXPECT_EQ(0, pool.hitCount());
+  EXPECT_EQ(3, pool.missCount());
+  EXPECT_EQ(3, pool.evictedCount());
+
+  AllocatorStats stats;
+  pool.GetStats(&stats);
+  EXPECT_EQ(3, stats.num_allocs);
+  EXPECT_EQ(0, stats.bytes_in_use);
+  EXPECT_EQ(4096, stats.max_bytes_in_use);
+}
+
+TEST(clBufferPoolTest, IgnoresForeignBuffers) {
+  cl_context ctx = Context();
+  if (ctx == NULL) return;
+  clBufferPool pool(ctx, 1 << 20 /*pool_bytes_limit*/,
+                    100 /*pool_size_limit*/);
+
+  cl_int err = CL_SUCCESS;
+  cl_mem foreign = clCreateBuffer(ctx, CL_MEM_READ_WRITE, 4096, NULL, &err);
+  ASSERT_EQ(CL_SUCCESS, err);
+  pool.put(foreign);
+  pool.put(NULL);  // Should not crash.
+  EXPECT_EQ(0, pool.cachedByteCount());
+
+  // The pool doesn't hand out or release the foreign buffer.
+  cl_mem p = pool.get(CL_MEM_READ_WRITE, 4096);
+  ASSERT_NE(nullptr, p);
+  EXPECT_NE(foreign, p);
+  EXPECT_EQ(0, pool.hitCount());
+  pool.put(p);
+  pool.clear();
+  EXPECT_EQ(CL_SUCCESS, clReleaseMemObject(foreign));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,392 @@
+#include "tensorflow/core/kernels/matmul_cl_device_info.h"
+
+#include <algorithm>
+#include <functional>
+
+#include "tensorflow/core/kernels/matmul_cl_program_registry.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Rounds of Probe_Flops_Fp32, which runs at 2 flop/byte per round. The low
+// end is bound by device memory, the high end by the ALUs.
+const int kFlopsIterations[] = { 1, 4, 16, 64, 256 };
+
+// Buffer size of every probe, capped by CL_DEVICE_MAX_MEM_ALLOC_SIZE
+constexpr size_t kProbeBytes = 16 << 20;
+
+// Each measurement keeps the best of kRepeats runs, after a warm up run
+constexpr int kRepeats = 3;
+
+string deviceInfoString(cl_device_id device, cl_device_info param){
+  size_t size = 0;
+  if( clGetDeviceInfo(device, param, 0, NULL, &size) != CL_SUCCESS ||
+      size == 0 ){
+    return "";
+  }
+  std::vector<char> value(size);
+  if( clGetDeviceInfo(device, param, size, value.data(), NULL) !=
+      CL_SUCCESS ){
+    return "";
+  }
+  return string(value.data(), strnlen(value.data(), size));
+}
+
+template <typename T>
+bool deviceInfo(cl_device_id device, cl_device_info param, T* value){
+  return clGetDeviceInfo(device, param, sizeof(T), value, NULL) == CL_SUCCESS;
+}
+
+// Sets *seconds to the best wall time of enqueue() followed by clFinish()
+bool bestTime(cl_command_queue queue, const std::function<cl_int()>& enqueue,
+              double* seconds){
+  Env* env = Env::Default();
+  for( int r = 0 ; r <= kRepeats ; r++ ){
+    const uint64 start = env->NowMicros();
+    cl_int err = enqueue();
+    if( err == CL_SUCCESS ){
+      err = clFinish(queue);
+    }
+    if( err != CL_SUCCESS ){
+      LOG(WARNING) << "OpenCL device probe failed with code " << err;
+      return false;
+    }
+    const double elapsed =
+      std::max(( env->NowMicros() - start ) * 1e-6, 1e-9);
+    if( r == 1 || ( r > 1 && elapsed < *seconds ) ){
+      *seconds = elapsed;
+    }
+  }
+  return true;
+}
+
+cl_int enqueue1D(cl_command_queue queue, cl_kernel kernel, size_t globalSize){
+  return clEnqueueNDRangeKernel(queue, kernel, 1, NULL, &globalSize, NULL, 0,
+                                NULL, NULL);
+}
+
+// Limits of the runtime's device, with the measurements of the cache or of
+// a new probe unless TF_OPENCL_DEVICE_PROBE=0
+clDeviceCapabilities* loadOrProbe(){
+  clMatMulRuntime* runtime = clMatMulRuntime::Global();
+  if( !runtime->ok() ){
+    return nullptr;
+  }
+  clDeviceCapabilities* caps = new clDeviceCapabilities();
+  if( !clDeviceInfo::queryLimits(runtime, caps) ){
+    LOG(ERROR) << "Fail to query the limits of OpenCL device "
+               << runtime->deviceName();
+    delete caps;
+    return nullptr;
+  }
+
+  bool probe = true;
+  Status s = ReadBoolFromEnvVar("TF_OPENCL_DEVICE_PROBE", true, &probe);
+  if( !s.ok() ){
+    LOG(ERROR) << s.error_message();
+    probe = true;
+  }
+  if( !probe ){
+    return caps;
+  }
+
+  Env* env = Env::Default();
+  const string cachePath = clDeviceInfo::cachePath(runtime);
+  string contents;
+  if( ReadFileToString(env, cachePath, &contents).ok() ){
+    clDeviceCapabilities cached;
+    if( cached.FromString(contents) && cached.measured() &&
+        cached.name == caps->name &&
+        cached.driverVersion == caps->driverVersion ){
+      caps->gflops = cached.gflops;
+      caps->peakGflops = cached.peakGflops;
+      caps->hostToDeviceGBps = cached.hostToDeviceGBps;
+      caps->deviceToHostGBps = cached.deviceToHostGBps;
+      caps->deviceGBps = cached.deviceGBps;
+      VLOG(1) << "Loaded OpenCL device capabilities from " << cachePath;
+      return caps;
+    }
+    LOG(WARNING) << "Ignoring unusable OpenCL device capabilities "
+                 << cachePath;
+  }
+
+  const uint64 start = env->NowMicros();
+  if( !clDeviceInfo::measure(runtime, caps) ){
+    LOG(WARNING) << "OpenCL device probe failed, only the limits of "
+                 << caps->name << " are known";
+    return caps;
+  }
+  LOG(INFO) << "Probed OpenCL device " << caps->name << " in "
+            << ( env->NowMicros() - start ) / 1000 << " ms: "
+            << caps->peakGflops << " GFLOP/s, device "
+            << caps->deviceGBps << " GB/s, host to device "
+            << caps->hostToDeviceGBps << " GB/s, device to host "
+            << caps->deviceToHostGBps << " GB/s";
+
+  // Write to a temporary file and rename it, so a concurrent process never
+  // reads a partial file
+  const string tmpPath = strings::StrCat(cachePath, ".tmp", env->NowMicros());
+  s = env->RecursivelyCreateDir(io::Dirname(cachePath).ToString());
+  if( s.ok() ){
+    s = WriteStringToFile(env, tmpPath, caps->ToString());
+  }
+  if( s.ok() ){
+    s = env->RenameFile(tmpPath, cachePath);
+  }
+  if( !s.ok() ){
+    LOG(WARNING) << "Fail to write OpenCL device capabilities " << cachePath
+                 << ": " << s;
+    env->DeleteFile(tmpPath).IgnoreError();
+  }
+  return caps;
+}
+
+}  // namespace
+
+string clDeviceCapabilities::ToString() const {
+  string out = strings::StrCat(
+      "name ", name, "\n",
+      "vendor ", vendor, "\n",
+      "driver_version ", driverVersion, "\n",
+      "version ", version, "\n",
+      "gpu ", static_cast<int>(gpu), "\n",
+      "compute_units ", computeUnits, "\n",
+      "clock_mhz ", clockMHz, "\n",
+      "max_work_group_size ", maxWorkGroupSize, "\n",
+      "local_mem_size ", localMemSize, "\n",
+      "global_mem_size ", globalMemSize, "\n",
+      "global_mem_cache_size ", globalMemCacheSize, "\n");
+  strings::StrAppend(&out,
+      "fp16 ", static_cast<int>(fp16), "\n",
+      "host_to_device_gbps ", hostToDeviceGBps, "\n",
+      "device_to_host_gbps ", deviceToHostGBps, "\n",
+      "device_gbps ", deviceGBps, "\n");
+  for( const auto& g : gflops ){
+    strings::StrAppend(&out, "gflops ", g.first, " ", g.second, "\n");
+  }
+  return out;
+}
+
+bool clDeviceCapabilities::FromString(const string& text){
+  *this = clDeviceCapabilities();
+  const std::pair<const char*, string*> stringFields[] = {
+    { "name", &name },
+    { "vendor", &vendor },
+    { "driver_version", &driverVersion },
+    { "version", &version },
+  };
+  const std::pair<const char*, int64*> integerFields[] = {
+    { "compute_units", &computeUnits },
+    { "clock_mhz", &clockMHz },
+    { "max_work_group_size", &maxWorkGroupSize },
+    { "local_mem_size", &localMemSize },
+    { "global_mem_size", &globalMemSize },
+    { "global_mem_cache_size", &globalMemCacheSize },
+  };
+  const std::pair<const char*, double*> doubleFields[] = {
+    { "host_to_device_gbps", &hostToDeviceGBps },
+    { "device_to_host_gbps", &deviceToHostGBps },
+    { "device_gbps", &deviceGBps },
+  };
+
+  for( const string& line : str_util::Split(text, '\n') ){
+    if( line.empty() ){
+      continue;
+    }
+    const size_t space = line.find(' ');
+    if( space == string::npos ){
+      return false;
+    }
+    const string key = line.substr(0, space);
+    const string value = line.substr(space + 1);
+
+    bool known = false;
+    for( const auto& field : stringFields ){
+      if( key == field.first ){
+        *field.second = value;
+        known = true;
+      }
+    }
+    for( const auto& field : integerFields ){
+      if( key == field.first ){
+        if( !strings::safe_strto64(value, field.second) ){
+          return false;
+        }
+        known = true;
+      }
+    }
+    for( const auto& field : doubleFields ){
+      if( key == field.first ){
+        if( !strings::safe_strtod(value.c_str(), field.second) ){
+          return false;
+        }
+        known = true;
+      }
+    }
+    if( key == "gpu" || key == "fp16" ){
+      int64 flag = 0;
+      if( !strings::safe_strto64(value, &flag) ){
+        return false;
+      }
+      ( key == "gpu" ? gpu : fp16 ) = flag != 0;
+      known = true;
+    }
+    if( key == "gflops" ){
+      std::vector<string> pair = str_util::Split(value, ' ');
+      double intensity = 0, rate = 0;
+      if( pair.size() != 2 ||
+          !strings::safe_strtod(pair[0].c_str(), &intensity) ||
+          !strings::safe_strtod(pair[1].c_str(), &rate) ){
+        return false;
+      }
+      gflops.emplace_back(intensity, rate);
+      peakGflops = std::max(peakGflops, rate);
+      known = true;
+    }
+    if( !known ){
+      return false;
+    }
+  }
+  return !name.empty();
+}
+
+const clDeviceCapabilities* clDeviceInfo::Global(){
+  static const clDeviceCapabilities* caps = loadOrProbe();
+  return caps;
+}
+
+bool clDeviceInfo::queryLimits(clMatMulRuntime* runtime,
+                               clDeviceCapabilities* caps){
+  cl_device_id device = runtime->device();
+  cl_device_type type = 0;
+  cl_uint computeUnits = 0;
+  cl_uint clockMHz = 0;
+  size_t maxWorkGroupSize = 0;
+  cl_ulong localMemSize = 0;
+  cl_ulong globalMemSize = 0;
+  cl_ulong globalMemCacheSize = 0;
+  if( !deviceInfo(device, CL_DEVICE_TYPE, &type) ||
+      !deviceInfo(device, CL_DEVICE_MAX_COMPUTE_UNITS, &computeUnits) ||
+      !deviceInfo(device, CL_DEVICE_MAX_CLOCK_FREQUENCY, &clockMHz) ||
+      !deviceInfo(device, CL_DEVICE_MAX_WORK_GROUP_SIZE, &maxWorkGroupSize) ||
+      !deviceInfo(device, CL_DEVICE_LOCAL_MEM_SIZE, &localMemSize) ||
+      !deviceInfo(device, CL_DEVICE_GLOBAL_MEM_SIZE, &globalMemSize) ||
+      !deviceInfo(device, CL_DEVICE_GLOBAL_MEM_CACHE_SIZE,
+                  &globalMemCacheSize) ){
+    return false;
+  }
+
+  caps->name = runtime->deviceName();
+  caps->vendor = deviceInfoString(device, CL_DEVICE_VENDOR);
+  caps->driverVersion = runtime->driverVersion();
+  caps->version = deviceInfoString(device, CL_DEVICE_VERSION);
+  caps->gpu = ( type & CL_DEVICE_TYPE_GPU ) != 0;
+  caps->computeUnits = computeUnits;
+  caps->clockMHz = clockMHz;
+  caps->maxWorkGroupSize = maxWorkGroupSize;
+  caps->localMemSize = localMemSize;
+  caps->globalMemSize = globalMemSize;
+  caps->globalMemCacheSize = globalMemCacheSize;
+  caps->fp16 = deviceInfoString(device, CL_DEVICE_EXTENSIONS)
+                 .find("cl_khr_fp16") != string::npos;
+  return true;
+}
+
+bool clDeviceInfo::measure(clMatMulRuntime* runtime,
+                           clDeviceCapabilities* caps){
+  cl_program program = runtime->program(kClDeviceProbeProgram, "");
+  if( program == NULL ){
+    return false;
+  }
+  cl_command_queue queue = runtime->queue();
+
+  // Whole float4s, within the largest allocation the device accepts
+  const size_t numBytes =
+    std::min(kProbeBytes, runtime->maxMemAllocSize()) / 16 * 16;
+  const size_t numFloats = numBytes / sizeof(float);
+  std::vector<char> host(numBytes, 0);
+  cl_int err = CL_SUCCESS;
+  cl_mem src = clCreateBuffer(runtime->context(), CL_MEM_READ_WRITE, numBytes,
+                              NULL, &err);
+  cl_mem dst = clCreateBuffer(runtime->context(), CL_MEM_READ_WRITE, numBytes,
+                              NULL, &err);
+  cl_kernel copy = runtime->acquireKernel(program, "Probe_Copy_Fp32");
+  cl_kernel flops = runtime->acquireKernel(program, "Probe_Flops_Fp32");
+  bool ok = numBytes > 0 && src != NULL && dst != NULL && copy != NULL &&
+            flops != NULL;
+
+  double seconds = 0;
+  ok = ok && bestTime(queue, [&](){
+    return clEnqueueWriteBuffer(queue, src, CL_FALSE, 0, numBytes,
+                                host.data(), 0, NULL, NULL);
+  }, &seconds);
+  caps->hostToDeviceGBps = ok ? numBytes / seconds * 1e-9 : 0;
+
+  ok = ok && bestTime(queue, [&](){
+    return clEnqueueReadBuffer(queue, src, CL_FALSE, 0, numBytes,
+                               host.data(), 0, NULL, NULL);
+  }, &seconds);
+  caps->deviceToHostGBps = ok ? numBytes / seconds * 1e-9 : 0;
+
+  // Every byte is read once and written once
+  ok = ok && clSetKernelArg(copy, 0, sizeof(cl_mem), &src) == CL_SUCCESS &&
+       clSetKernelArg(copy, 1, sizeof(cl_mem), &dst) == CL_SUCCESS &&
+       bestTime(queue, [&](){
+         return enqueue1D(queue, copy, numBytes / 16);
+       }, &seconds);
+  caps->deviceGBps = ok ? 2.0 * numBytes / seconds * 1e-9 : 0;
+
+  caps->gflops.clear();
+  caps->peakGflops = 0;
+  ok = ok && clSetKernelArg(flops, 0, sizeof(cl_mem), &src) == CL_SUCCESS;
+  for( const int iterations : kFlopsIterations ){
+    const cl_int arg = iterations;
+    ok = ok && clSetKernelArg(flops, 1, sizeof(cl_int), &arg) == CL_SUCCESS &&
+         bestTime(queue, [&](){
+           return enqueue1D(queue, flops, numFloats);
+         }, &seconds);
+    if( !ok ){
+      break;
+    }
+    const double rate = 16.0 * iterations * numFloats / seconds * 1e-9;
+    caps->gflops.emplace_back(2.0 * iterations, rate);
+    caps->peakGflops = std::max(caps->peakGflops, rate);
+  }
+
+  runtime->releaseKernel(program, "Probe_Copy_Fp32", copy);
+  runtime->releaseKernel(program, "Probe_Flops_Fp32", flops);
+  if( src != NULL ){
+    clReleaseMemObject(src);
+  }
+  if( dst != NULL ){
+    clReleaseMemObject(dst);
+  }
+
+  if( !ok ){
+    caps->gflops.clear();
+    caps->peakGflops = 0;
+    caps->hostToDeviceGBps = 0;
+    caps->deviceToHostGBps = 0;
+    caps->deviceGBps = 0;
+  }
+  return ok;
+}
+
+string clDeviceInfo::cachePath(clMatMulRuntime* runtime){
+  const string deviceKey = runtime->deviceName() + "|" +
+                           runtime->driverVersion();
+  return io::JoinPath(runtime->cacheDirectory(),
+                      strings::StrCat("device_info_", Hash64(deviceKey),
+                                      ".txt"));
+}
+
+}  // end namespace tensorflow
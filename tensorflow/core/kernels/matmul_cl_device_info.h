@@ -0,0 +1,101 @@
+// clDeviceInfo <---- clMatMulRuntime (device, queue, cache directory)
+//     |
+//     +-- limits      (compute units, clock, work-group size, local & global
+//     |                memory, fp16 support)
+//     +-- throughput  (GFLOP/s at several arithmetic intensities, host to
+//     |                device, device to host and device memory bandwidth)
+//     +-- <cache dir>/device_info_<device hash>.txt
+//
+// The runtime counterpart of opencl-info, opencl-mixbench and
+// opencl-babel-stream-benchmark. The device is probed once per device and
+// driver version, and the results are read by the MatMul dispatcher and by
+// the grappler cost model (GetLocalOpenCLInfo in grappler/clusters/utils.h).
+
+#ifndef MATMUL_CL_DEVICE_INFO_H_
+#define MATMUL_CL_DEVICE_INFO_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/kernels/matmul_cl_runtime.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+  // Static limits and measured throughput of an OpenCL device
+  struct clDeviceCapabilities {
+    // CL_DEVICE_NAME, CL_DEVICE_VENDOR, CL_DRIVER_VERSION, CL_DEVICE_VERSION
+    std::string name;
+    std::string vendor;
+    std::string driverVersion;
+    std::string version;
+
+    // CL_DEVICE_TYPE is CL_DEVICE_TYPE_GPU
+    bool gpu = false;
+    int64 computeUnits = 0;
+    int64 clockMHz = 0;
+    int64 maxWorkGroupSize = 0;
+    int64 localMemSize = 0;
+    int64 globalMemSize = 0;
+    int64 globalMemCacheSize = 0;
+    // cl_khr_fp16 is supported
+    bool fp16 = false;
+
+    // Measured float throughput as (flop/byte, GFLOP/s) pairs in increasing
+    // arithmetic intensity, and its maximum. Empty and 0 if not measured.
+    std::vector<std::pair<double, double>> gflops;
+    double peakGflops = 0;
+
+    // Measured bandwidths in GB/s, 0 if not measured
+    double hostToDeviceGBps = 0;
+    double deviceToHostGBps = 0;
+    double deviceGBps = 0;
+
+    bool measured() const { return peakGflops > 0; }
+
+    // "key value" lines, the format of the on-disk cache
+    string ToString() const;
+
+    // Parses the output of ToString(). Returns false, leaving *this in an
+    // unspecified state, on malformed input.
+    bool FromString(const string& text);
+  };
+
+  // Probes the device of clMatMulRuntime. Limits are queried with
+  // clGetDeviceInfo; throughput is measured with the "device_probe" program
+  // (opencl-compiler/kernels/DeviceProbe.c), which takes a second or two, so
+  // the results are stored in the OpenCL cache directory and reused by the
+  // next processes on the same device and driver.
+  //
+  // TF_OPENCL_DEVICE_PROBE=0 skips the measurements, and neither reads nor
+  // writes the cache.
+  class clDeviceInfo {
+    public:
+
+      // Returns the capabilities of the runtime's device, probing it or
+      // loading them from the cache on the first call. NULL if there is no
+      // usable OpenCL device.
+      static const clDeviceCapabilities* Global();
+
+      // Fills the limits of *caps, returns false on OpenCL errors
+      static bool queryLimits(clMatMulRuntime* runtime,
+                              clDeviceCapabilities* caps);
+
+      // Fills the measured fields of *caps, returns false if a microbenchmark
+      // could not run
+      static bool measure(clMatMulRuntime* runtime,
+                          clDeviceCapabilities* caps);
+
+      // Cache file of the runtime's device
+      static string cachePath(clMatMulRuntime* runtime);
+
+    private:
+
+      clDeviceInfo() = delete;
+
+  };  // class clDeviceInfo
+
+}  // end namespace tensorflow
+
+#endif  // MATMUL_CL_DEVICE_INFO_H_
@@ -0,0 +1,342 @@
+// clMatMulDispatcher <---- clMatMulRuntime, clDeviceInfo (transfer B/s)
+//     |
+//     +-- cost model  (CPU FLOP/s, OpenCL FLOP/s, transfer B/s, launch cost)
+//     +-- overrides   (TF_OPENCL_MATMUL_DISPATCH, TF_OPENCL_MATMUL_MIN_FLOPS,
+//                      TF_OPENCL_MATMUL_SPLIT)
+//
+// Decides per MatMul call whether a float GEMM runs on Eigen, on the OpenCL
+// device, or on both with the rows of the output split between them, and per
+// BatchMatMul call whether the batch runs on Eigen or on clBatchedEngine.
+
+#ifndef MATMUL_CL_DISPATCH_H_
+#define MATMUL_CL_DISPATCH_H_
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/kernels/matmul_cl_device_info.h"
+#include "tensorflow/core/kernels/matmul_cl_runtime.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+
+  // Where a MatMul call is computed
+  enum clMatMulTarget {
+    kClMatMulCPU = 0,     // Eigen on the CPU threadpool
+    kClMatMulOpenCL = 1,  // MatMulCLFunctor
+    kClMatMulSplit = 2,   // Leading rows on OpenCL, the rest on Eigen
+  };
+
+  // Calibrated throughputs of the dispatcher cost model
+  struct clMatMulCostModel {
+    double cpuFlops;    // Eigen GEMM, FLOP/s
+    double clFlops;     // OpenCL GEMM, FLOP/s
+    double bandwidth;   // Host to device transfers, bytes/s
+    double launchCost;  // Fixed cost of an OpenCL GEMM, seconds
+  };
+
+  // Process-wide cost model choosing a clMatMulTarget from the FLOPs and
+  // bytes moved by a GEMM. The model is calibrated once, on the first MatMul,
+  // with a short microbenchmark on both sides:
+  //
+  //   cpu(m, k, n)    = 2mkn / cpuFlops
+  //   opencl(m, k, n) = launchCost + 4(mk + kn + mn) / bandwidth
+  //                                + 2mkn / clFlops
+  //
+  // TF_OPENCL_MATMUL_DISPATCH forces "cpu" or "opencl" ("auto" by default),
+  // TF_OPENCL_MATMUL_MIN_FLOPS replaces the model by a fixed FLOP threshold,
+  // and TF_OPENCL_MATMUL_SPLIT lets large GEMMs run on both devices at once.
+  //
+  // The model is immutable once published, so choose() and chooseBatched()
+  // read it without a lock.
+  class clMatMulDispatcher {
+    public:
+
+      // Times one GEMM of out[m x n] = A[m x k] * B[k x n], returns false if
+      // it could not run
+      typedef std::function<bool(int64 m, int64 k, int64 n, double* seconds)>
+        GemmTimer;
+
+      // Both sides of a split get at least this many rows
+      static constexpr int64 kMinSplitRows = 16;
+
+      // Reads the overrides from the environment. The kernels share the
+      // instance returned by Global().
+      clMatMulDispatcher()
+      {
+        string modeName;
+        Status s = ReadStringFromEnvVar("TF_OPENCL_MATMUL_DISPATCH", "auto",
+                                        &modeName);
+        if( !s.ok() ){
+          LOG(ERROR) << s.error_message();
+        }
+        modeName = str_util::Lowercase(modeName);
+        if( modeName == "cpu" ){
+          mode = kCPU;
+        }else if( modeName == "opencl" ){
+          mode = kOpenCL;
+        }else if( modeName != "auto" ){
+          LOG(ERROR) << "Unknown TF_OPENCL_MATMUL_DISPATCH value " << modeName
+                     << ", expected auto, cpu or opencl";
+        }
+
+        s = ReadInt64FromEnvVar("TF_OPENCL_MATMUL_MIN_FLOPS", 0, &minFlops);
+        if( !s.ok() ){
+          LOG(ERROR) << s.error_message();
+          minFlops = 0;
+        }
+
+        s = ReadBoolFromEnvVar("TF_OPENCL_MATMUL_SPLIT", false, &splitEnabled);
+        if( !s.ok() ){
+          LOG(ERROR) << s.error_message();
+          splitEnabled = false;
+        }
+      }
+
+      ~clMatMulDispatcher()
+      {
+        delete model.load(std::memory_order_acquire);
+      }
+
+      static clMatMulDispatcher* Global(){
+        static clMatMulDispatcher* dispatcher = new clMatMulDispatcher();
+        return dispatcher;
+      }
+
+      // Runs the calibration microbenchmark on the first call, if the cost
+      // model is in use. Calls made while it runs return immediately, and
+      // GEMMs stay on the CPU until the model is published.
+      void calibrateOnce(const GemmTimer& cpuTimer, const GemmTimer& clTimer)
+      {
+        if( calibrationStarted.load(std::memory_order_acquire) ||
+            calibrationStarted.exchange(true, std::memory_order_acq_rel) ){
+          return;
+        }
+        if( mode != kAuto || minFlops > 0 ){
+          return;
+        }
+        clMatMulCostModel calibrated;
+        if( calibrate(cpuTimer, clTimer, &calibrated) ){
+          setModel(calibrated);
+        }
+      }
+
+      // Publishes the cost model used by choose() and chooseBatched(),
+      // unless one already is. Lets tests use a synthetic model.
+      void setModel(const clMatMulCostModel& calibrated)
+      {
+        const clMatMulCostModel* expected = nullptr;
+        clMatMulCostModel* published = new clMatMulCostModel(calibrated);
+        if( !model.compare_exchange_strong(expected, published,
+                                           std::memory_order_acq_rel) ){
+          delete published;
+        }
+      }
+
+      // Picks the target of out[m x n] = A[m x k] * B[k x n]. Splitting is
+      // only considered if canSplit, in which case *clRows is set to the
+      // number of leading rows of out to compute on OpenCL.
+      clMatMulTarget choose(int64 m, int64 k, int64 n, bool canSplit,
+                            int64* clRows)
+      {
+        if( mode == kCPU ){
+          return kClMatMulCPU;
+        }
+        if( mode == kOpenCL ){
+          return kClMatMulOpenCL;
+        }
+
+        const double flops = 2.0 * m * k * n;
+        if( minFlops > 0 ){
+          return flops >= minFlops ? kClMatMulOpenCL : kClMatMulCPU;
+        }
+
+        const clMatMulCostModel* costs = model.load(std::memory_order_acquire);
+        if( costs == nullptr ){
+          return kClMatMulCPU;
+        }
+
+        const double cpuTime = flops / costs->cpuFlops;
+        const double clFixed = costs->launchCost +
+                               4.0 * k * n / costs->bandwidth;
+        const double clPerAllRows = 4.0 * ( m * k + m * n ) / costs->bandwidth +
+                                    flops / costs->clFlops;
+        const double clTime = clFixed + clPerAllRows;
+
+        clMatMulTarget target =
+          clTime < cpuTime ? kClMatMulOpenCL : kClMatMulCPU;
+        if( splitEnabled && canSplit ){
+          // Share of the rows balancing both sides:
+          //   cpuTime * (1 - f) = clFixed + clPerAllRows * f
+          const double f = ( cpuTime - clFixed ) / ( cpuTime + clPerAllRows );
+          const int64 rows = static_cast<int64>(f * m);
+          const double splitTime = cpuTime * ( 1.0 - f );
+          if( rows >= kMinSplitRows && m - rows >= kMinSplitRows &&
+              splitTime < std::min(cpuTime, clTime) ){
+            *clRows = rows;
+            target = kClMatMulSplit;
+          }
+        }
+
+        VLOG(2) << "MatMul [" << m << "," << k << "," << n << "] predicted cpu "
+                << cpuTime * 1e6 << " us, opencl " << clTime * 1e6
+                << " us -> " << target;
+        return target;
+      }
+
+      // Picks kClMatMulCPU or kClMatMulOpenCL for a batch of 'batch' products
+      // out[m x n] = A[m x k] * B[k x n] of float elements. clBatchedEngine
+      // uploads and launches the whole batch at once, so the launch cost is
+      // paid once rather than per product:
+      //
+      //   cpu    = batch * 2mkn / cpuFlops
+      //   opencl = launchCost + batch * (4(mk + kn + mn) / bandwidth
+      //                                  + 2mkn / clFlops)
+      clMatMulTarget chooseBatched(int64 batch, int64 m, int64 k, int64 n)
+      {
+        if( mode == kCPU ){
+          return kClMatMulCPU;
+        }
+        if( mode == kOpenCL ){
+          return kClMatMulOpenCL;
+        }
+
+        const double flops = 2.0 * batch * m * k * n;
+        if( minFlops > 0 ){
+          return flops >= minFlops ? kClMatMulOpenCL : kClMatMulCPU;
+        }
+
+        const clMatMulCostModel* costs = model.load(std::memory_order_acquire);
+        if( costs == nullptr ){
+          return kClMatMulCPU;
+        }
+
+        const double cpuTime = flops / costs->cpuFlops;
+        const double clTime = costs->launchCost +
+                              4.0 * batch * ( m * k + k * n + m * n ) /
+                              costs->bandwidth + flops / costs->clFlops;
+        const clMatMulTarget target =
+          clTime < cpuTime ? kClMatMulOpenCL : kClMatMulCPU;
+        VLOG(2) << "BatchMatMul " << batch << " x [" << m << "," << k << ","
+                << n << "] predicted cpu " << cpuTime * 1e6 << " us, opencl "
+                << clTime * 1e6 << " us -> " << target;
+        return target;
+      }
+
+    private:
+
+      enum Mode { kAuto, kCPU, kOpenCL };
+
+      // Calibration problem sizes, small enough to finish in well under a
+      // second on a mobile GPU
+      static constexpr int64 kSmallDim = 32;
+      static constexpr int64 kLargeDim = 256;
+      static constexpr int64 kCopyBytes = 4 << 20;
+
+      // Fits *calibrated to GEMMs timed on both sides, returns false if the
+      // OpenCL side could not run
+      static bool calibrate(const GemmTimer& cpuTimer,
+                            const GemmTimer& clTimer,
+                            clMatMulCostModel* calibrated)
+      {
+        clMatMulRuntime* runtime = clMatMulRuntime::Global();
+        if( !runtime->ok() ){
+          return false;
+        }
+
+        // Every measurement is taken twice, the first run warms up caches,
+        // program builds and buffer pools
+        double cpuLarge = 0, clSmall = 0, clLarge = 0;
+        if( !timeTwice(cpuTimer, kLargeDim, &cpuLarge) ||
+            !timeTwice(clTimer, kSmallDim, &clSmall) ||
+            !timeTwice(clTimer, kLargeDim, &clLarge) ){
+          LOG(WARNING) << "OpenCL MatMul calibration failed, using Eigen";
+          return false;
+        }
+
+        // The transfer rate comes from the device probe, which is cached
+        // across processes, and is only timed here without it
+        double bandwidth = 0;
+        const clDeviceCapabilities* caps = clDeviceInfo::Global();
+        if( caps != nullptr && caps->hostToDeviceGBps > 0 ){
+          bandwidth = caps->hostToDeviceGBps * 1e9;
+        }else{
+          double copy = 0;
+          if( !timeCopy(runtime, &copy) || !timeCopy(runtime, &copy) ){
+            LOG(WARNING) << "OpenCL MatMul calibration failed, using Eigen";
+            return false;
+          }
+          bandwidth = kCopyBytes / std::max(copy, 1e-9);
+        }
+
+        const double smallFlops = 2.0 * kSmallDim * kSmallDim * kSmallDim;
+        const double largeFlops = 2.0 * kLargeDim * kLargeDim * kLargeDim;
+        const double smallBytes = 12.0 * kSmallDim * kSmallDim;
+        const double largeBytes = 12.0 * kLargeDim * kLargeDim;
+
+        calibrated->bandwidth = bandwidth;
+        calibrated->cpuFlops = largeFlops / std::max(cpuLarge, 1e-9);
+
+        // Two point fit of the OpenCL launch cost & throughput, after taking
+        // out the transfer time
+        const double computeDelta = ( clLarge - largeBytes / bandwidth ) -
+                                    ( clSmall - smallBytes / bandwidth );
+        calibrated->clFlops = ( largeFlops - smallFlops ) /
+                              std::max(computeDelta, 1e-9);
+        calibrated->launchCost =
+          std::max(0.0, clSmall - smallBytes / bandwidth -
+                        smallFlops / calibrated->clFlops);
+
+        LOG(INFO) << "OpenCL MatMul calibration: cpu "
+                  << calibrated->cpuFlops * 1e-9 << " GFLOP/s, opencl "
+                  << calibrated->clFlops * 1e-9 << " GFLOP/s, transfer "
+                  << bandwidth * 1e-9 << " GB/s, launch "
+                  << calibrated->launchCost * 1e6 << " us";
+        return true;
+      }
+
+      static bool timeTwice(const GemmTimer& timer, int64 dim, double* seconds)
+      {
+        return timer(dim, dim, dim, seconds) && timer(dim, dim, dim, seconds);
+      }
+
+      // Host to device copy of kCopyBytes through a pooled buffer
+      static bool timeCopy(clMatMulRuntime* runtime, double* seconds)
+      {
+        std::vector<char> host(kCopyBytes);
+        clBufferPool* pool = runtime->bufferPool();
+        cl_mem buffer = pool->get(CL_MEM_READ_ONLY, kCopyBytes);
+        if( buffer == NULL ){
+          return false;
+        }
+        const uint64 start = Env::Default()->NowMicros();
+        cl_int err = clEnqueueWriteBuffer(runtime->queue(), buffer, CL_TRUE, 0,
+                       kCopyBytes, host.data(), 0, NULL, NULL);
+        *seconds = ( Env::Default()->NowMicros() - start ) * 1e-6;
+        pool->put(buffer);
+        return err == CL_SUCCESS;
+      }
+
+      // Fixed after construction
+      Mode mode = kAuto;
+      int64 minFlops = 0;
+      bool splitEnabled = false;
+
+      std::atomic<bool> calibrationStarted{false};
+      // Null until calibrated, then immutable
+      std::atomic<const clMatMulCostModel*> model{nullptr};
+
+      TF_DISALLOW_COPY_AND_ASSIGN(clMatMulDispatcher);
+
+  };  // class clMatMulDispatcher
+
+}  // end namespace tensorflow
+
+#endif  // MATMUL_CL_DISPATCH_H_
@@ -0,0 +1,188 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/matmul_cl_dispatch.h"
+
+#include <stdlib.h>
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Eigen at 10 GFLOP/s, OpenCL at 100 GFLOP/s behind 10 GB/s transfers and a
+// 100 us launch cost. No device is needed.
+clMatMulCostModel SyntheticModel() {
+  clMatMulCostModel model;
+  model.cpuFlops = 10e9;
+  model.clFlops = 100e9;
+  model.bandwidth = 10e9;
+  model.launchCost = 100e-6;
+  return model;
+}
+
+class MatMulCLDispatchTest : public ::testing::Test {
+ protected:
+  void SetUp() override { ClearEnv(); }
+  void TearDown() override { ClearEnv(); }
+
+  static void ClearEnv() {
+    unsetenv("TF_OPENCL_MATMUL_DISPATCH");
+    unsetenv("TF_OPENCL_MATMUL_MIN_FLOPS");
+    unsetenv("TF_OPENCL_MATMUL_SPLIT");
+  }
+
+  static clMatMulTarget Choose(clMatMulDispatcher* dispatcher, int64 m,
+                               int64 k, int64 n) {
+    int64 cl_rows = -1;
+    const clMatMulTarget target =
+        dispatcher->choose(m, k, n, false /* canSplit */, &cl_rows);
+    EXPECT_EQ(-1, cl_rows);
+    return target;
+  }
+};
+
+TEST_F(MatMulCLDispatchTest, CPUWithoutModel) {
+  clMatMulDispatcher dispatcher;
+  EXPECT_EQ(kClMatMulCPU, Choose(&dispatcher, 4096, 4096, 4096));
+  EXPECT_EQ(kClMatMulCPU, dispatcher.chooseBatched(64, 1024, 1024, 1024));
+}
+
+TEST_F(MatMulCLDispatchTest, CostModel) {
+  clMatMulDispatcher dispatcher;
+  dispatcher.setModel(SyntheticModel());
+
+  // Launch bound
+  EXPECT_EQ(kClMatMulCPU, Choose(&dispatcher, 16, 16, 16));
+  EXPECT_EQ(kClMatMulCPU, Choose(&dispatcher, 64, 64, 64));
+  // Compute bound
+  EXPECT_EQ(kClMatMulOpenCL, Choose(&dispatcher, 2048, 2048, 2048));
+  // Transfer bound: 4 MB moved for 2 MFLOP
+  EXPECT_EQ(kClMatMulCPU, Choose(&dispatcher, 1024, 1, 1024));
+
+  // A batch pays the launch cost once
+  EXPECT_EQ(kClMatMulOpenCL, dispatcher.chooseBatched(1000, 64, 64, 64));
+  EXPECT_EQ(kClMatMulCPU, dispatcher.chooseBatched(1, 64, 64, 64));
+}
+
+TEST_F(MatMulCLDispatchTest, FirstModelWins) {
+  clMatMulDispatcher dispatcher;
+  dispatcher.setModel(SyntheticModel());
+  clMatMulCostModel fastCPU = SyntheticModel();
+  fastCPU.cpuFlops = 1e15;
+  dispatcher.setModel(fastCPU);
+  EXPECT_EQ(kClMatMulOpenCL, Choose(&dispatcher, 2048, 2048, 2048));
+}
+
+TEST_F(MatMulCLDispatchTest, Split) {
+  setenv("TF_OPENCL_MATMUL_SPLIT", "true", 1);
+  clMatMulDispatcher dispatcher;
+  dispatcher.setModel(SyntheticModel());
+
+  int64 cl_rows = 0;
+  EXPECT_EQ(kClMatMulSplit,
+            dispatcher.choose(2048, 2048, 2048, true, &cl_rows));
+  // OpenCL is 10x faster, so it gets most of the rows
+  EXPECT_GT(cl_rows, 1024);
+  EXPECT_LE(cl_rows, 2048 - clMatMulDispatcher::kMinSplitRows);
+
+  EXPECT_EQ(kClMatMulOpenCL, Choose(&dispatcher, 2048, 2048, 2048));
+  // Too few rows for both sides
+  cl_rows = 0;
+  EXPECT_NE(kClMatMulSplit, dispatcher.choose(20, 4096, 4096, true, &cl_rows));
+}
+
+TEST_F(MatMulCLDispatchTest, SplitDisabledByDefault) {
+  clMatMulDispatcher dispatcher;
+  dispatcher.setModel(SyntheticModel());
+  int64 cl_rows = 0;
+  EXPECT_EQ(kClMatMulOpenCL,
+            dispatcher.choose(2048, 2048, 2048, true, &cl_rows));
+}
+
+TEST_F(MatMulCLDispatchTest, ForcedTarget) {
+  setenv("TF_OPENCL_MATMUL_DISPATCH", "cpu", 1);
+  clMatMulDispatcher cpu;
+  cpu.setModel(SyntheticModel());
+  EXPECT_EQ(kClMatMulCPU, Choose(&cpu, 4096, 4096, 4096));
+  EXPECT_EQ(kClMatMulCPU, cpu.chooseBatched(1000, 256, 256, 256));
+
+  setenv("TF_OPENCL_MATMUL_DISPATCH", "OpenCL", 1);
+  clMatMulDispatcher opencl;
+  EXPECT_EQ(kClMatMulOpenCL, Choose(&opencl, 1, 1, 1));
+  EXPECT_EQ(kClMatMulOpenCL, opencl.chooseBatched(1, 1, 1, 1));
+
+  // Unknown values keep the cost model
+  setenv("TF_OPENCL_MATMUL_DISPATCH", "gpu", 1);
+  clMatMulDispatcher unknown;
+  unknown.setModel(SyntheticModel());
+  EXPECT_EQ(kClMatMulCPU, Choose(&unknown, 16, 16, 16));
+  EXPECT_EQ(kClMatMulOpenCL, Choose(&unknown, 2048, 2048, 2048));
+}
+
+TEST_F(MatMulCLDispatchTest, MinFlops) {
+  setenv("TF_OPENCL_MATMUL_MIN_FLOPS", "1000000", 1);
+  clMatMulDispatcher dispatcher;
+  // The threshold replaces the model, calibrated or not
+  EXPECT_EQ(kClMatMulCPU, Choose(&dispatcher, 64, 64, 64));
+  EXPECT_EQ(kClMatMulOpenCL, Choose(&dispatcher, 128, 128, 128));
+  EXPECT_EQ(kClMatMulCPU, dispatcher.chooseBatched(1, 64, 64, 64));
+  EXPECT_EQ(kClMatMulOpenCL, dispatcher.chooseBatched(2, 64, 64, 64));
+}
+
+TEST_F(MatMulCLDispatchTest, OverridesSkipCalibration) {
+  int timed = 0;
+  const clMatMulDispatcher::GemmTimer timer =
+      [&timed](int64 m, int64 k, int64 n, double* seconds) {
+        ++timed;
+        *seconds = 1e-3;
+        return true;
+      };
+
+  setenv("TF_OPENCL_MATMUL_DISPATCH", "cpu", 1);
+  clMatMulDispatcher forced;
+  forced.calibrateOnce(timer, timer);
+  ClearEnv();
+
+  setenv("TF_OPENCL_MATMUL_MIN_FLOPS", "1000000", 1);
+  clMatMulDispatcher threshold;
+  threshold.calibrateOnce(timer, timer);
+  EXPECT_EQ(0, timed);
+}
+
+TEST_F(MatMulCLDispatchTest, ChooseWhileModelIsPublished) {
+  clMatMulDispatcher dispatcher;
+  const int kNumThreads = 4;
+  {
+    thread::ThreadPool pool(Env::Default(), "test", kNumThreads + 1);
+    for (int t = 0; t < kNumThreads; ++t) {
+      pool.Schedule([&dispatcher]() {
+        for (int i = 0; i < 10000; ++i) {
+          int64 cl_rows = 0;
+          const clMatMulTarget target =
+              dispatcher.choose(2048, 2048, 2048, false, &cl_rows);
+          // Either before or after the model is published
+          EXPECT_TRUE(target == kClMatMulCPU || target == kClMatMulOpenCL);
+        }
+      });
+    }
+    pool.Schedule([&dispatcher]() { dispatcher.setModel(SyntheticModel()); });
+  }
+  EXPECT_EQ(kClMatMulOpenCL, Choose(&dispatcher, 2048, 2048, 2048));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -8,21 +8,46 @@
 //     v
 // clQualcommFP16Engine <---- binaryLoaderInterface
 
+// clQualcommFP32Engine
+//     |
+//     v
+// clLocalMem2DEngine
+
+// clMatMulEngine<float>
+//     |
+//     v
+// clTiledEngine <---- binaryLoaderInterface
+
 // clMatMulEngine<float>
 //     |
 //     v
 // clBLASTEngine
 
+// clMatMulEngine<T>, T = Eigen::half or float
+//     |
+//     v
+// clTiledFP16Engine<T> <---- binaryLoaderInterface
+
+// All engines share the OpenCL context, queue, programs and kernels owned by
+// clMatMulRuntime (see matmul_cl_runtime.h). The engine used for a given
+// problem shape is picked by clGemmAutotuneCache (see matmul_cl_autotune.h).
+
 #ifndef MATMUL_CL_FUNCTOR_H_
 #define MATMUL_CL_FUNCTOR_H_
 
-#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <vector>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/kernels/matmul_cl_autotune.h"
+#include "tensorflow/core/kernels/matmul_cl_runtime.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/matmul_autotune.h"
 
 #define CL_USE_DEPRECATED_OPENCL_1_2_APIS // to disable deprecation warnings
 
@@ -66,7 +91,7 @@ typedef union {
   float f;
 } FloatConvUnion;
 
-cl_half float_to_cl_half(float value){
+inline cl_half float_to_cl_half(float value){
 
   FloatConvUnion u;
   u.f = value;
@@ -96,6 +121,22 @@ cl_half float_to_cl_half(float value){
   return half;
 }
 
+// Converts n floats to cl_half through Eigen's packet casts, which use the
+// F16C / NEON conversion instructions where available instead of calling
+// float_to_cl_half on one value at a time
+inline void float_to_cl_half(const float* src, cl_half* dst, size_t n){
+  Eigen::TensorMap<Eigen::Tensor<const float, 1, Eigen::RowMajor>> in(src, n);
+  Eigen::TensorMap<Eigen::Tensor<Eigen::half, 1, Eigen::RowMajor>> out(
+    reinterpret_cast<Eigen::half*>(dst), n);
+  out = in.template cast<Eigen::half>();
+}
+
+// Eigen::half and cl_half share the IEEE 754 binary16 layout
+inline void float_to_cl_half(const Eigen::half* src, cl_half* dst, size_t n){
+  static_assert(sizeof(Eigen::half) == sizeof(cl_half), "half size mismatch");
+  std::memcpy(dst, src, n * sizeof(cl_half));
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 // clSetKernelArg Helper
 #define SET_GEMM_TN_KERNEL_ARG(M, K, N, clMemA, clMemB, clMemC, localSize, localMemType, \
@@ -127,6 +168,8 @@ namespace tensorflow {
   template<class T> class clMatMulEngine {
     public:
 
+      typedef T Scalar;
+
     // Concrete methods
       // clMatMulEngine initializaiotn function
       cl_int hostInit(
@@ -143,18 +186,11 @@ namespace tensorflow {
         RowC = out.dimension(0);
         ColC = out.dimension(1);
 
-        // Matrix size checking
-        int matrixSizeLimit = 0xffff; // Maximum value for cl_ushort
-        if( RowA > matrixSizeLimit ||
-            ColA > matrixSizeLimit ||
-            RowB > matrixSizeLimit ||
-            ColB > matrixSizeLimit ||
-            RowC > matrixSizeLimit ||
-            ColC > matrixSizeLimit )
-        {
-          LOG(ERROR) << "Matrix of Size Larger than " << matrixSizeLimit <<
-          " isn't supported";
-        }
+        // Output storage, wrapped directly by engines supporting zero copy
+        hostPtrC = out.data();
+
+        // Engines whose kernels take cl_ushort dimensions are only used for
+        // shapes that fit, see functor::clGemmSupported()
 
         // Matrix size init
         a_size = sizeof(T) * RowA * ColA;
@@ -165,17 +201,16 @@ namespace tensorflow {
         a_traspose = ( dim_pair[0].first == 0 ) ? true : false;
         b_traspose = ( dim_pair[0].second == 1 ) ? true : false;
 
-        // Query platforms
-        CL_CHECK( clGetPlatformIDs(1, &platform, NULL) );
-
-        // Query devices
-        CL_CHECK( clGetDeviceIDs(platform, CL_DEVICE_TYPE_ALL, 1, &clDevice, NULL) );
-
-        // Create context
-        clCtx = CL_CHECK_ERR( clCreateContext(NULL, 1, &clDevice, NULL, NULL, &_err) );
-
-        // Create command clQueue
-        clQueue = CL_CHECK_ERR( clCreateCommandQueue(clCtx, clDevice, 0, &_err) );
+        // Borrow platform, device, context & command queue from the
+        // process-wide runtime, created once on the first MatMul call
+        runtime = clMatMulRuntime::Global();
+        if( !runtime->ok() ){
+          return runtime->status();
+        }
+        platform = runtime->platform();
+        clDevice = runtime->device();
+        clCtx = runtime->context();
+        clQueue = runtime->queue();
 
         return CL_SUCCESS;
       }
@@ -227,45 +262,21 @@ namespace tensorflow {
       bool a_traspose;
       bool b_traspose;
 
+      // Output tensor storage
+      T* hostPtrC = nullptr;
+
       // Default matrix size
       size_t a_size = 0;
       size_t b_size = 0;
       size_t c_size = 0;
 
-      // OpenCL host side object
+      // OpenCL host side object, owned by clMatMulRuntime
+      clMatMulRuntime* runtime = nullptr;
       cl_platform_id platform;
       cl_device_id clDevice;
       cl_context clCtx;
       cl_command_queue clQueue;
 
-      // Timer
-      std::chrono::high_resolution_clock::time_point timer;
-
-      void startTimer(){
-        timer = std::chrono::high_resolution_clock::now();
-      }
-
-      double read_us(){
-        auto elapsed_time = std::chrono::high_resolution_clock::now() - timer;
-        return std::chrono::duration<double, std::micro>(elapsed_time).count();
-      }
-
-      // Performance calculator
-      void getPerformance(){
-
-        std::ofstream ofs ("performance.log", std::ios_base::app);
-
-        double delta_t = read_us() * 1e-6; // delta_t in second
-
-        double bandwidth = (a_size+b_size+c_size)/delta_t;
-        ofs << bandwidth << " B/s,";
-
-        double flops = (RowA*ColA*RowB*ColB*RowC*ColC)/delta_t;
-        ofs << flops << " FLOPS\n";
-
-        ofs.close();
-      }
-
   };  // class clMatMulEngine
 
   // binaryLoaderInterface abstract class (interface)
@@ -279,29 +290,6 @@ namespace tensorflow {
     protected:
 
     // Concrete methods
-      // Read OpenCL binary file from disk
-      int read_file(unsigned char **output, size_t *size, const char *name)
-      {
-        FILE* fp = fopen(name, "rb");
-        if (!fp) {
-          LOG(ERROR) << "Fail to read cl kernel binary " << std::string( name );
-          return -1;
-        }
-
-        fseek(fp, 0, SEEK_END);
-        *size = ftell(fp);
-        fseek(fp, 0, SEEK_SET);
-
-        *output = (unsigned char *)malloc(*size);
-        if (!*output) {
-          fclose(fp);
-          return -1;
-        }
-        fread(*output, *size, 1, fp);
-        fclose(fp);
-        return 0;
-      }
-
       // Show clKernel object info
       void debugOpenclKernel(cl_kernel cl_kernel, cl_device_id cl_device){
 
@@ -345,36 +333,34 @@ namespace tensorflow {
   class clQualcommFP32Engine : public binaryLoaderInterface, public clMatMulEngine<float>{
     public:
 
-      cl_int clEnd(){
-
-        // Free OpenCL memory objects
-        CL_CHECK( clReleaseMemObject(clBufferA) );
-        clReleaseMemObject(clBufferA_T);
-        CL_CHECK( clReleaseMemObject(clBufferB) );
-        clReleaseMemObject(clBufferB_T);
-        CL_CHECK( clReleaseMemObject(clBufferC) );
-
-        // Free OpenCL kernel
-        CL_CHECK( clReleaseKernel(clGemmKernel) );
-        CL_CHECK( clReleaseKernel(clTransKernel) );
+      // vecWidth selects the float4/float8/float16 kernel variants
+      explicit clQualcommFP32Engine(int vecWidth = 16)
+        : vecShift( vecWidth == 4 ? 2 : ( vecWidth == 8 ? 3 : 4 ) ) {}
 
-        // Free OpenCL program
-        CL_CHECK( clReleaseProgram(clProgram) );
+      cl_int clEnd(){
 
-        // Free OpenCL command queue
-        CL_CHECK( clReleaseCommandQueue(clQueue) );
+        // Return OpenCL memory objects to the buffer pool, buffers wrapping
+        // TF tensor storage are released
+        clBufferPool* pool = runtime->bufferPool();
+        releaseBuffer(pool, clBufferA, wrappedA);
+        pool->put(clBufferA_T);
+        releaseBuffer(pool, clBufferB, wrappedB);
+        pool->put(clBufferB_T);
+        releaseBuffer(pool, clBufferC, wrappedC);
 
-        // Free OpenCL context
-        CL_CHECK( clReleaseContext(clCtx) );
+        // Hand the kernel objects back to the runtime, the program, command
+        // queue and context stay alive for the next call
+        runtime->releaseKernel(clProgram, gemmKernelName, clGemmKernel);
+        runtime->releaseKernel(clProgram, transKernelName, clTransKernel);
 
         // Free OpenCL events
-        clReleaseEvent(transKernelEvent[0]);
-        clReleaseEvent(transKernelEvent[1]);
-        CL_CHECK( clReleaseEvent(gemmKernelEvent) );
-        CL_CHECK( clReleaseEvent(mapBufferEvents[0]) );
-        CL_CHECK( clReleaseEvent(mapBufferEvents[1]) );
-        CL_CHECK( clReleaseEvent(unMapBufferEvents[0]) );
-        CL_CHECK( clReleaseEvent(unMapBufferEvents[1]) );
+        if( transKernelEvent[0] ) clReleaseEvent(transKernelEvent[0]);
+        if( transKernelEvent[1] ) clReleaseEvent(transKernelEvent[1]);
+        if( gemmKernelEvent ) clReleaseEvent(gemmKernelEvent);
+        for( int i = 0 ; i < 2 ; i++ ){
+          if( mapBufferEvents[i] ) clReleaseEvent(mapBufferEvents[i]);
+          if( unMapBufferEvents[i] ) clReleaseEvent(unMapBufferEvents[i]);
+        }
 
         // Return CL_SUCCESS if all resources are released successfully
         return CL_SUCCESS;
@@ -382,15 +368,20 @@ namespace tensorflow {
 
       cl_int memLoad(typename functor::MatMulTypes<float>::out_type out){
 
-        // Use the map function to return clBufferA pointer to the host <= blocking
+        // Use the map function to return clBufferC pointer to the host <= blocking
         clHostPtrC = ( cl_float * ) clEnqueueMapBuffer(clQueue, clBufferC, CL_TRUE,
                           CL_MAP_READ, 0, c_size, 0, NULL, NULL, NULL);
 
-        // Read computed result back to host
-        for( auto idx = 0 ; idx < RowC*ColC ; idx++){
-          out.data()[idx] = clHostPtrC[idx];
+        // Read computed result back to host, nothing to copy if clBufferC wraps
+        // the output tensor and the device mapped it in place
+        if( clHostPtrC != out.data() ){
+          std::memcpy(out.data(), clHostPtrC, RowC * ColC * sizeof(float));
         }
 
+        // Unmap C before the buffer goes back to the pool
+        CL_CHECK( clEnqueueUnmapMemObject( clQueue, clBufferC, (void*) clHostPtrC,
+                    0, NULL, NULL ) );
+
         // Release OpenCL resources
         CL_CHECK( clEnd() );
 
@@ -403,85 +394,102 @@ namespace tensorflow {
         typename functor::MatMulTypes<float>::in_type in1)
       {
 
-        // Use zero copy to avoid additional memeory copy
+        clBufferPool* pool = runtime->bufferPool();
+        cl_uint numMapEvents = 0;
+        cl_uint numUnMapEvents = 0;
+
+        // Use zero copy to avoid additional memeory copy: wrap the TF tensor
+        // storage when the device accepts its alignment, otherwise stage the
+        // data through a mapped CL_MEM_ALLOC_HOST_PTR buffer
         // Matrix A
-        clBufferA = clCreateBuffer(clCtx, CL_MEM_HOST_WRITE_ONLY | CL_MEM_ALLOC_HOST_PTR,
-                      a_size, NULL, NULL);
-        // Use the map function to return clBufferA pointer to the host <= non-blocking
-        clHostPtrA = ( cl_float * ) clEnqueueMapBuffer(clQueue, clBufferA, CL_FALSE,
-                                      CL_MAP_WRITE, 0, a_size, 0, NULL,
-                                      &mapBufferEvents[0], NULL);
+        wrappedA = runtime->isZeroCopyCompatible(in0.data(), a_size);
+        if( wrappedA ){
+          clBufferA = CL_CHECK_ERR( clCreateBuffer(clCtx,
+                        CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR, a_size,
+                        const_cast<float*>(in0.data()), &_err) );
+        }else{
+          clBufferA = pool->get(CL_MEM_HOST_WRITE_ONLY | CL_MEM_ALLOC_HOST_PTR, a_size);
+          // Use the map function to return clBufferA pointer to the host <= non-blocking
+          clHostPtrA = ( cl_float * ) clEnqueueMapBuffer(clQueue, clBufferA, CL_FALSE,
+                                        CL_MAP_WRITE, 0, a_size, 0, NULL,
+                                        &mapBufferEvents[numMapEvents++], NULL);
+        }
         // Matrix B
-        clBufferB = clCreateBuffer(clCtx, CL_MEM_HOST_WRITE_ONLY | CL_MEM_ALLOC_HOST_PTR,
-                          b_size, NULL, NULL);
-        // Use the map function to return clBufferA pointer to the host <= non-blocking
-        clHostPtrB = ( cl_float * ) clEnqueueMapBuffer(clQueue, clBufferB, CL_FALSE,
-                                      CL_MAP_WRITE, 0, b_size, 0, NULL,
-                                      &mapBufferEvents[1], NULL);
+        wrappedB = runtime->isZeroCopyCompatible(in1.data(), b_size);
+        if( wrappedB ){
+          clBufferB = CL_CHECK_ERR( clCreateBuffer(clCtx,
+                        CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR, b_size,
+                        const_cast<float*>(in1.data()), &_err) );
+        }else{
+          clBufferB = pool->get(CL_MEM_HOST_WRITE_ONLY | CL_MEM_ALLOC_HOST_PTR, b_size);
+          // Use the map function to return clBufferB pointer to the host <= non-blocking
+          clHostPtrB = ( cl_float * ) clEnqueueMapBuffer(clQueue, clBufferB, CL_FALSE,
+                                        CL_MAP_WRITE, 0, b_size, 0, NULL,
+                                        &mapBufferEvents[numMapEvents++], NULL);
+        }
 
         // Create GPU buffer for transposed matrices only if needed
         if( a_traspose ){
-          clBufferA_T = clCreateBuffer(clCtx, CL_MEM_HOST_NO_ACCESS, a_size, NULL, NULL);
+          clBufferA_T = pool->get(CL_MEM_HOST_NO_ACCESS, a_size);
         }
         if( !b_traspose ){
-          clBufferB_T = clCreateBuffer(clCtx, CL_MEM_HOST_NO_ACCESS, b_size, NULL, NULL);
+          clBufferB_T = pool->get(CL_MEM_HOST_NO_ACCESS, b_size);
         }
 
-        // Wait for completion
-        CL_CHECK( clWaitForEvents(2, mapBufferEvents) );
-
-        // Host update the buffer using pointer clHostPtrA in host address space
-        for( auto idx = 0 ; idx < RowA*ColA ; idx ++){
-          clHostPtrA[ idx ] = in0.data()[idx];
-        }
-        // Host update the buffer using pointer clHostPtrB in host address space
-        for( auto idx = 0 ; idx < RowB*ColB ; idx ++){
-          clHostPtrB[ idx ] = in1.data()[idx];
+        // Matrix C
+        wrappedC = runtime->isZeroCopyCompatible(hostPtrC, c_size);
+        if( wrappedC ){
+          clBufferC = CL_CHECK_ERR( clCreateBuffer(clCtx,
+                        CL_MEM_WRITE_ONLY | CL_MEM_USE_HOST_PTR, c_size,
+                        hostPtrC, &_err) );
+        }else{
+          clBufferC = pool->get(CL_MEM_HOST_READ_ONLY | CL_MEM_ALLOC_HOST_PTR, c_size);
         }
 
-        // Unmap the object -> Used in the OpenCL kernel
-        CL_CHECK( clEnqueueUnmapMemObject( clQueue, clBufferA, (void*) clHostPtrA,
-                    0, NULL, &unMapBufferEvents[0] ) );
-
-        // Unmap the object -> Used in the OpenCL kernel
-        CL_CHECK( clEnqueueUnmapMemObject( clQueue, clBufferB, (void*) clHostPtrB,
-                    0, NULL, &unMapBufferEvents[1] ) );
+        if( numMapEvents == 0 ){
+          return CL_SUCCESS;
+        }
 
-        // Matrix C
-        clBufferC = clCreateBuffer(clCtx, CL_MEM_HOST_READ_ONLY | CL_MEM_ALLOC_HOST_PTR,
-                      c_size, NULL, NULL);
+        // Wait for completion
+        CL_CHECK( clWaitForEvents(numMapEvents, mapBufferEvents) );
+
+        // Host update the staging buffers with a vectorized copy
+        if( !wrappedA ){
+          std::memcpy(clHostPtrA, in0.data(), RowA * ColA * sizeof(float));
+          // Unmap the object -> Used in the OpenCL kernel
+          CL_CHECK( clEnqueueUnmapMemObject( clQueue, clBufferA, (void*) clHostPtrA,
+                      0, NULL, &unMapBufferEvents[numUnMapEvents++] ) );
+        }
+        if( !wrappedB ){
+          std::memcpy(clHostPtrB, in1.data(), RowB * ColB * sizeof(float));
+          // Unmap the object -> Used in the OpenCL kernel
+          CL_CHECK( clEnqueueUnmapMemObject( clQueue, clBufferB, (void*) clHostPtrB,
+                      0, NULL, &unMapBufferEvents[numUnMapEvents++] ) );
+        }
 
         // Wait for completion
-        CL_CHECK( clWaitForEvents(2, unMapBufferEvents) );
+        CL_CHECK( clWaitForEvents(numUnMapEvents, unMapBufferEvents) );
         return CL_SUCCESS;
       }
 
       cl_int loadFromBinaryCompute()
       {
 
-        unsigned char* clKernelBinaryFile = NULL;
-        size_t clKernelBinSize = 0;
-        // Read compiled OpenCL kernel binary file from disk
-        read_file(&clKernelBinaryFile, &clKernelBinSize, "matmul.bin" );
-
-        // Create an OpenCL program object from binary
-        clProgram = CL_CHECK_ERR( clCreateProgramWithBinary(clCtx, 1, &clDevice,
-                                    &clKernelBinSize,
-                                    (const unsigned char **)&clKernelBinaryFile,
-                                    NULL, &_err) );
+        // Program built once per process from the compiled OpenCL binary
+        clProgram = runtime->program(kClMatMulProgram, "-cl-fast-relaxed-math");
 
-        // OpenCL build program
-        CL_CHECK( clBuildProgram(clProgram, 1, &clDevice, "-cl-fast-relaxed-math" , NULL, NULL) );
+        // Borrow OpenCL GEMM kernel object, MatMul_TN_1D_Fp32_Float{4,8,16}
+        const std::string vecSuffix = "Float" + std::to_string(1 << vecShift);
+        gemmKernelName = "MatMul_TN_1D_Fp32_" + vecSuffix;
+        clGemmKernel = runtime->acquireKernel(clProgram, gemmKernelName);
 
-        // Create OpenCL GEMM kernel object
-        // clGemmKernel = CL_CHECK_ERR( clCreateKernel(clProgram, "MatMul_TN_1D_Fp32_Float4" , &_err) );
-        // clGemmKernel = CL_CHECK_ERR( clCreateKernel(clProgram, "MatMul_TN_1D_Fp32_Float8" , &_err) );
-        clGemmKernel = CL_CHECK_ERR( clCreateKernel(clProgram, "MatMul_TN_1D_Fp32_Float16" , &_err) );
+        // Borrow OpenCL Transpose kernel object, MatTrans_1D_Fp32_Float{4,8,16}
+        transKernelName = "MatTrans_1D_Fp32_" + vecSuffix;
+        clTransKernel = runtime->acquireKernel(clProgram, transKernelName);
 
-        // Create OpenCL Transpose kernel object
-        // clTransKernel = CL_CHECK_ERR( clCreateKernel(clProgram, "MatTrans_1D_Fp32_Float4" , &_err) );
-        // clTransKernel = CL_CHECK_ERR( clCreateKernel(clProgram, "MatTrans_1D_Fp32_Float8" , &_err) );
-        clTransKernel = CL_CHECK_ERR( clCreateKernel(clProgram, "MatTrans_1D_Fp32_Float16" , &_err) );
+        if( clGemmKernel == NULL || clTransKernel == NULL ){
+          return CL_INVALID_PROGRAM;
+        }
 
         cl_ushort gemmKernelIter;
         cl_ushort transKernelIter;
@@ -489,8 +497,8 @@ namespace tensorflow {
         // Handle Matrices Transpose
         if( a_traspose && b_traspose ){ // Transpose A: yes, Transpose B: yes
 
-          transKernelIter = ColA >> 4;
-          gemmKernelIter = RowA >> 4;
+          transKernelIter = ColA >> vecShift;
+          gemmKernelIter = RowA >> vecShift;
 
           // Transpose A
           SET_TRANS_KERNEL_ARG(RowA, ColA, clBufferA, clBufferA_T, transKernelIter );
@@ -499,9 +507,7 @@ namespace tensorflow {
                       &RowA, NULL, 0, NULL, &transKernelEvent[0]) );
 
           SET_GEMM_TN_KERNEL_ARG(ColA, RowA, RowB, clBufferA_T, clBufferB,
-            clBufferC, ColA, float, gemmKernelIter );
-
-          startTimer();
+            clBufferC, RowA, float, gemmKernelIter );
 
           const size_t global = ColA;
           CL_CHECK( clEnqueueNDRangeKernel(clQueue, clGemmKernel, 1, NULL,
@@ -511,8 +517,8 @@ namespace tensorflow {
 
         }else if( a_traspose && !b_traspose ){ // Transpose A: yes, Transpose B: no
 
-          transKernelIter = ColA >> 4;
-          gemmKernelIter = RowA >> 4;
+          transKernelIter = ColA >> vecShift;
+          gemmKernelIter = RowA >> vecShift;
 
           // Transpose A
           SET_TRANS_KERNEL_ARG(RowA, ColA, clBufferA, clBufferA_T, transKernelIter );
@@ -520,7 +526,7 @@ namespace tensorflow {
           CL_CHECK( clEnqueueNDRangeKernel(clQueue, clTransKernel, 1, NULL,
                       &RowA, NULL, 0, NULL, &transKernelEvent[0]) );
 
-          transKernelIter = ColB >> 4;
+          transKernelIter = ColB >> vecShift;
 
           // Transpose B
           SET_TRANS_KERNEL_ARG(RowB, ColB, clBufferB, clBufferB_T, transKernelIter );
@@ -531,8 +537,6 @@ namespace tensorflow {
           SET_GEMM_TN_KERNEL_ARG(ColA, RowA, ColB, clBufferA_T, clBufferB_T,
             clBufferC, RowA, float, gemmKernelIter );
 
-          startTimer();
-
           const size_t global = ColA;
           CL_CHECK( clEnqueueNDRangeKernel(clQueue, clGemmKernel, 1, NULL,
                       &global, NULL, 2, transKernelEvent, &gemmKernelEvent) );
@@ -541,13 +545,11 @@ namespace tensorflow {
 
         }else if( !a_traspose && b_traspose ){ // Transpose A: no, Transpose B: yes
 
-          gemmKernelIter = ColA >> 4;
+          gemmKernelIter = ColA >> vecShift;
 
           SET_GEMM_TN_KERNEL_ARG(RowA, ColA, RowB, clBufferA, clBufferB,
             clBufferC, ColA, float, gemmKernelIter );
 
-          startTimer();
-
           const size_t global = RowA;
           CL_CHECK( clEnqueueNDRangeKernel(clQueue, clGemmKernel, 1, NULL,
                       &global, NULL, 0, NULL, &gemmKernelEvent) );
@@ -556,8 +558,8 @@ namespace tensorflow {
 
         }else if( !a_traspose && !b_traspose ){ // Transpose A: no, Transpose B: no
 
-          transKernelIter = ColB >> 4;
-          gemmKernelIter = ColA >> 4;
+          transKernelIter = ColB >> vecShift;
+          gemmKernelIter = ColA >> vecShift;
 
           // Transpose B
           SET_TRANS_KERNEL_ARG(RowB, ColB, clBufferB, clBufferB_T, transKernelIter );
@@ -568,8 +570,6 @@ namespace tensorflow {
           SET_GEMM_TN_KERNEL_ARG(RowA, ColA, ColB, clBufferA, clBufferB_T,
             clBufferC, ColA, float, gemmKernelIter);
 
-          startTimer();
-
           const size_t global = RowA;
           CL_CHECK( clEnqueueNDRangeKernel(clQueue, clGemmKernel, 1, NULL,
                       &global, NULL, 1, transKernelEvent, &gemmKernelEvent) );
@@ -577,36 +577,54 @@ namespace tensorflow {
           CL_CHECK( clWaitForEvents(1, &gemmKernelEvent) );
         }
 
-        getPerformance();
         return CL_SUCCESS;
       }
 
     protected:
 
+      // Return a buffer to the pool, or release it if it wraps tensor storage
+      static void releaseBuffer(clBufferPool* pool, cl_mem buffer, bool wrapped){
+        if( wrapped ){
+          CL_CHECK( clReleaseMemObject(buffer) );
+        }else{
+          pool->put(buffer);
+        }
+      }
+
+      // log2 of the kernel vector width
+      const int vecShift;
+
       // OpenCL memeory object
       cl_mem clBufferA;
-      cl_mem clBufferA_T;
+      cl_mem clBufferA_T = NULL;
       cl_mem clBufferB;
-      cl_mem clBufferB_T;
+      cl_mem clBufferB_T = NULL;
       cl_mem clBufferC;
 
+      // Whether clBufferA/B/C wrap the TF tensor storage (CL_MEM_USE_HOST_PTR)
+      bool wrappedA = false;
+      bool wrappedB = false;
+      bool wrappedC = false;
+
       // Host memory data
       cl_float * clHostPtrA;
       cl_float * clHostPtrB;
       cl_float * clHostPtrC;
 
       // OpenCL events
-      cl_event gemmKernelEvent;
-      cl_event transKernelEvent[2];
-      cl_event mapBufferEvents[2];
-      cl_event unMapBufferEvents[2];
+      cl_event gemmKernelEvent = NULL;
+      cl_event transKernelEvent[2] = {NULL, NULL};
+      cl_event mapBufferEvents[2] = {NULL, NULL};
+      cl_event unMapBufferEvents[2] = {NULL, NULL};
 
-      // OpenCL program object
-      cl_program clProgram;
+      // OpenCL program object, owned by clMatMulRuntime
+      cl_program clProgram = NULL;
 
-      // OpenCL kernel object
-      cl_kernel clGemmKernel;
-      cl_kernel clTransKernel;
+      // OpenCL kernel object, borrowed from clMatMulRuntime
+      std::string gemmKernelName;
+      std::string transKernelName;
+      cl_kernel clGemmKernel = NULL;
+      cl_kernel clTransKernel = NULL;
 
   };  // class clQualcommFP32Engine
 
@@ -621,9 +639,11 @@ namespace tensorflow {
                                       CL_MAP_READ, 0, c_size, 0, NULL, NULL, NULL);
 
         // Read computed result back to host
-        for( auto idx = 0 ; idx < RowC*ColC ; idx++){
-          out.data()[idx] = clHostPtrC[idx];
-        }
+        std::memcpy(out.data(), clHostPtrC, RowC * ColC * sizeof(float));
+
+        // Unmap C before the buffer goes back to the pool
+        CL_CHECK( clEnqueueUnmapMemObject( clQueue, clBufferC, (void*) clHostPtrC,
+                    0, NULL, NULL ) );
 
         // Release OpenCL resources
         CL_CHECK( clEnd() );
@@ -643,15 +663,14 @@ namespace tensorflow {
 
         // Use zero copy to avoid memeory copy
         // Matrix A
-        clBufferA = clCreateBuffer(clCtx, CL_MEM_HOST_WRITE_ONLY | CL_MEM_ALLOC_HOST_PTR,
-                      a_size, NULL, NULL);
+        clBufferPool* pool = runtime->bufferPool();
+        clBufferA = pool->get(CL_MEM_HOST_WRITE_ONLY | CL_MEM_ALLOC_HOST_PTR, a_size);
         // Use the map function to return clBufferA pointer to the host <= non-blocking
         clHostFp16PtrA = ( cl_half * ) clEnqueueMapBuffer(clQueue, clBufferA, CL_FALSE,
                                         CL_MAP_WRITE, 0, a_size, 0, NULL,
                                         &mapBufferEvents[0], NULL);
         // Matrix B
-        clBufferB = clCreateBuffer(clCtx, CL_MEM_HOST_WRITE_ONLY | CL_MEM_ALLOC_HOST_PTR,
-                      b_size, NULL, NULL);
+        clBufferB = pool->get(CL_MEM_HOST_WRITE_ONLY | CL_MEM_ALLOC_HOST_PTR, b_size);
         // Use the map function to return clBufferA pointer to the host <= non-blocking
         clHostFp16PtrB = ( cl_half * ) clEnqueueMapBuffer(clQueue, clBufferB, CL_FALSE,
                                         CL_MAP_WRITE, 0, b_size, 0, NULL,
@@ -659,23 +678,18 @@ namespace tensorflow {
 
         // Create GPU buffer for transposed matrices only if needed
         if( a_traspose ){
-          clBufferA_T = clCreateBuffer(clCtx, CL_MEM_HOST_NO_ACCESS, a_size, NULL, NULL);
+          clBufferA_T = pool->get(CL_MEM_HOST_NO_ACCESS, a_size);
         }
         if( !b_traspose ){
-          clBufferB_T = clCreateBuffer(clCtx, CL_MEM_HOST_NO_ACCESS, b_size, NULL, NULL);
+          clBufferB_T = pool->get(CL_MEM_HOST_NO_ACCESS, b_size);
         }
 
         // Wait for completion
         CL_CHECK( clWaitForEvents(2, mapBufferEvents) );
 
-        // Host update the buffer using pointer clHostFp16PtrA in host address space
-        for( auto idx = 0 ; idx < RowA*ColA ; idx ++){
-          clHostFp16PtrA[ idx ] = float_to_cl_half( in0.data()[idx] );
-        }
-        // Host update the buffer using pointer clHostFp16PtrB in host address space
-        for( auto idx = 0 ; idx < RowB*ColB ; idx ++){
-          clHostFp16PtrB[ idx ] = float_to_cl_half( in1.data()[idx] );
-        }
+        // Host update the buffers using pointers in host address space
+        float_to_cl_half(in0.data(), clHostFp16PtrA, RowA * ColA);
+        float_to_cl_half(in1.data(), clHostFp16PtrB, RowB * ColB);
 
         // Unmap the object -> Used in the OpenCL kernel
         CL_CHECK( clEnqueueUnmapMemObject( clQueue, clBufferA, (void*) clHostFp16PtrA,
@@ -686,8 +700,7 @@ namespace tensorflow {
                     0, NULL, &unMapBufferEvents[1] ) );
 
         // Matrix C
-        clBufferC = clCreateBuffer(clCtx, CL_MEM_HOST_READ_ONLY | CL_MEM_ALLOC_HOST_PTR,
-                      c_size, NULL, NULL);
+        clBufferC = pool->get(CL_MEM_HOST_READ_ONLY | CL_MEM_ALLOC_HOST_PTR, c_size);
 
         // Wait for completion
         CL_CHECK( clWaitForEvents(2, unMapBufferEvents) );
@@ -697,32 +710,27 @@ namespace tensorflow {
       cl_int loadFromBinaryCompute()
       {
 
-        unsigned char* clKernelBinaryFile = NULL;
-        size_t clKernelBinSize = 0;
-        // Read compiled OpenCL kernel binary file from disk
-        read_file(&clKernelBinaryFile, &clKernelBinSize, "matmul.bin" );
-
-        // Create an OpenCL program object from binary
-        clProgram = CL_CHECK_ERR( clCreateProgramWithBinary(clCtx, 1, &clDevice,
-                                    &clKernelBinSize,
-                                    (const unsigned char **)&clKernelBinaryFile,
-                                    NULL, &_err) );
-
-        // OpenCL build program
-        CL_CHECK( clBuildProgram(clProgram, 1, &clDevice, NULL , NULL, NULL) );
+        // Program built once per process from the compiled OpenCL binary
+        clProgram = runtime->program(kClMatMulProgram, NULL);
 
         cl_ushort gemmKernelIter;
         cl_ushort transKernelIter;
 
-        // Create OpenCL GEMM kernel object
-        // clGemmKernel = CL_CHECK_ERR( clCreateKernel(clProgram, "MatMul_TN_1D_Fp16_Half4" , &_err) );
-        // clGemmKernel = CL_CHECK_ERR( clCreateKernel(clProgram, "MatMul_TN_1D_Fp16_Half8" , &_err) );
-        clGemmKernel = CL_CHECK_ERR( clCreateKernel(clProgram, "MatMul_TN_1D_Fp16_Half16" , &_err) );
+        // Borrow OpenCL GEMM kernel object
+        // gemmKernelName = "MatMul_TN_1D_Fp16_Half4";
+        // gemmKernelName = "MatMul_TN_1D_Fp16_Half8";
+        gemmKernelName = "MatMul_TN_1D_Fp16_Half16";
+        clGemmKernel = runtime->acquireKernel(clProgram, gemmKernelName);
 
-        // Create OpenCL Transpose kernel object
-        // clTransKernel = CL_CHECK_ERR( clCreateKernel(clProgram, "MatTrans_1D_Fp16_Half4" , &_err) );
-        // clTransKernel = CL_CHECK_ERR( clCreateKernel(clProgram, "MatTrans_1D_Fp16_Half8" , &_err) );
-        clTransKernel = CL_CHECK_ERR( clCreateKernel(clProgram, "MatTrans_1D_Fp16_Half16" , &_err) );
+        // Borrow OpenCL Transpose kernel object
+        // transKernelName = "MatTrans_1D_Fp16_Half4";
+        // transKernelName = "MatTrans_1D_Fp16_Half8";
+        transKernelName = "MatTrans_1D_Fp16_Half16";
+        clTransKernel = runtime->acquireKernel(clProgram, transKernelName);
+
+        if( clGemmKernel == NULL || clTransKernel == NULL ){
+          return CL_INVALID_PROGRAM;
+        }
 
         // Handle Matrices Transpose
         if( a_traspose && b_traspose ){ // Transpose A: yes, Transpose B: yes
@@ -737,7 +745,7 @@ namespace tensorflow {
                       &RowA, NULL, 0, NULL, &transKernelEvent[0]) );
 
           SET_GEMM_TN_KERNEL_ARG(ColA, RowA, RowB, clBufferA_T, clBufferB,
-            clBufferC, ColA, cl_half, gemmKernelIter);
+            clBufferC, RowA, cl_half, gemmKernelIter);
 
           const size_t global = ColA;
           CL_CHECK( clEnqueueNDRangeKernel(clQueue, clGemmKernel, 1, NULL,
@@ -817,27 +825,571 @@ namespace tensorflow {
 
   };  // class clQualcommFP16Engine
 
+  // clLocalMem2DEngine concrete class using the 2D local memory GEMM kernel.
+  // Only handles non-transposed inputs whose dimensions are multiples of the
+  // 16x16 tile, see supports().
+  class clLocalMem2DEngine : public clQualcommFP32Engine{
+    public:
+
+      static constexpr size_t kTileSize = 16;
+
+      static bool supports(size_t m, size_t k, size_t n, bool transpose_a,
+                           bool transpose_b){
+        return !transpose_a && !transpose_b &&
+               m % kTileSize == 0 && k % kTileSize == 0 && n % kTileSize == 0;
+      }
+
+      cl_int loadFromBinaryCompute()
+      {
+        // Program built once per process from the compiled OpenCL binary
+        clProgram = runtime->program(kClMatMulProgram, "-cl-fast-relaxed-math");
+
+        // Borrow OpenCL GEMM kernel object, no transpose kernel is needed
+        gemmKernelName = "MatMul_NN_2D_LocalMem_Fp32";
+        clGemmKernel = runtime->acquireKernel(clProgram, gemmKernelName);
+        if( clGemmKernel == NULL ){
+          return CL_INVALID_PROGRAM;
+        }
+
+        cl_ushort M = RowA;
+        cl_ushort K = ColA;
+        cl_ushort N = ColB;
+        CL_CHECK( clSetKernelArg(clGemmKernel, 0, sizeof(cl_ushort), &M) );
+        CL_CHECK( clSetKernelArg(clGemmKernel, 1, sizeof(cl_ushort), &K) );
+        CL_CHECK( clSetKernelArg(clGemmKernel, 2, sizeof(cl_ushort), &N) );
+        CL_CHECK( clSetKernelArg(clGemmKernel, 3, sizeof(cl_mem), &clBufferA) );
+        CL_CHECK( clSetKernelArg(clGemmKernel, 4, sizeof(cl_mem), &clBufferB) );
+        CL_CHECK( clSetKernelArg(clGemmKernel, 5, sizeof(cl_mem), &clBufferC) );
+
+        const size_t global[2] = { RowA, ColB };
+        const size_t local[2] = { kTileSize, kTileSize };
+        cl_int err = clEnqueueNDRangeKernel(clQueue, clGemmKernel, 2, NULL,
+                       global, local, 0, NULL, &gemmKernelEvent);
+        if( err != CL_SUCCESS ){
+          return err;
+        }
+
+        CL_CHECK( clWaitForEvents(1, &gemmKernelEvent) );
+
+        return CL_SUCCESS;
+      }
+
+  };  // class clLocalMem2DEngine
+
+  // clTiledEngine concrete class using the 32-bit indexed tiled kernels, for
+  // matrices of any size. Products whose operands don't fit in a single cl_mem
+  // are computed block by block: C is split into blocks of at most blockRows x
+  // blockCols, and for each block the matching rows of op(A) and columns of
+  // op(B) are uploaded with rectangular copies. Transposed operands are turned
+  // around on the device with MatTrans_2D_Tiled_Fp32.
+  //
+  // The uploads, transposes, GEMMs and read backs are enqueued without
+  // blocking, as a graph of events: uploads wait for the previous GEMM reading
+  // the same buffer, each GEMM waits for its operands and for the previous
+  // read back of clBufferC, and each read back waits for its GEMM.
+  // enqueueCompute() returns the event of the last read back, which
+  // loadFromBinaryCompute() waits on and MatMulCLAsyncOp attaches a callback to.
+  class clTiledEngine : public binaryLoaderInterface, public clMatMulEngine<float>{
+    public:
+
+      static constexpr size_t kTileSize = 16;
+
+      // maxBlockDim caps the rows & columns of a block of C, 0 only splits
+      // the product as far as the device allocation limit requires
+      explicit clTiledEngine(size_t maxBlockDim = 0) : maxBlockDim(maxBlockDim) {}
+
+      cl_int clEnd(){
+
+        // Return OpenCL memory objects to the buffer pool
+        clBufferPool* pool = runtime->bufferPool();
+        pool->put(clBufferA);
+        pool->put(clBufferB);
+        pool->put(clBufferC);
+        pool->put(clBufferTA);
+        pool->put(clBufferTB);
+        clBufferA = clBufferB = clBufferC = clBufferTA = clBufferTB = NULL;
+
+        // Hand the kernel objects back to the runtime
+        runtime->releaseKernel(clProgram, kGemmKernelName, clGemmKernel);
+        runtime->releaseKernel(clProgram, kTransKernelName, clTransKernel);
+        clGemmKernel = clTransKernel = NULL;
+
+        // Free OpenCL events
+        for( cl_event e : events ){
+          clReleaseEvent(e);
+        }
+        events.clear();
+
+        return CL_SUCCESS;
+      }
+
+      cl_int memLoad(typename functor::MatMulTypes<float>::out_type out){
+
+        // Blocks of C were read into out by loadFromBinaryCompute()
+        CL_CHECK( clEnd() );
+        return CL_SUCCESS;
+      }
+
+      cl_int memInit(
+        typename functor::MatMulTypes<float>::in_type in0,
+        typename functor::MatMulTypes<float>::in_type in1)
+      {
+        hostPtrA = in0.data();
+        hostPtrB = in1.data();
+        K = a_traspose ? RowA : ColA;
+
+        // Block sizes, every buffer must fit the device allocation limit once
+        // rounded up to a buffer pool bucket, and be addressable with 32-bit
+        // indices
+        const size_t maxAllocBytes = runtime->maxMemAllocSize();
+        if( maxAllocBytes < sizeof(float) ){
+          return CL_INVALID_BUFFER_SIZE;
+        }
+        const size_t maxElems = std::min<size_t>(
+            ( size_t(1) << Log2Floor64(maxAllocBytes) ) / sizeof(float),
+            0xffffffffu);
+        if( K == 0 || K > maxElems ){
+          LOG(ERROR) << "Inner dimension " << K << " exceeds the OpenCL "
+                     << "allocation limit of " << maxElems << " floats";
+          return CL_INVALID_BUFFER_SIZE;
+        }
+        blockRows = std::min(RowC, maxElems / K);
+        blockCols = std::min(ColC, maxElems / K);
+        if( maxBlockDim > 0 ){
+          blockRows = std::min(blockRows, maxBlockDim);
+          blockCols = std::min(blockCols, maxBlockDim);
+        }
+        while( blockRows * blockCols > maxElems ){
+          if( blockRows > blockCols ){
+            blockRows = ( blockRows + 1 ) / 2;
+          }else{
+            blockCols = ( blockCols + 1 ) / 2;
+          }
+        }
+        blockRows = std::max<size_t>(blockRows, 1);
+        blockCols = std::max<size_t>(blockCols, 1);
+
+        // Transpose scratch buffers are separate for A and B so both
+        // operands can be prepared concurrently
+        clBufferPool* pool = runtime->bufferPool();
+        clBufferA = pool->get(CL_MEM_READ_WRITE, sizeof(float) * blockRows * K);
+        clBufferB = pool->get(CL_MEM_READ_WRITE, sizeof(float) * K * blockCols);
+        clBufferC = pool->get(CL_MEM_WRITE_ONLY, sizeof(float) * blockRows * blockCols);
+        if( clBufferA == NULL || clBufferB == NULL || clBufferC == NULL ){
+          return CL_MEM_OBJECT_ALLOCATION_FAILURE;
+        }
+        if( a_traspose ){
+          clBufferTA = pool->get(CL_MEM_READ_WRITE, sizeof(float) * K * blockRows);
+          if( clBufferTA == NULL ){
+            return CL_MEM_OBJECT_ALLOCATION_FAILURE;
+          }
+        }
+        if( b_traspose ){
+          clBufferTB = pool->get(CL_MEM_READ_WRITE, sizeof(float) * blockCols * K);
+          if( clBufferTB == NULL ){
+            return CL_MEM_OBJECT_ALLOCATION_FAILURE;
+          }
+        }
+
+        return CL_SUCCESS;
+      }
+
+      cl_int loadFromBinaryCompute()
+      {
+        cl_event done = NULL;
+        cl_int err = enqueueCompute(&done);
+        if( err != CL_SUCCESS ) return err;
+
+        err = clWaitForEvents(1, &done);
+        if( err != CL_SUCCESS ) return err;
+
+        return CL_SUCCESS;
+      }
+
+      // Enqueues the whole product without blocking and sets *done to the
+      // event of the last read back into the output tensor. The event is
+      // owned by the engine and released by clEnd().
+      cl_int enqueueCompute(cl_event* done)
+      {
+        // Program built once per process from the compiled OpenCL binary
+        clProgram = runtime->program(kClMatMulProgram, "-cl-fast-relaxed-math");
+
+        // Borrow OpenCL kernel objects
+        clGemmKernel = runtime->acquireKernel(clProgram, kGemmKernelName);
+        clTransKernel = runtime->acquireKernel(clProgram, kTransKernelName);
+        if( clGemmKernel == NULL || clTransKernel == NULL ){
+          return CL_INVALID_PROGRAM;
+        }
+
+        cl_int err = CL_SUCCESS;
+        cl_event readyA = NULL;   // clBufferA holds the current rows of op(A)
+        cl_event readyB = NULL;   // clBufferB holds the current cols of op(B)
+        cl_event lastGemm = NULL; // Last GEMM reading clBufferA & clBufferB
+        cl_event lastRead = NULL; // Last read back of clBufferC
+        for( size_t i0 = 0 ; i0 < RowC ; i0 += blockRows ){
+          const size_t rows = std::min(blockRows, RowC - i0);
+          err = loadBlockA(i0, rows, lastGemm, &readyA);
+          if( err != CL_SUCCESS ) return err;
+
+          for( size_t j0 = 0 ; j0 < ColC ; j0 += blockCols ){
+            const size_t cols = std::min(blockCols, ColC - j0);
+
+            // A single column block of B is uploaded once
+            if( i0 == 0 || blockCols < ColC ){
+              err = loadBlockB(j0, cols, lastGemm, &readyB);
+              if( err != CL_SUCCESS ) return err;
+            }
+
+            cl_event gemmWait[3] = { readyA, readyB, lastRead };
+            err = gemmBlock(rows, cols, lastRead ? 3 : 2, gemmWait, &lastGemm);
+            if( err != CL_SUCCESS ) return err;
+
+            // Read the block of C back into the output tensor
+            const size_t bufferOrigin[3] = { 0, 0, 0 };
+            const size_t hostOrigin[3] = { j0 * sizeof(float), i0, 0 };
+            const size_t region[3] = { cols * sizeof(float), rows, 1 };
+            err = track(clEnqueueReadBufferRect(clQueue, clBufferC, CL_FALSE,
+                    bufferOrigin, hostOrigin, region,
+                    cols * sizeof(float), 0, ColC * sizeof(float), 0,
+                    hostPtrC, 1, &lastGemm, &lastRead), &lastRead);
+            if( err != CL_SUCCESS ) return err;
+          }
+        }
+
+        // Make sure the commands are submitted to the device
+        err = clFlush(clQueue);
+        if( err != CL_SUCCESS ) return err;
+
+        *done = lastRead;
+        return CL_SUCCESS;
+      }
+
+    private:
+
+      static constexpr const char* kGemmKernelName = "MatMul_NN_2D_Tiled_Fp32";
+      static constexpr const char* kTransKernelName = "MatTrans_2D_Tiled_Fp32";
+
+      static size_t roundUpToTile(size_t n){
+        return ( n + kTileSize - 1 ) / kTileSize * kTileSize;
+      }
+
+      // Keeps *event for release by clEnd() if the command was enqueued
+      cl_int track(cl_int err, cl_event* event)
+      {
+        if( err == CL_SUCCESS ){
+          events.push_back(*event);
+        }
+        return err;
+      }
+
+      // Uploads rows [i0, i0 + rows) of op(A) to clBufferA, row pitch K,
+      // once prevGemm is done reading it
+      cl_int loadBlockA(size_t i0, size_t rows, cl_event prevGemm,
+                        cl_event* ready)
+      {
+        const cl_uint numWait = prevGemm ? 1 : 0;
+        if( !a_traspose ){
+          // Rows of A are contiguous
+          return track(clEnqueueWriteBuffer(clQueue, clBufferA, CL_FALSE, 0,
+                   sizeof(float) * rows * K, hostPtrA + i0 * K,
+                   numWait, &prevGemm, ready), ready);
+        }
+
+        // Columns [i0, i0 + rows) of the K x RowC matrix A, then transpose.
+        // The previous transpose has completed before prevGemm could start.
+        const size_t bufferOrigin[3] = { 0, 0, 0 };
+        const size_t hostOrigin[3] = { i0 * sizeof(float), 0, 0 };
+        const size_t region[3] = { rows * sizeof(float), K, 1 };
+        cl_event uploaded = NULL;
+        cl_int err = track(clEnqueueWriteBufferRect(clQueue, clBufferTA,
+                       CL_FALSE, bufferOrigin, hostOrigin, region,
+                       rows * sizeof(float), 0, ColA * sizeof(float), 0,
+                       hostPtrA, numWait, &prevGemm, &uploaded), &uploaded);
+        if( err != CL_SUCCESS ) return err;
+        return transpose(K, rows, clBufferTA, clBufferA, uploaded, prevGemm,
+                         ready);
+      }
+
+      // Uploads columns [j0, j0 + cols) of op(B) to clBufferB, row pitch
+      // cols, once prevGemm is done reading it
+      cl_int loadBlockB(size_t j0, size_t cols, cl_event prevGemm,
+                        cl_event* ready)
+      {
+        const cl_uint numWait = prevGemm ? 1 : 0;
+        if( b_traspose ){
+          // Rows of the ColC x K matrix B are contiguous, then transpose
+          cl_event uploaded = NULL;
+          cl_int err = track(clEnqueueWriteBuffer(clQueue, clBufferTB,
+                         CL_FALSE, 0, sizeof(float) * cols * K,
+                         hostPtrB + j0 * K, numWait, &prevGemm, &uploaded),
+                         &uploaded);
+          if( err != CL_SUCCESS ) return err;
+          return transpose(cols, K, clBufferTB, clBufferB, uploaded, prevGemm,
+                           ready);
+        }
+
+        const size_t bufferOrigin[3] = { 0, 0, 0 };
+        const size_t hostOrigin[3] = { j0 * sizeof(float), 0, 0 };
+        const size_t region[3] = { cols * sizeof(float), K, 1 };
+        return track(clEnqueueWriteBufferRect(clQueue, clBufferB, CL_FALSE,
+                 bufferOrigin, hostOrigin, region,
+                 cols * sizeof(float), 0, ColB * sizeof(float), 0,
+                 hostPtrB, numWait, &prevGemm, ready), ready);
+      }
+
+      // dst (cols x rows) = transpose of src (rows x cols), once src is
+      // uploaded and prevGemm is done reading dst
+      cl_int transpose(size_t rows, size_t cols, cl_mem src, cl_mem dst,
+                       cl_event uploaded, cl_event prevGemm, cl_event* ready)
+      {
+        cl_uint clRows = rows;
+        cl_uint clCols = cols;
+        CL_CHECK( clSetKernelArg(clTransKernel, 0, sizeof(cl_uint), &clRows) );
+        CL_CHECK( clSetKernelArg(clTransKernel, 1, sizeof(cl_uint), &clCols) );
+        CL_CHECK( clSetKernelArg(clTransKernel, 2, sizeof(cl_mem), &src) );
+        CL_CHECK( clSetKernelArg(clTransKernel, 3, sizeof(cl_mem), &dst) );
+
+        const cl_event wait[2] = { uploaded, prevGemm };
+        const size_t global[2] = { roundUpToTile(cols), roundUpToTile(rows) };
+        const size_t local[2] = { kTileSize, kTileSize };
+        return track(clEnqueueNDRangeKernel(clQueue, clTransKernel, 2, NULL,
+                 global, local, prevGemm ? 2 : 1, wait, ready), ready);
+      }
+
+      // clBufferC (rows x cols) = clBufferA (rows x K) * clBufferB (K x cols)
+      cl_int gemmBlock(size_t rows, size_t cols, cl_uint numWait,
+                       const cl_event* wait, cl_event* gemmDone)
+      {
+        cl_uint M = rows;
+        cl_uint clK = K;
+        cl_uint N = cols;
+        CL_CHECK( clSetKernelArg(clGemmKernel, 0, sizeof(cl_uint), &M) );
+        CL_CHECK( clSetKernelArg(clGemmKernel, 1, sizeof(cl_uint), &clK) );
+        CL_CHECK( clSetKernelArg(clGemmKernel, 2, sizeof(cl_uint), &N) );
+        CL_CHECK( clSetKernelArg(clGemmKernel, 3, sizeof(cl_mem), &clBufferA) );
+        CL_CHECK( clSetKernelArg(clGemmKernel, 4, sizeof(cl_uint), &clK) );
+        CL_CHECK( clSetKernelArg(clGemmKernel, 5, sizeof(cl_mem), &clBufferB) );
+        CL_CHECK( clSetKernelArg(clGemmKernel, 6, sizeof(cl_uint), &N) );
+        CL_CHECK( clSetKernelArg(clGemmKernel, 7, sizeof(cl_mem), &clBufferC) );
+        CL_CHECK( clSetKernelArg(clGemmKernel, 8, sizeof(cl_uint), &N) );
+
+        const size_t global[2] = { roundUpToTile(rows), roundUpToTile(cols) };
+        const size_t local[2] = { kTileSize, kTileSize };
+        return track(clEnqueueNDRangeKernel(clQueue, clGemmKernel, 2, NULL,
+                 global, local, numWait, wait, gemmDone), gemmDone);
+      }
+
+      const size_t maxBlockDim;
+
+      // Inner dimension of op(A) * op(B) & block shape of C
+      size_t K = 0;
+      size_t blockRows = 0;
+      size_t blockCols = 0;
+
+      // Input tensor storage
+      const float* hostPtrA = nullptr;
+      const float* hostPtrB = nullptr;
+
+      // OpenCL memeory object, clBufferTA/TB are transpose scratch buffers
+      cl_mem clBufferA = NULL;
+      cl_mem clBufferB = NULL;
+      cl_mem clBufferC = NULL;
+      cl_mem clBufferTA = NULL;
+      cl_mem clBufferTB = NULL;
+
+      // Every event created by enqueueCompute(), released by clEnd()
+      std::vector<cl_event> events;
+
+      // OpenCL program object, owned by clMatMulRuntime
+      cl_program clProgram = NULL;
+
+      // OpenCL kernel object, borrowed from clMatMulRuntime
+      cl_kernel clGemmKernel = NULL;
+      cl_kernel clTransKernel = NULL;
+
+  };  // class clTiledEngine
+
+  // clTiledFP16Engine concrete class using the FP16 storage tiled kernels.
+  // Operands are uploaded as half, Eigen::half tensors as is and float tensors
+  // converted on the host, and the product is accumulated in float. T selects
+  // the output: Eigen::half for DT_HALF MatMuls, float for float32 MatMuls run
+  // with half precision operands (TF_MATMUL_OPENCL_FP16_COMPUTE). Transposed
+  // operands are read with swapped strides, so there is no transpose pass.
+  // Products whose operands don't fit a single cl_mem are not split, the
+  // caller falls back to another path.
+  template<class T>
+  class clTiledFP16Engine : public binaryLoaderInterface, public clMatMulEngine<T>{
+    public:
+
+      static constexpr size_t kTileSize = 16;
+
+      cl_int clEnd(){
+
+        // Return OpenCL memory objects to the buffer pool
+        clBufferPool* pool = this->runtime->bufferPool();
+        pool->put(clBufferA);
+        pool->put(clBufferB);
+        pool->put(clBufferC);
+        clBufferA = clBufferB = clBufferC = NULL;
+
+        // Hand the kernel object back to the runtime
+        this->runtime->releaseKernel(clProgram, gemmKernelName(), clGemmKernel);
+        clGemmKernel = NULL;
+
+        if( gemmKernelEvent != NULL ){
+          clReleaseEvent(gemmKernelEvent);
+          gemmKernelEvent = NULL;
+        }
+        return CL_SUCCESS;
+      }
+
+      cl_int memLoad(typename functor::MatMulTypes<T>::out_type out){
+
+        // C was read into out by loadFromBinaryCompute()
+        CL_CHECK( clEnd() );
+        return CL_SUCCESS;
+      }
+
+      cl_int memInit(
+        typename functor::MatMulTypes<T>::in_type in0,
+        typename functor::MatMulTypes<T>::in_type in1)
+      {
+        const size_t elemsA = this->RowA * this->ColA;
+        const size_t elemsB = this->RowB * this->ColB;
+        const size_t elemsC = this->RowC * this->ColC;
+
+        // Whole operands live in one buffer each, indexed with 32-bit uints
+        const size_t maxAllocBytes = this->runtime->maxMemAllocSize();
+        const size_t maxElems = std::max(std::max(elemsA, elemsB), elemsC);
+        if( maxElems > 0xffffffffu ||
+            elemsA * sizeof(cl_half) > maxAllocBytes ||
+            elemsB * sizeof(cl_half) > maxAllocBytes ||
+            elemsC * sizeof(T) > maxAllocBytes ){
+          return CL_INVALID_BUFFER_SIZE;
+        }
+
+        // Zero copy operands, converted to half straight into the mapping
+        clBufferPool* pool = this->runtime->bufferPool();
+        clBufferA = pool->get(CL_MEM_READ_ONLY | CL_MEM_ALLOC_HOST_PTR,
+                              elemsA * sizeof(cl_half));
+        clBufferB = pool->get(CL_MEM_READ_ONLY | CL_MEM_ALLOC_HOST_PTR,
+                              elemsB * sizeof(cl_half));
+        clBufferC = pool->get(CL_MEM_WRITE_ONLY, elemsC * sizeof(T));
+        if( clBufferA == NULL || clBufferB == NULL || clBufferC == NULL ){
+          return CL_MEM_OBJECT_ALLOCATION_FAILURE;
+        }
+
+        cl_int err = upload(clBufferA, in0.data(), elemsA);
+        if( err != CL_SUCCESS ) return err;
+        return upload(clBufferB, in1.data(), elemsB);
+      }
+
+      cl_int loadFromBinaryCompute()
+      {
+        // Program built once per process from the compiled OpenCL binary
+        clProgram = this->runtime->program(kClMatMulProgram,
+                                           "-cl-fast-relaxed-math");
+
+        // Borrow OpenCL GEMM kernel object
+        clGemmKernel = this->runtime->acquireKernel(clProgram, gemmKernelName());
+        if( clGemmKernel == NULL ){
+          return CL_INVALID_PROGRAM;
+        }
+
+        // Element (i, k) of op(A) is A[i * rowStrideA + k * colStrideA]
+        cl_uint M = this->RowC;
+        cl_uint K = this->a_traspose ? this->RowA : this->ColA;
+        cl_uint N = this->ColC;
+        cl_uint rowStrideA = this->a_traspose ? 1 : this->ColA;
+        cl_uint colStrideA = this->a_traspose ? this->ColA : 1;
+        cl_uint rowStrideB = this->b_traspose ? 1 : this->ColB;
+        cl_uint colStrideB = this->b_traspose ? this->ColB : 1;
+        CL_CHECK( clSetKernelArg(clGemmKernel, 0, sizeof(cl_uint), &M) );
+        CL_CHECK( clSetKernelArg(clGemmKernel, 1, sizeof(cl_uint), &K) );
+        CL_CHECK( clSetKernelArg(clGemmKernel, 2, sizeof(cl_uint), &N) );
+        CL_CHECK( clSetKernelArg(clGemmKernel, 3, sizeof(cl_mem), &clBufferA) );
+        CL_CHECK( clSetKernelArg(clGemmKernel, 4, sizeof(cl_uint), &rowStrideA) );
+        CL_CHECK( clSetKernelArg(clGemmKernel, 5, sizeof(cl_uint), &colStrideA) );
+        CL_CHECK( clSetKernelArg(clGemmKernel, 6, sizeof(cl_mem), &clBufferB) );
+        CL_CHECK( clSetKernelArg(clGemmKernel, 7, sizeof(cl_uint), &rowStrideB) );
+        CL_CHECK( clSetKernelArg(clGemmKernel, 8, sizeof(cl_uint), &colStrideB) );
+        CL_CHECK( clSetKernelArg(clGemmKernel, 9, sizeof(cl_mem), &clBufferC) );
+
+        const size_t global[2] = { roundUpToTile(M), roundUpToTile(N) };
+        const size_t local[2] = { kTileSize, kTileSize };
+        cl_int err = clEnqueueNDRangeKernel(this->clQueue, clGemmKernel, 2,
+                       NULL, global, local, 0, NULL, &gemmKernelEvent);
+        if( err != CL_SUCCESS ){
+          gemmKernelEvent = NULL;
+          return err;
+        }
+
+        // Read C back into the output tensor <= blocking
+        err = clEnqueueReadBuffer(this->clQueue, clBufferC, CL_TRUE, 0,
+                sizeof(T) * M * N, this->hostPtrC, 1, &gemmKernelEvent, NULL);
+        if( err != CL_SUCCESS ) return err;
+
+        return CL_SUCCESS;
+      }
+
+    private:
+
+      // MatMul_NN_2D_Tiled_Fp16 stores half, the Fp32Out variant float
+      static const char* gemmKernelName(){
+        return sizeof(T) == sizeof(cl_half) ? "MatMul_NN_2D_Tiled_Fp16"
+                                            : "MatMul_NN_2D_Tiled_Fp16_Fp32Out";
+      }
+
+      static size_t roundUpToTile(size_t n){
+        return ( n + kTileSize - 1 ) / kTileSize * kTileSize;
+      }
+
+      // Writes n elements of src to clMem as half <= blocking
+      cl_int upload(cl_mem clMem, const T* src, size_t n)
+      {
+        cl_int err = CL_SUCCESS;
+        cl_half* clHostFp16Ptr = ( cl_half * ) clEnqueueMapBuffer(this->clQueue,
+                                   clMem, CL_TRUE, CL_MAP_WRITE_INVALIDATE_REGION,
+                                   0, n * sizeof(cl_half), 0, NULL, NULL, &err);
+        if( err != CL_SUCCESS ) return err;
+        float_to_cl_half(src, clHostFp16Ptr, n);
+        return clEnqueueUnmapMemObject(this->clQueue, clMem,
+                 (void*) clHostFp16Ptr, 0, NULL, NULL);
+      }
+
+      // OpenCL memeory object
+      cl_mem clBufferA = NULL;
+      cl_mem clBufferB = NULL;
+      cl_mem clBufferC = NULL;
+
+      // OpenCL program object, owned by clMatMulRuntime
+      cl_program clProgram = NULL;
+
+      // OpenCL kernel object, borrowed from clMatMulRuntime
+      cl_kernel clGemmKernel = NULL;
+      cl_event gemmKernelEvent = NULL;
+
+  };  // class clTiledFP16Engine
+
   // clBLASTEngine concrete class using CLBLAST API
   class clBLASTEngine : public clMatMulEngine<float>{
     public:
 
       cl_int clEnd(){
 
-        // Free OpenCL memory objects
-        CL_CHECK( clReleaseMemObject(clBufferA) );
-        CL_CHECK( clReleaseMemObject(clBufferB) );
-        CL_CHECK( clReleaseMemObject(clBufferC) );
-
-        // Free OpenCL command queue
-        CL_CHECK( clReleaseCommandQueue(clQueue) );
+        // Return OpenCL memory objects to the buffer pool
+        clBufferPool* pool = runtime->bufferPool();
+        pool->put(clBufferA);
+        pool->put(clBufferB);
+        pool->put(clBufferC);
 
-        // Free OpenCL context
-        CL_CHECK( clReleaseContext(clCtx) );
+        // Command queue & context are owned by clMatMulRuntime
 
         // Free OpenCL events
-        CL_CHECK( clReleaseEvent(gemmKernelEvent) );
-        CL_CHECK( clReleaseEvent(writeBufferEvents[0]) );
-        CL_CHECK( clReleaseEvent(writeBufferEvents[1]) );
+        if( gemmKernelEvent ) clReleaseEvent(gemmKernelEvent);
+        for( int i = 0 ; i < 2 ; i++ ){
+          if( writeBufferEvents[i] ) clReleaseEvent(writeBufferEvents[i]);
+        }
 
         // Return CL_SUCCESS if all resources are released successfully
         return CL_SUCCESS;
@@ -861,13 +1413,11 @@ namespace tensorflow {
         typename functor::MatMulTypes<float>::in_type in1)
       {
 
-        // Allocate memory buffers
-        clBufferA = CL_CHECK_ERR( clCreateBuffer(clCtx, CL_MEM_READ_ONLY, a_size,
-                                    NULL, &_err) );
-        clBufferB = CL_CHECK_ERR( clCreateBuffer(clCtx, CL_MEM_READ_ONLY, b_size,
-                                    NULL, &_err) );
-        clBufferC = CL_CHECK_ERR( clCreateBuffer(clCtx, CL_MEM_READ_WRITE, c_size,
-                                    NULL, &_err) );
+        // Allocate memory buffers from the pool
+        clBufferPool* pool = runtime->bufferPool();
+        clBufferA = pool->get(CL_MEM_READ_ONLY, a_size);
+        clBufferB = pool->get(CL_MEM_READ_ONLY, b_size);
+        clBufferC = pool->get(CL_MEM_READ_WRITE, c_size);
 
         // Enqueue write buffer commands (acynchronous write)
         CL_CHECK( clEnqueueWriteBuffer(clQueue, clBufferA, CL_FALSE, 0, a_size,
@@ -895,24 +1445,16 @@ namespace tensorflow {
         // Leading dimension of the input B matrix. This value must be greater than 0.
         size_t b_ld;
 
-        // When transpose_a == Transpose::kNo, then a_ld must be at least m,
-        // otherwise a_ld must be at least k.
-        if( MatATranspose == CLBlastTransposeYes ){
-          a_ld = RowA;
-        }else{
-          a_ld = ColA;
-        }
+        // In row-major layout the leading dimension is the number of columns
+        // of the matrix as stored, whether or not it is transposed.
+        a_ld = ColA;
+        b_ld = ColB;
 
-        // When transpose_b == Transpose::kNo, then b_ld must be at least k,
-        // otherwise b_ld must be at least n.
-        if( MatBTranspose == CLBlastTransposeYes ){
-          b_ld = ColA;
-        }else{
-          b_ld = ColB;
-        }
+        // The value of c_ld must be at least n.
+        const size_t c_ld = ColC;
 
-        // The value of c_ld must be at least m.
-        const size_t c_ld = ColB;
+        // Inner dimension of op(A) * op(B)
+        const size_t K = a_traspose ? RowA : ColA;
 
         // Performs the matrix product C = alpha * A * B + beta * C
         const float alpha = 1.0f;
@@ -921,7 +1463,7 @@ namespace tensorflow {
         // Call the SGEMM routine.
         CLBlastStatusCode status = CLBlastSgemm(CLBlastLayoutRowMajor,
                                                 MatATranspose, MatBTranspose,
-                                                RowA, ColB, ColA,
+                                                RowC, ColC, K,
                                                 alpha,
                                                 clBufferA, 0, a_ld,
                                                 clBufferB, 0, b_ld,
@@ -942,18 +1484,230 @@ namespace tensorflow {
     protected:
 
       // OpenCL memeory object
-      cl_mem clBufferA;
-      cl_mem clBufferB;
-      cl_mem clBufferC;
+      cl_mem clBufferA = NULL;
+      cl_mem clBufferB = NULL;
+      cl_mem clBufferC = NULL;
 
-      // OpenCL events
-      cl_event gemmKernelEvent;
-      cl_event writeBufferEvents[2];
+      // OpenCL events, NULL until enqueued so that clEnd can run after a
+      // failed memInit
+      cl_event gemmKernelEvent = NULL;
+      cl_event writeBufferEvents[2] = {NULL, NULL};
 
   };  // class clBLASTEngine
 
 namespace functor {
 
+  // Runs the OpenCL stages of engine c, returns the first failing status
+  template <class Engine, class ComputeFn>
+  cl_int clRunEngine(Engine& c, ComputeFn compute,
+      typename MatMulTypes<typename Engine::Scalar>::out_type out,
+      typename MatMulTypes<typename Engine::Scalar>::in_type in0,
+      typename MatMulTypes<typename Engine::Scalar>::in_type in1,
+      const Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1>& dim_pair)
+  {
+    // OpenCL host & device side initializaiotn
+    cl_int err = c.hostInit(in0, in1, out, dim_pair);
+    if( err != CL_SUCCESS ){
+      return err;
+    }
+
+    // OpenCL memeory object init & memory copy
+    err = c.memInit(in0, in1);
+    if( err == CL_SUCCESS ){
+      // GEMM computation
+      err = compute(c);
+    }
+    if( err != CL_SUCCESS ){
+      // Commands enqueued before the failure may still use the buffers
+      CL_CHECK( clFinish(clMatMulRuntime::Global()->queue()) );
+      CL_CHECK( c.clEnd() );
+      return err;
+    }
+
+    // OpenCL memory load
+    return c.memLoad(out);
+  }
+
+  // Whether the TN 1D kernels of vector width vecWidth, launched with the
+  // work-group size workGroupSize they require, can compute params: their
+  // dimensions are cl_ushort, indices are computed with mul24, the row cache
+  // of B^T lives in local memory and is filled with aligned vector loads.
+  inline bool clTN1DSupported(const clGemmParameters& params, uint64 vecWidth,
+                              uint64 workGroupSize)
+  {
+    const uint64 kMul24Limit = 1 << 24;
+    const clMatMulRuntime* runtime = clMatMulRuntime::Global();
+    return params.m <= 0xffff && params.k <= 0xffff && params.n <= 0xffff &&
+           params.m * params.k < kMul24Limit &&
+           params.k * params.n < kMul24Limit &&
+           params.m * params.n < kMul24Limit &&
+           params.k * sizeof(float) <= runtime->localMemSize() &&
+           params.k % vecWidth == 0 && params.m % workGroupSize == 0;
+  }
+
+  // Whether algorithm can compute the GEMM described by params
+  inline bool clGemmSupported(clGemmAlgorithm algorithm,
+                              const clGemmParameters& params)
+  {
+    switch( algorithm ){
+      case kClGemmTN1DFloat4:
+        return clTN1DSupported(params, 4, 16);
+      case kClGemmTN1DFloat8:
+        // MatTrans_1D_Fp32_Float8 requires work-groups of 32 rows of K
+        return clTN1DSupported(params, 8, 16) && params.k % 32 == 0;
+      case kClGemmTN1DFloat16:
+        return clTN1DSupported(params, 16, 64);
+      case kClGemmNN2DLocalMem:
+        return params.m <= 0xffff && params.k <= 0xffff &&
+               params.n <= 0xffff &&
+               clLocalMem2DEngine::supports(params.m, params.k, params.n,
+                                            params.transpose_a,
+                                            params.transpose_b);
+      case kClGemmCLBlast:
+      case kClGemmTiled2D:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  // Computes out = in0 * in1 with the given OpenCL GEMM variant
+  inline cl_int clGemmRun(clGemmAlgorithm algorithm,
+      typename MatMulTypes<float>::out_type out,
+      typename MatMulTypes<float>::in_type in0,
+      typename MatMulTypes<float>::in_type in1,
+      const Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1>& dim_pair)
+  {
+    auto binaryCompute = [](binaryLoaderInterface& c){
+      return c.loadFromBinaryCompute();
+    };
+    switch( algorithm ){
+      case kClGemmTN1DFloat4: {
+        clQualcommFP32Engine c(4);
+        return clRunEngine(c, binaryCompute, out, in0, in1, dim_pair);
+      }
+      case kClGemmTN1DFloat8: {
+        clQualcommFP32Engine c(8);
+        return clRunEngine(c, binaryCompute, out, in0, in1, dim_pair);
+      }
+      case kClGemmTN1DFloat16: {
+        clQualcommFP32Engine c(16);
+        return clRunEngine(c, binaryCompute, out, in0, in1, dim_pair);
+      }
+      case kClGemmNN2DLocalMem: {
+        clLocalMem2DEngine c;
+        return clRunEngine(c, binaryCompute, out, in0, in1, dim_pair);
+      }
+      case kClGemmTiled2D: {
+        clTiledEngine c;
+        return clRunEngine(c, binaryCompute, out, in0, in1, dim_pair);
+      }
+      case kClGemmCLBlast: {
+        clBLASTEngine c;
+        return clRunEngine(c, [](clBLASTEngine& e){ return e.clBlastCompute(); },
+                           out, in0, in1, dim_pair);
+      }
+      default:
+        return CL_INVALID_VALUE;
+    }
+  }
+
+  // Computes out = in0 * in1 with half precision operands and float
+  // accumulation, T is Eigen::half or float (see clTiledFP16Engine)
+  template <typename T>
+  cl_int clFP16GemmRun(
+      typename MatMulTypes<T>::out_type out,
+      typename MatMulTypes<T>::in_type in0,
+      typename MatMulTypes<T>::in_type in1,
+      const Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1>& dim_pair)
+  {
+    clTiledFP16Engine<T> c;
+    return clRunEngine(c, [](clTiledFP16Engine<T>& e){
+                         return e.loadFromBinaryCompute();
+                       }, out, in0, in1, dim_pair);
+  }
+
+  // Times every supported GEMM variant on this problem, records the fastest
+  // one in clGemmAutotuneCache and returns true if any variant succeeded.
+  // Each variant is run twice and only the second run is timed, so one-off
+  // program builds and buffer allocations don't skew the result.
+  inline bool clGemmAutotune(const clGemmParameters& params,
+      typename MatMulTypes<float>::out_type out,
+      typename MatMulTypes<float>::in_type in0,
+      typename MatMulTypes<float>::in_type in1,
+      const Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1>& dim_pair)
+  {
+    Env* env = Env::Default();
+    clGemmAlgorithm best = kClGemmDefaultAlgorithm;
+    uint64 bestTime = ~0ull;
+    for( int a = 0 ; a < kClGemmNumAlgorithms ; a++ ){
+      clGemmAlgorithm algorithm = static_cast<clGemmAlgorithm>(a);
+      if( !clGemmSupported(algorithm, params) ||
+          clGemmRun(algorithm, out, in0, in1, dim_pair) != CL_SUCCESS ){
+        continue;
+      }
+      const uint64 start = env->NowMicros();
+      if( clGemmRun(algorithm, out, in0, in1, dim_pair) != CL_SUCCESS ){
+        continue;
+      }
+      const uint64 elapsed = env->NowMicros() - start;
+      VLOG(1) << "OpenCL GEMM [" << params.ToString() << "] "
+              << clGemmAlgorithmName(algorithm) << ": " << elapsed << " us";
+      if( elapsed < bestTime ){
+        bestTime = elapsed;
+        best = algorithm;
+      }
+    }
+    if( bestTime == ~0ull ){
+      return false;
+    }
+
+    clGemmAutotuneCache::Global()->insert(params, best);
+    // out holds the product of the last successful variant; recompute it
+    // with the winner so results don't depend on the tuning order
+    return clGemmRun(best, out, in0, in1, dim_pair) == CL_SUCCESS;
+  }
+
+  // Computes out = in0 * in1 on OpenCL with the tuned GEMM variant of this
+  // shape, tuning it first if autotuning is enabled (TF_MATMUL_AUTOTUNE_ENABLE).
+  // With TF_MATMUL_OPENCL_FP16_COMPUTE, operands are rounded to half and the
+  // tuned float variants are only used if the FP16 GEMM fails.
+  // Returns false if no OpenCL device or kernel is available.
+  inline bool clMatMulTuned(
+      typename MatMulTypes<float>::out_type out,
+      typename MatMulTypes<float>::in_type in0,
+      typename MatMulTypes<float>::in_type in1,
+      const Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1>& dim_pair)
+  {
+    static const bool use_fp16_compute = MatmulOpenCLFP16Compute();
+    if( use_fp16_compute &&
+        clFP16GemmRun<float>(out, in0, in1, dim_pair) == CL_SUCCESS ){
+      return true;
+    }
+
+    const bool transpose_a = dim_pair[0].first == 0;
+    const bool transpose_b = dim_pair[0].second == 1;
+    const clGemmParameters params = {
+      static_cast<uint64>(out.dimension(0)),
+      static_cast<uint64>(in0.dimension(transpose_a ? 0 : 1)),
+      static_cast<uint64>(out.dimension(1)),
+      transpose_a, transpose_b, DT_FLOAT,
+    };
+
+    static const bool use_autotune = MatmulAutotuneEnable();
+    clGemmAlgorithm algorithm = kClGemmDefaultAlgorithm;
+    if( !clGemmAutotuneCache::Global()->find(params, &algorithm) ){
+      if( use_autotune ){
+        // The autotuner leaves the product of the winning variant in out
+        return clGemmAutotune(params, out, in0, in1, dim_pair);
+      }
+    }
+    if( !clGemmSupported(algorithm, params) ){
+      algorithm = kClGemmFallbackAlgorithm;
+    }
+    return clGemmRun(algorithm, out, in0, in1, dim_pair) == CL_SUCCESS;
+  }
+
   template <typename Device, typename T>
   struct MatMulCLFunctor {
     // Computes on device "d": out = in0 * in1, where * is matrix
@@ -991,29 +1745,29 @@ namespace functor {
         const Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1>& dim_pair)
       {
 
-      clQualcommFP32Engine c = clQualcommFP32Engine();
-      // clQualcommFP16Engine c = clQualcommFP16Engine();
-      // clBLASTEngine c = clBLASTEngine();
-
-      // OpenCL host & device side initializaiotn
-      CL_CHECK( c.hostInit(in0, in1, out, dim_pair) );
-
-      // debug info
-      // c.debug(true);
-
-      // OpenCL memeory object init & memory copy
-      CL_CHECK( c.memInit(in0, in1) );
-
-      // GEMM computation
-      CL_CHECK( c.loadFromBinaryCompute() );
-      // CL_CHECK( c.clBlastCompute() );
-
-      // OpenCL memory load
-      CL_CHECK( c.memLoad(out) );
+      // Fall back to Eigen if no OpenCL device or kernel is available
+      if( !clMatMulTuned(out, in0, in1, dim_pair) ){
+        MatMul<CPUDevice>(d, out, in0, in1, dim_pair);
+      }
+    }
+  };
 
-      // Results
-      // c.printMatrix(in0, in1, out);
+  // Partial specialization MatMulFunctor<Device=CPUDevice, Eigen::half>.
+  // Eigen has no vectorized half GEMM on the CPU, so half MatMuls always go
+  // to the FP16 OpenCL kernel when there is a device.
+  template <>
+  struct MatMulCLFunctor<CPUDevice, Eigen::half> {
+    void operator()(
+        const CPUDevice& d, typename MatMulTypes<Eigen::half>::out_type out,
+        typename MatMulTypes<Eigen::half>::in_type in0,
+        typename MatMulTypes<Eigen::half>::in_type in1,
+        const Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1>& dim_pair)
+      {
 
+      // Fall back to Eigen if no OpenCL device or kernel is available
+      if( clFP16GemmRun<Eigen::half>(out, in0, in1, dim_pair) != CL_SUCCESS ){
+        MatMul<CPUDevice>(d, out, in0, in1, dim_pair);
+      }
     }
   };
 
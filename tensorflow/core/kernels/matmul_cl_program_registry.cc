@@ -0,0 +1,44 @@
+#include "tensorflow/core/kernels/matmul_cl_program_registry.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Generated from opencl-compiler/kernels/GEMM.c, as a raw string literal
+const char kGemmSource[] =
+#include "tensorflow/core/kernels/matmul_cl_gemm_source.inc"
+    ;
+
+// Generated from opencl-compiler/kernels/DeviceProbe.c
+const char kDeviceProbeSource[] =
+#include "tensorflow/core/kernels/matmul_cl_device_probe_source.inc"
+    ;
+
+// Generated from opencl-finan-benchmk/kernel/pricingOpsKernels.cl
+const char kPricingSource[] =
+#include "tensorflow/core/kernels/matmul_cl_pricing_source.inc"
+    ;
+
+struct clProgramEntry {
+  const char* name;
+  const char* source;
+};
+
+const clProgramEntry kPrograms[] = {
+  { kClMatMulProgram, kGemmSource },
+  { kClDeviceProbeProgram, kDeviceProbeSource },
+  { kClPricingProgram, kPricingSource },
+};
+
+}  // namespace
+
+const char* clProgramSource(const std::string& name){
+  for( const clProgramEntry& entry : kPrograms ){
+    if( name == entry.name ){
+      return entry.source;
+    }
+  }
+  return nullptr;
+}
+
+}  // end namespace tensorflow
@@ -0,0 +1,37 @@
+// clMatMulRuntime::program() ----> clProgramSource (embedded OpenCL C)
+//                                      |
+//                                      +-- "matmul": opencl-compiler/kernels/GEMM.c
+//                                      +-- "device_probe":
+//                                      |     opencl-compiler/kernels/DeviceProbe.c
+//                                      +-- "pricing": opencl-finan-benchmk/
+//                                            kernel/pricingOpsKernels.cl
+//
+// OpenCL C sources compiled into the library by the matmul_cl_program_sources
+// genrule, so programs can be built for whatever device the process runs on
+// without a prebuilt binary next to the executable.
+
+#ifndef MATMUL_CL_PROGRAM_REGISTRY_H_
+#define MATMUL_CL_PROGRAM_REGISTRY_H_
+
+#include <string>
+
+namespace tensorflow {
+
+  // GEMM, transpose and elementwise kernels of the MatMul path and the
+  // OPENCL device
+  constexpr const char* kClMatMulProgram = "matmul";
+
+  // Throughput microbenchmarks of clDeviceInfo
+  constexpr const char* kClDeviceProbeProgram = "device_probe";
+
+  // Black-Scholes and Monte-Carlo kernels of the BlackScholesPrice and
+  // MonteCarloPathSim ops on the OPENCL device
+  constexpr const char* kClPricingProgram = "pricing";
+
+  // Returns the OpenCL C source of the embedded program name, or NULL if no
+  // such program is registered
+  const char* clProgramSource(const std::string& name);
+
+}  // end namespace tensorflow
+
+#endif  // MATMUL_CL_PROGRAM_REGISTRY_H_
@@ -0,0 +1,465 @@
+// clMatMulRuntime (process-wide singleton)
+//     |
+//     +-- cl_platform_id / cl_device_id
+//     +-- cl_context
+//     +-- cl_command_queue
+//     +-- cl_program cache  (keyed by program name + build options)
+//     |       +-- embedded OpenCL C sources (matmul_cl_program_registry.h)
+//     |       +-- on-disk binaries in cacheDirectory()
+//     +-- cl_kernel pool    (keyed by program + kernel name)
+//     +-- clBufferPool      (recycled cl_mem objects)
+//
+// Every clMatMulEngine borrows the OpenCL objects above instead of creating
+// and releasing its own context, queue and program on every MatMul call.
+
+#ifndef MATMUL_CL_RUNTIME_H_
+#define MATMUL_CL_RUNTIME_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/kernels/matmul_cl_buffer_pool.h"
+#include "tensorflow/core/kernels/matmul_cl_program_registry.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/util/env_var.h"
+
+#define CL_USE_DEPRECATED_OPENCL_1_2_APIS // to disable deprecation warnings
+
+#include "CL/cl.h"
+
+namespace tensorflow {
+
+  // clMatMulRuntime owns all long-lived OpenCL objects of the MatMul path.
+  // It is created lazily on first use and lives until the process exits, so
+  // the per-call cost of an OpenCL MatMul is reduced to buffer management,
+  // kernel argument setup and the kernel launches themselves.
+  //
+  // Thread-safety: the context and the command queue are thread-safe OpenCL
+  // objects and may be used concurrently. Kernel objects are not (argument
+  // setup is racy), so callers borrow an exclusive cl_kernel through
+  // acquireKernel() and hand it back with releaseKernel() once it has been
+  // enqueued.
+  class clMatMulRuntime {
+    public:
+
+      // Returns the process-wide runtime, initializing it on first use.
+      static clMatMulRuntime* Global(){
+        static clMatMulRuntime* runtime = new clMatMulRuntime();
+        return runtime;
+      }
+
+      // Whether the OpenCL platform/device/context/queue are usable
+      bool ok() const { return initStatus == CL_SUCCESS; }
+      cl_int status() const { return initStatus; }
+
+      cl_platform_id platform() const { return clPlatform; }
+      cl_device_id device() const { return clDevice; }
+      cl_context context() const { return clCtx; }
+      cl_command_queue queue() const { return clQueue; }
+
+      // CL_DEVICE_NAME & CL_DRIVER_VERSION of device(), used to key on-disk
+      // caches so they are invalidated by a GPU or driver change
+      const std::string& deviceName() const { return clDeviceName; }
+      const std::string& driverVersion() const { return clDriverVersion; }
+
+      // Directory for on-disk OpenCL caches, TF_OPENCL_CACHE_DIR if set
+      std::string cacheDirectory() const
+      {
+        std::string cacheDir;
+        Status s = ReadStringFromEnvVar("TF_OPENCL_CACHE_DIR",
+                                        kDefaultCacheDir, &cacheDir);
+        if( !s.ok() ){
+          LOG(ERROR) << s.error_message();
+          return kDefaultCacheDir;
+        }
+        return cacheDir;
+      }
+
+      // Whether a host allocation of numBytes at ptr can be wrapped with
+      // CL_MEM_USE_HOST_PTR without the driver falling back to a copy: the
+      // address must satisfy CL_DEVICE_MEM_BASE_ADDR_ALIGN and the size must
+      // be a whole number of global memory cache lines.
+      bool isZeroCopyCompatible(const void* ptr, size_t numBytes) const
+      {
+        if( !zeroCopyEnabled || ptr == NULL || numBytes == 0 ){
+          return false;
+        }
+        return reinterpret_cast<uintptr_t>(ptr) % memBaseAddrAlign == 0 &&
+               numBytes % cacheLineSize == 0;
+      }
+
+      // CL_DEVICE_MAX_MEM_ALLOC_SIZE, the largest single cl_mem the device
+      // accepts. Larger GEMM operands are split by the blocking driver.
+      size_t maxMemAllocSize() const { return maxAllocSize; }
+
+      // CL_DEVICE_LOCAL_MEM_SIZE, bounds the row cache of the 1D kernels
+      size_t localMemSize() const { return localMemBytes; }
+
+      // Pool recycling the A/B/C and scratch buffers of the MatMul engines.
+      // NULL if the runtime failed to initialize.
+      clBufferPool* bufferPool() const { return clBuffers; }
+
+      // Returns the embedded program name (see matmul_cl_program_registry.h)
+      // built with buildOptions for device(). The first request of a given
+      // (name, buildOptions) in the process loads the device binary from
+      // cacheDirectory(), or builds the program from source and stores its
+      // binary there for the next process. Returns NULL if the program
+      // cannot be built.
+      cl_program program(const std::string& name, const char* buildOptions)
+      {
+        const std::string options = buildOptions ? buildOptions : "";
+        const std::string key = name + "|" + options;
+        mutex_lock l(mu);
+        auto it = programs.find(key);
+        if( it != programs.end() ){
+          return it->second;
+        }
+
+        cl_program clProgram = buildProgram(name, options);
+        // Failed builds are cached too, so a broken program is reported once
+        // instead of on every MatMul call
+        programs[key] = clProgram;
+        return clProgram;
+      }
+
+      // On-disk binary of program name built with buildOptions, keyed by a
+      // hash of the program source, device name, driver version and build
+      // options so that any change invalidates it
+      std::string programCachePath(const std::string& name,
+                                   const std::string& buildOptions) const
+      {
+        const char* source = clProgramSource(name);
+        const uint64 key = Hash64(strings::StrCat(
+            source ? source : "", "|", clDeviceName, "|", clDriverVersion,
+            "|", buildOptions));
+        return io::JoinPath(cacheDirectory(),
+                            strings::StrCat(name, "_", key, ".bin"));
+      }
+
+      // Borrows a kernel object for kernelName from clProgram. The caller has
+      // exclusive use of the returned kernel until releaseKernel().
+      cl_kernel acquireKernel(cl_program clProgram, const std::string& kernelName)
+      {
+        if( clProgram == NULL ){
+          return NULL;
+        }
+        const std::string key = kernelKey(clProgram, kernelName);
+        {
+          mutex_lock l(mu);
+          std::vector<cl_kernel>& freeList = kernels[key];
+          if( !freeList.empty() ){
+            cl_kernel clKernel = freeList.back();
+            freeList.pop_back();
+            return clKernel;
+          }
+        }
+
+        // No idle kernel object, create a new one outside of the lock
+        cl_int err = CL_SUCCESS;
+        cl_kernel clKernel = clCreateKernel(clProgram, kernelName.c_str(), &err);
+        if( err != CL_SUCCESS ){
+          LOG(ERROR) << "Fail to create cl kernel " << kernelName
+                     << " with code " << err;
+          return NULL;
+        }
+        return clKernel;
+      }
+
+      // Returns a kernel object obtained from acquireKernel() to the pool.
+      // Kernel arguments are captured at enqueue time, so the kernel can be
+      // released right after clEnqueueNDRangeKernel() returns.
+      void releaseKernel(cl_program clProgram, const std::string& kernelName,
+                         cl_kernel clKernel)
+      {
+        if( clKernel == NULL ){
+          return;
+        }
+        mutex_lock l(mu);
+        kernels[kernelKey(clProgram, kernelName)].push_back(clKernel);
+      }
+
+    private:
+
+      clMatMulRuntime(){
+        initStatus = hostInit();
+        if( initStatus != CL_SUCCESS ){
+          LOG(ERROR) << "OpenCL MatMul runtime initialization failed with code "
+                     << initStatus;
+          return;
+        }
+
+        // Buffer pool caps, overridable through the environment
+        int64 poolLimitMB = 0;
+        int64 poolSizeLimit = 0;
+        Status s = ReadInt64FromEnvVar("TF_OPENCL_BUFFER_POOL_LIMIT_MB",
+                                       kDefaultPoolLimitMB, &poolLimitMB);
+        if( !s.ok() ){
+          LOG(ERROR) << s.error_message();
+          poolLimitMB = kDefaultPoolLimitMB;
+        }
+        s = ReadInt64FromEnvVar("TF_OPENCL_BUFFER_POOL_SIZE_LIMIT",
+                                kDefaultPoolSizeLimit, &poolSizeLimit);
+        if( !s.ok() ){
+          LOG(ERROR) << s.error_message();
+          poolSizeLimit = kDefaultPoolSizeLimit;
+        }
+        clBuffers = new clBufferPool(clCtx,
+                                     static_cast<size_t>(poolLimitMB) << 20,
+                                     static_cast<size_t>(poolSizeLimit));
+      }
+
+#ifdef __ANDROID__
+      static constexpr const char* kDefaultCacheDir =
+          "/data/local/tmp/tf_opencl_cache";
+#else
+      static constexpr const char* kDefaultCacheDir = "/tmp/tf_opencl_cache";
+#endif  // __ANDROID__
+
+      // Default caps on idle buffers kept by clBuffers
+      static constexpr int64 kDefaultPoolLimitMB = 256;
+      static constexpr int64 kDefaultPoolSizeLimit = 64;
+
+      // The runtime is never destroyed, see Global()
+      clMatMulRuntime(const clMatMulRuntime&) = delete;
+      void operator=(const clMatMulRuntime&) = delete;
+
+      // Query platform & device, create context & command queue
+      cl_int hostInit(){
+        cl_int err = clGetPlatformIDs(1, &clPlatform, NULL);
+        if( err != CL_SUCCESS ) return err;
+
+        err = clGetDeviceIDs(clPlatform, CL_DEVICE_TYPE_ALL, 1, &clDevice, NULL);
+        if( err != CL_SUCCESS ) return err;
+
+        clCtx = clCreateContext(NULL, 1, &clDevice, NULL, NULL, &err);
+        if( err != CL_SUCCESS ) return err;
+
+        clQueue = clCreateCommandQueue(clCtx, clDevice, 0, &err);
+        if( err != CL_SUCCESS ) return err;
+
+        // Alignment requirements for wrapping host memory, the base address
+        // alignment is reported in bits
+        cl_uint baseAddrAlignBits = 0;
+        cl_uint cacheLineBytes = 0;
+        err = clGetDeviceInfo(clDevice, CL_DEVICE_MEM_BASE_ADDR_ALIGN,
+                              sizeof(cl_uint), &baseAddrAlignBits, NULL);
+        if( err != CL_SUCCESS ) return err;
+        err = clGetDeviceInfo(clDevice, CL_DEVICE_GLOBAL_MEM_CACHELINE_SIZE,
+                              sizeof(cl_uint), &cacheLineBytes, NULL);
+        if( err != CL_SUCCESS ) return err;
+        memBaseAddrAlign = std::max<size_t>(baseAddrAlignBits / 8, 1);
+
+        cl_ulong maxAllocBytes = 0;
+        err = clGetDeviceInfo(clDevice, CL_DEVICE_MAX_MEM_ALLOC_SIZE,
+                              sizeof(cl_ulong), &maxAllocBytes, NULL);
+        if( err != CL_SUCCESS ) return err;
+        maxAllocSize = static_cast<size_t>(maxAllocBytes);
+
+        cl_ulong localBytes = 0;
+        err = clGetDeviceInfo(clDevice, CL_DEVICE_LOCAL_MEM_SIZE,
+                              sizeof(cl_ulong), &localBytes, NULL);
+        if( err != CL_SUCCESS ) return err;
+        localMemBytes = static_cast<size_t>(localBytes);
+
+        clDeviceName = deviceInfoString(CL_DEVICE_NAME);
+        clDriverVersion = deviceInfoString(CL_DRIVER_VERSION);
+        cacheLineSize = std::max<size_t>(cacheLineBytes, 1);
+
+        Status s = ReadBoolFromEnvVar("TF_OPENCL_ZERO_COPY", true,
+                                      &zeroCopyEnabled);
+        if( !s.ok() ){
+          LOG(ERROR) << s.error_message();
+          zeroCopyEnabled = true;
+        }
+        return CL_SUCCESS;
+      }
+
+      std::string deviceInfoString(cl_device_info param) const
+      {
+        size_t size = 0;
+        if( clGetDeviceInfo(clDevice, param, 0, NULL, &size) != CL_SUCCESS ||
+            size == 0 ){
+          return "";
+        }
+        std::vector<char> value(size);
+        if( clGetDeviceInfo(clDevice, param, size, value.data(), NULL) !=
+            CL_SUCCESS ){
+          return "";
+        }
+        // Drop the trailing NUL
+        return std::string(value.data(), strnlen(value.data(), size));
+      }
+
+      // Loads program name from the binary cache, or builds it from its
+      // embedded source and fills the cache
+      cl_program buildProgram(const std::string& name,
+                              const std::string& buildOptions)
+      {
+        if( !ok() ){
+          return NULL;
+        }
+        const char* source = clProgramSource(name);
+        if( source == nullptr ){
+          LOG(ERROR) << "No embedded OpenCL program named " << name;
+          return NULL;
+        }
+
+        const std::string cachePath = programCachePath(name, buildOptions);
+        cl_program clProgram = buildFromCachedBinary(cachePath, buildOptions);
+        if( clProgram != NULL ){
+          VLOG(1) << "Loaded OpenCL program " << name << " from " << cachePath;
+          return clProgram;
+        }
+
+        const uint64 start = Env::Default()->NowMicros();
+        cl_int err = CL_SUCCESS;
+        clProgram = clCreateProgramWithSource(clCtx, 1, &source, NULL, &err);
+        if( err != CL_SUCCESS ){
+          LOG(ERROR) << "Fail to create cl program " << name
+                     << " with code " << err;
+          return NULL;
+        }
+        if( !build(clProgram, name, buildOptions) ){
+          clReleaseProgram(clProgram);
+          return NULL;
+        }
+        LOG(INFO) << "Built OpenCL program " << name << " from source in "
+                  << ( Env::Default()->NowMicros() - start ) / 1000 << " ms";
+
+        saveBinary(clProgram, cachePath);
+        return clProgram;
+      }
+
+      // Creates a program from the device binary at cachePath. Returns NULL,
+      // without logging an error, if there is no usable binary.
+      cl_program buildFromCachedBinary(const std::string& cachePath,
+                                       const std::string& buildOptions)
+      {
+        std::string binary;
+        if( !ReadFileToString(Env::Default(), cachePath, &binary).ok() ||
+            binary.empty() ){
+          return NULL;
+        }
+
+        const size_t binarySize = binary.size();
+        const unsigned char* binaryPtr =
+          reinterpret_cast<const unsigned char*>(binary.data());
+        cl_int binaryStatus = CL_SUCCESS;
+        cl_int err = CL_SUCCESS;
+        cl_program clProgram = clCreateProgramWithBinary(clCtx, 1, &clDevice,
+                                 &binarySize, &binaryPtr, &binaryStatus, &err);
+        if( err != CL_SUCCESS || binaryStatus != CL_SUCCESS ){
+          LOG(WARNING) << "Ignoring unusable OpenCL binary " << cachePath;
+          if( clProgram != NULL ){
+            clReleaseProgram(clProgram);
+          }
+          return NULL;
+        }
+        if( !build(clProgram, cachePath, buildOptions) ){
+          clReleaseProgram(clProgram);
+          return NULL;
+        }
+        return clProgram;
+      }
+
+      bool build(cl_program clProgram, const std::string& name,
+                 const std::string& buildOptions)
+      {
+        cl_int err = clBuildProgram(clProgram, 1, &clDevice,
+                                    buildOptions.c_str(), NULL, NULL);
+        if( err != CL_SUCCESS ){
+          char buildLog[16384];
+          clGetProgramBuildInfo(clProgram, clDevice, CL_PROGRAM_BUILD_LOG,
+                                sizeof(buildLog), buildLog, NULL);
+          LOG(ERROR) << "Fail to build cl program " << name << ": "
+                     << buildLog;
+          return false;
+        }
+        return true;
+      }
+
+      // Writes the device binary of a built single-device program to
+      // cachePath. Failures only cost a rebuild in the next process.
+      void saveBinary(cl_program clProgram, const std::string& cachePath)
+      {
+        size_t binarySize = 0;
+        cl_int err = clGetProgramInfo(clProgram, CL_PROGRAM_BINARY_SIZES,
+                                      sizeof(size_t), &binarySize, NULL);
+        if( err != CL_SUCCESS || binarySize == 0 ){
+          return;
+        }
+        std::string binary(binarySize, '\0');
+        unsigned char* binaryPtr = reinterpret_cast<unsigned char*>(&binary[0]);
+        err = clGetProgramInfo(clProgram, CL_PROGRAM_BINARIES,
+                               sizeof(unsigned char*), &binaryPtr, NULL);
+        if( err != CL_SUCCESS ){
+          return;
+        }
+
+        // Write to a temporary file and rename it, so a concurrent process
+        // never reads a partial binary
+        Env* env = Env::Default();
+        const std::string tmpPath = strings::StrCat(cachePath, ".tmp",
+                                                    env->NowMicros());
+        Status s = env->RecursivelyCreateDir(io::Dirname(cachePath).ToString());
+        if( s.ok() ){
+          s = WriteStringToFile(env, tmpPath, binary);
+        }
+        if( s.ok() ){
+          s = env->RenameFile(tmpPath, cachePath);
+        }
+        if( !s.ok() ){
+          LOG(WARNING) << "Fail to write OpenCL binary cache " << cachePath
+                       << ": " << s;
+          env->DeleteFile(tmpPath).IgnoreError();
+        }
+      }
+
+      static std::string kernelKey(cl_program clProgram,
+                                   const std::string& kernelName){
+        return std::to_string(reinterpret_cast<uintptr_t>(clProgram)) + "|" +
+               kernelName;
+      }
+
+      // OpenCL host side object, immutable after construction
+      cl_int initStatus = CL_SUCCESS;
+      cl_platform_id clPlatform = NULL;
+      cl_device_id clDevice = NULL;
+      cl_context clCtx = NULL;
+      cl_command_queue clQueue = NULL;
+      clBufferPool* clBuffers = nullptr;
+
+      std::string clDeviceName;
+      std::string clDriverVersion;
+
+      // Zero copy requirements of clDevice
+      bool zeroCopyEnabled = true;
+      size_t memBaseAddrAlign = 1;
+      size_t cacheLineSize = 1;
+
+      // Allocation limits of clDevice
+      size_t maxAllocSize = 0;
+      size_t localMemBytes = 0;
+
+      // Built programs & idle kernel objects
+      mutex mu;
+      std::unordered_map<std::string, cl_program> programs GUARDED_BY(mu);
+      std::unordered_map<std::string, std::vector<cl_kernel>> kernels
+        GUARDED_BY(mu);
+
+  };  // class clMatMulRuntime
+
+}  // end namespace tensorflow
+
+#endif  // MATMUL_CL_RUNTIME_H_
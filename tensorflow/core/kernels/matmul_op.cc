@@ -20,12 +20,15 @@ limitations under the License.
 #include "tensorflow/core/kernels/matmul_op.h"
 
 // MatMul op accelerated with OpenCL
+#include "tensorflow/core/kernels/matmul_cl_dispatch.h"
 #include "tensorflow/core/kernels/matmul_cl_functor.h"
 
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/kernels/fill_functor.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/util/matmul_autotune.h"
 #if GOOGLE_CUDA
 #include "cuda/include/cuda.h"
@@ -112,6 +115,147 @@ bool ExplicitVectorMatrixOptimization<Eigen::half>(
   return false;
 }
 
+// Runs MatMulCLFunctor, which computes on OpenCL where supported.
+template <typename Device, typename T>
+struct LaunchMatMulCL {
+  static void launch(
+      OpKernelContext* ctx, const Tensor& a, const Tensor& b,
+      const Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1>& dim_pair,
+      Tensor* out) {
+    functor::MatMulCLFunctor<Device, T>()(ctx->eigen_device<Device>(),
+                                          out->matrix<T>(), a.matrix<T>(),
+                                          b.matrix<T>(), dim_pair);
+  }
+};
+
+// Float GEMMs on the CPU device are sent to Eigen, to OpenCL, or split by
+// rows between both, as decided by clMatMulDispatcher.
+template <>
+struct LaunchMatMulCL<CPUDevice, float> {
+  static void launch(
+      OpKernelContext* ctx, const Tensor& a, const Tensor& b,
+      const Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1>& dim_pair,
+      Tensor* out) {
+    const CPUDevice& d = ctx->eigen_device<CPUDevice>();
+    Calibrate(d);
+    clMatMulDispatcher* dispatcher = clMatMulDispatcher::Global();
+
+    const int64 m = out->dim_size(0);
+    const int64 n = out->dim_size(1);
+    const int64 k = a.dim_size(dim_pair[0].first);
+    // Rows of op(A) are only contiguous if A isn't transposed
+    const bool can_split = dim_pair[0].first == 1;
+    int64 cl_rows = 0;
+    switch (dispatcher->choose(m, k, n, can_split, &cl_rows)) {
+      case kClMatMulCPU:
+        functor::MatMul<CPUDevice>(d, out->matrix<float>(), a.matrix<float>(),
+                                   b.matrix<float>(), dim_pair);
+        break;
+      case kClMatMulOpenCL:
+        functor::MatMulCLFunctor<CPUDevice, float>()(
+            d, out->matrix<float>(), a.matrix<float>(), b.matrix<float>(),
+            dim_pair);
+        break;
+      case kClMatMulSplit:
+        LaunchSplit(ctx, a, b, dim_pair, cl_rows, out);
+        break;
+    }
+  }
+
+  // Runs the dispatcher calibration on the first call.
+  static void Calibrate(const CPUDevice& d) {
+    auto eigen_gemm = [&d](Tensor* c, const Tensor& x, const Tensor& y) {
+      functor::MatMul<CPUDevice>(d, c->matrix<float>(), x.matrix<float>(),
+                                 y.matrix<float>(), kNoTranspose());
+      return true;
+    };
+    auto cl_gemm = [](Tensor* c, const Tensor& x, const Tensor& y) {
+      return functor::clMatMulTuned(c->matrix<float>(), x.matrix<float>(),
+                                    y.matrix<float>(), kNoTranspose());
+    };
+    clMatMulDispatcher::Global()->calibrateOnce(
+        [&eigen_gemm](int64 m, int64 k, int64 n, double* seconds) {
+          return TimeCalibrationGemm(m, k, n, seconds, eigen_gemm);
+        },
+        [&cl_gemm](int64 m, int64 k, int64 n, double* seconds) {
+          return TimeCalibrationGemm(m, k, n, seconds, cl_gemm);
+        });
+  }
+
+ private:
+  static Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1> kNoTranspose() {
+    Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1> dim_pair;
+    dim_pair[0].first = 1;
+    dim_pair[0].second = 0;
+    return dim_pair;
+  }
+
+  // Times gemm on random m x k and k x n inputs.
+  template <typename GemmFn>
+  static bool TimeCalibrationGemm(int64 m, int64 k, int64 n, double* seconds,
+                                  GemmFn gemm) {
+    Tensor x(DT_FLOAT, TensorShape({m, k}));
+    Tensor y(DT_FLOAT, TensorShape({k, n}));
+    Tensor c(DT_FLOAT, TensorShape({m, n}));
+    x.flat<float>().setRandom();
+    y.flat<float>().setRandom();
+    const uint64 start = Env::Default()->NowMicros();
+    const bool ok = gemm(&c, x, y);
+    *seconds = (Env::Default()->NowMicros() - start) * 1e-6;
+    return ok;
+  }
+
+  // Thread running the OpenCL half of split GEMMs. Waiting for the device on
+  // a worker of the CPU device would take a thread from the Eigen half. All
+  // GEMMs share the in-order queue of clMatMulRuntime, so one thread is
+  // enough.
+  static thread::ThreadPool* SplitThread() {
+    static thread::ThreadPool* pool =
+        new thread::ThreadPool(Env::Default(), "opencl_matmul_split", 1);
+    return pool;
+  }
+
+  // The first cl_rows rows of out are computed on OpenCL from SplitThread()
+  // while the calling thread computes the rest with Eigen on the intra-op
+  // threadpool.
+  static void LaunchSplit(
+      OpKernelContext* ctx, const Tensor& a, const Tensor& b,
+      const Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1>& dim_pair,
+      int64 cl_rows, Tensor* out) {
+    const CPUDevice& d = ctx->eigen_device<CPUDevice>();
+    const int64 m = out->dim_size(0);
+    const int64 n = out->dim_size(1);
+    const int64 k = a.dim_size(1);
+
+    // Leading row slices share the buffers and alignment of a and out
+    const Tensor a_top = a.Slice(0, cl_rows);
+    Tensor out_top = out->Slice(0, cl_rows);
+    bool cl_ok = false;
+    Notification cl_done;
+    SplitThread()->Schedule([&]() {
+      cl_ok = functor::clMatMulTuned(out_top.matrix<float>(),
+                                     a_top.matrix<float>(), b.matrix<float>(),
+                                     dim_pair);
+      cl_done.Notify();
+    });
+
+    Eigen::array<Eigen::DenseIndex, 2> offsets = {cl_rows, 0};
+    Eigen::array<Eigen::DenseIndex, 2> a_extents = {m - cl_rows, k};
+    Eigen::array<Eigen::DenseIndex, 2> out_extents = {m - cl_rows, n};
+    out->matrix<float>().slice(offsets, out_extents).device(d) =
+        a.matrix<float>()
+            .slice(offsets, a_extents)
+            .contract(b.matrix<float>(), dim_pair);
+
+    cl_done.WaitForNotification();
+    if (!cl_ok) {
+      functor::MatMul<CPUDevice>(d, out_top.matrix<float>(),
+                                 a_top.matrix<float>(), b.matrix<float>(),
+                                 dim_pair);
+    }
+  }
+};
+
 template <typename Device, typename T>
 struct LaunchMatMulBase {
 #if GOOGLE_CUDA
@@ -131,9 +275,7 @@ struct LaunchMatMulBase {
     if (!was_vector) {
 #endif  // TENSORFLOW_USE_SYCL
 
-      functor::MatMulCLFunctor<Device, T>()(ctx->eigen_device<Device>(),
-                                          out->matrix<T>(), a.matrix<T>(),
-                                          b.matrix<T>(), dim_pair);
+      LaunchMatMulCL<Device, T>::launch(ctx, a, b, dim_pair, out);
       // functor::MatMulFunctor<Device, T>()(ctx->eigen_device<Device>(),
       //                                     out->matrix<T>(), a.matrix<T>(),
       //                                     b.matrix<T>(), dim_pair);
@@ -513,6 +655,149 @@ class MatMulOp : public OpKernel {
   bool transpose_b_;
 };
 
+// MatMul on the OpenCL device that doesn't block the executor thread, selected
+// with the "opencl_async" kernel label. clTiledEngine enqueues the uploads,
+// transposes, GEMM and read back as one graph of events, and the completion of
+// the last read back schedules the DoneCallback on the CPU worker threads, so
+// the inter-op threadpool can run other nodes while the device works. GEMMs
+// the dispatcher keeps on the CPU, and OpenCL failures, are computed with
+// Eigen instead.
+class MatMulCLAsyncOp : public AsyncOpKernel {
+ public:
+  explicit MatMulCLAsyncOp(OpKernelConstruction* ctx) : AsyncOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("transpose_a", &transpose_a_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("transpose_b", &transpose_b_));
+  }
+
+  void ComputeAsync(OpKernelContext* ctx, DoneCallback done) override {
+    const Tensor& a = ctx->input(0);
+    const Tensor& b = ctx->input(1);
+
+    // Check that the dimensions of the two matrices are valid.
+    OP_REQUIRES_ASYNC(ctx, TensorShapeUtils::IsMatrix(a.shape()),
+                      errors::InvalidArgument("In[0] is not a matrix"), done);
+    OP_REQUIRES_ASYNC(ctx, TensorShapeUtils::IsMatrix(b.shape()),
+                      errors::InvalidArgument("In[1] is not a matrix"), done);
+    const DimPair dim_pair = GetDimPair();
+
+    OP_REQUIRES_ASYNC(
+        ctx, a.dim_size(dim_pair[0].first) == b.dim_size(dim_pair[0].second),
+        errors::InvalidArgument(
+            "Matrix size-incompatible: In[0]: ", a.shape().DebugString(),
+            ", In[1]: ", b.shape().DebugString()),
+        done);
+    TensorShape out_shape({a.dim_size(1 - dim_pair[0].first),
+                           b.dim_size(1 - dim_pair[0].second)});
+    Tensor* out = nullptr;
+    OP_REQUIRES_OK_ASYNC(ctx, ctx->allocate_output(0, out_shape, &out), done);
+
+    if (out->NumElements() == 0) {
+      done();
+      return;
+    }
+    if (a.NumElements() == 0 || b.NumElements() == 0) {
+      functor::SetZeroFunctor<CPUDevice, float> f;
+      f(ctx->eigen_device<CPUDevice>(), out->flat<float>());
+      done();
+      return;
+    }
+
+    const CPUDevice& d = ctx->eigen_device<CPUDevice>();
+    LaunchMatMulCL<CPUDevice, float>::Calibrate(d);
+    int64 cl_rows = 0;
+    if (clMatMulDispatcher::Global()->choose(
+            out->dim_size(0), a.dim_size(dim_pair[0].first), out->dim_size(1),
+            false /* can_split */, &cl_rows) == kClMatMulCPU) {
+      ComputeOnEigen(ctx, dim_pair);
+      done();
+      return;
+    }
+
+    // Enqueue the whole product without waiting
+    clTiledEngine* engine = new clTiledEngine();
+    cl_event done_event = NULL;
+    cl_int err = engine->hostInit(a.matrix<float>(), b.matrix<float>(),
+                                  out->matrix<float>(), dim_pair);
+    const bool runtime_ok = err == CL_SUCCESS;
+    if (err == CL_SUCCESS) {
+      err = engine->memInit(a.matrix<float>(), b.matrix<float>());
+    }
+    if (err == CL_SUCCESS) {
+      err = engine->enqueueCompute(&done_event);
+    }
+
+    CallbackState* state = nullptr;
+    if (err == CL_SUCCESS) {
+      state = new CallbackState{engine, ctx, dim_pair, std::move(done),
+                                ctx->device()->tensorflow_cpu_worker_threads()};
+      err = clSetEventCallback(done_event, CL_COMPLETE, &OnComplete, state);
+      if (err == CL_SUCCESS) {
+        return;
+      }
+      done = std::move(state->done);
+      delete state;
+    }
+
+    // Wait for anything already enqueued, then compute on the CPU
+    LOG(WARNING) << "Asynchronous OpenCL MatMul failed with code " << err
+                 << ", using Eigen";
+    if (runtime_ok) {
+      clFinish(clMatMulRuntime::Global()->queue());
+      engine->clEnd();
+    }
+    delete engine;
+    ComputeOnEigen(ctx, dim_pair);
+    done();
+  }
+
+ private:
+  typedef Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1> DimPair;
+
+  struct CallbackState {
+    clTiledEngine* engine;
+    OpKernelContext* ctx;
+    DimPair dim_pair;
+    DoneCallback done;
+    const DeviceBase::CpuWorkerThreads* workers;
+  };
+
+  DimPair GetDimPair() const {
+    DimPair dim_pair;
+    dim_pair[0].first = transpose_a_ ? 0 : 1;
+    dim_pair[0].second = transpose_b_ ? 1 : 0;
+    return dim_pair;
+  }
+
+  static void ComputeOnEigen(OpKernelContext* ctx, const DimPair& dim_pair) {
+    functor::MatMul<CPUDevice>(ctx->eigen_device<CPUDevice>(),
+                               ctx->mutable_output(0)->matrix<float>(),
+                               ctx->input(0).matrix<float>(),
+                               ctx->input(1).matrix<float>(), dim_pair);
+  }
+
+  // Called by the OpenCL runtime when the last read back completes or the
+  // event graph fails. Releasing OpenCL objects and running the executor
+  // continuation happen on a worker thread, off the OpenCL callback thread.
+  static void CL_CALLBACK OnComplete(cl_event event, cl_int status,
+                                     void* user_data) {
+    CallbackState* state = static_cast<CallbackState*>(user_data);
+    state->workers->workers->Schedule([state, status]() {
+      state->engine->clEnd();
+      delete state->engine;
+      if (status != CL_COMPLETE) {
+        LOG(WARNING) << "Asynchronous OpenCL MatMul failed with code "
+                     << status << ", using Eigen";
+        ComputeOnEigen(state->ctx, state->dim_pair);
+      }
+      state->done();
+      delete state;
+    });
+  }
+
+  bool transpose_a_;
+  bool transpose_b_;
+};
+
 namespace functor {
 
 // Partial specialization MatMulFunctor<Device=CPUDevice, T>.
@@ -564,6 +849,12 @@ struct MatMulFunctor<SYCLDevice, T> {
                               .Label("cublas"),                    \
                           MatMulOp<GPUDevice, T, true /* cublas */>)
 
+REGISTER_KERNEL_BUILDER(Name("MatMul")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<float>("T")
+                            .Label("opencl_async"),
+                        MatMulCLAsyncOp);
+
 #if defined(INTEL_MKL)
 // MKL does not support half and int32 types for matrix-multiplication, so
 // register the kernel to use default Eigen based implementations for these
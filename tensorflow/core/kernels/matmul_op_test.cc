@@ -13,13 +13,321 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
+
+#include "tensorflow/cc/client/client_session.h"
+#include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/matmul_cl_functor.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 
+typedef functor::MatMulTypes<float>::out_type CLOutType;
+typedef functor::MatMulTypes<float>::in_type CLInType;
+typedef Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1> CLDimPair;
+
+// The OpenCL GEMM paths are checked against Eigen. The tests are skipped when
+// the process has no OpenCL device or the kernels fail to build.
+static bool OpenCLMatMulAvailable() {
+  clMatMulRuntime* runtime = clMatMulRuntime::Global();
+  if (!runtime->ok() ||
+      runtime->program(kClMatMulProgram, "-cl-fast-relaxed-math") == NULL) {
+    LOG(WARNING) << "No OpenCL MatMul runtime, skipping test";
+    return false;
+  }
+  return true;
+}
+
+// Runs compute on random inputs of the given shape and compares the result
+// with Eigen's contraction.
+template <typename ComputeFn>
+static void ExpectMatchesEigen(int m, int k, int n, bool transpose_a,
+                               bool transpose_b, ComputeFn compute,
+                               double tolerance_per_k = 1e-4) {
+  Tensor a(DT_FLOAT, transpose_a ? TensorShape({k, m}) : TensorShape({m, k}));
+  a.flat<float>().setRandom();
+  Tensor b(DT_FLOAT, transpose_b ? TensorShape({n, k}) : TensorShape({k, n}));
+  b.flat<float>().setRandom();
+  const Tensor& ca = a;
+  const Tensor& cb = b;
+
+  CLDimPair dim_pair;
+  dim_pair[0].first = transpose_a ? 0 : 1;
+  dim_pair[0].second = transpose_b ? 1 : 0;
+
+  Tensor expected(DT_FLOAT, TensorShape({m, n}));
+  expected.matrix<float>() =
+      ca.matrix<float>().contract(cb.matrix<float>(), dim_pair);
+
+  Tensor actual(DT_FLOAT, TensorShape({m, n}));
+  actual.flat<float>().setZero();
+  ASSERT_EQ(CL_SUCCESS, compute(actual.matrix<float>(), ca.matrix<float>(),
+                                cb.matrix<float>(), dim_pair))
+      << "m=" << m << " k=" << k << " n=" << n << " ta=" << transpose_a
+      << " tb=" << transpose_b;
+  test::ExpectTensorNear<float>(expected, actual, tolerance_per_k * k);
+}
+
+// Every OpenCL GEMM variant supporting the shape, as picked by the autotuner
+static void ExpectAllAlgorithmsMatchEigen(int m, int k, int n,
+                                          bool transpose_a, bool transpose_b) {
+  const clGemmParameters params = {
+      static_cast<uint64>(m), static_cast<uint64>(k), static_cast<uint64>(n),
+      transpose_a, transpose_b, DT_FLOAT};
+  for (int a = 0; a < kClGemmNumAlgorithms; ++a) {
+    const clGemmAlgorithm algorithm = static_cast<clGemmAlgorithm>(a);
+    if (!functor::clGemmSupported(algorithm, params)) continue;
+    SCOPED_TRACE(clGemmAlgorithmName(algorithm));
+    ExpectMatchesEigen(m, k, n, transpose_a, transpose_b,
+                       [algorithm](CLOutType out, CLInType in0, CLInType in1,
+                                   const CLDimPair& dim_pair) {
+                         return functor::clGemmRun(algorithm, out, in0, in1,
+                                                   dim_pair);
+                       });
+  }
+}
+
+// clTiledEngine with C split into blocks of at most maxBlockDim rows & columns
+static void ExpectTiledBlocksMatchEigen(int m, int k, int n, bool transpose_a,
+                                        bool transpose_b, size_t maxBlockDim) {
+  ExpectMatchesEigen(m, k, n, transpose_a, transpose_b,
+                     [maxBlockDim](CLOutType out, CLInType in0, CLInType in1,
+                                   const CLDimPair& dim_pair) {
+                       clTiledEngine engine(maxBlockDim);
+                       return functor::clRunEngine(
+                           engine,
+                           [](clTiledEngine& e) {
+                             return e.loadFromBinaryCompute();
+                           },
+                           out, in0, in1, dim_pair);
+                     });
+}
+
+TEST(MatMulCLTest, AlgorithmsMatchEigenOnRandomShapes) {
+  if (!OpenCLMatMulAvailable()) return;
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  for (int i = 0; i < 8; ++i) {
+    // Mostly unaligned shapes, plus aligned ones reaching the vector kernels
+    const int scale = (i % 2 == 0) ? 1 : 64;
+    const int m = scale * (1 + rnd.Uniform(300 / scale));
+    const int k = scale * (1 + rnd.Uniform(300 / scale));
+    const int n = 1 + rnd.Uniform(300);
+    for (bool transpose_a : {false, true}) {
+      for (bool transpose_b : {false, true}) {
+        ExpectAllAlgorithmsMatchEigen(m, k, n, transpose_a, transpose_b);
+      }
+    }
+  }
+}
+
+TEST(MatMulCLTest, TiledBlocksMatchEigen) {
+  if (!OpenCLMatMulAvailable()) return;
+  for (bool transpose_a : {false, true}) {
+    for (bool transpose_b : {false, true}) {
+      ExpectTiledBlocksMatchEigen(100, 37, 83, transpose_a, transpose_b, 16);
+      ExpectTiledBlocksMatchEigen(129, 65, 17, transpose_a, transpose_b, 40);
+      ExpectTiledBlocksMatchEigen(1, 300, 1, transpose_a, transpose_b, 7);
+    }
+  }
+}
+
+TEST(MatMulCLTest, TiledHandlesDimensionsAbove65535) {
+  if (!OpenCLMatMulAvailable()) return;
+  ExpectAllAlgorithmsMatchEigen(70001, 3, 5, false, false);
+  ExpectAllAlgorithmsMatchEigen(5, 70001, 3, true, false);
+  ExpectAllAlgorithmsMatchEigen(3, 5, 70001, false, true);
+}
+
+// DT_HALF product on OpenCL against Eigen's float contraction of the same
+// half inputs, so only the float accumulation order and the final rounding
+// to half differ.
+static void ExpectHalfMatchesEigen(int m, int k, int n, bool transpose_a,
+                                   bool transpose_b) {
+  Tensor a_float(DT_FLOAT,
+                 transpose_a ? TensorShape({k, m}) : TensorShape({m, k}));
+  a_float.flat<float>().setRandom();
+  Tensor a(DT_HALF, a_float.shape());
+  a.flat<Eigen::half>() = a_float.flat<float>().cast<Eigen::half>();
+  Tensor b_float(DT_FLOAT,
+                 transpose_b ? TensorShape({n, k}) : TensorShape({k, n}));
+  b_float.flat<float>().setRandom();
+  Tensor b(DT_HALF, b_float.shape());
+  b.flat<Eigen::half>() = b_float.flat<float>().cast<Eigen::half>();
+  const Tensor& ca = a;
+  const Tensor& cb = b;
+
+  CLDimPair dim_pair;
+  dim_pair[0].first = transpose_a ? 0 : 1;
+  dim_pair[0].second = transpose_b ? 1 : 0;
+
+  Tensor expected(DT_FLOAT, TensorShape({m, n}));
+  expected.matrix<float>() = ca.matrix<Eigen::half>().cast<float>().contract(
+      cb.matrix<Eigen::half>().cast<float>(), dim_pair);
+
+  Tensor actual(DT_HALF, TensorShape({m, n}));
+  ASSERT_EQ(CL_SUCCESS, functor::clFP16GemmRun<Eigen::half>(
+                            actual.matrix<Eigen::half>(),
+                            ca.matrix<Eigen::half>(), cb.matrix<Eigen::half>(),
+                            dim_pair))
+      << "m=" << m << " k=" << k << " n=" << n << " ta=" << transpose_a
+      << " tb=" << transpose_b;
+  Tensor actual_float(DT_FLOAT, TensorShape({m, n}));
+  actual_float.flat<float>() = actual.flat<Eigen::half>().cast<float>();
+  test::ExpectTensorNear<float>(expected, actual_float, 1e-3 * k);
+}
+
+TEST(MatMulCLTest, HalfMatchesEigen) {
+  if (!OpenCLMatMulAvailable()) return;
+  for (bool transpose_a : {false, true}) {
+    for (bool transpose_b : {false, true}) {
+      ExpectHalfMatchesEigen(100, 37, 83, transpose_a, transpose_b);
+      ExpectHalfMatchesEigen(64, 256, 64, transpose_a, transpose_b);
+      ExpectHalfMatchesEigen(1, 300, 1, transpose_a, transpose_b);
+    }
+  }
+}
+
+// Float MatMul with half precision operands: the inputs in [0, 1) lose up to
+// 2^-11 of relative precision each, so the tolerance is looser than for the
+// float32 kernels.
+TEST(MatMulCLTest, FP16ComputeMatchesEigenWithinHalfPrecision) {
+  if (!OpenCLMatMulAvailable()) return;
+  for (bool transpose_a : {false, true}) {
+    for (bool transpose_b : {false, true}) {
+      for (int k : {1, 37, 300}) {
+        ExpectMatchesEigen(65, k, 19, transpose_a, transpose_b,
+                           [](CLOutType out, CLInType in0, CLInType in1,
+                              const CLDimPair& dim_pair) {
+                             return functor::clFP16GemmRun<float>(
+                                 out, in0, in1, dim_pair);
+                           },
+                           2e-3);
+      }
+    }
+  }
+}
+
+// MatMul -> BiasAdd -> Relu placed on device, fetched to the host. On the
+// OPENCL device the intermediate results stay in cl_mem buffers.
+static Tensor RunMatMulBiasAddRelu(const string& device, const Tensor& x,
+                                   const Tensor& w, const Tensor& bias,
+                                   bool transpose_a, bool transpose_b) {
+  Scope root = Scope::NewRootScope();
+  Scope dev = root.WithDevice(device);
+  auto product = ops::MatMul(
+      dev, ops::Const(dev, x), ops::Const(dev, w),
+      ops::MatMul::TransposeA(transpose_a).TransposeB(transpose_b));
+  auto biased = ops::BiasAdd(dev, product, ops::Const(dev, bias));
+  auto relu = ops::Relu(dev, biased);
+  TF_CHECK_OK(root.status());
+
+  ClientSession session(root);
+  std::vector<Tensor> outputs;
+  TF_CHECK_OK(session.Run({relu}, &outputs));
+  return outputs[0];
+}
+
+TEST(OpenCLDeviceTest, MatMulBiasAddReluMatchesCPU) {
+  if (!OpenCLMatMulAvailable()) return;
+  for (bool transpose_a : {false, true}) {
+    for (bool transpose_b : {false, true}) {
+      const int m = 37, k = 70, n = 19;
+      Tensor x(DT_FLOAT,
+               transpose_a ? TensorShape({k, m}) : TensorShape({m, k}));
+      x.flat<float>().setRandom();
+      Tensor w(DT_FLOAT,
+               transpose_b ? TensorShape({n, k}) : TensorShape({k, n}));
+      w.flat<float>().setRandom();
+      Tensor bias(DT_FLOAT, TensorShape({n}));
+      bias.flat<float>().setRandom();
+      bias.flat<float>() -= bias.flat<float>().constant(0.5f);
+
+      const Tensor expected = RunMatMulBiasAddRelu(
+          "/device:CPU:0", x, w, bias, transpose_a, transpose_b);
+      const Tensor actual = RunMatMulBiasAddRelu(
+          "/device:OPENCL:0", x, w, bias, transpose_a, transpose_b);
+      test::ExpectTensorNear<float>(expected, actual, 1e-4 * k);
+    }
+  }
+}
+
+// MatMul on the CPU device, with the kernel selected by label.
+static Tensor RunLabeledMatMul(const string& label, const Tensor& x,
+                               const Tensor& w, bool transpose_a,
+                               bool transpose_b) {
+  Scope root = Scope::NewRootScope();
+  const Scope dev = root.WithDevice("/device:CPU:0");
+  auto product = ops::MatMul(
+      dev.WithKernelLabel(label), ops::Const(root, x), ops::Const(root, w),
+      ops::MatMul::TransposeA(transpose_a).TransposeB(transpose_b));
+  TF_CHECK_OK(root.status());
+
+  ClientSession session(root);
+  std::vector<Tensor> outputs;
+  TF_CHECK_OK(session.Run({product}, &outputs));
+  return outputs[0];
+}
+
+static void ExpectAsyncMatchesCPU(int m, int k, int n, bool transpose_a,
+                                  bool transpose_b) {
+  Tensor x(DT_FLOAT, transpose_a ? TensorShape({k, m}) : TensorShape({m, k}));
+  x.flat<float>().setRandom();
+  Tensor w(DT_FLOAT, transpose_b ? TensorShape({n, k}) : TensorShape({k, n}));
+  w.flat<float>().setRandom();
+
+  // The reference is a direct contraction, as the default CPU MatMul kernel
+  // may itself dispatch to OpenCL.
+  const Tensor& cx = x;
+  const Tensor& cw = w;
+  CLDimPair dim_pair;
+  dim_pair[0].first = transpose_a ? 0 : 1;
+  dim_pair[0].second = transpose_b ? 1 : 0;
+  Tensor expected(DT_FLOAT, TensorShape({m, n}));
+  if (k == 0) {
+    expected.flat<float>().setZero();
+  } else {
+    expected.matrix<float>() =
+        cx.matrix<float>().contract(cw.matrix<float>(), dim_pair);
+  }
+
+  const Tensor actual =
+      RunLabeledMatMul("opencl_async", x, w, transpose_a, transpose_b);
+  SCOPED_TRACE(strings::StrCat("m=", m, " k=", k, " n=", n,
+                               " ta=", transpose_a, " tb=", transpose_b));
+  test::ExpectTensorNear<float>(expected, actual, 1e-4 * std::max(k, 1));
+}
+
+// MatMulCLAsyncOp computes on OpenCL when there is a device, and with Eigen
+// otherwise, so these run everywhere.
+TEST(MatMulCLAsyncOpTest, MatchesCPUMatMul) {
+  for (bool transpose_a : {false, true}) {
+    for (bool transpose_b : {false, true}) {
+      ExpectAsyncMatchesCPU(256, 256, 256, transpose_a, transpose_b);
+      ExpectAsyncMatchesCPU(129, 65, 257, transpose_a, transpose_b);
+    }
+  }
+}
+
+// Shapes the OpenCL path doesn't take: products the dispatcher keeps on the
+// CPU, and empty inputs or outputs.
+TEST(MatMulCLAsyncOpTest, FallsBackOnUnsupportedShapes) {
+  for (bool transpose_a : {false, true}) {
+    for (bool transpose_b : {false, true}) {
+      ExpectAsyncMatchesCPU(1, 300, 1, transpose_a, transpose_b);
+      ExpectAsyncMatchesCPU(3, 2, 5, transpose_a, transpose_b);
+      ExpectAsyncMatchesCPU(7, 0, 9, transpose_a, transpose_b);
+      ExpectAsyncMatchesCPU(0, 4, 9, transpose_a, transpose_b);
+    }
+  }
+}
+
 template <typename T>
 static Graph* Matmul(int m, int k, int n, bool transpose_a, bool transpose_b,
                      DataType type) {
@@ -53,6 +361,91 @@ static Graph* Matmul(int m, int k, int n, bool transpose_a, bool transpose_b,
 // BM_MatmulDev(M, K, N, TA, TB, double, DT_DOUBLE, gpu);                   \
 // BM_MatmulDev(M, K, N, TA, TB, std::complex<double>, DT_COMPLEX128, gpu);
 
+// A graph of num independent dim x dim MatMuls, run with the kernel selected
+// by label ("" for the default synchronous kernel).
+static Graph* IndependentMatmuls(int num, int dim, const string& label) {
+  Graph* g = new Graph(OpRegistry::Global());
+  for (int i = 0; i < num; ++i) {
+    Tensor in0(DT_FLOAT, TensorShape({dim, dim}));
+    in0.flat<float>().setRandom();
+    Tensor in1(DT_FLOAT, TensorShape({dim, dim}));
+    in1.flat<float>().setRandom();
+    Node* n = test::graph::Matmul(g, test::graph::Constant(g, in0),
+                                  test::graph::Constant(g, in1), false, false);
+    if (!label.empty()) n->AddAttr("_kernel", label);
+  }
+  return g;
+}
+
+// Throughput of independent MatMuls with the synchronous OpenCL path, which
+// blocks an executor thread per MatMul, and with MatMulCLAsyncOp.
+#define BM_IndependentMatmuls(NUM, DIM)                                      \
+  static void BM_IndependentMatmuls_##NUM##_##DIM##_sync(int iters) {        \
+    testing::UseRealTime();                                                  \
+    testing::ItemsProcessed(static_cast<int64>(iters) * NUM * DIM * DIM *    \
+                            DIM * 2);                                        \
+    test::Benchmark("cpu", IndependentMatmuls(NUM, DIM, "")).Run(iters);     \
+  }                                                                          \
+  BENCHMARK(BM_IndependentMatmuls_##NUM##_##DIM##_sync);                     \
+  static void BM_IndependentMatmuls_##NUM##_##DIM##_async(int iters) {       \
+    testing::UseRealTime();                                                  \
+    testing::ItemsProcessed(static_cast<int64>(iters) * NUM * DIM * DIM *    \
+                            DIM * 2);                                        \
+    test::Benchmark("cpu", IndependentMatmuls(NUM, DIM, "opencl_async"))     \
+        .Run(iters);                                                         \
+  }                                                                          \
+  BENCHMARK(BM_IndependentMatmuls_##NUM##_##DIM##_async);
+
+BM_IndependentMatmuls(8, 256);
+BM_IndependentMatmuls(8, 512);
+BM_IndependentMatmuls(32, 256);
+
+// A fully connected layer, MatMul -> BiasAdd -> Relu. On the opencl device the
+// three ops run back to back on device buffers.
+static Graph* MatmulBiasAddRelu(int m, int k, int n) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor in0(DT_FLOAT, TensorShape({m, k}));
+  in0.flat<float>().setRandom();
+  Tensor in1(DT_FLOAT, TensorShape({k, n}));
+  in1.flat<float>().setRandom();
+  Tensor bias(DT_FLOAT, TensorShape({n}));
+  bias.flat<float>().setRandom();
+  Node* product =
+      test::graph::Matmul(g, test::graph::Constant(g, in0),
+                          test::graph::Constant(g, in1), false, false);
+  test::graph::Relu(
+      g, test::graph::BiasAdd(g, product, test::graph::Constant(g, bias)));
+  return g;
+}
+
+#define BM_MatmulBiasAddReluDev(M, K, N, DEVICE)                              \
+  static void BM_MatmulBiasAddRelu_##M##_##K##_##N##_##DEVICE(int iters) {    \
+    testing::UseRealTime();                                                   \
+    testing::ItemsProcessed(static_cast<int64>(iters) * M * K * N * 2);       \
+    test::Benchmark(#DEVICE, MatmulBiasAddRelu(M, K, N)).Run(iters);          \
+  }                                                                           \
+  BENCHMARK(BM_MatmulBiasAddRelu_##M##_##K##_##N##_##DEVICE);
+
+#define BM_MatmulBiasAddRelu(M, K, N)        \
+  BM_MatmulBiasAddReluDev(M, K, N, cpu);     \
+  BM_MatmulBiasAddReluDev(M, K, N, opencl);
+
+BM_MatmulBiasAddRelu(128, 512, 512);
+BM_MatmulBiasAddRelu(512, 1024, 1024);
+
+// Small square matrices, dominated by the fixed per-call cost of the OpenCL
+// MatMul path (runtime setup, program build, kernel launch).
+BM_Matmul(16, 16, 16, false, false);
+BM_Matmul(32, 32, 32, false, false);
+BM_Matmul(64, 64, 64, false, false);
+BM_Matmul(128, 128, 128, false, false);
+
+// Half precision, computed by MatMul_NN_2D_Tiled_Fp16 when there is an OpenCL
+// device. Compare with the float benchmarks of the same shape.
+BM_MatmulDev(128, 512, 512, false, false, Eigen::half, DT_HALF, cpu);
+BM_MatmulDev(512, 1024, 1024, false, false, Eigen::half, DT_HALF, cpu);
+BM_MatmulDev(512, 1024, 1024, false, false, float, DT_FLOAT, cpu);
+
 // Batch size of 1 included for inference.
 // Typical fully connected layers
 BM_Matmul(1, 512, 512, false, false);
@@ -102,16 +102,12 @@ enum CONV_OP {
 
 }  // namespace
 
-static void BM_ConvFloat(int iters, int batch, int rows, int cols, int in_depth,
-                         int out_depth, int filter_rows, int filter_cols,
-                         CONV_OP op, int num_threads, int stride,
-                         Padding padding, bool use_gpu, DataType data_type,
-                         const string& label) {
-  if (!IsGoogleCudaEnabled() && use_gpu) {
-    testing::SetLabel(
-        strings::StrCat("Skipping GPU test (no --config=cuda): ", label));
-    return;
-  }
+static void BM_ConvFloatOnDevice(int iters, int batch, int rows, int cols,
+                                 int in_depth, int out_depth, int filter_rows,
+                                 int filter_cols, CONV_OP op, int num_threads,
+                                 int stride, Padding padding,
+                                 const string& device, DataType data_type,
+                                 const string& label) {
   testing::SetLabel(label);
 
   // Set the number of threads
@@ -218,12 +214,26 @@ static void BM_ConvFloat(int iters, int batch, int rows, int cols, int in_depth,
   GraphConstructorOptions opts;
   TF_CHECK_OK(ConvertGraphDefToGraph(opts, graph, g));
 
-  string device = use_gpu ? "gpu" : "cpu";
   testing::UseRealTime();
   test::Benchmark(device, g, &options).Run(iters);
   testing::ItemsProcessed(num_ops * iters);
 }
 
+static void BM_ConvFloat(int iters, int batch, int rows, int cols, int in_depth,
+                         int out_depth, int filter_rows, int filter_cols,
+                         CONV_OP op, int num_threads, int stride,
+                         Padding padding, bool use_gpu, DataType data_type,
+                         const string& label) {
+  if (!IsGoogleCudaEnabled() && use_gpu) {
+    testing::SetLabel(
+        strings::StrCat("Skipping GPU test (no --config=cuda): ", label));
+    return;
+  }
+  BM_ConvFloatOnDevice(iters, batch, rows, cols, in_depth, out_depth,
+                       filter_rows, filter_cols, op, num_threads, stride,
+                       padding, use_gpu ? "gpu" : "cpu", data_type, label);
+}
+
 // BS: batch_size
 // R: tensor_in_rows
 // C: tensor_in_cols
@@ -485,6 +495,46 @@ BM_ConvFloatBkFGPU(128, 32, 32, 128, 128, 9, 9, "convnet-layer3");
 BM_ConvFloatBkFGPU(128, 16, 16, 128, 128, 7, 7, "convnet-layer4");
 BM_ConvFloatBkFGPU(128, 13, 13, 384, 384, 3, 3, "convnet-layer5");
 
+#ifdef TENSORFLOW_USE_SYCL
+// Forward and both gradients on the SYCL device. The shapes cover the
+// pointwise, direct and im2col + GEMM paths of the SYCL convolutions.
+#define BM_ConvFloatSYCL(BS, R, C, ID, OD, KR, KC, STR, PAD, LABEL)            \
+  static void BM_ConvFloatFwdSYCL_##LABEL(int iters) {                         \
+    BM_ConvFloatOnDevice(iters, BS, R, C, ID, OD, KR, KC, CONV_OP_FORWARD, 1,  \
+                         STR, PAD, "sycl", DT_FLOAT,                           \
+                         strings::StrCat(BS, "_", R, "_", C, "_", ID, "_", OD, \
+                                         "_", KR, "_", KC, "_", STR, "_", PAD, \
+                                         "_f_sycl"));                          \
+  }                                                                            \
+  static void BM_ConvFloatBkInSYCL_##LABEL(int iters) {                        \
+    BM_ConvFloatOnDevice(iters, BS, R, C, ID, OD, KR, KC,                      \
+                         CONV_OP_BACKPROP_INPUT, 1, STR, PAD, "sycl",          \
+                         DT_FLOAT,                                             \
+                         strings::StrCat(BS, "_", R, "_", C, "_", ID, "_", OD, \
+                                         "_", KR, "_", KC, "_", STR, "_", PAD, \
+                                         "_sycl"));                            \
+  }                                                                            \
+  static void BM_ConvFloatBkFilterSYCL_##LABEL(int iters) {                    \
+    BM_ConvFloatOnDevice(iters, BS, R, C, ID, OD, KR, KC,                      \
+                         CONV_OP_BACKPROP_FILTER, 1, STR, PAD, "sycl",         \
+                         DT_FLOAT,                                             \
+                         strings::StrCat(BS, "_", R, "_", C, "_", ID, "_", OD, \
+                                         "_", KR, "_", KC, "_", STR, "_", PAD, \
+                                         "_sycl"));                            \
+  }                                                                            \
+  BENCHMARK(BM_ConvFloatFwdSYCL_##LABEL);                                      \
+  BENCHMARK(BM_ConvFloatBkInSYCL_##LABEL);                                     \
+  BENCHMARK(BM_ConvFloatBkFilterSYCL_##LABEL)
+
+BM_ConvFloatSYCL(32, 8, 8, 2048, 192, 1, 1, 1, SAME, conv3);
+BM_ConvFloatSYCL(32, 17, 17, 192, 192, 3, 3, 2, VALID, conv12);
+BM_ConvFloatSYCL(32, 17, 17, 192, 192, 3, 3, 1, SAME, conv13);
+BM_ConvFloatSYCL(32, 35, 35, 48, 64, 5, 5, 1, SAME, conv46);
+BM_ConvFloatSYCL(32, 73, 73, 64, 192, 3, 3, 1, VALID, conv52);
+BM_ConvFloatSYCL(32, 147, 147, 24, 64, 1, 1, 1, VALID, conv54);
+BM_ConvFloatSYCL(32, 112, 112, 3, 64, 3, 3, 2, SAME, first_layer);
+#endif  // TENSORFLOW_USE_SYCL
+
 namespace {
 
 enum DEPTHWISE_CONV_OP {
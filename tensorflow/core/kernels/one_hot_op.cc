@@ -34,11 +34,90 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/util/overflow.h"
+#ifdef TENSORFLOW_USE_SYCL
+#include "tensorflow/core/common_runtime/sycl/sycl_util.h"
+#endif  // TENSORFLOW_USE_SYCL
 
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
+#ifdef TENSORFLOW_USE_SYCL
+typedef Eigen::SyclDevice SYCLDevice;
+
+// Eigen does not pass the tensors captured by a generator to SYCL kernels,
+// so OneGenerator cannot run there.  Expects one thread per element of the
+// [prefix, depth, suffix] output.
+template <typename T, typename TI>
+class OneHotSYCL {
+  using write_accessor = SYCLTensorAccessor<cl::sycl::access::mode::write>;
+  using read_accessor = SYCLTensorAccessor<cl::sycl::access::mode::read>;
+
+ public:
+  OneHotSYCL(const read_accessor indices, const read_accessor on_value,
+             const read_accessor off_value, write_accessor output,
+             int64 depth, int64 suffix_dim_size)
+      : indices_accessor_(indices),
+        on_value_accessor_(on_value),
+        off_value_accessor_(off_value),
+        output_accessor_(output),
+        depth_(depth),
+        suffix_dim_size_(suffix_dim_size) {}
+  void operator()(cl::sycl::item<1> item) {
+    const TI* indices_data = indices_accessor_.template get<TI>();
+    T* output_data = output_accessor_.template get<T>();
+
+    const int64 index = item.get_linear_id();
+    const int64 suffix = index % suffix_dim_size_;
+    const int64 prefix_depth = index / suffix_dim_size_;
+    const int64 d = prefix_depth % depth_;
+    const int64 prefix = prefix_depth / depth_;
+    const int64 hot = indices_data[prefix * suffix_dim_size_ + suffix];
+    output_data[index] = hot == d ? *on_value_accessor_.template get<T>()
+                                  : *off_value_accessor_.template get<T>();
+  }
+
+ private:
+  const read_accessor indices_accessor_;
+  const read_accessor on_value_accessor_;
+  const read_accessor off_value_accessor_;
+  write_accessor output_accessor_;
+  const int64 depth_;
+  const int64 suffix_dim_size_;
+};
+
+namespace functor {
+
+template <typename T, typename TI>
+struct OneHot<SYCLDevice, T, TI> {
+  static void Compute(const SYCLDevice& d,
+                      const typename TTypes<TI>::ConstMatrix& indices,
+                      const typename TTypes<T>::ConstScalar& on_value,
+                      const typename TTypes<T>::ConstScalar& off_value,
+                      typename TTypes<T, 3>::Tensor* output) {
+    const int64 depth = output->dimension(1);
+    const int64 suffix_dim_size = output->dimension(2);
+    d.sycl_queue().submit([&](cl::sycl::handler& cgh) {
+      auto indices_access = GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+          d, indices.data(), cgh);
+      auto on_value_access =
+          GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+              d, on_value.data(), cgh);
+      auto off_value_access =
+          GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+              d, off_value.data(), cgh);
+      auto output_access = GetSYCLTensorAccessor<cl::sycl::access::mode::write>(
+          d, output->data(), cgh);
+      OneHotSYCL<T, TI> functor(indices_access, on_value_access,
+                                off_value_access, output_access, depth,
+                                suffix_dim_size);
+      cgh.parallel_for(cl::sycl::range<1>(output->size()), functor);
+    });
+  }
+};
+
+}  // namespace functor
+#endif  // TENSORFLOW_USE_SYCL
 
 template <typename Device, typename T, typename TI>
 class OneHotOp : public OpKernel {
@@ -190,4 +269,25 @@ TF_CALL_int64(REGISTER_ONE_HOT_GPU);
 
 #endif  // GOOGLE_CUDA
 
+#ifdef TENSORFLOW_USE_SYCL
+#define REGISTER_ONE_HOT_SYCL_INDEX(type, index_type)           \
+  REGISTER_KERNEL_BUILDER(Name("OneHot")                        \
+                              .Device(DEVICE_SYCL)              \
+                              .TypeConstraint<index_type>("TI") \
+                              .TypeConstraint<type>("T")        \
+                              .HostMemory("depth"),             \
+                          OneHotOp<SYCLDevice, type, index_type>);
+
+#define REGISTER_ONE_HOT_SYCL(type)         \
+  REGISTER_ONE_HOT_SYCL_INDEX(type, uint8); \
+  REGISTER_ONE_HOT_SYCL_INDEX(type, int32); \
+  REGISTER_ONE_HOT_SYCL_INDEX(type, int64);
+
+TF_CALL_SYCL_NUMBER_TYPES(REGISTER_ONE_HOT_SYCL);
+
+#undef REGISTER_ONE_HOT_SYCL_INDEX
+#undef REGISTER_ONE_HOT_SYCL
+
+#endif  // TENSORFLOW_USE_SYCL
+
 }  // namespace tensorflow
@@ -0,0 +1,487 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// DEVICE_OPENCL kernels for MatMul, BiasAdd and Relu on float tensors, and
+// for the BlackScholesPrice and MonteCarloPathSim pricing ops.
+//
+// Inputs and outputs are cl_mem buffers of OpenCLAllocator, so a chain such as
+// MatMul -> BiasAdd -> Relu placed on /device:OPENCL:0 is computed without any
+// host round trip: each op only enqueues its kernels on the in-order command
+// queue of clMatMulRuntime and returns. The MatMul, BiasAdd and Relu kernels
+// belong to the embedded kClMatMulProgram, opencl-compiler/kernels/GEMM.c, the
+// pricing kernels to kClPricingProgram,
+// opencl-finan-benchmk/kernel/pricingOpsKernels.cl.
+
+#include <algorithm>
+
+#include "tensorflow/core/common_runtime/opencl/opencl_util.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/matmul_cl_runtime.h"
+#include "tensorflow/core/kernels/pricing_ops.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/tensor_format.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Work-group edge of MatMul_NN_2D_Tiled_Fp32 and MatTrans_2D_Tiled_Fp32
+constexpr size_t kTileSize = 16;
+
+// Element counts and matrix dimensions are passed to the kernels as uint
+constexpr int64 kMaxKernelElements = 0xffffffffLL;
+
+size_t RoundUpToTile(size_t n) {
+  return (n + kTileSize - 1) / kTileSize * kTileSize;
+}
+
+Status CLStatus(cl_int err, const char* what) {
+  if (err == CL_SUCCESS) return Status::OK();
+  return errors::Internal(what, " failed with OpenCL error ", err);
+}
+
+cl_int SetKernelArgs(cl_kernel kernel, cl_uint index) { return CL_SUCCESS; }
+
+// Sets the arguments of kernel from index on, in order
+template <typename T, typename... Args>
+cl_int SetKernelArgs(cl_kernel kernel, cl_uint index, const T& value,
+                     const Args&... args) {
+  const cl_int err = clSetKernelArg(kernel, index, sizeof(T), &value);
+  if (err != CL_SUCCESS) return err;
+  return SetKernelArgs(kernel, index + 1, args...);
+}
+
+// A kernel object of an embedded program, kClMatMulProgram by default,
+// borrowed from clMatMulRuntime for the lifetime of this object. Arguments are
+// captured at enqueue time, so the kernel can be handed back as soon as it has
+// been enqueued.
+class ScopedCLKernel {
+ public:
+  ScopedCLKernel(clMatMulRuntime* runtime, const char* name,
+                 const char* program = kClMatMulProgram)
+      : runtime_(runtime),
+        program_(runtime->program(program, "-cl-fast-relaxed-math")),
+        name_(name),
+        kernel_(runtime->acquireKernel(program_, name)) {}
+
+  ~ScopedCLKernel() { runtime_->releaseKernel(program_, name_, kernel_); }
+
+  cl_kernel get() const { return kernel_; }
+
+  Status status() const {
+    if (kernel_ != NULL) return Status::OK();
+    return errors::Unavailable("OpenCL kernel ", name_, " is not available");
+  }
+
+ private:
+  clMatMulRuntime* runtime_;  // not owned
+  cl_program program_;        // owned by runtime_
+  const string name_;
+  cl_kernel kernel_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ScopedCLKernel);
+};
+
+// Enqueues a one work-item per element kernel
+cl_int Enqueue1D(clMatMulRuntime* runtime, cl_kernel kernel,
+                 size_t num_elements) {
+  return clEnqueueNDRangeKernel(runtime->queue(), kernel, 1, NULL,
+                                &num_elements, NULL, 0, NULL, NULL);
+}
+
+// Sets the buffers of the option parameters of a pricing kernel, in input
+// order from index on
+cl_int SetOptionArgs(cl_kernel kernel, cl_uint index, OpKernelContext* ctx) {
+  for (int i = 0; i < kNumOptionInputs; ++i) {
+    const cl_int err = SetKernelArgs(kernel, index + i,
+                                     GetCLBuffer(ctx->input(i)));
+    if (err != CL_SUCCESS) return err;
+  }
+  return CL_SUCCESS;
+}
+
+}  // namespace
+
+class MatMulOpenCLOp : public OpKernel {
+ public:
+  explicit MatMulOpenCLOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("transpose_a", &transpose_a_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("transpose_b", &transpose_b_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& a = ctx->input(0);
+    const Tensor& b = ctx->input(1);
+
+    // Check that the dimensions of the two matrices are valid.
+    OP_REQUIRES(ctx, TensorShapeUtils::IsMatrix(a.shape()),
+                errors::InvalidArgument("In[0] is not a matrix"));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsMatrix(b.shape()),
+                errors::InvalidArgument("In[1] is not a matrix"));
+    const int64 m = a.dim_size(transpose_a_ ? 1 : 0);
+    const int64 k = a.dim_size(transpose_a_ ? 0 : 1);
+    const int64 n = b.dim_size(transpose_b_ ? 0 : 1);
+    OP_REQUIRES(ctx, k == b.dim_size(transpose_b_ ? 1 : 0),
+                errors::InvalidArgument(
+                    "Matrix size-incompatible: In[0]: ", a.shape().DebugString(),
+                    ", In[1]: ", b.shape().DebugString()));
+    OP_REQUIRES(ctx,
+                std::max({m * k, k * n, m * n}) <= kMaxKernelElements,
+                errors::InvalidArgument(
+                    "OpenCL MatMul operands are limited to 2^32 elements: "
+                    "In[0]: ", a.shape().DebugString(),
+                    ", In[1]: ", b.shape().DebugString()));
+
+    Tensor* out = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({m, n}), &out));
+    if (out->NumElements() == 0) {
+      return;
+    }
+
+    clMatMulRuntime* runtime = clMatMulRuntime::Global();
+    cl_mem out_buffer = GetCLBuffer(*out);
+    if (k == 0) {
+      // [m, 0] x [0, n], the output is all zeros
+      const float zero = 0.0f;
+      OP_REQUIRES_OK(
+          ctx, CLStatus(clEnqueueFillBuffer(runtime->queue(), out_buffer,
+                                            &zero, sizeof(zero), 0,
+                                            out->TotalBytes(), 0, NULL, NULL),
+                        "MatMul zero fill"));
+      return;
+    }
+
+    ScopedCLKernel gemm(runtime, "MatMul_NN_2D_Tiled_Fp32");
+    OP_REQUIRES_OK(ctx, gemm.status());
+
+    // Transposed operands are turned around into pooled scratch buffers. They
+    // are handed back right after the GEMM is enqueued, the in-order queue
+    // runs the GEMM before any later use of the buffers.
+    clBufferPool* pool = runtime->bufferPool();
+    cl_mem a_buffer = GetCLBuffer(a);
+    cl_mem b_buffer = GetCLBuffer(b);
+    cl_mem a_scratch = NULL;
+    cl_mem b_scratch = NULL;
+    Status s;
+    if (transpose_a_) {
+      s = Transpose(runtime, k, m, a_buffer, &a_scratch);
+      a_buffer = a_scratch;
+    }
+    if (s.ok() && transpose_b_) {
+      s = Transpose(runtime, n, k, b_buffer, &b_scratch);
+      b_buffer = b_scratch;
+    }
+    if (s.ok()) {
+      const cl_uint cl_m = m;
+      const cl_uint cl_k = k;
+      const cl_uint cl_n = n;
+      cl_int err = SetKernelArgs(gemm.get(), 0, cl_m, cl_k, cl_n, a_buffer,
+                                 cl_k, b_buffer, cl_n, out_buffer, cl_n);
+      if (err == CL_SUCCESS) {
+        const size_t global[2] = {RoundUpToTile(m), RoundUpToTile(n)};
+        const size_t local[2] = {kTileSize, kTileSize};
+        err = clEnqueueNDRangeKernel(runtime->queue(), gemm.get(), 2, NULL,
+                                     global, local, 0, NULL, NULL);
+      }
+      s = CLStatus(err, "MatMul");
+    }
+    pool->put(a_scratch);
+    pool->put(b_scratch);
+    OP_REQUIRES_OK(ctx, s);
+  }
+
+ private:
+  // Enqueues *dst (cols x rows) = transpose of src (rows x cols), with *dst
+  // taken from the buffer pool
+  static Status Transpose(clMatMulRuntime* runtime, int64 rows, int64 cols,
+                          cl_mem src, cl_mem* dst) {
+    ScopedCLKernel trans(runtime, "MatTrans_2D_Tiled_Fp32");
+    TF_RETURN_IF_ERROR(trans.status());
+    *dst = runtime->bufferPool()->get(CL_MEM_READ_WRITE,
+                                      sizeof(float) * rows * cols);
+    if (*dst == NULL) {
+      return errors::ResourceExhausted("OOM allocating OpenCL transpose of ",
+                                       rows, "x", cols, " floats");
+    }
+    const cl_uint cl_rows = rows;
+    const cl_uint cl_cols = cols;
+    cl_int err = SetKernelArgs(trans.get(), 0, cl_rows, cl_cols, src, *dst);
+    if (err == CL_SUCCESS) {
+      const size_t global[2] = {RoundUpToTile(cols), RoundUpToTile(rows)};
+      const size_t local[2] = {kTileSize, kTileSize};
+      err = clEnqueueNDRangeKernel(runtime->queue(), trans.get(), 2, NULL,
+                                   global, local, 0, NULL, NULL);
+    }
+    return CLStatus(err, "MatMul transpose");
+  }
+
+  bool transpose_a_;
+  bool transpose_b_;
+};
+
+class BiasAddOpenCLOp : public OpKernel {
+ public:
+  explicit BiasAddOpenCLOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    string data_format;
+    if (ctx->GetAttr("data_format", &data_format).ok()) {
+      OP_REQUIRES(ctx, FormatFromString(data_format, &data_format_),
+                  errors::InvalidArgument("Invalid data format"));
+    } else {
+      data_format_ = FORMAT_NHWC;
+    }
+    OP_REQUIRES(ctx, data_format_ == FORMAT_NHWC,
+                errors::Unimplemented(
+                    "The OpenCL BiasAdd only supports the NHWC data format"));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& input = ctx->input(0);
+    const Tensor& bias = ctx->input(1);
+
+    OP_REQUIRES(ctx, TensorShapeUtils::IsMatrixOrHigher(input.shape()),
+                errors::InvalidArgument("Input tensor must be at least 2D: ",
+                                        input.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(bias.shape()),
+                errors::InvalidArgument("Biases must be 1D: ",
+                                        bias.shape().DebugString()));
+    OP_REQUIRES(
+        ctx, bias.shape().dim_size(0) == input.shape().dim_size(input.dims() - 1),
+        errors::InvalidArgument(
+            "Must provide as many biases as the last dimension "
+            "of the input tensor: ",
+            bias.shape().DebugString(), " vs. ", input.shape().DebugString()));
+    OP_REQUIRES(ctx, input.NumElements() <= kMaxKernelElements,
+                errors::InvalidArgument(
+                    "OpenCL BiasAdd input is limited to 2^32 elements: ",
+                    input.shape().DebugString()));
+
+    // BiasAdd_1D_Fp32 may write in place
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->forward_input_or_allocate_output(
+                            {0}, 0, input.shape(), &output));
+    if (input.NumElements() == 0) {
+      return;
+    }
+
+    clMatMulRuntime* runtime = clMatMulRuntime::Global();
+    ScopedCLKernel kernel(runtime, "BiasAdd_1D_Fp32");
+    OP_REQUIRES_OK(ctx, kernel.status());
+    const cl_uint num_elements = input.NumElements();
+    const cl_uint channels = bias.NumElements();
+    cl_int err = SetKernelArgs(kernel.get(), 0, num_elements, channels,
+                               GetCLBuffer(input), GetCLBuffer(bias),
+                               GetCLBuffer(*output));
+    if (err == CL_SUCCESS) {
+      err = Enqueue1D(runtime, kernel.get(), num_elements);
+    }
+    OP_REQUIRES_OK(ctx, CLStatus(err, "BiasAdd"));
+  }
+
+ private:
+  TensorFormat data_format_;
+};
+
+class ReluOpenCLOp : public OpKernel {
+ public:
+  explicit ReluOpenCLOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& input = ctx->input(0);
+    OP_REQUIRES(ctx, input.NumElements() <= kMaxKernelElements,
+                errors::InvalidArgument(
+                    "OpenCL Relu input is limited to 2^32 elements: ",
+                    input.shape().DebugString()));
+
+    // Relu_1D_Fp32 may write in place
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->forward_input_or_allocate_output(
+                            {0}, 0, input.shape(), &output));
+    if (input.NumElements() == 0) {
+      return;
+    }
+
+    clMatMulRuntime* runtime = clMatMulRuntime::Global();
+    ScopedCLKernel kernel(runtime, "Relu_1D_Fp32");
+    OP_REQUIRES_OK(ctx, kernel.status());
+    const cl_uint num_elements = input.NumElements();
+    cl_int err = SetKernelArgs(kernel.get(), 0, num_elements,
+                               GetCLBuffer(input), GetCLBuffer(*output));
+    if (err == CL_SUCCESS) {
+      err = Enqueue1D(runtime, kernel.get(), num_elements);
+    }
+    OP_REQUIRES_OK(ctx, CLStatus(err, "Relu"));
+  }
+};
+
+class BlackScholesPriceOpenCLOp : public OpKernel {
+ public:
+  explicit BlackScholesPriceOpenCLOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, GetOptionType(ctx, &is_call_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    OP_REQUIRES_OK(ctx, ValidateOptionInputs(ctx));
+    const Tensor& spot = ctx->input(0);
+    OP_REQUIRES(ctx, spot.NumElements() <= kMaxKernelElements,
+                errors::InvalidArgument(
+                    "OpenCL BlackScholesPrice is limited to 2^32 options: ",
+                    spot.shape().DebugString()));
+
+    Tensor* price = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, spot.shape(), &price));
+    if (spot.NumElements() == 0) {
+      return;
+    }
+
+    clMatMulRuntime* runtime = clMatMulRuntime::Global();
+    ScopedCLKernel kernel(runtime, "BlackScholes_1D_Fp32", kClPricingProgram);
+    OP_REQUIRES_OK(ctx, kernel.status());
+    const cl_uint num_options = spot.NumElements();
+    const cl_int type = is_call_ ? 0 : 1;
+    cl_int err = SetKernelArgs(kernel.get(), 0, num_options, type);
+    if (err == CL_SUCCESS) {
+      err = SetOptionArgs(kernel.get(), 2, ctx);
+    }
+    if (err == CL_SUCCESS) {
+      err = SetKernelArgs(kernel.get(), 2 + kNumOptionInputs,
+                          GetCLBuffer(*price));
+    }
+    if (err == CL_SUCCESS) {
+      err = Enqueue1D(runtime, kernel.get(), num_options);
+    }
+    OP_REQUIRES_OK(ctx, CLStatus(err, "BlackScholesPrice"));
+  }
+
+ private:
+  bool is_call_;
+};
+
+class MonteCarloPathSimOpenCLOp : public OpKernel {
+ public:
+  explicit MonteCarloPathSimOpenCLOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, GetOptionType(ctx, &is_call_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("num_paths", &num_paths_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("num_steps", &num_steps_));
+    OP_REQUIRES_OK(ctx, generator_.Init(ctx));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    OP_REQUIRES_OK(ctx, ValidateOptionInputs(ctx));
+    const Tensor& spot = ctx->input(0);
+    const int64 num_options = spot.NumElements();
+    const int64 num_groups = (num_paths_ + kGroupSize - 1) / kGroupSize;
+    OP_REQUIRES(ctx, num_options * num_groups <= kMaxKernelElements,
+                errors::InvalidArgument(
+                    "OpenCL MonteCarloPathSim is limited to 2^32 groups of ",
+                    kGroupSize, " paths: ", spot.shape().DebugString(),
+                    " options of ", num_paths_, " paths"));
+
+    Tensor* price = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, spot.shape(), &price));
+    if (num_options == 0) {
+      return;
+    }
+
+    clMatMulRuntime* runtime = clMatMulRuntime::Global();
+    ScopedCLKernel paths(runtime, "MonteCarlo_Paths_Fp32", kClPricingProgram);
+    OP_REQUIRES_OK(ctx, paths.status());
+    ScopedCLKernel mean(runtime, "MonteCarlo_Mean_Fp32", kClPricingProgram);
+    OP_REQUIRES_OK(ctx, mean.status());
+
+    // Payoff sums of every work-group of MonteCarlo_Paths_Fp32. The buffer is
+    // handed back once both kernels are enqueued, the in-order queue runs
+    // them before any later use of it.
+    clBufferPool* pool = runtime->bufferPool();
+    cl_mem partial_sums = pool->get(CL_MEM_READ_WRITE,
+                                    sizeof(float) * num_options * num_groups);
+    OP_REQUIRES(ctx, partial_sums != NULL,
+                errors::ResourceExhausted(
+                    "OOM allocating OpenCL Monte-Carlo sums of ", num_options,
+                    "x", num_groups, " floats"));
+
+    random::PhiloxRandom::ResultType counter;
+    random::PhiloxRandom::Key key;
+    ReserveMonteCarloStream(&generator_, &counter, &key);
+    cl_uint4 cl_counter;
+    for (int i = 0; i < 4; ++i) cl_counter.s[i] = counter[i];
+    cl_uint2 cl_key;
+    for (int i = 0; i < 2; ++i) cl_key.s[i] = key[i];
+
+    const cl_uint cl_num_options = num_options;
+    const cl_uint cl_num_groups = num_groups;
+    const cl_uint cl_num_paths = num_paths_;
+    const cl_uint cl_num_steps = num_steps_;
+    const cl_int type = is_call_ ? 0 : 1;
+    cl_int err = SetKernelArgs(paths.get(), 0, cl_num_paths, cl_num_steps,
+                               type);
+    if (err == CL_SUCCESS) {
+      err = SetOptionArgs(paths.get(), 3, ctx);
+    }
+    if (err == CL_SUCCESS) {
+      err = SetKernelArgs(paths.get(), 3 + kNumOptionInputs, cl_counter,
+                          cl_key, partial_sums);
+    }
+    if (err == CL_SUCCESS) {
+      const size_t global[2] = {static_cast<size_t>(num_groups * kGroupSize),
+                                static_cast<size_t>(num_options)};
+      const size_t local[2] = {kGroupSize, 1};
+      err = clEnqueueNDRangeKernel(runtime->queue(), paths.get(), 2, NULL,
+                                   global, local, 0, NULL, NULL);
+    }
+    if (err == CL_SUCCESS) {
+      err = SetKernelArgs(mean.get(), 0, cl_num_options, cl_num_groups,
+                          cl_num_paths, GetCLBuffer(ctx->input(2)),
+                          GetCLBuffer(ctx->input(5)), partial_sums,
+                          GetCLBuffer(*price));
+    }
+    if (err == CL_SUCCESS) {
+      err = Enqueue1D(runtime, mean.get(), num_options);
+    }
+    pool->put(partial_sums);
+    OP_REQUIRES_OK(ctx, CLStatus(err, "MonteCarloPathSim"));
+  }
+
+ private:
+  // MC_GROUP_SIZE of MonteCarlo_Paths_Fp32
+  static constexpr size_t kGroupSize = 64;
+
+  bool is_call_;
+  int32 num_paths_;
+  int32 num_steps_;
+  GuardedPhiloxRandom generator_;
+};
+
+constexpr size_t MonteCarloPathSimOpenCLOp::kGroupSize;
+
+REGISTER_KERNEL_BUILDER(
+    Name("MatMul").Device(DEVICE_OPENCL).TypeConstraint<float>("T"),
+    MatMulOpenCLOp);
+REGISTER_KERNEL_BUILDER(
+    Name("BiasAdd").Device(DEVICE_OPENCL).TypeConstraint<float>("T"),
+    BiasAddOpenCLOp);
+REGISTER_KERNEL_BUILDER(
+    Name("Relu").Device(DEVICE_OPENCL).TypeConstraint<float>("T"),
+    ReluOpenCLOp);
+REGISTER_KERNEL_BUILDER(Name("BlackScholesPrice").Device(DEVICE_OPENCL),
+                        BlackScholesPriceOpenCLOp);
+REGISTER_KERNEL_BUILDER(Name("MonteCarloPathSim").Device(DEVICE_OPENCL),
+                        MonteCarloPathSimOpenCLOp);
+
+}  // namespace tensorflow
@@ -20,6 +20,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_POOLING_OP_3D_SYCL_H_
 #define TENSORFLOW_CORE_KERNELS_POOLING_OP_3D_SYCL_H_
 
+#include "tensorflow/core/common_runtime/sycl/sycl_util.h"
 #include "tensorflow/core/kernels/pooling_ops_3d.h"
 
 namespace tensorflow {
@@ -113,12 +114,8 @@ struct SYCL3DPoolParams {
 // copied into that output element.
 template <typename T>
 class MaxPool3DSYCL {
-  using write_accessor =
-      cl::sycl::accessor<uint8_t, 1, cl::sycl::access::mode::write,
-                         cl::sycl::access::target::global_buffer>;
-  using read_accessor =
-      cl::sycl::accessor<uint8_t, 1, cl::sycl::access::mode::read,
-                         cl::sycl::access::target::global_buffer>;
+  using write_accessor = SYCLTensorAccessor<cl::sycl::access::mode::write>;
+  using read_accessor = SYCLTensorAccessor<cl::sycl::access::mode::read>;
 
  public:
   MaxPool3DSYCL(const int depth, const int batch, const int in_planes,
@@ -134,8 +131,8 @@ class MaxPool3DSYCL {
         input_accessor_(input_accessor),
         output_accessor_(output_accessor) {}
   void operator()(cl::sycl::item<1> item) {
-    T* input_data = ConvertToActualTypeSycl(T, input_accessor_);
-    T* output_data = ConvertToActualTypeSycl(T, output_accessor_);
+    T* input_data = input_accessor_.template get<T>();
+    T* output_data = output_accessor_.template get<T>();
 
     int index = item.get_linear_id();
     int n = index;
@@ -194,16 +191,11 @@ struct LaunchPoolingOp<SYCLDevice, T, MAX> {
 
     const int num_threads = output->NumElements();
 
-    auto input_buffer =
-        device.get_sycl_buffer(tensor_in.template flat<T>().data());
-    auto output_buffer =
-        device.get_sycl_buffer(output->template flat<T>().data());
-
     device.sycl_queue().submit([&](cl::sycl::handler& cgh) {
-      auto input_access =
-          input_buffer.template get_access<cl::sycl::access::mode::read>(cgh);
-      auto output_access =
-          output_buffer.template get_access<cl::sycl::access::mode::write>(cgh);
+      auto input_access = GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+          device, tensor_in.template flat<T>().data(), cgh);
+      auto output_access = GetSYCLTensorAccessor<cl::sycl::access::mode::write>(
+          device, output->template flat<T>().data(), cgh);
       MaxPool3DSYCL<T> max_pool(depth, batch, in_planes, in_rows, in_cols,
                                 out_planes, out_rows, out_cols, window, stride,
                                 padding, input_access, output_access);
@@ -224,12 +216,8 @@ struct LaunchPoolingOp<SYCLDevice, T, MAX> {
 // error should be propagated back to the corresponding backprop element.
 template <typename T>
 class MaxPool3DGradSYCL {
-  using write_accessor =
-      cl::sycl::accessor<uint8_t, 1, cl::sycl::access::mode::write,
-                         cl::sycl::access::target::global_buffer>;
-  using read_accessor =
-      cl::sycl::accessor<uint8_t, 1, cl::sycl::access::mode::read,
-                         cl::sycl::access::target::global_buffer>;
+  using write_accessor = SYCLTensorAccessor<cl::sycl::access::mode::write>;
+  using read_accessor = SYCLTensorAccessor<cl::sycl::access::mode::read>;
 
  public:
   MaxPool3DGradSYCL(const int depth, const int batch, const int in_planes,
@@ -249,10 +237,10 @@ class MaxPool3DGradSYCL {
         input_backprop_accessor_(input_backprop_accessor),
         output_backprop_accessor_(output_backprop_accessor) {}
   void operator()(cl::sycl::item<1> item) {
-    T* input_data = ConvertToActualTypeSycl(T, input_data_accessor_);
-    T* output_data = ConvertToActualTypeSycl(T, output_data_accessor_);
-    T* input_backprop = ConvertToActualTypeSycl(T, input_backprop_accessor_);
-    T* output_backprop = ConvertToActualTypeSycl(T, output_backprop_accessor_);
+    T* input_data = input_data_accessor_.template get<T>();
+    T* output_data = output_data_accessor_.template get<T>();
+    T* input_backprop = input_backprop_accessor_.template get<T>();
+    T* output_backprop = output_backprop_accessor_.template get<T>();
 
     const int index = item.get_linear_id();
     T output_value = 0;
@@ -360,28 +348,19 @@ struct LaunchMaxPooling3dGradOp<SYCLDevice, T> {
 
     const int output_size = output->NumElements();
 
-    auto input_data_buffer =
-        device.get_sycl_buffer(tensor_in.template flat<T>().data());
-    auto output_data_buffer =
-        device.get_sycl_buffer(tensor_out.template flat<T>().data());
-    auto input_backprop_buffer =
-        device.get_sycl_buffer(out_backprop.template flat<T>().data());
-    auto output_backprop_buffer =
-        device.get_sycl_buffer(output->template flat<T>().data());
-
     device.sycl_queue().submit([&](cl::sycl::handler& cgh) {
       auto input_data_access =
-          input_data_buffer.template get_access<cl::sycl::access::mode::read>(
-              cgh);
+          GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+              device, tensor_in.template flat<T>().data(), cgh);
       auto output_data_access =
-          output_data_buffer.template get_access<cl::sycl::access::mode::read>(
-              cgh);
+          GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+              device, tensor_out.template flat<T>().data(), cgh);
       auto input_backprop_access =
-          input_backprop_buffer
-              .template get_access<cl::sycl::access::mode::read>(cgh);
+          GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+              device, out_backprop.template flat<T>().data(), cgh);
       auto output_backprop_access =
-          output_backprop_buffer
-              .template get_access<cl::sycl::access::mode::write>(cgh);
+          GetSYCLTensorAccessor<cl::sycl::access::mode::write>(
+              device, output->template flat<T>().data(), cgh);
       MaxPool3DGradSYCL<T> max_pool(
           depth, batch, in_planes, in_rows, in_cols, out, window, stride,
           padding, input_data_access, output_data_access, input_backprop_access,
@@ -401,12 +380,8 @@ struct LaunchMaxPooling3dGradOp<SYCLDevice, T> {
 // pass through to the output backprop tensor.
 template <typename T>
 class MaxPool3DGradGradSYCL {
-  using write_accessor =
-      cl::sycl::accessor<uint8_t, 1, cl::sycl::access::mode::write,
-                         cl::sycl::access::target::global_buffer>;
-  using read_accessor =
-      cl::sycl::accessor<uint8_t, 1, cl::sycl::access::mode::read,
-                         cl::sycl::access::target::global_buffer>;
+  using write_accessor = SYCLTensorAccessor<cl::sycl::access::mode::write>;
+  using read_accessor = SYCLTensorAccessor<cl::sycl::access::mode::read>;
 
  public:
   MaxPool3DGradGradSYCL(const Pool3dParameters& params,
@@ -420,10 +395,10 @@ class MaxPool3DGradGradSYCL {
         input_backprop_accessor_(input_backprop_accessor),
         output_backprop_accessor_(output_backprop_accessor) {}
   void operator()(cl::sycl::item<1> item) {
-    T* input_data = ConvertToActualTypeSycl(T, input_data_accessor_);
-    T* output_data = ConvertToActualTypeSycl(T, output_data_accessor_);
-    T* input_backprop = ConvertToActualTypeSycl(T, input_backprop_accessor_);
-    T* output_backprop = ConvertToActualTypeSycl(T, output_backprop_accessor_);
+    T* input_data = input_data_accessor_.template get<T>();
+    T* output_data = output_data_accessor_.template get<T>();
+    T* input_backprop = input_backprop_accessor_.template get<T>();
+    T* output_backprop = output_backprop_accessor_.template get<T>();
 
     int index = item.get_linear_id();
     int n = index;
@@ -480,28 +455,19 @@ struct LaunchMaxPooling3dGradGradOp<SYCLDevice, T> {
 
     const int num_threads = output->NumElements();
 
-    auto input_data_buffer =
-        device.get_sycl_buffer(tensor_in.template flat<T>().data());
-    auto output_data_buffer =
-        device.get_sycl_buffer(tensor_out.template flat<T>().data());
-    auto input_backprop_buffer =
-        device.get_sycl_buffer(out_backprop.template flat<T>().data());
-    auto output_backprop_buffer =
-        device.get_sycl_buffer(output->template flat<T>().data());
-
     device.sycl_queue().submit([&](cl::sycl::handler& cgh) {
       auto input_data_access =
-          input_data_buffer.template get_access<cl::sycl::access::mode::read>(
-              cgh);
+          GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+              device, tensor_in.template flat<T>().data(), cgh);
       auto output_data_access =
-          output_data_buffer.template get_access<cl::sycl::access::mode::read>(
-              cgh);
+          GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+              device, tensor_out.template flat<T>().data(), cgh);
       auto input_backprop_access =
-          input_backprop_buffer
-              .template get_access<cl::sycl::access::mode::read>(cgh);
+          GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+              device, out_backprop.template flat<T>().data(), cgh);
       auto output_backprop_access =
-          output_backprop_buffer
-              .template get_access<cl::sycl::access::mode::write>(cgh);
+          GetSYCLTensorAccessor<cl::sycl::access::mode::write>(
+              device, output->template flat<T>().data(), cgh);
       MaxPool3DGradGradSYCL<T> functor(
           params, input_data_access, output_data_access, input_backprop_access,
           output_backprop_access);
@@ -519,12 +485,8 @@ struct LaunchMaxPooling3dGradGradOp<SYCLDevice, T> {
 // bigger than the values we are adding and so decrease any errors.
 template <typename T>
 class AvgPool3DSYCL {
-  using write_accessor =
-      cl::sycl::accessor<uint8_t, 1, cl::sycl::access::mode::write,
-                         cl::sycl::access::target::global_buffer>;
-  using read_accessor =
-      cl::sycl::accessor<uint8_t, 1, cl::sycl::access::mode::read,
-                         cl::sycl::access::target::global_buffer>;
+  using write_accessor = SYCLTensorAccessor<cl::sycl::access::mode::write>;
+  using read_accessor = SYCLTensorAccessor<cl::sycl::access::mode::read>;
 
  public:
   AvgPool3DSYCL(const int depth, const int batch, const int in_planes,
@@ -540,8 +502,8 @@ class AvgPool3DSYCL {
         input_accessor_(input_accessor),
         output_accessor_(output_accessor) {}
   void operator()(cl::sycl::item<1> item) {
-    T* input_data = ConvertToActualTypeSycl(T, input_accessor_);
-    T* output_data = ConvertToActualTypeSycl(T, output_accessor_);
+    T* input_data = input_accessor_.template get<T>();
+    T* output_data = output_accessor_.template get<T>();
 
     int index = item.get_linear_id();
     int n = index;
@@ -600,16 +562,11 @@ struct LaunchPoolingOp<SYCLDevice, T, AVG> {
 
     const int num_threads = output->NumElements();
 
-    auto input_buffer =
-        device.get_sycl_buffer(tensor_in.template flat<T>().data());
-    auto output_buffer =
-        device.get_sycl_buffer(output->template flat<T>().data());
-
     device.sycl_queue().submit([&](cl::sycl::handler& cgh) {
-      auto input_access =
-          input_buffer.template get_access<cl::sycl::access::mode::read>(cgh);
-      auto output_access =
-          output_buffer.template get_access<cl::sycl::access::mode::write>(cgh);
+      auto input_access = GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+          device, tensor_in.template flat<T>().data(), cgh);
+      auto output_access = GetSYCLTensorAccessor<cl::sycl::access::mode::write>(
+          device, output->template flat<T>().data(), cgh);
       AvgPool3DSYCL<T> avg_pool(depth, batch, in_planes, in_rows, in_cols,
                                 out_planes, out_rows, out_cols, window, stride,
                                 padding, input_access, output_access);
@@ -630,12 +587,8 @@ struct LaunchPoolingOp<SYCLDevice, T, AVG> {
 // output backprop value.
 template <typename T>
 class AvgPool3DGradSYCL {
-  using write_accessor =
-      cl::sycl::accessor<uint8_t, 1, cl::sycl::access::mode::write,
-                         cl::sycl::access::target::global_buffer>;
-  using read_accessor =
-      cl::sycl::accessor<uint8_t, 1, cl::sycl::access::mode::read,
-                         cl::sycl::access::target::global_buffer>;
+  using write_accessor = SYCLTensorAccessor<cl::sycl::access::mode::write>;
+  using read_accessor = SYCLTensorAccessor<cl::sycl::access::mode::read>;
 
  public:
   AvgPool3DGradSYCL(const int depth, const int batch, const int in_planes,
@@ -651,8 +604,8 @@ class AvgPool3DGradSYCL {
         input_backprop_accessor_(input_backprop_accessor),
         output_backprop_accessor_(output_backprop_accessor) {}
   void operator()(cl::sycl::item<1> item) {
-    T* input_backprop = ConvertToActualTypeSycl(T, input_backprop_accessor_);
-    T* output_backprop = ConvertToActualTypeSycl(T, output_backprop_accessor_);
+    T* input_backprop = input_backprop_accessor_.template get<T>();
+    T* output_backprop = output_backprop_accessor_.template get<T>();
 
     const int index = item.get_linear_id();
     int n = index;
@@ -732,18 +685,13 @@ struct LaunchAvgPooling3dGradOp<SYCLDevice, T> {
 
     const int num_threads = output->NumElements();
 
-    auto input_backprop_buffer =
-        device.get_sycl_buffer(out_backprop.template flat<T>().data());
-    auto output_backprop_buffer =
-        device.get_sycl_buffer(output->template flat<T>().data());
-
     device.sycl_queue().submit([&](cl::sycl::handler& cgh) {
       auto input_backprop_access =
-          input_backprop_buffer
-              .template get_access<cl::sycl::access::mode::read>(cgh);
+          GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+              device, out_backprop.template flat<T>().data(), cgh);
       auto output_backprop_access =
-          output_backprop_buffer
-              .template get_access<cl::sycl::access::mode::write>(cgh);
+          GetSYCLTensorAccessor<cl::sycl::access::mode::write>(
+              device, output->template flat<T>().data(), cgh);
       AvgPool3DGradSYCL<T> functor(
           depth, batch, in_planes, in_rows, in_cols, output_shape, window,
           stride, padding, input_backprop_access, output_backprop_access);
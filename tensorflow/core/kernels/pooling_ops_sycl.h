@@ -0,0 +1,114 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if !TENSORFLOW_USE_SYCL
+#error This file must only be included when building with SYCL support
+#endif
+
+#ifndef TENSORFLOW_CORE_KERNELS_POOLING_OPS_SYCL_H_
+#define TENSORFLOW_CORE_KERNELS_POOLING_OPS_SYCL_H_
+
+#include <array>
+
+#include "tensorflow/core/kernels/pooling_ops_3d_sycl.h"
+#include "tensorflow/core/kernels/pooling_ops_common.h"
+
+namespace tensorflow {
+
+// 2D pooling on SYCL devices runs the 3D pooling kernels of
+// pooling_ops_3d_sycl.h on a single plane: an NHWC tensor [N, H, W, C] is
+// viewed as the NDHWC tensor [N, 1, H, W, C], and the window, stride and
+// padding of the plane dimension are 1, 1 and 0.  The views share the
+// buffers of the original tensors.
+namespace sycl_pool2d {
+
+inline TensorShape PlaneShape(const TensorShape& shape) {
+  return TensorShape(
+      {shape.dim_size(0), 1, shape.dim_size(1), shape.dim_size(2),
+       shape.dim_size(3)});
+}
+
+inline Tensor PlaneView(const Tensor& tensor) {
+  Tensor view;
+  CHECK(view.CopyFrom(tensor, PlaneShape(tensor.shape())));
+  return view;
+}
+
+// The 3D SYCL launchers take their arrays in {cols, rows, planes} order.
+inline std::array<int64, 3> WindowArray(const PoolParameters& params) {
+  return {{params.window_cols, params.window_rows, 1}};
+}
+
+inline std::array<int64, 3> StrideArray(const PoolParameters& params) {
+  return {{params.col_stride, params.row_stride, 1}};
+}
+
+inline std::array<int64, 3> PaddingArray(const PoolParameters& params) {
+  return {{params.pad_cols, params.pad_rows, 0}};
+}
+
+inline std::array<int64, 3> OutArray(const PoolParameters& params) {
+  return {{params.out_width, params.out_height, 1}};
+}
+
+}  // namespace sycl_pool2d
+
+// Max or average pooling of the NHWC tensor "tensor_in" into "output".
+template <typename T, PoolingType Type>
+void SpatialPoolSYCL(OpKernelContext* context, const Tensor& tensor_in,
+                     const PoolParameters& params, Padding padding_type,
+                     Tensor* output) {
+  Tensor output_view = sycl_pool2d::PlaneView(*output);
+  LaunchPoolingOp<SYCLDevice, T, Type>::launch(
+      context, sycl_pool2d::PlaneView(tensor_in),
+      sycl_pool2d::WindowArray(params), sycl_pool2d::StrideArray(params),
+      sycl_pool2d::PaddingArray(params), FORMAT_NHWC, padding_type,
+      &output_view);
+}
+
+// Routes each gradient in "out_backprop" to the first maximum of its window
+// in "tensor_in", writing "output" which has the shape of "tensor_in".
+template <typename T>
+void SpatialMaxPoolGradSYCL(OpKernelContext* context, const Tensor& tensor_in,
+                            const Tensor& tensor_out,
+                            const Tensor& out_backprop,
+                            const PoolParameters& params, Tensor* output) {
+  Tensor output_view = sycl_pool2d::PlaneView(*output);
+  LaunchMaxPooling3dGradOp<SYCLDevice, T>::launch(
+      context, sycl_pool2d::PlaneView(tensor_in),
+      sycl_pool2d::PlaneView(tensor_out), sycl_pool2d::PlaneView(out_backprop),
+      sycl_pool2d::WindowArray(params), sycl_pool2d::StrideArray(params),
+      sycl_pool2d::OutArray(params), sycl_pool2d::PaddingArray(params),
+      FORMAT_NHWC, &output_view);
+}
+
+// Spreads each gradient in "out_backprop" evenly over the unpadded part of
+// its window, writing "output" of shape "tensor_in_shape".
+template <typename T>
+void SpatialAvgPoolGradSYCL(OpKernelContext* context,
+                            const TensorShape& tensor_in_shape,
+                            const Tensor& out_backprop,
+                            const PoolParameters& params, Tensor* output) {
+  Tensor output_view = sycl_pool2d::PlaneView(*output);
+  LaunchAvgPooling3dGradOp<SYCLDevice, T>::launch(
+      context, sycl_pool2d::PlaneShape(tensor_in_shape),
+      sycl_pool2d::PlaneView(out_backprop), sycl_pool2d::WindowArray(params),
+      sycl_pool2d::StrideArray(params), sycl_pool2d::OutArray(params),
+      sycl_pool2d::PaddingArray(params), FORMAT_NHWC, &output_view);
+}
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_POOLING_OPS_SYCL_H_
@@ -0,0 +1,209 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// CPU kernels of BlackScholesPrice and MonteCarloPathSim, the analytic and
+// Monte-Carlo engines of opencl-finan-benchmk as graph ops.
+//
+// BlackScholesPrice is a chain of Eigen expressions evaluated on the
+// ThreadPoolDevice, so it is vectorized and split over the intra-op threads
+// like the cwise ops. MonteCarloPathSim shards blocks of paths over the
+// threads; each path only draws its normals, the payoffs of a block are then
+// computed with vectorized Eigen array expressions.
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "third_party/eigen3/Eigen/Core"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "third_party/eigen3/unsupported/Eigen/SpecialFunctions"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/kernels/pricing_ops.h"
+#include "tensorflow/core/lib/random/random_distributions.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+class BlackScholesPriceOp : public OpKernel {
+ public:
+  explicit BlackScholesPriceOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, GetOptionType(ctx, &is_call_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    OP_REQUIRES_OK(ctx, ValidateOptionInputs(ctx));
+    const Tensor& spot_t = ctx->input(0);
+    Tensor* price_t = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, spot_t.shape(), &price_t));
+    if (spot_t.NumElements() == 0) {
+      return;
+    }
+
+    Tensor forward_t, std_dev_t;
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(DT_FLOAT, spot_t.shape(),
+                                           &forward_t));
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(DT_FLOAT, spot_t.shape(),
+                                           &std_dev_t));
+
+    auto spot = spot_t.flat<float>();
+    auto strike = ctx->input(1).flat<float>();
+    auto rate = ctx->input(2).flat<float>();
+    auto dividend = ctx->input(3).flat<float>();
+    auto volatility = ctx->input(4).flat<float>();
+    auto time = ctx->input(5).flat<float>();
+    auto forward = forward_t.flat<float>();
+    auto std_dev = std_dev_t.flat<float>();
+    // Holds d1 until it is overwritten with the price
+    auto price = price_t->flat<float>();
+
+    const CPUDevice& d = ctx->eigen_device<CPUDevice>();
+    forward.device(d) = spot * ((rate - dividend) * time).exp();
+    std_dev.device(d) = volatility * time.sqrt();
+    price.device(d) = (forward / strike).log() / std_dev + std_dev * 0.5f;
+
+    // N(x) = erfc(-x / sqrt(2)) / 2
+    const auto erfc = Eigen::internal::scalar_erfc_op<float>();
+    const float scale = -static_cast<float>(M_SQRT1_2);
+    if (is_call_) {
+      price.device(d) =
+          (-rate * time).exp() * 0.5f *
+          (forward * (price * scale).unaryExpr(erfc) -
+           strike * ((price - std_dev) * scale).unaryExpr(erfc));
+    } else {
+      price.device(d) =
+          (-rate * time).exp() * 0.5f *
+          (strike * ((std_dev - price) * scale).unaryExpr(erfc) -
+           forward * (-price * scale).unaryExpr(erfc));
+    }
+  }
+
+ private:
+  bool is_call_;
+};
+
+class MonteCarloPathSimOp : public OpKernel {
+ public:
+  explicit MonteCarloPathSimOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, GetOptionType(ctx, &is_call_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("num_paths", &num_paths_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("num_steps", &num_steps_));
+    OP_REQUIRES_OK(ctx, generator_.Init(ctx));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    OP_REQUIRES_OK(ctx, ValidateOptionInputs(ctx));
+    const Tensor& spot_t = ctx->input(0);
+    Tensor* price_t = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, spot_t.shape(), &price_t));
+    const int64 num_options = spot_t.NumElements();
+    if (num_options == 0) {
+      return;
+    }
+
+    random::PhiloxRandom::ResultType counter;
+    random::PhiloxRandom::Key key;
+    ReserveMonteCarloStream(&generator_, &counter, &key);
+
+    const float* spot = spot_t.flat<float>().data();
+    const float* strike = ctx->input(1).flat<float>().data();
+    const float* rate = ctx->input(2).flat<float>().data();
+    const float* dividend = ctx->input(3).flat<float>().data();
+    const float* volatility = ctx->input(4).flat<float>().data();
+    const float* time = ctx->input(5).flat<float>().data();
+
+    // Payoff sum of every block of kPathsPerBlock paths of every option
+    const int64 num_blocks = (num_paths_ + kPathsPerBlock - 1) / kPathsPerBlock;
+    std::vector<double> block_sums(num_options * num_blocks);
+
+    const int64 num_paths = num_paths_;
+    const int64 num_steps = num_steps_;
+    const int64 samples_per_path = MonteCarloSamplesPerPath(num_steps);
+    const bool is_call = is_call_;
+    auto DoWork = [&](int64 start, int64 limit) {
+      typedef Eigen::Array<float, Eigen::Dynamic, 1> ArrayXf;
+      random::NormalDistribution<random::PhiloxRandom, float> normal;
+      ArrayXf sum_dw(kPathsPerBlock);
+      ArrayXf value(kPathsPerBlock);
+      for (int64 unit = start; unit < limit; ++unit) {
+        const int64 option = unit / num_blocks;
+        const int64 first_path = (unit % num_blocks) * kPathsPerBlock;
+        const int64 paths = std::min(kPathsPerBlock, num_paths - first_path);
+
+        // The paths of a block use consecutive samples of the stream
+        random::PhiloxRandom gen(counter, key);
+        gen.Skip((option * num_paths + first_path) * samples_per_path);
+        for (int64 p = 0; p < paths; ++p) {
+          float sum = 0.0f;
+          for (int64 step = 0; step < num_steps; step += 4) {
+            const auto dw = normal(&gen);
+            const int64 n = std::min<int64>(4, num_steps - step);
+            for (int64 i = 0; i < n; ++i) sum += dw[i];
+          }
+          sum_dw(p) = sum;
+        }
+
+        // The log of a path moves by drift + diffusion * dw on each step
+        const float vol = volatility[option];
+        const float dt = time[option] / num_steps;
+        const float drift =
+            (rate[option] - dividend[option] - 0.5f * vol * vol) * dt;
+        const float diffusion = vol * std::sqrt(dt);
+        value.head(paths) =
+            spot[option] *
+            (drift * num_steps + diffusion * sum_dw.head(paths)).exp();
+        block_sums[unit] =
+            is_call ? (value.head(paths) - strike[option]).max(0.0f).sum()
+                    : (strike[option] - value.head(paths)).max(0.0f).sum();
+      }
+    };
+    // Philox rounds, Box-Muller and accumulation of every step
+    const int64 cost = kPathsPerBlock * num_steps * 40;
+    auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          num_options * num_blocks, cost, DoWork);
+
+    auto price = price_t->flat<float>();
+    for (int64 option = 0; option < num_options; ++option) {
+      double sum = 0;
+      for (int64 b = 0; b < num_blocks; ++b) {
+        sum += block_sums[option * num_blocks + b];
+      }
+      price(option) = std::exp(-rate[option] * time[option]) * sum / num_paths;
+    }
+  }
+
+ private:
+  static constexpr int64 kPathsPerBlock = 64;
+
+  bool is_call_;
+  int32 num_paths_;
+  int32 num_steps_;
+  GuardedPhiloxRandom generator_;
+};
+
+constexpr int64 MonteCarloPathSimOp::kPathsPerBlock;
+
+REGISTER_KERNEL_BUILDER(Name("BlackScholesPrice").Device(DEVICE_CPU),
+                        BlackScholesPriceOp);
+REGISTER_KERNEL_BUILDER(Name("MonteCarloPathSim").Device(DEVICE_CPU),
+                        MonteCarloPathSimOp);
+
+}  // namespace tensorflow
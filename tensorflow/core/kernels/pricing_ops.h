@@ -0,0 +1,81 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Helpers shared by the CPU (pricing_ops.cc) and OPENCL
+// (opencl_device_ops.cc) kernels of BlackScholesPrice and MonteCarloPathSim.
+
+#ifndef TENSORFLOW_KERNELS_PRICING_OPS_H_
+#define TENSORFLOW_KERNELS_PRICING_OPS_H_
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/util/guarded_philox_random.h"
+
+namespace tensorflow {
+
+// spot, strike, rate, dividend, volatility and time
+constexpr int kNumOptionInputs = 6;
+
+// Reads the "option_type" attr.
+inline Status GetOptionType(OpKernelConstruction* ctx, bool* is_call) {
+  string option_type;
+  TF_RETURN_IF_ERROR(ctx->GetAttr("option_type", &option_type));
+  *is_call = option_type == "call";
+  return Status::OK();
+}
+
+// Checks that all option parameters have the shape of spot.
+inline Status ValidateOptionInputs(OpKernelContext* ctx) {
+  static const char* const kNames[kNumOptionInputs] = {
+      "spot", "strike", "rate", "dividend", "volatility", "time"};
+  const TensorShape& shape = ctx->input(0).shape();
+  for (int i = 1; i < kNumOptionInputs; ++i) {
+    if (ctx->input(i).shape() != shape) {
+      return errors::InvalidArgument(
+          "Option parameters must have the same shape: ", kNames[i],
+          " has shape ", ctx->input(i).shape().DebugString(),
+          " but spot has shape ", shape.DebugString());
+    }
+  }
+  return Status::OK();
+}
+
+// Philox counter and key of one MonteCarloPathSim run, drawn from the op's
+// generator. Path p of option o uses the normals of the 128-bit samples
+// (o * num_paths + p) * MonteCarloSamplesPerPath(num_steps) on, which the
+// CPU and OpenCL kernels derive the same way.
+inline void ReserveMonteCarloStream(GuardedPhiloxRandom* generator,
+                                    random::PhiloxRandom::ResultType* counter,
+                                    random::PhiloxRandom::Key* key) {
+  random::PhiloxRandom gen = generator->ReserveSamples128(1);
+  const random::PhiloxRandom::ResultType words = gen();
+  (*key)[0] = words[0];
+  (*key)[1] = words[1];
+  (*counter)[0] = 0;
+  (*counter)[1] = 0;
+  (*counter)[2] = words[2];
+  (*counter)[3] = words[3];
+}
+
+// Each 128-bit sample gives 4 normals, one per time step.
+inline int64 MonteCarloSamplesPerPath(int64 num_steps) {
+  return (num_steps + 3) / 4;
+}
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_PRICING_OPS_H_
@@ -0,0 +1,303 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+
+// Options of the form {spot, strike, rate, dividend, volatility, time}, with
+// their call and put prices.
+struct OptionCase {
+  float params[6];
+  float call;
+  float put;
+};
+
+const OptionCase kOptions[] = {
+    {{100, 100, 0.05f, 0, 0.2f, 1}, 10.450584f, 5.573526f},
+    {{42, 40, 0.1f, 0, 0.2f, 0.5f}, 4.759422f, 0.808599f},
+    // The option of opencl-finan-benchmk/Monte-Carlo
+    {{30, 40, 0.06f, 0, 0.2f, 1}, 0.425976f, 8.096558f},
+    {{50, 45, 0.03f, 0.02f, 0.35f, 2}, 11.942831f, 6.282763f},
+};
+
+class PricingOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(const string& op, const string& option_type) {
+    NodeDefBuilder builder("pricing_op", op);
+    for (int i = 0; i < 6; ++i) {
+      builder.Input(FakeInput(DT_FLOAT));
+    }
+    builder.Attr("option_type", option_type);
+    if (op == "MonteCarloPathSim") {
+      builder.Attr("num_paths", 100000)
+          .Attr("num_steps", 16)
+          .Attr("seed", 17)
+          .Attr("seed2", 42);
+    }
+    TF_ASSERT_OK(builder.Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  void AddOptions() {
+    const int64 n = TF_ARRAYSIZE(kOptions);
+    for (int i = 0; i < 6; ++i) {
+      std::vector<float> values;
+      for (const OptionCase& option : kOptions) {
+        values.push_back(option.params[i]);
+      }
+      AddInputFromArray<float>(TensorShape({n}), values);
+    }
+  }
+
+  Tensor Expected(bool is_call) {
+    std::vector<float> prices;
+    for (const OptionCase& option : kOptions) {
+      prices.push_back(is_call ? option.call : option.put);
+    }
+    return test::AsTensor<float>(prices);
+  }
+};
+
+TEST_F(PricingOpTest, BlackScholesCall) {
+  MakeOp("BlackScholesPrice", "call");
+  AddOptions();
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorNear<float>(Expected(true), *GetOutput(0), 1e-3);
+}
+
+TEST_F(PricingOpTest, BlackScholesPut) {
+  MakeOp("BlackScholesPrice", "put");
+  AddOptions();
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorNear<float>(Expected(false), *GetOutput(0), 1e-3);
+}
+
+TEST_F(PricingOpTest, BlackScholesShapeMismatch) {
+  MakeOp("BlackScholesPrice", "call");
+  for (int i = 0; i < 6; ++i) {
+    AddInputFromArray<float>(TensorShape({i == 3 ? 2 : 1}),
+                             std::vector<float>(i == 3 ? 2 : 1, 1.0f));
+  }
+  Status s = RunOpKernel();
+  EXPECT_TRUE(StringPiece(s.ToString()).contains("dividend has shape [2]"))
+      << s;
+}
+
+TEST_F(PricingOpTest, BlackScholesEmpty) {
+  MakeOp("BlackScholesPrice", "call");
+  for (int i = 0; i < 6; ++i) {
+    AddInputFromArray<float>(TensorShape({0, 3}), {});
+  }
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_EQ(TensorShape({0, 3}), GetOutput(0)->shape());
+}
+
+// With 100000 paths the standard error of the prices is below 0.03
+TEST_F(PricingOpTest, MonteCarloCallConverges) {
+  MakeOp("MonteCarloPathSim", "call");
+  AddOptions();
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorNear<float>(Expected(true), *GetOutput(0), 0.15);
+}
+
+TEST_F(PricingOpTest, MonteCarloPutConverges) {
+  MakeOp("MonteCarloPathSim", "put");
+  AddOptions();
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorNear<float>(Expected(false), *GetOutput(0), 0.15);
+}
+
+TEST_F(PricingOpTest, MonteCarloRunsDrawNewPaths) {
+  MakeOp("MonteCarloPathSim", "put");
+  AddOptions();
+  TF_ASSERT_OK(RunOpKernel());
+  Tensor first = *GetOutput(0);
+
+  TF_ASSERT_OK(RunOpKernel());
+  const Tensor& second = *GetOutput(0);
+  test::ExpectTensorNear<float>(first, second, 0.3);
+  for (int i = 0; i < first.NumElements(); ++i) {
+    EXPECT_NE(first.flat<float>()(i), second.flat<float>()(i));
+  }
+}
+
+// Benchmarks of the ops against the graphs of elementwise ops that compute
+// the same prices.
+
+namespace {
+
+Node* RandomValues(Graph* g, int num_options, float base) {
+  Tensor values(DT_FLOAT, TensorShape({num_options}));
+  values.flat<float>().setRandom();
+  values.flat<float>() = values.flat<float>() * (base / 2) + base;
+  return test::graph::Constant(g, values);
+}
+
+// spot, strike, rate, dividend, volatility and time of random options
+std::vector<Node*> RandomOptions(Graph* g, int num_options) {
+  return {RandomValues(g, num_options, 100),
+          RandomValues(g, num_options, 100),
+          RandomValues(g, num_options, 0.05f),
+          RandomValues(g, num_options, 0.01f),
+          RandomValues(g, num_options, 0.3f),
+          RandomValues(g, num_options, 1)};
+}
+
+Node* Scalar(Graph* g, float value) {
+  return test::graph::Constant(g, test::AsScalar<float>(value));
+}
+
+Graph* PricingOp(const string& op, int num_options) {
+  Graph* g = new Graph(OpRegistry::Global());
+  NodeBuilder builder(g->NewName("n"), op);
+  for (Node* input : RandomOptions(g, num_options)) {
+    builder.Input(input);
+  }
+  if (op == "MonteCarloPathSim") {
+    builder.Attr("num_paths", 1024).Attr("num_steps", 64);
+  }
+  TF_CHECK_OK(builder.Finalize(g, nullptr));
+  return g;
+}
+
+// Builds the elementwise graphs of the composite benchmarks
+class Composite {
+ public:
+  explicit Composite(Graph* g) : g_(g) {}
+
+  Node* Unary(const string& func, Node* x) {
+    return test::graph::Unary(g_, func, x);
+  }
+  Node* Add(Node* a, Node* b) { return test::graph::Binary(g_, "Add", a, b); }
+  Node* Sub(Node* a, Node* b) { return test::graph::Binary(g_, "Sub", a, b); }
+  Node* Mul(Node* a, Node* b) { return test::graph::Binary(g_, "Mul", a, b); }
+  Node* Div(Node* a, Node* b) {
+    return test::graph::Binary(g_, "RealDiv", a, b);
+  }
+  Node* Mul(Node* a, float b) { return Mul(a, Scalar(g_, b)); }
+
+  // exp(-rate * time)
+  Node* Discount(Node* rate, Node* time) {
+    return Unary("Exp", Unary("Neg", Mul(rate, time)));
+  }
+
+  // Standard normal distribution, erfc(-x / sqrt(2)) / 2
+  Node* Cdf(Node* x) {
+    return Mul(Unary("Erfc", Mul(x, -M_SQRT1_2)), 0.5f);
+  }
+
+ private:
+  Graph* g_;
+};
+
+// Call prices of BlackScholesPrice
+Graph* BlackScholesComposite(int num_options) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Composite c(g);
+  const std::vector<Node*> in = RandomOptions(g, num_options);
+  Node* spot = in[0];
+  Node* strike = in[1];
+  Node* rate = in[2];
+  Node* dividend = in[3];
+  Node* vol = in[4];
+  Node* time = in[5];
+
+  Node* forward = c.Mul(spot, c.Unary("Exp", c.Mul(c.Sub(rate, dividend),
+                                                   time)));
+  Node* std_dev = c.Mul(vol, c.Unary("Sqrt", time));
+  Node* d1 = c.Add(c.Div(c.Unary("Log", c.Div(forward, strike)), std_dev),
+                   c.Mul(std_dev, 0.5f));
+  Node* d2 = c.Sub(d1, std_dev);
+  c.Mul(c.Discount(rate, time),
+        c.Sub(c.Mul(forward, c.Cdf(d1)), c.Mul(strike, c.Cdf(d2))));
+  return g;
+}
+
+// Call prices of MonteCarloPathSim with 1024 paths of 64 steps, from the
+// [1024, num_options, 64] normals of RandomStandardNormal
+Graph* MonteCarloComposite(int num_options) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Composite c(g);
+  const std::vector<Node*> in = RandomOptions(g, num_options);
+  Node* spot = in[0];
+  Node* strike = in[1];
+  Node* rate = in[2];
+  Node* dividend = in[3];
+  Node* vol = in[4];
+  Node* time = in[5];
+
+  Node* normals = test::graph::RandomGaussian(
+      g,
+      test::graph::Constant(g, test::AsTensor<int32>({1024, num_options, 64})),
+      DT_FLOAT);
+  Node* sum_dw = test::graph::Reduce(
+      g, "Sum", normals, test::graph::Constant(g, test::AsScalar<int32>(2)));
+  Node* drift = c.Mul(
+      c.Sub(c.Sub(rate, dividend), c.Mul(c.Unary("Square", vol), 0.5f)), time);
+  Node* diffusion = c.Mul(vol, c.Unary("Sqrt", c.Mul(time, 1.0f / 64)));
+  Node* value =
+      c.Mul(spot, c.Unary("Exp", c.Add(drift, c.Mul(diffusion, sum_dw))));
+  Node* payoff = test::graph::Binary(g, "Maximum", c.Sub(value, strike),
+                                     Scalar(g, 0));
+  Node* mean = test::graph::Reduce(
+      g, "Mean", payoff, test::graph::Constant(g, test::AsScalar<int32>(0)));
+  c.Mul(mean, c.Discount(rate, time));
+  return g;
+}
+
+}  // namespace
+
+static void BM_BlackScholesPrice(int iters, int num_options) {
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_options);
+  test::Benchmark("cpu", PricingOp("BlackScholesPrice", num_options))
+      .Run(iters);
+}
+BENCHMARK(BM_BlackScholesPrice)->Arg(1024)->Arg(64 << 10)->Arg(1 << 20);
+
+static void BM_BlackScholesComposite(int iters, int num_options) {
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_options);
+  test::Benchmark("cpu", BlackScholesComposite(num_options)).Run(iters);
+}
+BENCHMARK(BM_BlackScholesComposite)->Arg(1024)->Arg(64 << 10)->Arg(1 << 20);
+
+// Items are simulated paths
+static void BM_MonteCarloPathSim(int iters, int num_options) {
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_options * 1024);
+  test::Benchmark("cpu", PricingOp("MonteCarloPathSim", num_options))
+      .Run(iters);
+}
+BENCHMARK(BM_MonteCarloPathSim)->Arg(1)->Arg(16)->Arg(128);
+
+static void BM_MonteCarloComposite(int iters, int num_options) {
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_options * 1024);
+  test::Benchmark("cpu", MonteCarloComposite(num_options)).Run(iters);
+}
+BENCHMARK(BM_MonteCarloComposite)->Arg(1)->Arg(16)->Arg(128);
+
+}  // namespace tensorflow
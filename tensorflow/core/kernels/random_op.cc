@@ -34,6 +34,10 @@ limitations under the License.
 #include "tensorflow/core/util/guarded_philox_random.h"
 #include "tensorflow/core/util/work_sharder.h"
 
+#ifdef TENSORFLOW_USE_SYCL
+#include "tensorflow/core/common_runtime/sycl/sycl_util.h"
+#endif  // TENSORFLOW_USE_SYCL
+
 #if EIGEN_COMP_GNUC && __cplusplus > 199711L
 #define DISABLE_FLOAT_EQUALITY_WARNING \
   _Pragma("GCC diagnostic push")       \
@@ -566,12 +570,11 @@ struct FillPhiloxRandomKernel;
 template <class Distribution>
 struct FillPhiloxRandomKernel<Distribution, false> {
   typedef typename Distribution::ResultElementType T;
-  using write_accessor = sycl::accessor<uint8_t, 1, sycl::access::mode::write,
-                                        sycl::access::target::global_buffer>;
+  using write_accessor = SYCLTensorAccessor<sycl::access::mode::write>;
 
-  FillPhiloxRandomKernel(write_accessor& data, random::PhiloxRandom& gen,
-                         Distribution& dist)
-      : data_(data), gen_(gen), dist_(dist) {}
+  FillPhiloxRandomKernel(write_accessor& data, size_t size,
+                         random::PhiloxRandom& gen, Distribution& dist)
+      : data_(data), size_(size), gen_(gen), dist_(dist) {}
 
   void operator()(sycl::nd_item<1> item) {
     const size_t kGroupSize = Distribution::kResultElementCount;
@@ -581,8 +584,8 @@ struct FillPhiloxRandomKernel<Distribution, false> {
     size_t offset = item_id * kGroupSize;
     gen_.Skip(item_id);
 
-    const size_t size = data_.get_size() / sizeof(T);
-    T* data = ConvertToActualTypeSycl(T, data_);
+    const size_t size = size_;
+    T* data = data_.template get<T>();
 
     while (offset + kGroupSize <= size) {
       const typename Distribution::ResultType samples = dist_(&gen_);
@@ -606,6 +609,8 @@ struct FillPhiloxRandomKernel<Distribution, false> {
 
  private:
   write_accessor data_;
+  // Number of elements of the tensor, the SYCL buffer may be larger.
+  const size_t size_;
   random::PhiloxRandom gen_;
   Distribution dist_;
 };
@@ -613,12 +618,11 @@ struct FillPhiloxRandomKernel<Distribution, false> {
 template <class Distribution>
 struct FillPhiloxRandomKernel<Distribution, true> {
   typedef typename Distribution::ResultElementType T;
-  using write_accessor = sycl::accessor<uint8_t, 1, sycl::access::mode::write,
-                                        sycl::access::target::global_buffer>;
+  using write_accessor = SYCLTensorAccessor<sycl::access::mode::write>;
 
-  FillPhiloxRandomKernel(write_accessor& data, random::PhiloxRandom& gen,
-                         Distribution& dist)
-      : data_(data), gen_(gen), dist_(dist) {}
+  FillPhiloxRandomKernel(write_accessor& data, size_t size,
+                         random::PhiloxRandom& gen, Distribution& dist)
+      : data_(data), size_(size), gen_(gen), dist_(dist) {}
 
   void operator()(sycl::nd_item<1> item) {
     using random::PhiloxRandom;
@@ -635,8 +639,8 @@ struct FillPhiloxRandomKernel<Distribution, true> {
     size_t group_index = item_id;
     size_t offset = group_index * kGroupSize;
 
-    T* data = ConvertToActualTypeSycl(T, data_);
-    const size_t size = data_.get_size() / sizeof(T);
+    T* data = data_.template get<T>();
+    const size_t size = size_;
 
     while (offset < size) {
       // Since each output takes a variable number of samples, we need to
@@ -662,6 +666,8 @@ struct FillPhiloxRandomKernel<Distribution, true> {
 
  private:
   write_accessor data_;
+  // Number of elements of the tensor, the SYCL buffer may be larger.
+  const size_t size_;
   random::PhiloxRandom gen_;
   Distribution dist_;
 };
@@ -678,14 +684,13 @@ void FillPhiloxRandom<SYCLDevice, Distribution>::operator()(
   const size_t group_size = device.maxSyclThreadsPerBlock();
   const size_t group_count = (size + group_size - 1) / group_size;
 
-  auto buffer = device.get_sycl_buffer(data);
-
   device.sycl_queue().submit([&](sycl::handler& cgh) {
-    auto access = buffer.template get_access<sycl::access::mode::write>(cgh);
+    auto access =
+        GetSYCLTensorAccessor<sycl::access::mode::write>(device, data, cgh);
 
     FillPhiloxRandomKernel<Distribution,
                            Distribution::kVariableSamplesPerOutput>
-        task(access, gen, dist);
+        task(access, size, gen, dist);
     cgh.parallel_for<class FillRandomKernel<Distribution>>(
         sycl::nd_range<1>(sycl::range<1>(group_count * group_size),
                           sycl::range<1>(group_size)),
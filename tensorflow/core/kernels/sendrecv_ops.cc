@@ -116,6 +116,10 @@ REGISTER_KERNEL_BUILDER(
     Name("_HostSend").Device(DEVICE_SYCL).HostMemory("tensor"), SendOp);
 #endif  // TENSORFLOW_USE_SYCL
 
+REGISTER_KERNEL_BUILDER(Name("_Send").Device(DEVICE_OPENCL), SendOp);
+REGISTER_KERNEL_BUILDER(
+    Name("_HostSend").Device(DEVICE_OPENCL).HostMemory("tensor"), SendOp);
+
 REGISTER_KERNEL_BUILDER(Name("_HostSend").Device(DEVICE_CPU), SendOp);
 REGISTER_KERNEL_BUILDER(
     Name("_HostSend").Device(DEVICE_GPU).HostMemory("tensor"), SendOp);
@@ -200,6 +204,8 @@ REGISTER_KERNEL_BUILDER(Name("_Recv").Device(DEVICE_GPU), RecvOp);
 REGISTER_KERNEL_BUILDER(Name("_Recv").Device(DEVICE_SYCL), RecvOp);
 #endif  // TENSORFLOW_USE_SYCL
 
+REGISTER_KERNEL_BUILDER(Name("_Recv").Device(DEVICE_OPENCL), RecvOp);
+
 REGISTER_KERNEL_BUILDER(Name("_HostRecv").Device(DEVICE_CPU), RecvOp);
 REGISTER_KERNEL_BUILDER(
     Name("_HostRecv").Device(DEVICE_GPU).HostMemory("tensor"), RecvOp);
@@ -209,4 +215,7 @@ REGISTER_KERNEL_BUILDER(
     Name("_HostRecv").Device(DEVICE_SYCL).HostMemory("tensor"), RecvOp);
 #endif  // TENSORFLOW_USE_SYCL
 
+REGISTER_KERNEL_BUILDER(
+    Name("_HostRecv").Device(DEVICE_OPENCL).HostMemory("tensor"), RecvOp);
+
 }  // end namespace tensorflow
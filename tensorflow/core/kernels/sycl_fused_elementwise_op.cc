@@ -0,0 +1,396 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/math_ops.cc.  The graph rewrite that creates these ops
+// is in ../graph/sycl_fusion_pass.cc.
+
+#ifdef TENSORFLOW_USE_SYCL
+
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/common_runtime/sycl/sycl_util.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/bcast.h"
+
+namespace tensorflow {
+
+typedef Eigen::SyclDevice SYCLDevice;
+
+namespace sycl_fused_elementwise {
+
+// Limits of one fused op, the rewrite pass does not create bigger ones.
+constexpr int kMaxInputs = 4;
+constexpr int kMaxSteps = 8;
+constexpr int kMaxDims = 6;
+
+enum OpCode {
+  kAbs,
+  kExp,
+  kLog,
+  kNeg,
+  kReciprocal,
+  kRelu,
+  kRsqrt,
+  kSigmoid,
+  kSqrt,
+  kSquare,
+  kTanh,
+  kAdd,
+  kMaximum,
+  kMinimum,
+  kMul,
+  kRealDiv,
+  kReluGrad,
+  kSigmoidGrad,
+  kSquaredDifference,
+  kSub,
+  kTanhGrad,
+};
+
+// Codes below kAdd take a single operand.
+inline bool IsUnary(int op) { return op < kAdd; }
+
+// BiasAdd is an Add whose bias broadcasts along the last dimension.
+inline bool OpCodeFromName(const string& name, int* op) {
+  static const auto* codes = new std::unordered_map<string, int>({
+      {"Abs", kAbs},
+      {"Exp", kExp},
+      {"Log", kLog},
+      {"Neg", kNeg},
+      {"Reciprocal", kReciprocal},
+      {"Relu", kRelu},
+      {"Rsqrt", kRsqrt},
+      {"Sigmoid", kSigmoid},
+      {"Sqrt", kSqrt},
+      {"Square", kSquare},
+      {"Tanh", kTanh},
+      {"Add", kAdd},
+      {"BiasAdd", kAdd},
+      {"Maximum", kMaximum},
+      {"Minimum", kMinimum},
+      {"Mul", kMul},
+      {"RealDiv", kRealDiv},
+      {"ReluGrad", kReluGrad},
+      {"SigmoidGrad", kSigmoidGrad},
+      {"SquaredDifference", kSquaredDifference},
+      {"Sub", kSub},
+      {"TanhGrad", kTanhGrad},
+  });
+  auto it = codes->find(name);
+  if (it == codes->end()) return false;
+  *op = it->second;
+  return true;
+}
+
+// The steps of the fused expression.  An operand below kMaxInputs is an
+// input of the op, operand kMaxInputs + s is the result of step s.  The
+// result of the last step is the output.
+struct Program {
+  int num_steps;
+  int op[kMaxSteps];
+  int operand[kMaxSteps][2];
+};
+
+// How each input is read for an element of the output.
+enum InputMode { kSameShape, kScalar, kBroadcast };
+
+struct Layout {
+  int num_inputs;
+  int rank;
+  int output_dims[kMaxDims];
+  int mode[kMaxInputs];
+  // Strides of the broadcast inputs over the output dimensions, 0 along the
+  // dimensions they are broadcast in.
+  int strides[kMaxInputs][kMaxDims];
+};
+
+template <typename T>
+inline T Apply(int op, T a, T b) {
+  switch (op) {
+    case kAbs:
+      return cl::sycl::fabs(a);
+    case kExp:
+      return cl::sycl::exp(a);
+    case kLog:
+      return cl::sycl::log(a);
+    case kNeg:
+      return -a;
+    case kReciprocal:
+      return T(1) / a;
+    case kRelu:
+      return a > T(0) ? a : T(0);
+    case kRsqrt:
+      return cl::sycl::rsqrt(a);
+    case kSigmoid:
+      return T(1) / (T(1) + cl::sycl::exp(-a));
+    case kSqrt:
+      return cl::sycl::sqrt(a);
+    case kSquare:
+      return a * a;
+    case kTanh:
+      return cl::sycl::tanh(a);
+    case kAdd:
+      return a + b;
+    case kMaximum:
+      return a > b ? a : b;
+    case kMinimum:
+      return a < b ? a : b;
+    case kMul:
+      return a * b;
+    case kRealDiv:
+      return a / b;
+    case kReluGrad:
+      // ReluGrad(gradients, features)
+      return b > T(0) ? a : T(0);
+    case kSigmoidGrad:
+      // SigmoidGrad(y, dy)
+      return b * a * (T(1) - a);
+    case kSquaredDifference:
+      return (a - b) * (a - b);
+    case kSub:
+      return a - b;
+    case kTanhGrad:
+      // TanhGrad(y, dy)
+      return b * (T(1) - a * a);
+  }
+  return T(0);
+}
+
+// Evaluates the whole program for one element of the output per work item,
+// so the intermediate results stay in registers.  Unused input accessors
+// alias the first input.
+template <typename T>
+class FusedElementwiseSYCL {
+  using write_accessor = SYCLTensorAccessor<cl::sycl::access::mode::write>;
+  using read_accessor = SYCLTensorAccessor<cl::sycl::access::mode::read>;
+
+ public:
+  FusedElementwiseSYCL(const read_accessor in0, const read_accessor in1,
+                       const read_accessor in2, const read_accessor in3,
+                       write_accessor output, const Program& program,
+                       const Layout& layout)
+      : in0_accessor_(in0),
+        in1_accessor_(in1),
+        in2_accessor_(in2),
+        in3_accessor_(in3),
+        output_accessor_(output),
+        program_(program),
+        layout_(layout) {}
+
+  void operator()(cl::sycl::item<1> item) {
+    const T* inputs[kMaxInputs] = {
+        in0_accessor_.template get<T>(), in1_accessor_.template get<T>(),
+        in2_accessor_.template get<T>(), in3_accessor_.template get<T>()};
+    T* output_data = output_accessor_.template get<T>();
+
+    const int index = item.get_linear_id();
+    T values[kMaxInputs + kMaxSteps];
+    for (int i = 0; i < layout_.num_inputs; ++i) {
+      values[i] = inputs[i][InputIndex(i, index)];
+    }
+    for (int s = 0; s < program_.num_steps; ++s) {
+      const int b = program_.operand[s][1];
+      values[kMaxInputs + s] =
+          Apply(program_.op[s], values[program_.operand[s][0]],
+                b < 0 ? T(0) : values[b]);
+    }
+    output_data[index] = values[kMaxInputs + program_.num_steps - 1];
+  }
+
+ private:
+  int InputIndex(int input, int index) const {
+    switch (layout_.mode[input]) {
+      case kSameShape:
+        return index;
+      case kScalar:
+        return 0;
+    }
+    int input_index = 0;
+    for (int d = layout_.rank - 1; d >= 0; --d) {
+      const int dim = layout_.output_dims[d];
+      input_index += (index % dim) * layout_.strides[input][d];
+      index /= dim;
+    }
+    return input_index;
+  }
+
+  const read_accessor in0_accessor_;
+  const read_accessor in1_accessor_;
+  const read_accessor in2_accessor_;
+  const read_accessor in3_accessor_;
+  write_accessor output_accessor_;
+  const Program program_;
+  const Layout layout_;
+};
+
+template <typename T>
+class SYCLFusedElementwiseOp : public OpKernel {
+ public:
+  explicit SYCLFusedElementwiseOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    std::vector<string> ops;
+    OP_REQUIRES_OK(context, context->GetAttr("ops", &ops));
+    std::vector<int32> operands;
+    OP_REQUIRES_OK(context, context->GetAttr("operands", &operands));
+    const int num_inputs = context->num_inputs();
+    OP_REQUIRES(context, num_inputs <= kMaxInputs,
+                errors::InvalidArgument("At most ", kMaxInputs,
+                                        " inputs can be fused, got ",
+                                        num_inputs));
+    OP_REQUIRES(context, !ops.empty() && ops.size() <= kMaxSteps,
+                errors::InvalidArgument("Between 1 and ", kMaxSteps,
+                                        " ops can be fused, got ",
+                                        ops.size()));
+    OP_REQUIRES(context, operands.size() == 2 * ops.size(),
+                errors::InvalidArgument("Expected ", 2 * ops.size(),
+                                        " operands, got ", operands.size()));
+
+    program_.num_steps = ops.size();
+    for (int s = 0; s < ops.size(); ++s) {
+      int* op = &program_.op[s];
+      OP_REQUIRES(context, OpCodeFromName(ops[s], op),
+                  errors::InvalidArgument("Cannot fuse op ", ops[s]));
+      for (int k = 0; k < 2; ++k) {
+        const int operand = operands[2 * s + k];
+        if (k == 1 && IsUnary(*op)) {
+          OP_REQUIRES(context, operand == -1,
+                      errors::InvalidArgument(ops[s], " takes one operand"));
+          program_.operand[s][k] = -1;
+          continue;
+        }
+        // Inputs, then the results of the previous steps.
+        OP_REQUIRES(context, operand >= 0 && operand < num_inputs + s,
+                    errors::InvalidArgument("Operand ", operand, " of step ",
+                                            s, " is out of range"));
+        program_.operand[s][k] = operand < num_inputs
+                                     ? operand
+                                     : kMaxInputs + operand - num_inputs;
+      }
+    }
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const int num_inputs = context->num_inputs();
+
+    // The output has the broadcast shape of all the inputs.
+    BCast::Vec output_vec = BCast::FromShape(context->input(0).shape());
+    for (int i = 1; i < num_inputs; ++i) {
+      BCast bcast(output_vec, BCast::FromShape(context->input(i).shape()),
+                  /*fewer_dims_optimization=*/false);
+      OP_REQUIRES(context, bcast.IsValid(),
+                  errors::InvalidArgument(
+                      "Incompatible shapes: ",
+                      BCast::ToShape(output_vec).DebugString(), " vs. ",
+                      context->input(i).shape().DebugString()));
+      output_vec = bcast.output_shape();
+    }
+    const TensorShape output_shape = BCast::ToShape(output_vec);
+    OP_REQUIRES(context, output_shape.dims() <= kMaxDims,
+                errors::Unimplemented("Fused elementwise ops support up to ",
+                                      kMaxDims, " dimensions, got ",
+                                      output_shape.dims()));
+    OP_REQUIRES(
+        context,
+        FastBoundsCheck(output_shape.num_elements(),
+                        std::numeric_limits<int32>::max()),
+        errors::InvalidArgument("Fused elementwise output is too large"));
+
+    Layout layout;
+    layout.num_inputs = num_inputs;
+    layout.rank = output_shape.dims();
+    for (int d = 0; d < layout.rank; ++d) {
+      layout.output_dims[d] = output_shape.dim_size(d);
+    }
+    std::vector<int> same_shape_inputs;
+    for (int i = 0; i < num_inputs; ++i) {
+      const TensorShape& shape = context->input(i).shape();
+      if (shape.num_elements() == output_shape.num_elements()) {
+        // Broadcasting only repeats elements, so the layouts are the same.
+        layout.mode[i] = kSameShape;
+        if (shape == output_shape) same_shape_inputs.push_back(i);
+      } else if (shape.num_elements() == 1) {
+        layout.mode[i] = kScalar;
+      } else {
+        layout.mode[i] = kBroadcast;
+        // Align the dimensions of the input with the trailing dimensions of
+        // the output.
+        const int offset = layout.rank - shape.dims();
+        int stride = 1;
+        for (int d = layout.rank - 1; d >= 0; --d) {
+          const int64 dim = d < offset ? 1 : shape.dim_size(d - offset);
+          layout.strides[i][d] = dim == 1 ? 0 : stride;
+          stride *= dim;
+        }
+      }
+    }
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                same_shape_inputs, 0, output_shape, &output));
+    if (output_shape.num_elements() == 0) return;
+
+    const SYCLDevice& d = context->eigen_device<SYCLDevice>();
+    std::vector<const T*> inputs;
+    for (int i = 0; i < kMaxInputs; ++i) {
+      inputs.push_back(
+          context->input(i < num_inputs ? i : 0).template flat<T>().data());
+    }
+    T* output_data = output->template flat<T>().data();
+    const Program& program = program_;
+    d.sycl_queue().submit([&](cl::sycl::handler& cgh) {
+      auto in0_access = GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+          d, inputs[0], cgh);
+      auto in1_access = GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+          d, inputs[1], cgh);
+      auto in2_access = GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+          d, inputs[2], cgh);
+      auto in3_access = GetSYCLTensorAccessor<cl::sycl::access::mode::read>(
+          d, inputs[3], cgh);
+      auto output_access = GetSYCLTensorAccessor<cl::sycl::access::mode::write>(
+          d, output_data, cgh);
+      FusedElementwiseSYCL<T> functor(in0_access, in1_access, in2_access,
+                                      in3_access, output_access, program,
+                                      layout);
+      cgh.parallel_for(cl::sycl::range<1>(output_shape.num_elements()),
+                       functor);
+    });
+  }
+
+ private:
+  Program program_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SYCLFusedElementwiseOp);
+};
+
+}  // namespace sycl_fused_elementwise
+
+#define REGISTER_SYCL(T)                                                 \
+  REGISTER_KERNEL_BUILDER(Name("_SYCLFusedElementwise")                  \
+                              .Device(DEVICE_SYCL)                       \
+                              .TypeConstraint<T>("T"),                   \
+                          sycl_fused_elementwise::SYCLFusedElementwiseOp<T>);
+TF_CALL_SYCL_NUMBER_TYPES(REGISTER_SYCL);
+#undef REGISTER_SYCL
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_USE_SYCL
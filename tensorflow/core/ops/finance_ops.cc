@@ -0,0 +1,67 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/common_shape_fns.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/shape_inference.h"
+
+namespace tensorflow {
+
+using shape_inference::InferenceContext;
+using shape_inference::ShapeHandle;
+
+namespace {
+
+// All option parameters have the same shape, which is the shape of the
+// prices.
+Status OptionPriceShape(InferenceContext* c) {
+  ShapeHandle out = c->input(0);
+  for (int i = 1; i < c->num_inputs(); ++i) {
+    TF_RETURN_IF_ERROR(c->Merge(out, c->input(i), &out));
+  }
+  c->set_output(0, out);
+  return Status::OK();
+}
+
+}  // namespace
+
+REGISTER_OP("BlackScholesPrice")
+    .Input("spot: float")
+    .Input("strike: float")
+    .Input("rate: float")
+    .Input("dividend: float")
+    .Input("volatility: float")
+    .Input("time: float")
+    .Output("price: float")
+    .Attr("option_type: {'call', 'put'} = 'call'")
+    .SetShapeFn(OptionPriceShape);
+
+REGISTER_OP("MonteCarloPathSim")
+    .Input("spot: float")
+    .Input("strike: float")
+    .Input("rate: float")
+    .Input("dividend: float")
+    .Input("volatility: float")
+    .Input("time: float")
+    .SetIsStateful()
+    .Output("price: float")
+    .Attr("option_type: {'call', 'put'} = 'call'")
+    .Attr("num_paths: int >= 1 = 100000")
+    .Attr("num_steps: int >= 1 = 250")
+    .Attr("seed: int = 0")
+    .Attr("seed2: int = 0")
+    .SetShapeFn(OptionPriceShape);
+
+}  // namespace tensorflow
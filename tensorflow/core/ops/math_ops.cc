@@ -433,6 +433,24 @@ Returns the max of x and y (i.e. x > y ? x : y) element-wise.
 [here](http://docs.scipy.org/doc/numpy/user/basics.broadcasting.html)
 )doc");
 
+REGISTER_OP("_SYCLFusedElementwise")
+    .Input("inputs: N * T")
+    .Output("output: T")
+    .Attr("N: int >= 1")
+    .Attr("T: {float, double}")
+    .Attr("ops: list(string)")
+    .Attr("operands: list(int)")
+    .SetShapeFn(shape_inference::UnknownShape)
+    .Doc(R"doc(
+Evaluates a chain of elementwise ops in a single SYCL kernel.
+
+Created after partitioning by the SYCL fusion pass, so no shape function is
+needed.  Step s applies ops[s] to operands[2 * s] and operands[2 * s + 1],
+where operand k < N is inputs[k] and operand N + t is the result of step t,
+and -1 is the missing operand of a unary op.  output is the result of the
+last step, with the broadcast shape of all the inputs.
+)doc");
+
 REGISTER_OP("Minimum")
     .Input("x: T")
     .Input("y: T")
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/regexp.h"
 #include "tensorflow/core/util/reporter.h"
 
 namespace tensorflow {
@@ -113,13 +114,18 @@ Benchmark* Benchmark::RangePair(int lo1, int hi1, int lo2, int hi2) {
 void Benchmark::Run(const char* pattern) {
   if (!all_benchmarks) return;
 
-  // Converts "all" into the wildcard '.*'.  Currently pattern isn't
-  // specified by clients, but we keep this here to match the internal
-  // Google implementation, should we ever enable user-specified
-  // pattern specification.
+  // Converts "all" into the wildcard '.*'.  Other patterns are regular
+  // expressions matched against any part of the benchmark name, including
+  // its arguments (e.g. "BM_Foo/64").
   if (StringPiece(pattern) == "all") {
     pattern = ".*";
   }
+  RE2 pattern_re(pattern);
+  if (!pattern_re.ok()) {
+    LOG(ERROR) << "Invalid benchmark pattern " << pattern << ": "
+               << pattern_re.error();
+    exit(EXIT_FAILURE);
+  }
 
   // Compute name width.
   int width = 10;
@@ -135,9 +141,7 @@ void Benchmark::Run(const char* pattern) {
         }
       }
 
-      // TODO(vrv): Check against 'pattern' using a regex before
-      // computing the width, if we start allowing clients to pass in
-      // a custom pattern.
+      if (!RE2::PartialMatch(name, pattern_re)) continue;
       width = std::max<int>(width, name.size());
     }
   }
@@ -155,9 +159,7 @@ void Benchmark::Run(const char* pattern) {
         }
       }
 
-      // TODO(vrv): Match 'name' against 'pattern' using a regex
-      // before continuing, if we start allowing clients to pass in a
-      // custom pattern.
+      if (!RE2::PartialMatch(name, pattern_re)) continue;
 
       int iters;
       double seconds;
@@ -186,6 +188,17 @@ void Benchmark::Run(const char* pattern) {
       }
       s = reporter.Benchmark(iters, 0.0, seconds,
                              items_processed * 1e-6 / seconds);
+      if (s.ok() && bytes_processed > 0) {
+        s = reporter.SetProperty("bytes_per_second",
+                                 bytes_processed / seconds);
+      }
+      if (s.ok() && items_processed > 0) {
+        s = reporter.SetProperty("items_per_second",
+                                 items_processed / seconds);
+      }
+      if (s.ok() && !label.empty()) {
+        s = reporter.SetProperty("label", label);
+      }
       if (!s.ok()) {
         LOG(ERROR) << s.ToString();
         exit(EXIT_FAILURE);
@@ -241,9 +254,7 @@ void Benchmark::Run(int arg1, int arg2, int* run_count, double* run_seconds) {
   }
 }
 
-// TODO(vrv): Add support for running a subset of benchmarks by having
-// RunBenchmarks take in a spec (and maybe other options such as
-// benchmark_min_time, etc).
+// TODO(vrv): Add support for other options such as benchmark_min_time.
 void RunBenchmarks() { Benchmark::Run("all"); }
 void SetLabel(const std::string& l) { label = l; }
 void BytesProcessed(int64 n) { bytes_processed = n; }
@@ -48,4 +48,17 @@ bool MatmulDoFP32ComputationFP16Input() {
   return value;
 }
 
+bool MatmulOpenCLFP16Compute() {
+  bool value;
+  // Opt-in: float32 MatMuls computed on OpenCL round their operands to half
+  // precision, halving the upload size and using the FP16 ALUs of mobile GPUs.
+  // Products are still accumulated and returned in float32.
+  Status status =
+      ReadBoolFromEnvVar("TF_MATMUL_OPENCL_FP16_COMPUTE", false, &value);
+  if (!status.ok()) {
+    LOG(ERROR) << status.error_message();
+  }
+  return value;
+}
+
 }  // namespace tensorflow
@@ -22,6 +22,7 @@ namespace tensorflow {
 
 bool MatmulAutotuneEnable();
 bool MatmulDoFP32ComputationFP16Input();
+bool MatmulOpenCLFP16Compute();
 
 }  // namespace tensorflow
 
@@ -15,8 +15,15 @@ limitations under the License.
 
 #include "tensorflow/core/util/reporter.h"
 
+#include <cmath>
+#include <set>
+#include <vector>
+
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/mutex.h"
 
 namespace tensorflow {
@@ -47,6 +54,18 @@ Status TestReporter::Benchmark(int64 iters, double cpu_time, double wall_time,
   return Status::OK();
 }
 
+Status TestReporter::SetProperty(const string& name, const string& value) {
+  if (closed_) return Status::OK();
+  (*benchmark_entry_.mutable_extras())[name].set_string_value(value);
+  return Status::OK();
+}
+
+Status TestReporter::SetProperty(const string& name, double value) {
+  if (closed_) return Status::OK();
+  (*benchmark_entry_.mutable_extras())[name].set_double_value(value);
+  return Status::OK();
+}
+
 Status TestReporter::Initialize() {
   if (fname_.empty()) {
     return Status::OK();
@@ -66,4 +85,206 @@ Status TestReporter::Initialize() {
   return Status::OK();
 }
 
+namespace {
+
+string JsonString(const string& s) {
+  string out = "\"";
+  for (char c : s) {
+    switch (c) {
+      case '"':
+        out += "\\\"";
+        break;
+      case '\\':
+        out += "\\\\";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      case '\t':
+        out += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          strings::Appendf(&out, "\\u%04x", static_cast<unsigned char>(c));
+        } else {
+          out += c;
+        }
+    }
+  }
+  out += "\"";
+  return out;
+}
+
+// JSON has no NaN or infinity.
+string JsonNumber(double value) {
+  return std::isfinite(value) ? strings::StrCat(value) : "null";
+}
+
+string JsonValue(const EntryValue& value) {
+  if (value.kind_case() == EntryValue::kStringValue) {
+    return JsonString(value.string_value());
+  }
+  return JsonNumber(value.double_value());
+}
+
+string CsvField(const string& s) {
+  if (s.find_first_of(",\"\n") == string::npos) return s;
+  return strings::StrCat(
+      "\"", str_util::StringReplace(s, "\"", "\"\"", true), "\"");
+}
+
+string CsvValue(const EntryValue& value) {
+  if (value.kind_case() == EntryValue::kStringValue) {
+    return CsvField(value.string_value());
+  }
+  return strings::StrCat(value.double_value());
+}
+
+// Splits one CSV line, as written by BenchmarkEntriesToCsv.
+std::vector<string> SplitCsvLine(const string& line) {
+  std::vector<string> fields(1);
+  bool quoted = false;
+  for (size_t i = 0; i < line.size(); ++i) {
+    const char c = line[i];
+    if (quoted) {
+      if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+        fields.back() += '"';
+        ++i;
+      } else if (c == '"') {
+        quoted = false;
+      } else {
+        fields.back() += c;
+      }
+    } else if (c == '"') {
+      quoted = true;
+    } else if (c == ',') {
+      fields.emplace_back();
+    } else {
+      fields.back() += c;
+    }
+  }
+  return fields;
+}
+
+double ExtraNumber(const BenchmarkEntry& entry, const string& key) {
+  auto it = entry.extras().find(key);
+  return it == entry.extras().end() ? 0 : it->second.double_value();
+}
+
+}  // namespace
+
+string BenchmarkEntriesToJson(const BenchmarkEntries& entries) {
+  string out = "[";
+  for (int i = 0; i < entries.entry_size(); ++i) {
+    const BenchmarkEntry& entry = entries.entry(i);
+    strings::StrAppend(&out, i > 0 ? ",\n" : "\n", "  {\"name\": ",
+                       JsonString(entry.name()), ", \"iters\": ", entry.iters(),
+                       ", \"cpu_time\": ", JsonNumber(entry.cpu_time()),
+                       ", \"wall_time\": ", JsonNumber(entry.wall_time()),
+                       ", \"throughput\": ", JsonNumber(entry.throughput()));
+    // Sort the extras, map iteration order is unspecified.
+    std::set<string> keys;
+    for (const auto& extra : entry.extras()) keys.insert(extra.first);
+    if (!keys.empty()) {
+      out += ", \"extras\": {";
+      bool first = true;
+      for (const string& key : keys) {
+        strings::StrAppend(&out, first ? "" : ", ", JsonString(key), ": ",
+                           JsonValue(entry.extras().at(key)));
+        first = false;
+      }
+      out += "}";
+    }
+    out += "}";
+  }
+  out += entries.entry_size() > 0 ? "\n]\n" : "]\n";
+  return out;
+}
+
+string BenchmarkEntriesToCsv(const BenchmarkEntries& entries) {
+  std::set<string> keys;
+  for (const BenchmarkEntry& entry : entries.entry()) {
+    for (const auto& extra : entry.extras()) keys.insert(extra.first);
+  }
+  string out = "name,iters,cpu_time,wall_time,throughput";
+  for (const string& key : keys) strings::StrAppend(&out, ",", CsvField(key));
+  out += "\n";
+  for (const BenchmarkEntry& entry : entries.entry()) {
+    strings::StrAppend(&out, CsvField(entry.name()), ",", entry.iters(), ",",
+                       entry.cpu_time(), ",", entry.wall_time(), ",",
+                       entry.throughput());
+    for (const string& key : keys) {
+      out += ",";
+      auto it = entry.extras().find(key);
+      if (it != entry.extras().end()) out += CsvValue(it->second);
+    }
+    out += "\n";
+  }
+  return out;
+}
+
+Status BenchmarkEntriesFromCsv(const string& csv, BenchmarkEntries* entries) {
+  std::vector<string> lines = str_util::Split(csv, '\n', str_util::SkipEmpty());
+  if (lines.empty()) return errors::InvalidArgument("Empty benchmark CSV");
+  const std::vector<string> header = SplitCsvLine(lines[0]);
+  if (header.size() < 5 || header[0] != "name" || header[3] != "wall_time") {
+    return errors::InvalidArgument("Not a benchmark CSV header: ", lines[0]);
+  }
+  for (size_t l = 1; l < lines.size(); ++l) {
+    const std::vector<string> fields = SplitCsvLine(lines[l]);
+    if (fields.size() != header.size()) {
+      return errors::InvalidArgument("Line ", l + 1, ": expected ",
+                                     header.size(), " fields, got ",
+                                     fields.size());
+    }
+    int64 iters = 0;
+    double cpu_time = 0, wall_time = 0, throughput = 0;
+    if (!strings::safe_strto64(fields[1], &iters) ||
+        !strings::safe_strtod(fields[2].c_str(), &cpu_time) ||
+        !strings::safe_strtod(fields[3].c_str(), &wall_time) ||
+        !strings::safe_strtod(fields[4].c_str(), &throughput)) {
+      return errors::InvalidArgument("Line ", l + 1, ": malformed entry");
+    }
+    BenchmarkEntry* entry = entries->add_entry();
+    entry->set_name(fields[0]);
+    entry->set_iters(iters);
+    entry->set_cpu_time(cpu_time);
+    entry->set_wall_time(wall_time);
+    entry->set_throughput(throughput);
+    for (size_t i = 5; i < fields.size(); ++i) {
+      if (fields[i].empty()) continue;
+      EntryValue& value = (*entry->mutable_extras())[header[i]];
+      double number;
+      if (header[i] != "label" &&
+          strings::safe_strtod(fields[i].c_str(), &number)) {
+        value.set_double_value(number);
+      } else {
+        value.set_string_value(fields[i]);
+      }
+    }
+  }
+  return Status::OK();
+}
+
+string BenchmarkRegression(const BenchmarkEntry& entry,
+                           const BenchmarkEntry& baseline, double tolerance) {
+  for (const char* key : {"items_per_second", "bytes_per_second"}) {
+    const double current = ExtraNumber(entry, key);
+    const double expected = ExtraNumber(baseline, key);
+    if (current > 0 && expected > 0) {
+      if (current >= expected * (1 - tolerance)) return "";
+      return strings::StrCat(key, " ", current, " < ", expected, " (",
+                             std::round(100 * (1 - current / expected)),
+                             "% slower)");
+    }
+  }
+  // TestReporter already records the wall time per iteration.
+  const double current = entry.wall_time();
+  const double expected = baseline.wall_time();
+  if (current <= expected * (1 + tolerance)) return "";
+  return strings::StrCat("seconds per iteration ", current, " > ", expected,
+                         " (", std::round(100 * (current / expected - 1)),
+                         "% slower)");
+}
+
 }  // namespace tensorflow
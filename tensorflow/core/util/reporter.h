@@ -75,6 +75,12 @@ class TestReporter {
   Status Benchmark(int64 iters, double cpu_time, double wall_time,
                    double throughput);
 
+  // Add a key/value pair to the extras of the benchmark entry, e.g. a
+  // bandwidth or a FLOP rate.  Only does something if the reporting env
+  // flag is set.
+  Status SetProperty(const string& name, const string& value);
+  Status SetProperty(const string& name, double value);
+
   // TODO(b/32704451): Don't just ignore the ::tensorflow::Status object!
   ~TestReporter() { Close().IgnoreError(); }  // Autoclose in destructor.
 
@@ -91,6 +97,31 @@ class TestReporter {
   TF_DISALLOW_COPY_AND_ASSIGN(TestReporter);
 };
 
+// Machine readable renderings of benchmark entries, for tools comparing
+// runs.  Both list the fields of BenchmarkEntry followed by the extras.
+//
+// JSON: an array with one object per entry, extras are nested under
+// "extras".
+string BenchmarkEntriesToJson(const BenchmarkEntries& entries);
+
+// CSV: a header row, then one row per entry.  The columns after
+// "throughput" are the union of the extras of all entries, sorted by name,
+// left empty for entries without them.  Fields containing a comma, a quote
+// or a newline are quoted.
+string BenchmarkEntriesToCsv(const BenchmarkEntries& entries);
+
+// Parses the output of BenchmarkEntriesToCsv, appending one entry per row to
+// 'entries'.  Extras are read back as numbers, except for "label" and the
+// fields which are not numbers.
+Status BenchmarkEntriesFromCsv(const string& csv, BenchmarkEntries* entries);
+
+// Compares 'entry' with its 'baseline' on the rate it reports, items or
+// bytes per second, or else on its wall time per iteration.  Returns a
+// description of the regression, or an empty string if 'entry' is at most
+// 'tolerance' (a fraction) slower.
+string BenchmarkRegression(const BenchmarkEntry& entry,
+                           const BenchmarkEntry& baseline, double tolerance);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_UTIL_REPORTER_H_
@@ -115,5 +115,131 @@ TEST(TestReporter, Benchmark) {
   EXPECT_EQ(benchmark_entry.throughput(), 3.0);
 }
 
+TEST(TestReporter, SetProperty) {
+  string fname =
+      strings::StrCat(testing::TmpDir(), "/test_reporter_set_property_");
+  TestReporter test_reporter(fname, "b2/3/4");
+  TF_EXPECT_OK(test_reporter.Initialize());
+  TF_EXPECT_OK(test_reporter.SetProperty("string_prop", "abc"));
+  TF_EXPECT_OK(test_reporter.SetProperty("double_prop", 4.0));
+  TF_EXPECT_OK(test_reporter.Close());
+
+  string read;
+  TF_EXPECT_OK(ReadFileToString(Env::Default(),
+                                strings::StrCat(fname, "b2__3__4"), &read));
+  BenchmarkEntries benchmark_entries;
+  ASSERT_TRUE(benchmark_entries.ParseFromString(read));
+  ASSERT_EQ(1, benchmark_entries.entry_size());
+  const auto& extras = benchmark_entries.entry(0).extras();
+  ASSERT_EQ(2, extras.size());
+  EXPECT_EQ("abc", extras.at("string_prop").string_value());
+  EXPECT_EQ(4.0, extras.at("double_prop").double_value());
+}
+
+BenchmarkEntries TwoEntries() {
+  BenchmarkEntries entries;
+  BenchmarkEntry* a = entries.add_entry();
+  a->set_name("BM_A/64");
+  a->set_iters(10);
+  a->set_wall_time(0.5);
+  (*a->mutable_extras())["bytes_per_second"].set_double_value(2e9);
+  BenchmarkEntry* b = entries.add_entry();
+  b->set_name("BM_B");
+  b->set_iters(3);
+  b->set_wall_time(0.25);
+  (*b->mutable_extras())["label"].set_string_value("m=1, \"n\"=2");
+  return entries;
+}
+
+TEST(BenchmarkEntriesToJson, Entries) {
+  EXPECT_EQ(
+      "[\n"
+      "  {\"name\": \"BM_A/64\", \"iters\": 10, \"cpu_time\": 0, "
+      "\"wall_time\": 0.5, \"throughput\": 0, "
+      "\"extras\": {\"bytes_per_second\": 2000000000}},\n"
+      "  {\"name\": \"BM_B\", \"iters\": 3, \"cpu_time\": 0, "
+      "\"wall_time\": 0.25, \"throughput\": 0, "
+      "\"extras\": {\"label\": \"m=1, \\\"n\\\"=2\"}}\n"
+      "]\n",
+      BenchmarkEntriesToJson(TwoEntries()));
+  EXPECT_EQ("[]\n", BenchmarkEntriesToJson(BenchmarkEntries()));
+}
+
+TEST(BenchmarkEntriesToCsv, Entries) {
+  EXPECT_EQ(
+      "name,iters,cpu_time,wall_time,throughput,bytes_per_second,label\n"
+      "BM_A/64,10,0,0.5,0,2000000000,\n"
+      "BM_B,3,0,0.25,0,,\"m=1, \"\"n\"\"=2\"\n",
+      BenchmarkEntriesToCsv(TwoEntries()));
+}
+
+TEST(BenchmarkEntriesFromCsv, RoundTrip) {
+  BenchmarkEntries entries;
+  TF_EXPECT_OK(
+      BenchmarkEntriesFromCsv(BenchmarkEntriesToCsv(TwoEntries()), &entries));
+  ASSERT_EQ(2, entries.entry_size());
+  EXPECT_EQ("BM_A/64", entries.entry(0).name());
+  EXPECT_EQ(10, entries.entry(0).iters());
+  EXPECT_EQ(0.5, entries.entry(0).wall_time());
+  EXPECT_EQ(2e9, entries.entry(0).extras().at("bytes_per_second")
+                     .double_value());
+  EXPECT_EQ(0, entries.entry(0).extras().count("label"));
+  EXPECT_EQ("BM_B", entries.entry(1).name());
+  EXPECT_EQ("m=1, \"n\"=2",
+            entries.entry(1).extras().at("label").string_value());
+}
+
+TEST(BenchmarkEntriesFromCsv, Malformed) {
+  BenchmarkEntries entries;
+  EXPECT_FALSE(BenchmarkEntriesFromCsv("", &entries).ok());
+  EXPECT_FALSE(BenchmarkEntriesFromCsv("a,b,c\n", &entries).ok());
+  const string header = "name,iters,cpu_time,wall_time,throughput\n";
+  EXPECT_FALSE(
+      BenchmarkEntriesFromCsv(header + "BM_A,1,0,0.5\n", &entries).ok());
+  EXPECT_FALSE(
+      BenchmarkEntriesFromCsv(header + "BM_A,x,0,0.5,0\n", &entries).ok());
+}
+
+BenchmarkEntry Entry(int64 iters, double wall_time, const string& rate_key,
+                     double rate) {
+  BenchmarkEntry entry;
+  entry.set_name("BM_A");
+  entry.set_iters(iters);
+  entry.set_wall_time(wall_time);
+  if (!rate_key.empty()) {
+    (*entry.mutable_extras())[rate_key].set_double_value(rate);
+  }
+  return entry;
+}
+
+TEST(BenchmarkRegression, ComparesRates) {
+  const BenchmarkEntry baseline = Entry(10, 1.0, "items_per_second", 100);
+  EXPECT_EQ("", BenchmarkRegression(Entry(10, 1.0, "items_per_second", 95),
+                                    baseline, 0.1));
+  EXPECT_EQ("", BenchmarkRegression(Entry(10, 1.0, "items_per_second", 200),
+                                    baseline, 0.1));
+  EXPECT_EQ("items_per_second 80 < 100 (20% slower)",
+            BenchmarkRegression(Entry(10, 1.0, "items_per_second", 80),
+                                baseline, 0.1));
+  // The rate is compared even if the time per iteration improved.
+  EXPECT_NE("", BenchmarkRegression(Entry(10, 0.1, "bytes_per_second", 1),
+                                    Entry(10, 1.0, "bytes_per_second", 2),
+                                    0.1));
+}
+
+TEST(BenchmarkRegression, ComparesWallTimePerIteration) {
+  // wall_time is per iteration: runs of different lengths compare equal.
+  EXPECT_EQ("", BenchmarkRegression(Entry(1000, 0.002, "", 0),
+                                    Entry(10, 0.002, "", 0), 0.1));
+  EXPECT_EQ("", BenchmarkRegression(Entry(10, 0.0021, "", 0),
+                                    Entry(1000, 0.002, "", 0), 0.1));
+  EXPECT_EQ("seconds per iteration 0.003 > 0.002 (50% slower)",
+            BenchmarkRegression(Entry(10, 0.003, "", 0),
+                                Entry(1000, 0.002, "", 0), 0.1));
+  // Without a rate on both sides the time is compared.
+  EXPECT_NE("", BenchmarkRegression(Entry(10, 0.003, "items_per_second", 1),
+                                    Entry(10, 0.002, "", 0), 0.1));
+}
+
 }  // namespace
 }  // namespace tensorflow
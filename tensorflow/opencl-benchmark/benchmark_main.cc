@@ -0,0 +1,222 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Runs the OpenCL / SYCL benchmark suites of benchmark_suites.cc, writes
+// their results as JSON or CSV and compares them with a baseline CSV.
+//
+// See README.md for usage instructions.
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/command_line_flags.h"
+#include "tensorflow/core/util/reporter.h"
+#include "tensorflow/core/util/test_log.pb.h"
+
+namespace tensorflow {
+namespace opencl_benchmark {
+namespace {
+
+const char* const kSuites[] = {"bandwidth", "roofline", "gemm", "ops"};
+
+// Builds the benchmark name pattern of a comma separated list of suites.
+Status SuitePattern(const string& suites, string* pattern) {
+  std::vector<string> names;
+  for (const string& suite : str_util::Split(suites, ',')) {
+    if (std::find(std::begin(kSuites), std::end(kSuites), suite) ==
+        std::end(kSuites)) {
+      return errors::InvalidArgument("Unknown suite ", suite);
+    }
+    string name = suite;
+    name[0] = toupper(name[0]);
+    names.push_back(name);
+  }
+  if (names.empty()) return errors::InvalidArgument("No suite selected");
+  *pattern = strings::StrCat("^BM_(", str_util::Join(names, "|"), ")_");
+  return Status::OK();
+}
+
+// Runs the benchmarks matching 'pattern', collecting the entries that
+// TestReporter writes to one file per benchmark.
+Status RunBenchmarks(const string& pattern, BenchmarkEntries* entries) {
+  Env* env = Env::Default();
+  string dir;
+  if (!env->LocalTempFilename(&dir)) {
+    return errors::Internal("Could not create a temporary file name");
+  }
+  TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(dir));
+  setenv(TestReporter::kTestReporterEnv, strings::StrCat(dir, "/").c_str(), 1);
+
+  testing::Benchmark::Run(pattern.c_str());
+
+  std::vector<string> files;
+  TF_RETURN_IF_ERROR(env->GetChildren(dir, &files));
+  std::sort(files.begin(), files.end());
+  for (const string& file : files) {
+    BenchmarkEntries run;
+    TF_RETURN_IF_ERROR(ReadBinaryProto(env, io::JoinPath(dir, file), &run));
+    entries->mutable_entry()->MergeFrom(run.entry());
+  }
+  int64 undeleted_files, undeleted_dirs;
+  return env->DeleteRecursively(dir, &undeleted_files, &undeleted_dirs);
+}
+
+// Reads a baseline written by --update_baseline.
+Status ReadBaseline(const string& path, BenchmarkEntries* entries) {
+  string contents;
+  TF_RETURN_IF_ERROR(ReadFileToString(Env::Default(), path, &contents));
+  Status s = BenchmarkEntriesFromCsv(contents, entries);
+  if (!s.ok()) return errors::InvalidArgument(path, ": ", s.error_message());
+  return Status::OK();
+}
+
+bool Skipped(const BenchmarkEntry& entry) {
+  auto it = entry.extras().find("label");
+  return entry.iters() == 0 ||
+         (it != entry.extras().end() &&
+          StringPiece(it->second.string_value()).starts_with("skipped"));
+}
+
+// Logs the regressions of 'entries' against 'baseline', returns their
+// number. Benchmarks missing from either side or skipped are ignored.
+int CompareWithBaseline(const BenchmarkEntries& entries,
+                        const BenchmarkEntries& baseline, double tolerance) {
+  std::map<string, const BenchmarkEntry*> expected;
+  for (const BenchmarkEntry& entry : baseline.entry()) {
+    expected[entry.name()] = &entry;
+  }
+  int compared = 0;
+  int regressions = 0;
+  for (const BenchmarkEntry& entry : entries.entry()) {
+    auto it = expected.find(entry.name());
+    if (it == expected.end() || Skipped(entry) || Skipped(*it->second)) {
+      continue;
+    }
+    ++compared;
+    const string regression =
+        BenchmarkRegression(entry, *it->second, tolerance);
+    if (!regression.empty()) {
+      LOG(ERROR) << "Regression: " << entry.name() << ": " << regression;
+      ++regressions;
+    }
+  }
+  LOG(INFO) << "Compared " << compared << " benchmarks with the baseline, "
+            << regressions << " regressed by more than "
+            << std::round(100 * tolerance) << "%";
+  return regressions;
+}
+
+int Main(int argc, char** argv) {
+  string suites = str_util::Join(kSuites, ",");
+  string output = "";
+  string baseline = "";
+  float tolerance = 0.1f;
+  bool update_baseline = false;
+  std::vector<Flag> flag_list = {
+      Flag("suites", &suites,
+           "comma separated suites to run: bandwidth, roofline, gemm, ops"),
+      Flag("output", &output,
+           "file receiving the results, CSV if it ends in .csv, else JSON"),
+      Flag("baseline", &baseline, "baseline CSV file to compare with"),
+      Flag("tolerance", &tolerance,
+           "allowed slowdown against the baseline, as a fraction"),
+      Flag("update_baseline", &update_baseline,
+           "write the results to --baseline instead of comparing"),
+  };
+  string usage = Flags::Usage(argv[0], flag_list);
+  const bool parse_result = Flags::Parse(&argc, argv, flag_list);
+  if (!parse_result) {
+    LOG(ERROR) << usage;
+    return -1;
+  }
+  ::tensorflow::port::InitMain(argv[0], &argc, &argv);
+  if (argc > 1) {
+    LOG(ERROR) << "Unknown argument " << argv[1] << "\n" << usage;
+    return -1;
+  }
+  if (update_baseline && baseline.empty()) {
+    LOG(ERROR) << "--update_baseline needs --baseline\n" << usage;
+    return -1;
+  }
+
+  string pattern;
+  Status s = SuitePattern(suites, &pattern);
+  if (!s.ok()) {
+    LOG(ERROR) << s << "\n" << usage;
+    return -1;
+  }
+
+  BenchmarkEntries entries;
+  s = RunBenchmarks(pattern, &entries);
+  if (!s.ok()) {
+    LOG(ERROR) << "Could not collect the benchmark results: " << s;
+    return -1;
+  }
+
+  if (!output.empty()) {
+    s = WriteStringToFile(Env::Default(), output,
+                          StringPiece(output).ends_with(".csv")
+                              ? BenchmarkEntriesToCsv(entries)
+                              : BenchmarkEntriesToJson(entries));
+    if (!s.ok()) {
+      LOG(ERROR) << "Could not write " << output << ": " << s;
+      return -1;
+    }
+  }
+
+  if (baseline.empty()) return 0;
+  if (update_baseline) {
+    s = WriteStringToFile(Env::Default(), baseline,
+                          BenchmarkEntriesToCsv(entries));
+    if (!s.ok()) {
+      LOG(ERROR) << "Could not write " << baseline << ": " << s;
+      return -1;
+    }
+    LOG(INFO) << "Wrote " << entries.entry_size() << " benchmarks to "
+              << baseline;
+    return 0;
+  }
+
+  BenchmarkEntries expected;
+  s = ReadBaseline(baseline, &expected);
+  if (!s.ok()) {
+    LOG(ERROR) << "Could not read the baseline: " << s;
+    return -1;
+  }
+  return CompareWithBaseline(entries, expected, tolerance) > 0 ? 1 : 0;
+}
+
+}  // namespace
+}  // namespace opencl_benchmark
+}  // namespace tensorflow
+
+int main(int argc, char** argv) {
+  return tensorflow::opencl_benchmark::Main(argc, argv);
+}
@@ -0,0 +1,341 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// The suites run by opencl-benchmark. Every benchmark is named
+// BM_<Suite>_<Case>, so that a suite is selected by a name pattern:
+//
+//   BM_Bandwidth_*   host to device, device to host and device copy
+//                    bandwidth (opencl-babel-stream-benchmark)
+//   BM_Roofline_*    FP32 rate at increasing arithmetic intensity
+//                    (opencl-mixbench)
+//   BM_Gemm_*        square MatMul sweep on the cpu and opencl devices
+//   BM_Ops_*         fully connected layer and convolution graphs on the
+//                    cpu, opencl and sycl devices, and the BlackScholesPrice
+//                    and MonteCarloPathSim pricing ops on the cpu and opencl
+//                    devices
+//
+// Benchmarks of a device which is not available return at once with a
+// "skipped" label, and the baseline comparison ignores them.
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/kernels/matmul_cl_program_registry.h"
+#include "tensorflow/core/kernels/matmul_cl_runtime.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+bool HasDevice(const string& type) {
+  if (DeviceFactory::GetFactory(type) == nullptr) return false;
+  if (type == "OPENCL") return clMatMulRuntime::Global()->ok();
+  return true;
+}
+
+bool SkipUnless(const string& type) {
+  if (HasDevice(type)) return false;
+  testing::SetLabel(strings::StrCat("skipped: no ", type, " device"));
+  return true;
+}
+
+// Device buffers of the bandwidth and roofline suites, created outside of
+// the timed region.
+class ProbeBuffers {
+ public:
+  explicit ProbeBuffers(size_t bytes) : bytes_(bytes), host_(bytes, 0) {
+    clMatMulRuntime* runtime = clMatMulRuntime::Global();
+    cl_int err = CL_SUCCESS;
+    src_ = clCreateBuffer(runtime->context(), CL_MEM_READ_WRITE, bytes, NULL,
+                          &err);
+    dst_ = clCreateBuffer(runtime->context(), CL_MEM_READ_WRITE, bytes, NULL,
+                          &err);
+  }
+  ~ProbeBuffers() {
+    if (src_ != NULL) clReleaseMemObject(src_);
+    if (dst_ != NULL) clReleaseMemObject(dst_);
+  }
+
+  bool ok() const { return src_ != NULL && dst_ != NULL; }
+  size_t bytes() const { return bytes_; }
+  char* host() { return host_.data(); }
+  cl_mem src() const { return src_; }
+  cl_mem dst() const { return dst_; }
+
+ private:
+  const size_t bytes_;
+  std::vector<char> host_;
+  cl_mem src_ = NULL;
+  cl_mem dst_ = NULL;
+};
+
+// Whole float4s within CL_DEVICE_MAX_MEM_ALLOC_SIZE
+size_t ProbeBytes(int megabytes) {
+  const size_t bytes = static_cast<size_t>(megabytes) << 20;
+  return std::min(bytes, clMatMulRuntime::Global()->maxMemAllocSize()) / 16 *
+         16;
+}
+
+void RunTransfer(int iters, int megabytes, bool to_device) {
+  if (SkipUnless("OPENCL")) return;
+  testing::StopTiming();
+  ProbeBuffers buffers(ProbeBytes(megabytes));
+  CHECK(buffers.ok()) << "Could not allocate " << buffers.bytes()
+                      << " bytes on the OpenCL device";
+  cl_command_queue queue = clMatMulRuntime::Global()->queue();
+  testing::UseRealTime();
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    cl_int err = to_device
+                     ? clEnqueueWriteBuffer(queue, buffers.src(), CL_FALSE, 0,
+                                            buffers.bytes(), buffers.host(),
+                                            0, NULL, NULL)
+                     : clEnqueueReadBuffer(queue, buffers.src(), CL_FALSE, 0,
+                                           buffers.bytes(), buffers.host(),
+                                           0, NULL, NULL);
+    CHECK_EQ(err, CL_SUCCESS);
+  }
+  CHECK_EQ(clFinish(queue), CL_SUCCESS);
+  testing::BytesProcessed(static_cast<int64>(iters) * buffers.bytes());
+}
+
+void BM_Bandwidth_HostToDevice(int iters, int megabytes) {
+  RunTransfer(iters, megabytes, true);
+}
+BENCHMARK(BM_Bandwidth_HostToDevice)->Arg(1)->Arg(16)->Arg(64);
+
+void BM_Bandwidth_DeviceToHost(int iters, int megabytes) {
+  RunTransfer(iters, megabytes, false);
+}
+BENCHMARK(BM_Bandwidth_DeviceToHost)->Arg(1)->Arg(16)->Arg(64);
+
+// STREAM copy, every byte is read once and written once
+void BM_Bandwidth_DeviceCopy(int iters, int megabytes) {
+  if (SkipUnless("OPENCL")) return;
+  testing::StopTiming();
+  clMatMulRuntime* runtime = clMatMulRuntime::Global();
+  cl_program program = runtime->program(kClDeviceProbeProgram, "");
+  CHECK(program != NULL) << "Could not build " << kClDeviceProbeProgram;
+  ProbeBuffers buffers(ProbeBytes(megabytes));
+  CHECK(buffers.ok());
+  cl_kernel kernel = runtime->acquireKernel(program, "Probe_Copy_Fp32");
+  CHECK(kernel != NULL);
+  cl_mem src = buffers.src();
+  cl_mem dst = buffers.dst();
+  CHECK_EQ(clSetKernelArg(kernel, 0, sizeof(cl_mem), &src), CL_SUCCESS);
+  CHECK_EQ(clSetKernelArg(kernel, 1, sizeof(cl_mem), &dst), CL_SUCCESS);
+  cl_command_queue queue = runtime->queue();
+  const size_t global_size = buffers.bytes() / 16;
+  testing::UseRealTime();
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    CHECK_EQ(clEnqueueNDRangeKernel(queue, kernel, 1, NULL, &global_size,
+                                    NULL, 0, NULL, NULL),
+             CL_SUCCESS);
+  }
+  CHECK_EQ(clFinish(queue), CL_SUCCESS);
+  testing::StopTiming();
+  runtime->releaseKernel(program, "Probe_Copy_Fp32", kernel);
+  testing::BytesProcessed(static_cast<int64>(iters) * 2 * buffers.bytes());
+}
+BENCHMARK(BM_Bandwidth_DeviceCopy)->Arg(16)->Arg(64);
+
+// Probe_Flops_Fp32 runs 'rounds' rounds of 16 flops per float, at 2 flop per
+// byte and round. Items are flops.
+void BM_Roofline_Fp32(int iters, int rounds) {
+  if (SkipUnless("OPENCL")) return;
+  testing::StopTiming();
+  clMatMulRuntime* runtime = clMatMulRuntime::Global();
+  cl_program program = runtime->program(kClDeviceProbeProgram, "");
+  CHECK(program != NULL) << "Could not build " << kClDeviceProbeProgram;
+  ProbeBuffers buffers(ProbeBytes(16));
+  CHECK(buffers.ok());
+  cl_kernel kernel = runtime->acquireKernel(program, "Probe_Flops_Fp32");
+  CHECK(kernel != NULL);
+  cl_mem data = buffers.src();
+  const cl_int arg = rounds;
+  CHECK_EQ(clSetKernelArg(kernel, 0, sizeof(cl_mem), &data), CL_SUCCESS);
+  CHECK_EQ(clSetKernelArg(kernel, 1, sizeof(cl_int), &arg), CL_SUCCESS);
+  cl_command_queue queue = runtime->queue();
+  const size_t global_size = buffers.bytes() / sizeof(float);
+  testing::UseRealTime();
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    CHECK_EQ(clEnqueueNDRangeKernel(queue, kernel, 1, NULL, &global_size,
+                                    NULL, 0, NULL, NULL),
+             CL_SUCCESS);
+  }
+  CHECK_EQ(clFinish(queue), CL_SUCCESS);
+  testing::StopTiming();
+  runtime->releaseKernel(program, "Probe_Flops_Fp32", kernel);
+  testing::ItemsProcessed(static_cast<int64>(iters) * global_size * 16 *
+                          rounds);
+  testing::SetLabel(strings::StrCat(2 * rounds, " flop/byte"));
+}
+BENCHMARK(BM_Roofline_Fp32)->Arg(1)->Arg(4)->Arg(16)->Arg(64)->Arg(256);
+
+Tensor RandomTensor(const TensorShape& shape) {
+  Tensor t(DT_FLOAT, shape);
+  t.flat<float>().setRandom();
+  return t;
+}
+
+Graph* Gemm(int dim) {
+  Graph* g = new Graph(OpRegistry::Global());
+  test::graph::Matmul(
+      g, test::graph::Constant(g, RandomTensor(TensorShape({dim, dim}))),
+      test::graph::Constant(g, RandomTensor(TensorShape({dim, dim}))), false,
+      false);
+  return g;
+}
+
+// Items are flops
+void RunGemm(int iters, int dim, const string& device) {
+  if (SkipUnless(str_util::Uppercase(device))) return;
+  testing::UseRealTime();
+  testing::ItemsProcessed(static_cast<int64>(iters) * dim * dim * dim * 2);
+  test::Benchmark(device, Gemm(dim)).Run(iters);
+}
+
+void BM_Gemm_cpu(int iters, int dim) { RunGemm(iters, dim, "cpu"); }
+BENCHMARK(BM_Gemm_cpu)->Arg(64)->Arg(128)->Arg(256)->Arg(512)->Arg(1024);
+
+void BM_Gemm_opencl(int iters, int dim) { RunGemm(iters, dim, "opencl"); }
+BENCHMARK(BM_Gemm_opencl)->Arg(64)->Arg(128)->Arg(256)->Arg(512)->Arg(1024);
+
+// A fully connected layer, MatMul -> BiasAdd -> Relu of a batch of 128.
+Graph* FullyConnected(int width) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* product = test::graph::Matmul(
+      g, test::graph::Constant(g, RandomTensor(TensorShape({128, width}))),
+      test::graph::Constant(g, RandomTensor(TensorShape({width, width}))),
+      false, false);
+  test::graph::Relu(
+      g, test::graph::BiasAdd(
+             g, product,
+             test::graph::Constant(g, RandomTensor(TensorShape({width})))));
+  return g;
+}
+
+void RunFullyConnected(int iters, int width, const string& device) {
+  if (SkipUnless(str_util::Uppercase(device))) return;
+  testing::UseRealTime();
+  testing::ItemsProcessed(static_cast<int64>(iters) * 128 * width * width * 2);
+  test::Benchmark(device, FullyConnected(width)).Run(iters);
+}
+
+void BM_Ops_FullyConnected_cpu(int iters, int width) {
+  RunFullyConnected(iters, width, "cpu");
+}
+BENCHMARK(BM_Ops_FullyConnected_cpu)->Arg(512)->Arg(1024);
+
+void BM_Ops_FullyConnected_opencl(int iters, int width) {
+  RunFullyConnected(iters, width, "opencl");
+}
+BENCHMARK(BM_Ops_FullyConnected_opencl)->Arg(512)->Arg(1024);
+
+// A 3x3 'SAME' convolution of a 8x'size'x'size'x64 batch into 64 channels.
+Graph* Convolution(int size) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor input = RandomTensor(TensorShape({8, size, size, 64}));
+  Tensor filter = RandomTensor(TensorShape({3, 3, 64, 64}));
+  test::graph::Conv2D(g, test::graph::Constant(g, input),
+                      test::graph::Constant(g, filter));
+  return g;
+}
+
+void RunConvolution(int iters, int size, const string& device) {
+  if (SkipUnless(str_util::Uppercase(device))) return;
+  testing::UseRealTime();
+  testing::ItemsProcessed(static_cast<int64>(iters) * 8 * size * size * 64 *
+                          64 * 9 * 2);
+  test::Benchmark(device, Convolution(size)).Run(iters);
+}
+
+void BM_Ops_Conv2D_cpu(int iters, int size) {
+  RunConvolution(iters, size, "cpu");
+}
+BENCHMARK(BM_Ops_Conv2D_cpu)->Arg(28)->Arg(56);
+
+// BlackScholesPrice or MonteCarloPathSim (1024 paths of 64 steps) of
+// 'num_options' random call options.
+Graph* Pricing(const string& op, int num_options) {
+  Graph* g = new Graph(OpRegistry::Global());
+  NodeBuilder builder(g->NewName("n"), op);
+  for (float base : {100.0f, 100.0f, 0.05f, 0.01f, 0.3f, 1.0f}) {
+    Tensor values = RandomTensor(TensorShape({num_options}));
+    values.flat<float>() = values.flat<float>() * (base / 2) + base;
+    builder.Input(test::graph::Constant(g, values));
+  }
+  if (op == "MonteCarloPathSim") {
+    builder.Attr("num_paths", 1024).Attr("num_steps", 64);
+  }
+  TF_CHECK_OK(builder.Finalize(g, nullptr));
+  return g;
+}
+
+// Items are options for BlackScholesPrice, simulated paths for
+// MonteCarloPathSim.
+void RunPricing(int iters, const string& op, int num_options,
+                const string& device) {
+  if (SkipUnless(str_util::Uppercase(device))) return;
+  testing::UseRealTime();
+  const int64 paths = op == "MonteCarloPathSim" ? 1024 : 1;
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_options * paths);
+  test::Benchmark(device, Pricing(op, num_options)).Run(iters);
+}
+
+void BM_Ops_BlackScholes_cpu(int iters, int num_options) {
+  RunPricing(iters, "BlackScholesPrice", num_options, "cpu");
+}
+BENCHMARK(BM_Ops_BlackScholes_cpu)->Arg(64 << 10)->Arg(1 << 20);
+
+void BM_Ops_BlackScholes_opencl(int iters, int num_options) {
+  RunPricing(iters, "BlackScholesPrice", num_options, "opencl");
+}
+BENCHMARK(BM_Ops_BlackScholes_opencl)->Arg(64 << 10)->Arg(1 << 20);
+
+void BM_Ops_MonteCarlo_cpu(int iters, int num_options) {
+  RunPricing(iters, "MonteCarloPathSim", num_options, "cpu");
+}
+BENCHMARK(BM_Ops_MonteCarlo_cpu)->Arg(16)->Arg(128);
+
+void BM_Ops_MonteCarlo_opencl(int iters, int num_options) {
+  RunPricing(iters, "MonteCarloPathSim", num_options, "opencl");
+}
+BENCHMARK(BM_Ops_MonteCarlo_opencl)->Arg(16)->Arg(128);
+
+#ifdef TENSORFLOW_USE_SYCL
+void BM_Ops_FullyConnected_sycl(int iters, int width) {
+  RunFullyConnected(iters, width, "sycl");
+}
+BENCHMARK(BM_Ops_FullyConnected_sycl)->Arg(512)->Arg(1024);
+
+void BM_Ops_Conv2D_sycl(int iters, int size) {
+  RunConvolution(iters, size, "sycl");
+}
+BENCHMARK(BM_Ops_Conv2D_sycl)->Arg(28)->Arg(56);
+#endif  // TENSORFLOW_USE_SYCL
+
+}  // namespace
+}  // namespace tensorflow
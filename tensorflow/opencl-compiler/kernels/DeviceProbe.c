@@ -0,0 +1,43 @@
+//--------------------------------------------------------------------------------------
+// File: DeviceProbe.cl
+// Desc: Microbenchmark kernels measuring the throughput of an OpenCL device,
+//       after opencl-mixbench and opencl-babel-stream-benchmark
+//--------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------
+// Name: Probe_Flops_Fp32()
+// Desc: Reads one float per work-item, runs 'iterations' rounds of 8 dependent
+// multiply-adds spread over 4 independent chains, and writes one float back.
+// Each work-item moves 8 bytes and computes 16 * iterations flops, so the
+// arithmetic intensity is 2 * iterations flop/byte.
+//--------------------------------------------------------------------------------------
+__kernel void Probe_Flops_Fp32(__global float* data, const int iterations)
+{
+    const size_t i = get_global_id(0);
+    float a = data[i];
+    float b = a + 1.0f;
+    float c = a + 2.0f;
+    float d = a + 3.0f;
+    const float m = 0.999f;
+    for (int k = 0; k < iterations; k++) {
+        a = mad(a, m, 0.001f);
+        b = mad(b, m, 0.001f);
+        c = mad(c, m, 0.001f);
+        d = mad(d, m, 0.001f);
+        a = mad(a, m, 0.001f);
+        b = mad(b, m, 0.001f);
+        c = mad(c, m, 0.001f);
+        d = mad(d, m, 0.001f);
+    }
+    data[i] = a + b + c + d;
+}
+
+//--------------------------------------------------------------------------------------
+// Name: Probe_Copy_Fp32()
+// Desc: STREAM copy, each work-item reads and writes one float4.
+//--------------------------------------------------------------------------------------
+__kernel void Probe_Copy_Fp32(__global const float4* src, __global float4* dst)
+{
+    const size_t i = get_global_id(0);
+    dst[i] = src[i];
+}
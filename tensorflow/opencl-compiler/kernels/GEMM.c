@@ -110,6 +110,368 @@ __kernel void MatMul_NN_2D_LocalMem_Fp32(
 
 }
 
+//=============================================================================//
+//                       2D tiled kernel (32-bit index)                        //
+//=============================================================================//
+
+//--------------------------------------------------------------------------------------
+// Name: MatMul_NN_2D_Tiled_Fp32()
+// Desc: Compute the multiplication of two row-major matrices of any size.  Same
+// local memory tiling as MatMul_NN_2D_LocalMem_Fp32, but dimensions are 32-bit,
+// each matrix has its own row pitch so a block of a larger product can be computed,
+// and partial tiles at the matrix edges are zero-filled.  The global size must be
+// rounded up to a multiple of TILE_SIZE in both dimensions.
+//--------------------------------------------------------------------------------------
+#define TILE_SIZE 16
+__attribute__((reqd_work_group_size(TILE_SIZE, TILE_SIZE, 1)))
+__kernel void MatMul_NN_2D_Tiled_Fp32(
+                                    const uint matrixRowsA,
+                                    const uint matrixColsARowsB,
+                                    const uint matrixColsB,
+                                    const __global float* matrixA,
+                                    const uint pitchA,
+                                    const __global float* matrixB,
+                                    const uint pitchB,
+                                    __global float* matrixProduct,
+                                    const uint pitchC)
+{
+    const uint localRow = get_local_id(0);
+    const uint localCol = get_local_id(1);
+    const uint globalRow = get_global_id(0);
+    const uint globalCol = get_global_id(1);
+
+    __local float Asub[TILE_SIZE][TILE_SIZE];
+    __local float Bsub[TILE_SIZE][TILE_SIZE];
+
+    float acc = 0.0f;
+
+    const uint numTiles = (matrixColsARowsB + TILE_SIZE - 1) / TILE_SIZE;
+    for (uint t = 0; t < numTiles; t++) {
+
+        // Load one tile of A and B, elements outside the matrices read as zero
+        const uint tiledRow = TILE_SIZE * t + localRow;
+        const uint tiledCol = TILE_SIZE * t + localCol;
+
+        Asub[localRow][localCol] = ( globalRow < matrixRowsA && tiledCol < matrixColsARowsB ) ?
+            matrixA[globalRow * pitchA + tiledCol] : 0.0f;
+        Bsub[localRow][localCol] = ( tiledRow < matrixColsARowsB && globalCol < matrixColsB ) ?
+            matrixB[tiledRow * pitchB + globalCol] : 0.0f;
+
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        for (uint k = 0; k < TILE_SIZE; k++) {
+            acc += Asub[localRow][k] * Bsub[k][localCol];
+        }
+
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    if( globalRow < matrixRowsA && globalCol < matrixColsB ){
+        matrixProduct[globalRow * pitchC + globalCol] = acc;
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// Name: MatTrans_2D_Tiled_Fp32()
+// Desc: Compute the transpose of a matrix of any size through a local memory tile,
+// so both the reads and the writes are contiguous along a work-group row.  The
+// global size must be rounded up to a multiple of TILE_SIZE in both dimensions,
+// dimension 0 running over the source columns and dimension 1 over the source rows.
+//--------------------------------------------------------------------------------------
+__attribute__((reqd_work_group_size(TILE_SIZE, TILE_SIZE, 1)))
+__kernel void MatTrans_2D_Tiled_Fp32(
+                                    const uint rows,
+                                    const uint cols,
+                                    const __global float* matrix,
+                                    __global float* matrixTranspose)
+{
+    // Extra column avoids local memory bank conflicts on the transposed read
+    __local float tile[TILE_SIZE][TILE_SIZE + 1];
+
+    const uint lx = get_local_id(0);
+    const uint ly = get_local_id(1);
+
+    uint col = get_group_id(0) * TILE_SIZE + lx;
+    uint row = get_group_id(1) * TILE_SIZE + ly;
+    if( row < rows && col < cols ){
+        tile[ly][lx] = matrix[row * cols + col];
+    }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    // Swap the roles of the work-group axes for the write
+    col = get_group_id(1) * TILE_SIZE + lx;
+    row = get_group_id(0) * TILE_SIZE + ly;
+    if( row < cols && col < rows ){
+        matrixTranspose[row * rows + col] = tile[lx][ly];
+    }
+}
+
+//=============================================================================//
+//                 2D tiled kernel, FP16 storage (32-bit index)                //
+//=============================================================================//
+
+//--------------------------------------------------------------------------------------
+// Name: MatMul_2D_Tiled_Fp16_Acc()
+// Desc: Shared body of the FP16 tiled kernels, returns element (globalRow, globalCol)
+// of op(A) * op(B).  Element (i, k) of op(A) is read from
+// matrixA[i * rowStrideA + k * colStrideA], so transposed operands are handled by
+// swapping the strides instead of a transpose pass.  Operands are stored as half and
+// widened with vload_half when a tile is loaded; the sum is accumulated in float.
+//--------------------------------------------------------------------------------------
+float MatMul_2D_Tiled_Fp16_Acc(
+                                    const uint matrixRowsA,
+                                    const uint matrixColsARowsB,
+                                    const uint matrixColsB,
+                                    const __global half* matrixA,
+                                    const uint rowStrideA,
+                                    const uint colStrideA,
+                                    const __global half* matrixB,
+                                    const uint rowStrideB,
+                                    const uint colStrideB,
+                                    __local float (*Asub)[TILE_SIZE],
+                                    __local float (*Bsub)[TILE_SIZE])
+{
+    const uint localRow = get_local_id(0);
+    const uint localCol = get_local_id(1);
+    const uint globalRow = get_global_id(0);
+    const uint globalCol = get_global_id(1);
+
+    float acc = 0.0f;
+
+    const uint numTiles = (matrixColsARowsB + TILE_SIZE - 1) / TILE_SIZE;
+    for (uint t = 0; t < numTiles; t++) {
+
+        // Load one tile of A and B, elements outside the matrices read as zero
+        const uint tiledRow = TILE_SIZE * t + localRow;
+        const uint tiledCol = TILE_SIZE * t + localCol;
+
+        Asub[localRow][localCol] = ( globalRow < matrixRowsA && tiledCol < matrixColsARowsB ) ?
+            vload_half(globalRow * rowStrideA + tiledCol * colStrideA, matrixA) : 0.0f;
+        Bsub[localRow][localCol] = ( tiledRow < matrixColsARowsB && globalCol < matrixColsB ) ?
+            vload_half(tiledRow * rowStrideB + globalCol * colStrideB, matrixB) : 0.0f;
+
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        for (uint k = 0; k < TILE_SIZE; k++) {
+            acc += Asub[localRow][k] * Bsub[k][localCol];
+        }
+
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    return acc;
+}
+
+//--------------------------------------------------------------------------------------
+// Name: MatMul_NN_2D_Tiled_Fp16()
+// Desc: Half precision matrix product of any size, accumulated in float and rounded
+// to the nearest half on store.  The product is row-major with a row pitch of
+// matrixColsB.  The global size must be rounded up to a multiple of TILE_SIZE in
+// both dimensions.
+//--------------------------------------------------------------------------------------
+__attribute__((reqd_work_group_size(TILE_SIZE, TILE_SIZE, 1)))
+__kernel void MatMul_NN_2D_Tiled_Fp16(
+                                    const uint matrixRowsA,
+                                    const uint matrixColsARowsB,
+                                    const uint matrixColsB,
+                                    const __global half* matrixA,
+                                    const uint rowStrideA,
+                                    const uint colStrideA,
+                                    const __global half* matrixB,
+                                    const uint rowStrideB,
+                                    const uint colStrideB,
+                                    __global half* matrixProduct)
+{
+    __local float Asub[TILE_SIZE][TILE_SIZE];
+    __local float Bsub[TILE_SIZE][TILE_SIZE];
+
+    const float acc = MatMul_2D_Tiled_Fp16_Acc(matrixRowsA, matrixColsARowsB,
+        matrixColsB, matrixA, rowStrideA, colStrideA, matrixB, rowStrideB,
+        colStrideB, Asub, Bsub);
+
+    const uint globalRow = get_global_id(0);
+    const uint globalCol = get_global_id(1);
+    if( globalRow < matrixRowsA && globalCol < matrixColsB ){
+        vstore_half_rte(acc, globalRow * matrixColsB + globalCol, matrixProduct);
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// Name: MatMul_NN_2D_Tiled_Fp16_Fp32Out()
+// Desc: Same as MatMul_NN_2D_Tiled_Fp16, but the float accumulator is stored as is.
+// Used to run float32 MatMuls with half precision operands.
+//--------------------------------------------------------------------------------------
+__attribute__((reqd_work_group_size(TILE_SIZE, TILE_SIZE, 1)))
+__kernel void MatMul_NN_2D_Tiled_Fp16_Fp32Out(
+                                    const uint matrixRowsA,
+                                    const uint matrixColsARowsB,
+                                    const uint matrixColsB,
+                                    const __global half* matrixA,
+                                    const uint rowStrideA,
+                                    const uint colStrideA,
+                                    const __global half* matrixB,
+                                    const uint rowStrideB,
+                                    const uint colStrideB,
+                                    __global float* matrixProduct)
+{
+    __local float Asub[TILE_SIZE][TILE_SIZE];
+    __local float Bsub[TILE_SIZE][TILE_SIZE];
+
+    const float acc = MatMul_2D_Tiled_Fp16_Acc(matrixRowsA, matrixColsARowsB,
+        matrixColsB, matrixA, rowStrideA, colStrideA, matrixB, rowStrideB,
+        colStrideB, Asub, Bsub);
+
+    const uint globalRow = get_global_id(0);
+    const uint globalCol = get_global_id(1);
+    if( globalRow < matrixRowsA && globalCol < matrixColsB ){
+        matrixProduct[globalRow * matrixColsB + globalCol] = acc;
+    }
+}
+
+//=============================================================================//
+//                     Batched 2D tiled kernels (32-bit index)                 //
+//=============================================================================//
+
+//--------------------------------------------------------------------------------------
+// Name: MatMul_Batched_2D_Tiled_Fp32()
+// Desc: Compute a batch of row-major matrix products in one launch, dimension 2 of
+// the global size running over the batch.  The matrices of a batch are packed one
+// after the other, M x K for A, K x N for B and M x N for C.  Element (i, k) of
+// op(A) is read from A[i * rowStrideA + k * colStrideA], so adjoint operands are
+// handled by swapping the strides.  The global size must be rounded up to a
+// multiple of TILE_SIZE in dimensions 0 and 1.
+//--------------------------------------------------------------------------------------
+__attribute__((reqd_work_group_size(TILE_SIZE, TILE_SIZE, 1)))
+__kernel void MatMul_Batched_2D_Tiled_Fp32(
+                                    const uint matrixRowsA,
+                                    const uint matrixColsARowsB,
+                                    const uint matrixColsB,
+                                    const __global float* matrixA,
+                                    const uint rowStrideA,
+                                    const uint colStrideA,
+                                    const __global float* matrixB,
+                                    const uint rowStrideB,
+                                    const uint colStrideB,
+                                    __global float* matrixProduct)
+{
+    const uint localRow = get_local_id(0);
+    const uint localCol = get_local_id(1);
+    const uint globalRow = get_global_id(0);
+    const uint globalCol = get_global_id(1);
+    const uint batch = get_global_id(2);
+
+    matrixA += batch * matrixRowsA * matrixColsARowsB;
+    matrixB += batch * matrixColsARowsB * matrixColsB;
+    matrixProduct += batch * matrixRowsA * matrixColsB;
+
+    __local float Asub[TILE_SIZE][TILE_SIZE];
+    __local float Bsub[TILE_SIZE][TILE_SIZE];
+
+    float acc = 0.0f;
+
+    const uint numTiles = (matrixColsARowsB + TILE_SIZE - 1) / TILE_SIZE;
+    for (uint t = 0; t < numTiles; t++) {
+
+        // Load one tile of A and B, elements outside the matrices read as zero
+        const uint tiledRow = TILE_SIZE * t + localRow;
+        const uint tiledCol = TILE_SIZE * t + localCol;
+
+        Asub[localRow][localCol] = ( globalRow < matrixRowsA && tiledCol < matrixColsARowsB ) ?
+            matrixA[globalRow * rowStrideA + tiledCol * colStrideA] : 0.0f;
+        Bsub[localRow][localCol] = ( tiledRow < matrixColsARowsB && globalCol < matrixColsB ) ?
+            matrixB[tiledRow * rowStrideB + globalCol * colStrideB] : 0.0f;
+
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        for (uint k = 0; k < TILE_SIZE; k++) {
+            acc += Asub[localRow][k] * Bsub[k][localCol];
+        }
+
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    if( globalRow < matrixRowsA && globalCol < matrixColsB ){
+        matrixProduct[globalRow * matrixColsB + globalCol] = acc;
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// Name: MatMul_Batched_2D_Tiled_Fp16()
+// Desc: Half precision counterpart of MatMul_Batched_2D_Tiled_Fp32, accumulated in
+// float and rounded to the nearest half on store.
+//--------------------------------------------------------------------------------------
+__attribute__((reqd_work_group_size(TILE_SIZE, TILE_SIZE, 1)))
+__kernel void MatMul_Batched_2D_Tiled_Fp16(
+                                    const uint matrixRowsA,
+                                    const uint matrixColsARowsB,
+                                    const uint matrixColsB,
+                                    const __global half* matrixA,
+                                    const uint rowStrideA,
+                                    const uint colStrideA,
+                                    const __global half* matrixB,
+                                    const uint rowStrideB,
+                                    const uint colStrideB,
+                                    __global half* matrixProduct)
+{
+    __local float Asub[TILE_SIZE][TILE_SIZE];
+    __local float Bsub[TILE_SIZE][TILE_SIZE];
+
+    const uint batch = get_global_id(2);
+    matrixA += batch * matrixRowsA * matrixColsARowsB;
+    matrixB += batch * matrixColsARowsB * matrixColsB;
+    matrixProduct += batch * matrixRowsA * matrixColsB;
+
+    const float acc = MatMul_2D_Tiled_Fp16_Acc(matrixRowsA, matrixColsARowsB,
+        matrixColsB, matrixA, rowStrideA, colStrideA, matrixB, rowStrideB,
+        colStrideB, Asub, Bsub);
+
+    const uint globalRow = get_global_id(0);
+    const uint globalCol = get_global_id(1);
+    if( globalRow < matrixRowsA && globalCol < matrixColsB ){
+        vstore_half_rte(acc, globalRow * matrixColsB + globalCol, matrixProduct);
+    }
+}
+
+//=============================================================================//
+//                       Elementwise kernel (32-bit index)                     //
+//=============================================================================//
+
+//--------------------------------------------------------------------------------------
+// Name: BiasAdd_1D_Fp32()
+// Desc: Add a bias vector along the last dimension of a row-major tensor with
+// "channels" elements per row, one work-item per element.  value and output may
+// be the same buffer.  The global size may be larger than numElements.
+//--------------------------------------------------------------------------------------
+__kernel void BiasAdd_1D_Fp32(
+                                    const uint numElements,
+                                    const uint channels,
+                                    const __global float* value,
+                                    const __global float* bias,
+                                    __global float* output)
+{
+    const uint i = get_global_id(0);
+    if( i < numElements ){
+        output[i] = value[i] + bias[i % channels];
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// Name: Relu_1D_Fp32()
+// Desc: output = max(features, 0), one work-item per element.  features and output
+// may be the same buffer.  The global size may be larger than numElements.
+//--------------------------------------------------------------------------------------
+__kernel void Relu_1D_Fp32(
+                                    const uint numElements,
+                                    const __global float* features,
+                                    __global float* output)
+{
+    const uint i = get_global_id(0);
+    if( i < numElements ){
+        output[i] = fmax(features[i], 0.0f);
+    }
+}
+
 //=============================================================================//
 //                                  1D kernel                                  //
 //=============================================================================//
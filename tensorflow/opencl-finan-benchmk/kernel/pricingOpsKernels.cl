@@ -0,0 +1,219 @@
+//pricingOpsKernels.cl
+//Kernels of the BlackScholesPrice and MonteCarloPathSim ops
+//(tensorflow/core/kernels/opencl_device_ops.cc)
+//
+//Ported from blackScholesAnalyticEngineKernels.cl and monteCarloKernels.cl
+//into a single source without includes, so it can be embedded into the
+//library and built at run time. Options are passed as one array per
+//parameter instead of arrays of structs, and the per-path mt19937 state of
+//monteCarloKernels.cl is replaced by a counter based Philox4x32-10 stream,
+//the generator of the TF random ops, which needs no state buffer and gives
+//the same samples as the CPU kernel of MonteCarloPathSim.
+
+#define CALL 0
+#define PUT 1
+
+//paths simulated and summed by one work-group of MonteCarlo_Paths_Fp32
+#define MC_GROUP_SIZE 64
+
+#define PHILOX_W32A 0x9E3779B9u
+#define PHILOX_W32B 0xBB67AE85u
+#define PHILOX_M4x32A 0xD2511F53u
+#define PHILOX_M4x32B 0xCD9E8D57u
+
+
+//cumulative normal distribution
+float cumNormDist(float x)
+{
+	return 0.5f * erfc(-x * M_SQRT1_2_F);
+}
+
+
+//price of a european option with the analytic engine of
+//blackScholesAnalyticEngineKernels.cl, for a flat rate, dividend yield and
+//volatility
+float blackScholesPrice(int type, float spot, float strike, float rate,
+                        float dividend, float volatility, float time)
+{
+	float discount = exp(-rate * time);
+	float forward = spot * exp((rate - dividend) * time);
+	float stdDev = volatility * sqrt(time);
+	float d1 = log(forward / strike) / stdDev + 0.5f * stdDev;
+	float d2 = d1 - stdDev;
+
+	if (type == CALL)
+		return discount * (forward * cumNormDist(d1) - strike * cumNormDist(d2));
+	else
+		return discount * (strike * cumNormDist(-d2) - forward * cumNormDist(-d1));
+}
+
+
+__kernel void BlackScholes_1D_Fp32(const uint numVals, const int type,
+                                   __global const float* spot,
+                                   __global const float* strike,
+                                   __global const float* rate,
+                                   __global const float* dividend,
+                                   __global const float* volatility,
+                                   __global const float* time,
+                                   __global float* out)
+{
+	size_t i = get_global_id(0);
+
+	if (i < numVals)
+	{
+		out[i] = blackScholesPrice(type, spot[i], strike[i], rate[i],
+		                           dividend[i], volatility[i], time[i]);
+	}
+}
+
+
+//one round of Philox4x32
+uint4 philoxRound(uint4 ctr, uint2 key)
+{
+	uint lo0 = PHILOX_M4x32A * ctr.x;
+	uint hi0 = mul_hi(PHILOX_M4x32A, ctr.x);
+	uint lo1 = PHILOX_M4x32B * ctr.z;
+	uint hi1 = mul_hi(PHILOX_M4x32B, ctr.z);
+	return (uint4)(hi1 ^ ctr.y ^ key.x, lo1, hi0 ^ ctr.w ^ key.y, lo0);
+}
+
+
+//four random words of the 128-bit counter ctr, as PhiloxRandom::operator()
+uint4 philox4x32_10(uint4 ctr, uint2 key)
+{
+	for (int round = 0; round < 9; round++)
+	{
+		ctr = philoxRound(ctr, key);
+		key += (uint2)(PHILOX_W32A, PHILOX_W32B);
+	}
+	return philoxRound(ctr, key);
+}
+
+
+//counter advanced by count samples, as PhiloxRandom::Skip
+uint4 philoxSkip(uint4 ctr, ulong count)
+{
+	uint countLo = (uint)count;
+	uint countHi = (uint)(count >> 32);
+
+	ctr.x += countLo;
+	if (ctr.x < countLo)
+		countHi++;
+
+	ctr.y += countHi;
+	if (ctr.y < countHi)
+	{
+		if (++ctr.z == 0)
+			ctr.w++;
+	}
+	return ctr;
+}
+
+
+//uniform float in [0, 1) from 23 random bits
+float uint32ToFloat(uint x)
+{
+	return as_float((x & 0x7fffffu) | 0x3f800000u) - 1.0f;
+}
+
+
+//two standard normal values from two random words (Box-Muller transform)
+float2 boxMuller(uint x0, uint x1)
+{
+	float u1 = fmax(uint32ToFloat(x0), 1.0e-7f);
+	float v1 = 2.0f * M_PI_F * uint32ToFloat(x1);
+	float u2 = sqrt(-2.0f * log(u1));
+	return (float2)(sin(v1) * u2, cos(v1) * u2);
+}
+
+
+//Simulates path get_global_id(0) of option get_global_id(1) and writes the
+//undiscounted payoff sum of each work-group of MC_GROUP_SIZE paths to
+//partialSums[option * get_num_groups(0) + group]. Path p of option o uses
+//the normals of Philox samples (o * numPaths + p) * ceil(numSteps / 4) on.
+__kernel __attribute__((reqd_work_group_size(MC_GROUP_SIZE, 1, 1)))
+void MonteCarlo_Paths_Fp32(const uint numPaths, const uint numSteps,
+                           const int type,
+                           __global const float* spot,
+                           __global const float* strike,
+                           __global const float* rate,
+                           __global const float* dividend,
+                           __global const float* volatility,
+                           __global const float* time,
+                           const uint4 counter, const uint2 key,
+                           __global float* partialSums)
+{
+	__local float sums[MC_GROUP_SIZE];
+
+	size_t numPath = get_global_id(0);
+	size_t numOption = get_global_id(1);
+	size_t lid = get_local_id(0);
+
+	float payoff = 0.0f;
+	if (numPath < numPaths)
+	{
+		//the log of the path evolves by drift + diffusion * dw on each step,
+		//as processEvolve() of monteCarloKernels.cl
+		float vol = volatility[numOption];
+		float dt = time[numOption] / numSteps;
+		float drift = (rate[numOption] - dividend[numOption] - 0.5f * vol * vol) * dt;
+		float diffusion = vol * sqrt(dt);
+
+		uint samplesPerPath = (numSteps + 3) / 4;
+		uint4 ctr = philoxSkip(counter,
+		    ((ulong)numOption * numPaths + numPath) * samplesPerPath);
+
+		float sumDw = 0.0f;
+		for (uint step = 0; step < numSteps; step += 4)
+		{
+			uint4 bits = philox4x32_10(ctr, key);
+			ctr = philoxSkip(ctr, 1);
+			float2 dw01 = boxMuller(bits.x, bits.y);
+			float2 dw23 = boxMuller(bits.z, bits.w);
+			uint left = numSteps - step;
+			sumDw += dw01.x;
+			if (left > 1) sumDw += dw01.y;
+			if (left > 2) sumDw += dw23.x;
+			if (left > 3) sumDw += dw23.y;
+		}
+
+		float val = spot[numOption] * exp(drift * numSteps + diffusion * sumDw);
+		payoff = (type == CALL) ? fmax(val - strike[numOption], 0.0f)
+		                        : fmax(strike[numOption] - val, 0.0f);
+	}
+
+	sums[lid] = payoff;
+	barrier(CLK_LOCAL_MEM_FENCE);
+	for (uint stride = MC_GROUP_SIZE / 2; stride > 0; stride >>= 1)
+	{
+		if (lid < stride)
+			sums[lid] += sums[lid + stride];
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (lid == 0)
+		partialSums[numOption * get_num_groups(0) + get_group_id(0)] = sums[0];
+}
+
+
+//Discounted mean payoff of each option from the work-group sums of
+//MonteCarlo_Paths_Fp32
+__kernel void MonteCarlo_Mean_Fp32(const uint numOptions, const uint numGroups,
+                                   const uint numPaths,
+                                   __global const float* rate,
+                                   __global const float* time,
+                                   __global const float* partialSums,
+                                   __global float* out)
+{
+	size_t numOption = get_global_id(0);
+
+	if (numOption < numOptions)
+	{
+		float sum = 0.0f;
+		for (uint group = 0; group < numGroups; group++)
+		{
+			sum += partialSums[numOption * numGroups + group];
+		}
+		out[numOption] = exp(-rate[numOption] * time[numOption]) * sum / numPaths;
+	}
+}
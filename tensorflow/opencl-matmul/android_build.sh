@@ -1,6 +1,8 @@
 #!/bin/bash
 
-TARGET=${PWD##*/}
+# Builds opencl-matmul by default, or the target given as first argument,
+# e.g. ./android_build.sh opencl-matmul-fp16
+TARGET=${1:-${PWD##*/}}
 
 bazel build --config=android_arm64 :$TARGET \
     --verbose_failures \
@@ -15,3 +17,4 @@ adb push matmul.pb $REMOTE_DIR
 adb push testMatmul.sh $REMOTE_DIR
 adb push testSquare.sh $REMOTE_DIR
 adb push testExpSquare.sh $REMOTE_DIR
+adb push testMatmulFp16.sh $REMOTE_DIR
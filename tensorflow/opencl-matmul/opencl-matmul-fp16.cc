@@ -0,0 +1,152 @@
+// Accuracy & throughput of the FP16 OpenCL MatMul paths against Eigen FP32.
+//
+//   fp32  : float MatMul, OpenCL float32 kernels (baseline)
+//   fp16  : DT_HALF MatMul, MatMul_NN_2D_Tiled_Fp16
+//   mixed : float MatMul with TF_MATMUL_OPENCL_FP16_COMPUTE=1, half operands
+//           and float accumulation (MatMul_NN_2D_Tiled_Fp16_Fp32Out)
+//
+// The graph is built in memory, no .pb file is needed.
+
+#include <stdlib.h>
+#include <sys/time.h>
+#include <time.h>
+#include <cmath>
+#include <random>
+
+#include "tensorflow/core/graph/default_device.h"
+#include "tensorflow/core/graph/graph_def_builder.h"
+#include "tensorflow/core/public/session.h"
+
+using namespace tensorflow;
+using namespace std;
+
+static double nowMicros() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1.0e6 + tv.tv_usec;
+}
+
+int main(int argc, char* argv[]) {
+
+    if( argc != 6 ){
+      cerr << "expected 5 arguments [M] [K] [N] [fp32|fp16|mixed] [Num of Runs]" << endl;
+      exit(1);
+    }
+
+    // Matrix size, C[M,N] = A[M,K] * B[K,N]
+    int M = atoi( argv[1] );
+    int K = atoi( argv[2] );
+    int N = atoi( argv[3] );
+    string mode = argv[4];
+    int num_runs = atoi( argv[5] );
+    if( mode != "fp32" && mode != "fp16" && mode != "mixed" ){
+      cerr << "unknown mode " << mode << endl;
+      exit(1);
+    }
+
+    // Read once by the first OpenCL MatMul of the process
+    if( mode == "mixed" ){
+      setenv("TF_MATMUL_OPENCL_FP16_COMPUTE", "1", 1);
+    }
+    const DataType dtype = ( mode == "fp16" ) ? DT_HALF : DT_FLOAT;
+
+    // matmul = x * y
+    GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+    Node* x = ops::SourceOp("Placeholder",
+                            b.opts().WithName("x").WithAttr("dtype", dtype));
+    Node* y = ops::SourceOp("Placeholder",
+                            b.opts().WithName("y").WithAttr("dtype", dtype));
+    ops::BinaryOp("MatMul", x, y, b.opts().WithName("matmul"));
+    GraphDef graph_def;
+    TF_CHECK_OK(b.ToGraphDef(&graph_def));
+    graph::SetDefaultDevice("/cpu:0", &graph_def);
+
+    Session* session;
+    SessionOptions opts;
+    TF_CHECK_OK(NewSession(opts, &session));
+    TF_CHECK_OK(session->Create(graph_def));
+
+    // Random inputs, the same values are fed to every mode
+    std::random_device rd;
+    std::default_random_engine gen = std::default_random_engine(rd());
+    std::normal_distribution<> dis{0,1};
+
+    Tensor TensorA (DT_FLOAT, TensorShape({ M, K }));
+    Tensor TensorB (DT_FLOAT, TensorShape({ K, N }));
+    auto a = TensorA.flat<float>();
+    auto bm = TensorB.flat<float>();
+    for( int i = 0 ; i < a.size() ; i ++ ) a(i) = dis(gen);
+    for( int i = 0 ; i < bm.size() ; i ++ ) bm(i) = dis(gen);
+
+    Tensor FeedA = TensorA;
+    Tensor FeedB = TensorB;
+    if( dtype == DT_HALF ){
+      FeedA = Tensor(DT_HALF, TensorA.shape());
+      FeedB = Tensor(DT_HALF, TensorB.shape());
+      FeedA.flat<Eigen::half>() = a.cast<Eigen::half>();
+      FeedB.flat<Eigen::half>() = bm.cast<Eigen::half>();
+    }
+
+    // Warm up: OpenCL runtime setup, program build & dispatcher calibration
+    vector<Tensor> outputs;
+    TF_CHECK_OK(session->Run({{"x", FeedA}, {"y", FeedB}}, {"matmul"}, {},
+                             &outputs));
+
+    LOG(INFO) << ">>> [TF " << mode << "] Starting " << num_runs << " runs...";
+    double start = nowMicros();
+    for( int r = 0 ; r < num_runs ; r ++ ){
+      TF_CHECK_OK(session->Run({{"x", FeedA}, {"y", FeedB}}, {"matmul"}, {},
+                               &outputs));
+    }
+    const double tf_us = ( nowMicros() - start ) / num_runs;
+
+    // Output as float
+    Tensor TfRes (DT_FLOAT, TensorShape({ M, N }));
+    if( dtype == DT_HALF ){
+      TfRes.flat<float>() = outputs[0].flat<Eigen::half>().cast<float>();
+    }else{
+      TfRes = outputs[0];
+    }
+
+    // Eigen FP32 reference on the original float inputs
+    typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic,
+                          Eigen::RowMajor> RowMajorMatrix;
+    Eigen::Map<const RowMajorMatrix> A(a.data(), M, K);
+    Eigen::Map<const RowMajorMatrix> B(bm.data(), K, N);
+    RowMajorMatrix C(M, N);
+
+    LOG(INFO) << ">>> [Eigen fp32] Starting " << num_runs << " runs...";
+    start = nowMicros();
+    for( int r = 0 ; r < num_runs ; r ++ ){
+      C.noalias() = A * B;
+    }
+    const double eigen_us = ( nowMicros() - start ) / num_runs;
+
+    // Error against Eigen fp32, relative to the largest reference magnitude
+    auto tf_res = TfRes.flat<float>();
+    double max_abs_err = 0;
+    double sum_abs_err = 0;
+    double max_ref = 0;
+    for( int i = 0 ; i < M * N ; i ++ ){
+      const double err = fabs( tf_res(i) - C.data()[i] );
+      max_abs_err = std::max(max_abs_err, err);
+      sum_abs_err += err;
+      max_ref = std::max(max_ref, (double) fabs( C.data()[i] ));
+    }
+
+    const double flops = 2.0 * M * K * N;
+    cout << "mode " << mode
+         << ", M " << M << ", K " << K << ", N " << N
+         << ", tf_us " << tf_us
+         << ", tf_gflops " << flops / tf_us * 1e-3
+         << ", eigen_fp32_us " << eigen_us
+         << ", eigen_fp32_gflops " << flops / eigen_us * 1e-3
+         << ", max_abs_err " << max_abs_err
+         << ", mean_abs_err " << sum_abs_err / ( M * N )
+         << ", max_rel_err " << ( max_ref > 0 ? max_abs_err / max_ref : 0 )
+         << endl;
+
+    TF_CHECK_OK(session->Close());
+    delete session;
+    return 0;
+}
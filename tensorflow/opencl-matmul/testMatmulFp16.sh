@@ -0,0 +1,18 @@
+#!/system/bin/sh
+# Accuracy & throughput of the FP16 MatMul paths against Eigen FP32, one line
+# of results per size and mode
+numTimes=10
+for size in 64 128 256 512 1024
+do
+  for mode in fp32 fp16 mixed
+  do
+    ./opencl-matmul-fp16 $size $size $size $mode $numTimes
+  done
+done
+
+# Typical fully connected layers
+for mode in fp32 fp16 mixed
+do
+  ./opencl-matmul-fp16 128 1024 1024 $mode $numTimes
+  ./opencl-matmul-fp16 16 1024 1024 $mode $numTimes
+done
@@ -9,3 +9,4 @@ REMOTE_DIR="/data/local/tmp"
 adb push ../../bazel-bin/tensorflow/opencl-mem-bandwidth/opencl-host_to_device $REMOTE_DIR
 adb push ../../bazel-bin/tensorflow/opencl-mem-bandwidth/opencl-device_to_host $REMOTE_DIR
 adb push ../../bazel-bin/tensorflow/opencl-mem-bandwidth/opencl-device_to_device $REMOTE_DIR
+adb push ../../bazel-bin/tensorflow/opencl-mem-bandwidth/opencl-zero_copy $REMOTE_DIR
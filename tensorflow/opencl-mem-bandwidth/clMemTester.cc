@@ -1,6 +1,8 @@
 #include "CL/cl.h"
 #include "Timer.h"
 #include "clMemTester.h"
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 // clMemTester constructor
@@ -30,6 +32,10 @@ cl_int clMemTester::init()
   // Create command clQueue
   clQueue = clCreateCommandQueue(clCtx, clDevice, 0, NULL);
 
+  // Base address alignment (in bits) required for zero copy buffers
+  clGetDeviceInfo(clDevice, CL_DEVICE_MEM_BASE_ADDR_ALIGN, sizeof(cl_uint),
+    &memBaseAddrAlign, NULL);
+
   // Timer init
   Timer timer = Timer();
 
@@ -209,6 +215,118 @@ cl_int clMemTester::DeviceToDevice( unsigned long int numBytes )
   return CL_SUCCESS;
 }
 
+// Host to device through a mapped CL_MEM_ALLOC_HOST_PTR staging buffer, the
+// path used by the OpenCL MatMul engines for unaligned tensors
+cl_int clMemTester::MapCopyHostToDevice( unsigned long int numBytes )
+{
+  // Create host buffer
+  char * hostBufPtr = new char [ numBytes ];
+  for ( auto i = 0; i < numBytes; i++ )
+  {
+      hostBufPtr[i] = (i & 0xff);
+  }
+
+  // err code init
+  err = CL_SUCCESS;
+
+  // Create staging buffer
+  cl_mem deviceBuffer = clCreateBuffer( clCtx,
+    CL_MEM_HOST_WRITE_ONLY | CL_MEM_ALLOC_HOST_PTR, numBytes, NULL, &err );
+  if ( err != CL_SUCCESS )
+  {
+      std::cerr << "clCreateBuffer fail with code " << err;
+      delete [] hostBufPtr;
+      return err;
+  }
+
+  clFinish( clQueue );
+
+  timer.start();
+
+  // Map, copy, unmap
+  for ( size_t i = 0; i < numTests; i++ )
+  {
+      void * mappedPtr = clEnqueueMapBuffer( clQueue, deviceBuffer, CL_TRUE,
+        CL_MAP_WRITE, 0, numBytes, 0, NULL, NULL, &err );
+      if (err != CL_SUCCESS )
+      {
+          std::cerr << "Error mapping device buffer";
+          clReleaseMemObject( deviceBuffer );
+          delete [] hostBufPtr;
+          return err;
+      }
+      memcpy( mappedPtr, hostBufPtr, numBytes );
+      clEnqueueUnmapMemObject( clQueue, deviceBuffer, mappedPtr, 0, NULL, NULL );
+  }
+
+  // Finish any outstanding unmaps
+  clFinish( clQueue );
+
+  printf("[map+copy] ");
+  computeBandwidth( numBytes, timer.read_us() );
+  delete [] hostBufPtr;
+  clReleaseMemObject( deviceBuffer );
+  return CL_SUCCESS;
+}
+
+// Host to device by wrapping aligned host memory with CL_MEM_USE_HOST_PTR, the
+// path used by the OpenCL MatMul engines for aligned tensors
+cl_int clMemTester::ZeroCopyHostToDevice( unsigned long int numBytes )
+{
+  // Create host buffer aligned to CL_DEVICE_MEM_BASE_ADDR_ALIGN
+  size_t alignment = memBaseAddrAlign / 8;
+  if ( alignment < sizeof(void*) )
+  {
+      alignment = sizeof(void*);
+  }
+  void * alignedPtr = NULL;
+  if ( posix_memalign( &alignedPtr, alignment, numBytes ) != 0 )
+  {
+      std::cerr << "posix_memalign fail";
+      return CL_OUT_OF_HOST_MEMORY;
+  }
+  char * hostBufPtr = (char *) alignedPtr;
+  for ( auto i = 0; i < numBytes; i++ )
+  {
+      hostBufPtr[i] = (i & 0xff);
+  }
+
+  // err code init
+  err = CL_SUCCESS;
+
+  clFinish( clQueue );
+
+  timer.start();
+
+  // Wrap, make visible to the device, release
+  for ( size_t i = 0; i < numTests; i++ )
+  {
+      cl_mem deviceBuffer = clCreateBuffer( clCtx,
+        CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR, numBytes, hostBufPtr, &err );
+      if ( err != CL_SUCCESS )
+      {
+          std::cerr << "clCreateBuffer fail with code " << err;
+          free( hostBufPtr );
+          return err;
+      }
+      // Map/unmap forces the driver to synchronize the host region
+      void * mappedPtr = clEnqueueMapBuffer( clQueue, deviceBuffer, CL_TRUE,
+        CL_MAP_READ, 0, numBytes, 0, NULL, NULL, &err );
+      if ( mappedPtr != hostBufPtr )
+      {
+          std::cerr << "Driver copied the wrapped host buffer\n";
+      }
+      clEnqueueUnmapMemObject( clQueue, deviceBuffer, mappedPtr, 0, NULL, NULL );
+      clFinish( clQueue );
+      clReleaseMemObject( deviceBuffer );
+  }
+
+  printf("[zero copy] ");
+  computeBandwidth( numBytes, timer.read_us() );
+  free( hostBufPtr );
+  return CL_SUCCESS;
+}
+
 // Memory bandwidth calculator
 void clMemTester::computeBandwidth(size_t numOfBytes, const double& time_us){
 
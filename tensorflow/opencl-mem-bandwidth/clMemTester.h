@@ -25,6 +25,12 @@ public:
   // Device to device memory bandwidth test
   cl_int DeviceToDevice( unsigned long int numBytes );
 
+  // Host to device through a mapped CL_MEM_ALLOC_HOST_PTR staging buffer
+  cl_int MapCopyHostToDevice( unsigned long int numBytes );
+
+  // Host to device by wrapping aligned host memory with CL_MEM_USE_HOST_PTR
+  cl_int ZeroCopyHostToDevice( unsigned long int numBytes );
+
   // Memory bandwidth calculator
   void computeBandwidth(size_t numOfBytes, const double& time_us);
 
@@ -33,6 +39,7 @@ private:
   cl_device_id clDevice;
   cl_context clCtx;
   cl_command_queue clQueue;
+  cl_uint memBaseAddrAlign = 0;
   cl_int err = CL_SUCCESS;
 
   Timer timer;
@@ -0,0 +1,27 @@
+#include "clMemTester.h"
+#include <vector>
+
+// Compares staging host data through a mapped buffer (map + memcpy) with
+// wrapping it in place (CL_MEM_USE_HOST_PTR), the two host to device paths of
+// the OpenCL MatMul engines.
+int main(){
+
+  std::vector<unsigned long int> Mbytes;
+
+  for( auto i = 4 ; i < MAX_ALLOCATED ; i=i+10 ){
+    Mbytes.push_back(i);
+  }
+
+  clMemTester c = clMemTester(NUM_OF_TESTS);
+
+  c.init();
+
+  for( auto b : Mbytes){
+    c.MapCopyHostToDevice( b << 20 );
+    c.ZeroCopyHostToDevice( b << 20 );
+  }
+
+  c.clEnd();
+
+  return 0;
+}